@@ -121,6 +121,15 @@ struct gui_llcache_table {
 	 */
 	nserror (*invalidate)(struct nsurl *url);
 
+	/**
+	 * Obtain backing store statistics.
+	 *
+	 * This operation is optional.
+	 *
+	 * @param[out] stats The statistics structure to fill.
+	 * @return NSERROR_OK on success or error code on failure.
+	 */
+	nserror (*stats)(struct llcache_store_stats *stats);
 };
 
 extern struct gui_llcache_table* null_llcache_table;
@@ -63,14 +63,17 @@ const char * const content_status_name[] = {
  *   CONTENT_STATUS_DONE, and CONTENT_MSG_READY then CONTENT_MSG_DONE are sent.
  * - If the conversion fails, CONTENT_MSG_ERROR is sent. The content will soon
  *   be destroyed and must no longer be used.
+ * - If a partial conversion has already made the content
+ *   CONTENT_STATUS_READY, the conversion is completed without locking it.
  */
 static void content_convert(struct content *c)
 {
 	assert(c);
 	assert(c->status == CONTENT_STATUS_LOADING ||
+	       c->status == CONTENT_STATUS_READY ||
 	       c->status == CONTENT_STATUS_ERROR);
 
-	if (c->status != CONTENT_STATUS_LOADING)
+	if (c->status == CONTENT_STATUS_ERROR)
 		return;
 
 	if (c->locked == true)
@@ -79,7 +82,14 @@ static void content_convert(struct content *c)
 	NSLOG(netsurf, INFO, "content "URL_FMT_SPC" (%p)",
 	      nsurl_access_log(llcache_handle_get_url(c->llcache)), c);
 
-	if (c->handler->data_complete != NULL) {
+	if (c->status == CONTENT_STATUS_READY) {
+		/* A partial conversion is already being displayed so
+		 * the content must remain usable while it completes */
+		assert(c->handler->data_complete != NULL);
+		if (c->handler->data_complete(c) == false) {
+			content_set_error(c);
+		}
+	} else if (c->handler->data_complete != NULL) {
 		c->locked = true;
 		if (c->handler->data_complete(c) == false) {
 			content_set_error(c);
@@ -295,6 +305,20 @@ void content_set_ready(struct content *c)
 }
 
 
+/* exported interface documented in content/protected.h */
+void content_set_ready_partial(struct content *c)
+{
+	/* The content has not yet had all its data and so is not
+	 * locked for conversion. */
+	assert(c->status == CONTENT_STATUS_LOADING);
+	assert(c->locked == false);
+
+	c->status = CONTENT_STATUS_READY;
+	content_update_status(c);
+	content_broadcast(c, CONTENT_MSG_READY, NULL);
+}
+
+
 /* exported interface documented in content/protected.h */
 void content_set_done(struct content *c)
 {
@@ -329,6 +329,14 @@ nserror content__clone(const struct content *c, struct content *nc);
  */
 void content_set_ready(struct content *c);
 
+/**
+ * Put a content which is still receiving data in status
+ * CONTENT_STATUS_READY so that a partial rendering may be shown.
+ *
+ * The content remains unlocked when the remaining data is converted.
+ */
+void content_set_ready_partial(struct content *c);
+
 /**
  * Put a content in status CONTENT_STATUS_DONE.
  */
@@ -47,6 +47,7 @@
 #include "private.h"
 #include "about.h"
 #include "blank.h"
+#include "cache.h"
 #include "certificate.h"
 #include "config.h"
 #include "chart.h"
@@ -56,6 +57,7 @@
 #include "query.h"
 #include "query_auth.h"
 #include "query_fetcherror.h"
+#include "query_offline.h"
 #include "query_privacy.h"
 #include "query_timeout.h"
 #include "atestament.h"
@@ -418,6 +420,14 @@ struct about_handlers about_handler_list[] = {
 		fetch_about_logo_handler,
 		true
 	},
+	{
+		/* details about the low level cache */
+		"cache",
+		SLEN("cache"),
+		NULL,
+		fetch_about_cache_handler,
+		true
+	},
 	{
 		/* details about the image cache */
 		"imagecache",
@@ -477,6 +487,13 @@ struct about_handlers about_handler_list[] = {
 		NULL,
 		fetch_about_query_fetcherror_handler,
 		true
+	},
+	{
+		"query/offline",
+		SLEN("query/offline"),
+		NULL,
+		fetch_about_query_offline_handler,
+		true
 	}
 };
 
@@ -0,0 +1,337 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf.
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * content generator for the about scheme cache page
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "netsurf/inttypes.h"
+#include "netsurf/types.h"
+#include "utils/errors.h"
+#include "utils/nsurl.h"
+
+#include "content/llcache.h"
+
+#include "private.h"
+#include "cache.h"
+
+/** labels for the latency histogram buckets */
+#define LATENCY_LABELS "0ms,1ms,2-3ms,4-7ms,8-15ms,16-31ms,32-63ms,64ms+"
+
+/**
+ * compute a percentage avoiding division by zero
+ */
+static unsigned int percent(uint64_t value, uint64_t total)
+{
+	if (total == 0) {
+		return 0;
+	}
+	return (unsigned int)((value * 100) / total);
+}
+
+/**
+ * format an array of values as a comma separated list
+ *
+ * \param buffer The output buffer.
+ * \param size The size of the output buffer.
+ * \param values The values to format.
+ * \param count The number of values.
+ * \return The output buffer.
+ */
+static char *
+values_list(char *buffer, size_t size, const unsigned int *values, unsigned int count)
+{
+	size_t slen = 0;
+	unsigned int idx;
+
+	buffer[0] = 0;
+	for (idx = 0; (idx < count) && (slen < size); idx++) {
+		slen += snprintf(buffer + slen, size - slen,
+				 "%s%u", (idx == 0) ? "" : ",", values[idx]);
+	}
+	return buffer;
+}
+
+/**
+ * output the memory cache summary
+ */
+static nserror
+cache_memory_summary(struct fetch_about_context *ctx, struct llcache_stats *stats)
+{
+	size_t free_size = 0;
+	unsigned int op_count;
+
+	if (stats->limit > stats->size) {
+		free_size = stats->limit - stats->size;
+	}
+
+	op_count = stats->hit_count + stats->revalidate_count + stats->miss_count;
+
+	return fetch_about_ssenddataf(ctx,
+		"<h2 class=\"ns-border\">Memory cache</h2>\n"
+		"<p>Configured limit of %"PRIsizet"</p>\n"
+		"<p>Using %"PRIsizet" (%u%%) in %u objects "
+		"(%u uncacheable, %u also on disc)"
+		"<img width=200 height=100 src=\"about:chart?type=pie&width=200&height=100&labels=used,free&values=%"PRIsizet",%"PRIsizet"\" />"
+		"</p>\n"
+		"<p>Retrieval total/hit/revalidate/miss (counts) %u/%u/%u/%u "
+		"(%u%%/%u%%/%u%%)"
+		"<img width=200 height=100 src=\"about:chart?type=pie&width=200&height=100&labels=hit,revalidate,miss&values=%u,%u,%u\" />"
+		"</p>\n"
+		"<p>Evicted %u objects of size %"PRIu64"</p>\n",
+		stats->limit,
+		stats->size,
+		percent(stats->size, stats->limit),
+		stats->object_count,
+		stats->uncached_count,
+		stats->disc_count,
+		stats->size,
+		free_size,
+		op_count,
+		stats->hit_count,
+		stats->revalidate_count,
+		stats->miss_count,
+		percent(stats->hit_count, op_count),
+		percent(stats->revalidate_count, op_count),
+		percent(stats->miss_count, op_count),
+		stats->hit_count,
+		stats->revalidate_count,
+		stats->miss_count,
+		stats->evict_count,
+		stats->evict_size);
+}
+
+/**
+ * output the activity history as a bar chart
+ */
+static nserror
+cache_history(struct fetch_about_context *ctx, struct llcache_stats *stats)
+{
+	unsigned int hits[LLCACHE_STATS_HISTORY];
+	unsigned int revalidates[LLCACHE_STATS_HISTORY];
+	unsigned int misses[LLCACHE_STATS_HISTORY];
+	char hitstr[LLCACHE_STATS_HISTORY * 12];
+	char revalstr[LLCACHE_STATS_HISTORY * 12];
+	char missstr[LLCACHE_STATS_HISTORY * 12];
+	unsigned int idx;
+
+	if (stats->history_len == 0) {
+		return fetch_about_ssenddataf(ctx,
+			"<p>No history for hit ratio chart</p>\n");
+	}
+
+	for (idx = 0; idx < stats->history_len; idx++) {
+		hits[idx] = stats->history[idx].hit_count;
+		revalidates[idx] = stats->history[idx].revalidate_count;
+		misses[idx] = stats->history[idx].miss_count;
+	}
+
+	return fetch_about_ssenddataf(ctx,
+		"<p>Retrievals over time (hit, revalidate and miss per sample)"
+		"<img width=600 height=150 src=\"about:chart?type=bar&width=600&height=150&labels=hit,revalidate,miss&values=%s&values=%s&values=%s\" />"
+		"</p>\n",
+		values_list(hitstr, sizeof(hitstr), hits, stats->history_len),
+		values_list(revalstr, sizeof(revalstr), revalidates, stats->history_len),
+		values_list(missstr, sizeof(missstr), misses, stats->history_len));
+}
+
+/**
+ * output the disc cache summary
+ */
+static nserror
+cache_disc_summary(struct fetch_about_context *ctx, struct llcache_stats *stats)
+{
+	struct llcache_store_stats *store = &stats->store;
+	uint64_t free_size = 0;
+	uint64_t bandwidth = 0;
+	unsigned int op_count;
+	char readstr[LLCACHE_STORE_LATENCY_BUCKETS * 12];
+	char writestr[LLCACHE_STORE_LATENCY_BUCKETS * 12];
+
+	if (stats->store_valid == false) {
+		return fetch_about_ssenddataf(ctx,
+			"<h2 class=\"ns-border\">Disc cache</h2>\n"
+			"<p>Disc cache is not available</p>\n");
+	}
+
+	if (store->limit > store->total_alloc) {
+		free_size = store->limit - store->total_alloc;
+	}
+
+	if (stats->total_elapsed > 0) {
+		bandwidth = (stats->total_written * 1000) / stats->total_elapsed;
+	}
+
+	op_count = store->hit_count + store->miss_count;
+
+	return fetch_about_ssenddataf(ctx,
+		"<h2 class=\"ns-border\">Disc cache</h2>\n"
+		"<p>Configured limit of %"PRIu64"</p>\n"
+		"<p>Using %"PRIu64" (%u%%) in %"PRIsizet" entries"
+		"<img width=200 height=100 src=\"about:chart?type=pie&width=200&height=100&labels=used,free&values=%"PRIu64",%"PRIu64"\" />"
+		"</p>\n"
+		"<p>Retrieval total/hit/miss (counts) %u/%"PRIsizet"/%"PRIsizet" "
+		"(%u%%/%u%%) serving %"PRIu64
+		"<img width=200 height=100 src=\"about:chart?type=pie&width=200&height=100&labels=hit,miss&values=%"PRIsizet",%"PRIsizet"\" />"
+		"</p>\n"
+		"<p>Wrote %"PRIu64" in %"PRIu64"ms (average %"PRIu64" bytes/second)</p>\n"
+		"<p>Evicted %"PRIsizet" entries of size %"PRIu64" in %"PRIsizet" runs</p>\n"
+		"<p>Read latency"
+		"<img width=300 height=150 src=\"about:chart?type=bar&width=300&height=150&labels=" LATENCY_LABELS "&values=%s\" />"
+		"</p>\n"
+		"<p>Write latency"
+		"<img width=300 height=150 src=\"about:chart?type=bar&width=300&height=150&labels=" LATENCY_LABELS "&values=%s\" />"
+		"</p>\n",
+		store->limit,
+		store->total_alloc,
+		percent(store->total_alloc, store->limit),
+		store->entry_count,
+		store->total_alloc,
+		free_size,
+		op_count,
+		store->hit_count,
+		store->miss_count,
+		percent(store->hit_count, op_count),
+		percent(store->miss_count, op_count),
+		store->hit_size,
+		store->hit_count,
+		store->miss_count,
+		stats->total_written,
+		stats->total_elapsed,
+		bandwidth,
+		store->evict_count,
+		store->evict_size,
+		store->evict_runs,
+		values_list(readstr, sizeof(readstr),
+			    store->read_latency, LLCACHE_STORE_LATENCY_BUCKETS),
+		values_list(writestr, sizeof(writestr),
+			    store->write_latency, LLCACHE_STORE_LATENCY_BUCKETS));
+}
+
+/**
+ * output the table of largest objects
+ */
+static nserror
+cache_top_objects(struct fetch_about_context *ctx, struct llcache_stats *stats)
+{
+	nserror res;
+	unsigned int idx;
+
+	res = fetch_about_ssenddataf(ctx,
+			"<h2 class=\"ns-border\">Largest objects</h2>\n"
+			"<p class=\"imagecachelist\">\n"
+			"<strong>"
+			"<span>Entry</span>"
+			"<span>Size</span>"
+			"<span>Source</span>"
+			"</strong>\n");
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	for (idx = 0; idx < stats->top_len; idx++) {
+		res = fetch_about_ssenddataf(ctx,
+			"<a%s href=\"%s\">"
+			"<span class=\"ns-border\">%u</span>"
+			"<span class=\"ns-border\">%"PRIsizet"</span>"
+			"<span class=\"ns-border\">%s</span>"
+			"</a>\n",
+			(idx & 1) ? "" : " class=\"ns-odd-bg\"",
+			nsurl_access(stats->top[idx].url),
+			idx,
+			stats->top[idx].size,
+			nsurl_access(stats->top[idx].url));
+		if (res != NSERROR_OK) {
+			return res;
+		}
+	}
+
+	return fetch_about_ssenddataf(ctx, "</p>\n");
+}
+
+/* exported interface documented in about/cache.h */
+bool fetch_about_cache_handler(struct fetch_about_context *ctx)
+{
+	nserror res;
+	struct llcache_stats stats;
+
+	res = llcache_get_stats(&stats);
+	if (res != NSERROR_OK) {
+		return fetch_about_srverror(ctx);
+	}
+
+	/* content is going to return ok */
+	fetch_about_set_http_code(ctx, 200);
+
+	/* content type */
+	if (fetch_about_send_header(ctx, "Content-Type: text/html"))
+		goto fetch_about_cache_handler_aborted;
+
+	/* page head */
+	res = fetch_about_ssenddataf(ctx,
+		"<html>\n<head>\n"
+		"<title>Cache Status</title>\n"
+		"<link rel=\"stylesheet\" type=\"text/css\" "
+		"href=\"resource:internal.css\">\n"
+		"</head>\n"
+		"<body id =\"cachelist\" class=\"ns-even-bg ns-even-fg ns-border\">\n"
+		"<h1 class=\"ns-border\">Cache Status</h1>\n");
+	if (res != NSERROR_OK) {
+		goto fetch_about_cache_handler_aborted;
+	}
+
+	res = cache_memory_summary(ctx, &stats);
+	if (res != NSERROR_OK) {
+		goto fetch_about_cache_handler_aborted;
+	}
+
+	res = cache_history(ctx, &stats);
+	if (res != NSERROR_OK) {
+		goto fetch_about_cache_handler_aborted;
+	}
+
+	res = cache_disc_summary(ctx, &stats);
+	if (res != NSERROR_OK) {
+		goto fetch_about_cache_handler_aborted;
+	}
+
+	res = cache_top_objects(ctx, &stats);
+	if (res != NSERROR_OK) {
+		goto fetch_about_cache_handler_aborted;
+	}
+
+	res = fetch_about_ssenddataf(ctx, "</body>\n</html>\n");
+	if (res != NSERROR_OK) {
+		goto fetch_about_cache_handler_aborted;
+	}
+
+	llcache_stats_release(&stats);
+
+	fetch_about_send_finished(ctx);
+
+	return true;
+
+fetch_about_cache_handler_aborted:
+	llcache_stats_release(&stats);
+
+	return false;
+}
@@ -48,6 +48,7 @@
 enum chart_type {
 		 CHART_TYPE_UNKNOWN,
 		 CHART_TYPE_PIE,
+		 CHART_TYPE_BAR,
 };
 
 /* type of chart key */
@@ -318,6 +319,8 @@ process_query_section(const char *str, size_t len, struct chart_param *chart)
 	    (strncmp(str, "type=", 5) == 0)) {
 		if (strncmp(str + 5, "pie", len - 5) == 0) {
 			chart->type = CHART_TYPE_PIE;
+		} else if (strncmp(str + 5, "bar", len - 5) == 0) {
+			chart->type = CHART_TYPE_BAR;
 		} else {
 			chart->type = CHART_TYPE_UNKNOWN;
 		}
@@ -398,7 +401,7 @@ chart_from_query(struct nsurl *url, struct chart_param *chart)
 
 
 static nserror
-output_pie_legend(struct fetch_about_context *ctx, struct chart_param *chart)
+output_legend(struct fetch_about_context *ctx, struct chart_param *chart)
 {
 	nserror res;
 	unsigned int lblidx;
@@ -535,7 +538,7 @@ pie_chart(struct fetch_about_context *ctx, struct chart_param *chart)
 	}
 
 	/* generate the legend */
-	res = output_pie_legend(ctx, chart);
+	res = output_legend(ctx, chart);
 	if (res != NSERROR_OK) {
 		goto aborted;
 	}
@@ -593,6 +596,168 @@ pie_chart(struct fetch_about_context *ctx, struct chart_param *chart)
 
 }
 
+/**
+ * find the largest value in any series
+ */
+static float compute_max_value(struct chart_param *chart)
+{
+	float max = 0;
+	unsigned int series;
+	unsigned int curdata;
+
+	for (series = 0; series < chart->data.series_len; series++) {
+		for (curdata = 0;
+		     curdata < chart->data.series[series].len;
+		     curdata++) {
+			if (chart->data.series[series].value[curdata] > max) {
+				max = chart->data.series[series].value[curdata];
+			}
+		}
+	}
+	return max;
+}
+
+/**
+ * render the data as a bar chart svg
+ *
+ * Each value index forms a group of bars, one bar for each series. With
+ * a single series each bar takes the colour of its label otherwise the
+ * labels name the series and each bar takes the colour of its series
+ * label.
+ */
+static bool
+bar_chart(struct fetch_about_context *ctx, struct chart_param *chart)
+{
+	nserror res;
+	float max_value;
+	unsigned int group_count = 0; /* number of bar groups */
+	unsigned int series;
+	unsigned int curdata;
+	float group_width;
+	float bar_width;
+	float bar_height;
+	unsigned int colour;
+
+	/* ensure there is data to render */
+	if (chart->data.series_len < 1) {
+		return false;
+	}
+
+	for (series = 0; series < chart->data.series_len; series++) {
+		if (chart->data.series[series].len > group_count) {
+			group_count = chart->data.series[series].len;
+		}
+	}
+
+	if (chart->data.series_len > 1) {
+		/* the key has one entry for each series */
+		if (ensure_label_count(chart, chart->data.series_len) != NSERROR_OK) {
+			return false;
+		}
+		while (chart->data.label_len > chart->data.series_len) {
+			chart->data.label_len--;
+			free(chart->data.label[chart->data.label_len].title);
+		}
+	}
+
+	max_value = compute_max_value(chart);
+	if (max_value <= 0) {
+		/* scale the empty chart sensibly */
+		max_value = 1;
+	}
+
+	/* chart area defaults to leaving space for the key on the right */
+	if ((chart->area.width == 0) || (chart->area.height == 0)) {
+		if (chart->key == CHART_KEY_NONE) {
+			chart->area.width = chart->width - chart->area.x;
+		} else {
+			chart->area.width = ((chart->width - chart->area.x) * 3) / 4;
+		}
+		chart->area.height = chart->height - chart->area.y;
+	}
+
+	group_width = (float)chart->area.width / group_count;
+	bar_width = group_width / (chart->data.series_len + 1);
+
+	/* content is going to return ok */
+	fetch_about_set_http_code(ctx, 200);
+
+	/* content type */
+	if (fetch_about_send_header(ctx,
+			"Content-Type: image/svg; charset=utf-8")) {
+		goto aborted;
+	}
+
+	/* svg header */
+	res = fetch_about_ssenddataf(ctx,
+			"<svg width=\"%u\" height=\"%u\" "
+			"xmlns=\"http://www.w3.org/2000/svg\">\n",
+			chart->width, chart->height);
+	if (res != NSERROR_OK) {
+		goto aborted;
+	}
+
+	/* generate the legend */
+	res = output_legend(ctx, chart);
+	if (res != NSERROR_OK) {
+		goto aborted;
+	}
+
+	/* axis */
+	res = fetch_about_ssenddataf(ctx,
+			"<path d=\"M %u %u L %u %u L %u %u\" "
+			"stroke=\"#000000\" fill=\"none\" />\n",
+			chart->area.x, chart->area.y,
+			chart->area.x, chart->area.y + chart->area.height - 1,
+			chart->area.x + chart->area.width,
+			chart->area.y + chart->area.height - 1);
+	if (res != NSERROR_OK) {
+		goto aborted;
+	}
+
+	/* plot the bars */
+	for (series = 0; series < chart->data.series_len; series++) {
+		for (curdata = 0;
+		     curdata < chart->data.series[series].len;
+		     curdata++) {
+			bar_height = (chart->data.series[series].value[curdata] /
+				      max_value) * (chart->area.height - 1);
+
+			if (chart->data.series_len == 1) {
+				colour = chart->data.label[curdata].colour;
+			} else {
+				colour = chart->data.label[series].colour;
+			}
+
+			res = fetch_about_ssenddataf(ctx,
+				"<rect x=\"%g\" y=\"%g\" width=\"%g\" "
+				"height=\"%g\" fill=\"#%06x\" />\n",
+				chart->area.x + (group_width * curdata) +
+					(bar_width * (series + 0.5)),
+				chart->area.y + chart->area.height - 1 - bar_height,
+				bar_width,
+				bar_height,
+				colour);
+			if (res != NSERROR_OK) {
+				goto aborted;
+			}
+		}
+	}
+
+	res = fetch_about_ssenddataf(ctx, "</svg>\n");
+	if (res != NSERROR_OK) {
+		goto aborted;
+	}
+
+	fetch_about_send_finished(ctx);
+
+	return true;
+
+ aborted:
+
+	return false;
+}
+
 /**
  * Handler to generate about scheme chart page.
  *
@@ -616,6 +781,9 @@ bool fetch_about_chart_handler(struct fetch_about_context *ctx)
 	case CHART_TYPE_PIE:
 		return pie_chart(ctx, &chart);
 
+	case CHART_TYPE_BAR:
+		return bar_chart(ctx, &chart);
+
 
 	default:
 		break;
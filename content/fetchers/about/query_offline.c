@@ -0,0 +1,150 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf.
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * content generator for the about scheme query offline page
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utils/errors.h"
+#include "utils/messages.h"
+#include "content/fetch.h"
+
+#include "private.h"
+#include "query.h"
+#include "query_offline.h"
+
+/**
+ * Handler to generate about scheme offline query page
+ *
+ * \param ctx The fetcher context.
+ * \return true if handled false if aborted.
+ */
+bool fetch_about_query_offline_handler(struct fetch_about_context *ctx)
+{
+	nserror res;
+	char *url_s;
+	size_t url_l;
+	const char *title;
+	struct nsurl *siteurl = NULL;
+	char *description = NULL;
+	const struct fetch_multipart_data *curmd; /* mutipart data iterator */
+
+	/* extract parameters from multipart post data */
+	curmd = fetch_about_get_multipart(ctx);
+	while (curmd != NULL) {
+		if (strcmp(curmd->name, "siteurl") == 0) {
+			res = nsurl_create(curmd->value, &siteurl);
+			if (res != NSERROR_OK) {
+				return fetch_about_srverror(ctx);
+			}
+		}
+		curmd = curmd->next;
+	}
+
+	if (siteurl == NULL) {
+		return fetch_about_srverror(ctx);
+	}
+
+	/* content is going to return ok */
+	fetch_about_set_http_code(ctx, 200);
+
+	/* content type */
+	if (fetch_about_send_header(ctx, "Content-Type: text/html; charset=utf-8")) {
+		goto fetch_about_query_offline_handler_aborted;
+	}
+
+	title = messages_get("OfflineTitle");
+	res = fetch_about_ssenddataf(ctx,
+			"<html>\n<head>\n"
+			"<title>%s</title>\n"
+			"<link rel=\"stylesheet\" type=\"text/css\" "
+			"href=\"resource:internal.css\">\n"
+			"</head>\n"
+			"<body class=\"ns-even-bg ns-even-fg ns-border\" id =\"offline\">\n"
+			"<h1 class=\"ns-border ns-odd-fg-bad\">%s</h1>\n",
+			title, title);
+	if (res != NSERROR_OK) {
+		goto fetch_about_query_offline_handler_aborted;
+	}
+
+	res = fetch_about_ssenddataf(ctx,
+			 "<form method=\"post\""
+			 " enctype=\"multipart/form-data\">");
+	if (res != NSERROR_OK) {
+		goto fetch_about_query_offline_handler_aborted;
+	}
+
+	res = get_query_description(siteurl,
+				    "OfflineDescription",
+				    &description);
+	if (res == NSERROR_OK) {
+		res = fetch_about_ssenddataf(ctx, "<div><p>%s</p></div>", description);
+		free(description);
+		if (res != NSERROR_OK) {
+			goto fetch_about_query_offline_handler_aborted;
+		}
+	}
+	res = fetch_about_ssenddataf(ctx,
+			 "<div id=\"buttons\">"
+			 "<input type=\"submit\" id=\"back\" name=\"back\" "
+			 "value=\"%s\" class=\"default-action\">"
+			 "<input type=\"submit\" id=\"retry\" name=\"retry\" "
+			 "value=\"%s\">"
+			 "</div>",
+			 messages_get("Backtoprevious"),
+			 messages_get("TryAgain"));
+	if (res != NSERROR_OK) {
+		goto fetch_about_query_offline_handler_aborted;
+	}
+
+	res = nsurl_get(siteurl, NSURL_COMPLETE, &url_s, &url_l);
+	if (res != NSERROR_OK) {
+		url_s = strdup("");
+	}
+	res = fetch_about_ssenddataf(ctx,
+			 "<input type=\"hidden\" name=\"siteurl\" value=\"%s\">",
+			 url_s);
+	free(url_s);
+	if (res != NSERROR_OK) {
+		goto fetch_about_query_offline_handler_aborted;
+	}
+
+	res = fetch_about_ssenddataf(ctx, "</form></body>\n</html>\n");
+	if (res != NSERROR_OK) {
+		goto fetch_about_query_offline_handler_aborted;
+	}
+
+	fetch_about_send_finished(ctx);
+
+	nsurl_unref(siteurl);
+
+	return true;
+
+fetch_about_query_offline_handler_aborted:
+	nsurl_unref(siteurl);
+
+	return false;
+}
@@ -42,6 +42,7 @@
 #include <time.h>
 #include <stdlib.h>
 #include <nsutils/unistd.h>
+#include <nsutils/time.h>
 
 #include "netsurf/inttypes.h"
 #include "utils/filepath.h"
@@ -239,6 +240,14 @@ struct store_state {
 	uint64_t hit_size; /**< size of storage served */
 	size_t miss_count; /**< number of cache misses */
 
+	size_t evict_runs; /**< number of eviction runs performed */
+	size_t evict_count; /**< number of entries evicted */
+	uint64_t evict_size; /**< size of evicted entries */
+
+	/** log2 millisecond histogram of read latencies */
+	unsigned int read_latency[LLCACHE_STORE_LATENCY_BUCKETS];
+	/** log2 millisecond histogram of write latencies */
+	unsigned int write_latency[LLCACHE_STORE_LATENCY_BUCKETS];
 };
 
 /**
@@ -249,6 +258,30 @@ struct store_state {
  */
 struct store_state *storestate;
 
+/**
+ * Record an operation duration in a latency histogram.
+ *
+ * @param histogram The histogram to update.
+ * @param startms The monotonic time in ms the operation started.
+ */
+static void
+record_latency(unsigned int *histogram, uint64_t startms)
+{
+	uint64_t endms = startms;
+	uint64_t elapsed;
+	unsigned int bucket = 0;
+
+	nsu_getmonotonic_ms(&endms);
+	elapsed = endms - startms;
+
+	while ((elapsed > 0) && (bucket < (LLCACHE_STORE_LATENCY_BUCKETS - 1))) {
+		elapsed = elapsed >> 1;
+		bucket++;
+	}
+
+	histogram[bucket]++;
+}
+
 /* Entries hashmap parameters
  *
  * Our hashmap has nsurl keys and store_entry values
@@ -625,6 +658,7 @@ static nserror store_evict(struct store_state *state)
 
 	/* evict entries in listed order */
 	removed = 0;
+	state->evict_runs++;
 	for (ent = 0; ent < estate.ent_count; ent++) {
 		struct store_entry *bse = estate.elist[ent];
 
@@ -636,6 +670,8 @@ static nserror store_evict(struct store_state *state)
 			break;
 		}
 
+		state->evict_count++;
+
 		if (removed > state->hysteresis) {
 			break;
 		}
@@ -643,6 +679,8 @@ static nserror store_evict(struct store_state *state)
 
 	free(estate.elist);
 
+	state->evict_size += removed;
+
 	NSLOG(netsurf, INFO,
 	      "removed %"PRIsizet" in %"PRIsizet" entries, %"PRIu64" remaining in %"PRIsizet" entries",
 	      removed, ent, state->total_alloc, old_count - ent);
@@ -1697,12 +1735,15 @@ store(nsurl *url,
 	nserror ret;
 	struct store_entry *bse;
 	int elem_idx;
+	uint64_t startms = 0;
 
 	/* check backing store is initialised */
 	if (storestate == NULL) {
 		return NSERROR_INIT_FAILED;
 	}
 
+	nsu_getmonotonic_ms(&startms);
+
 	/* calculate the entry element index */
 	if ((bsflags & BACKING_STORE_META) != 0) {
 		elem_idx = ENTRY_ELEM_META;
@@ -1725,6 +1766,10 @@ store(nsurl *url,
 		ret = store_write_file(storestate, bse, elem_idx);
 	}
 
+	if (ret == NSERROR_OK) {
+		record_latency(storestate->write_latency, startms);
+	}
+
 	return ret;
 }
 
@@ -1869,12 +1914,15 @@ fetch(nsurl *url,
 	struct store_entry *bse;
 	struct store_entry_element *elem;
 	int elem_idx;
+	uint64_t startms = 0;
 
 	/* check backing store is initialised */
 	if (storestate == NULL) {
 		return NSERROR_INIT_FAILED;
 	}
 
+	nsu_getmonotonic_ms(&startms);
+
 	/* fetch store entry */
 	ret = get_store_entry(storestate, url, &bse);
 	if (ret != NSERROR_OK) {
@@ -1925,6 +1973,10 @@ fetch(nsurl *url,
 		} else {
 			ret = store_read_file(storestate, bse, elem_idx);
 		}
+
+		if (ret == NSERROR_OK) {
+			record_latency(storestate->read_latency, startms);
+		}
 	}
 
 	/* free the allocation if there is a read error */
@@ -2017,6 +2069,42 @@ invalidate(nsurl *url)
 }
 
 
+/**
+ * Obtain backing store statistics.
+ *
+ * @param[out] stats_out The statistics structure to fill.
+ * @return NSERROR_OK on success or error code on failure.
+ */
+static nserror stats(struct llcache_store_stats *stats_out)
+{
+	/* check backing store is initialised */
+	if (storestate == NULL) {
+		return NSERROR_INIT_FAILED;
+	}
+
+	stats_out->limit = storestate->limit;
+	stats_out->total_alloc = storestate->total_alloc;
+	stats_out->entry_count = hashmap_count(storestate->entries);
+
+	stats_out->hit_count = storestate->hit_count;
+	stats_out->hit_size = storestate->hit_size;
+	stats_out->miss_count = storestate->miss_count;
+
+	stats_out->evict_runs = storestate->evict_runs;
+	stats_out->evict_count = storestate->evict_count;
+	stats_out->evict_size = storestate->evict_size;
+
+	memcpy(stats_out->read_latency,
+	       storestate->read_latency,
+	       sizeof(stats_out->read_latency));
+	memcpy(stats_out->write_latency,
+	       storestate->write_latency,
+	       sizeof(stats_out->write_latency));
+
+	return NSERROR_OK;
+}
+
+
 static struct gui_llcache_table llcache_table = {
 	.initialise = initialise,
 	.finalise = finalise,
@@ -2024,6 +2112,7 @@ static struct gui_llcache_table llcache_table = {
 	.fetch = fetch,
 	.invalidate = invalidate,
 	.release = release,
+	.stats = stats,
 };
 
 struct gui_llcache_table *filesystem_llcache_table = &llcache_table;
@@ -17,6 +17,8 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <strings.h>
 
@@ -260,6 +262,8 @@ css_select_results *nscss_get_style(nscss_select_ctx *ctx, dom_node *n,
 	int pseudo_element;
 	css_error error;
 
+	ctx->dependent = false;
+
 	/* Select style for node */
 	error = css_select_style(ctx->ctx, n, unit_len_ctx, media, inline_style,
 			&selection_handler, ctx, &styles);
@@ -357,10 +361,350 @@ css_computed_style *nscss_get_blank_style(nscss_select_ctx *ctx,
 	return composed;
 }
 
+/** Number of parents whose children are held in a sibling cache */
+#define NSCSS_SIBLING_CACHE_SIZE 16
+
+/**
+ * Position of an element amongst its element siblings
+ */
+struct nscss_sibling {
+	dom_node *node; /**< element */
+	lwc_string *name; /**< lower case element name while building */
+	int32_t index; /**< number of preceding element siblings */
+	int32_t name_index; /**< number of preceding siblings of the same name */
+	int32_t name_count; /**< number of siblings of the same name */
+};
+
+/**
+ * Element children of a parent node
+ */
+struct nscss_sibling_list {
+	dom_node *parent; /**< parent node, or NULL if unused */
+	uint32_t count; /**< number of element children */
+	struct nscss_sibling *child; /**< children ordered by node address */
+};
+
+/**
+ * Cache of the positions of elements amongst their siblings
+ */
+struct nscss_sibling_cache {
+	struct nscss_sibling_list list[NSCSS_SIBLING_CACHE_SIZE];
+};
+
+
+/**
+ * Empty a sibling list
+ *
+ * \param list  list to empty
+ */
+static void nscss_sibling_list_clear(struct nscss_sibling_list *list)
+{
+	uint32_t i;
+
+	if (list->parent == NULL) {
+		return;
+	}
+
+	for (i = 0; i != list->count; i++) {
+		if (list->child[i].name != NULL) {
+			lwc_string_unref(list->child[i].name);
+		}
+	}
+	free(list->child);
+	dom_node_unref(list->parent);
+
+	list->parent = NULL;
+	list->count = 0;
+	list->child = NULL;
+}
+
+
+/**
+ * Order siblings by name then by position
+ */
+static int nscss_sibling_cmp_name(const void *a, const void *b)
+{
+	const struct nscss_sibling *sa = a;
+	const struct nscss_sibling *sb = b;
+
+	if ((uintptr_t) sa->name != (uintptr_t) sb->name) {
+		return ((uintptr_t) sa->name < (uintptr_t) sb->name) ? -1 : 1;
+	}
+
+	return sa->index - sb->index;
+}
+
+
+/**
+ * Order siblings by node address
+ */
+static int nscss_sibling_cmp_node(const void *a, const void *b)
+{
+	const struct nscss_sibling *sa = a;
+	const struct nscss_sibling *sb = b;
+
+	if ((uintptr_t) sa->node == (uintptr_t) sb->node) {
+		return 0;
+	}
+
+	return ((uintptr_t) sa->node < (uintptr_t) sb->node) ? -1 : 1;
+}
+
+
+/**
+ * Add an element to a sibling list which is being built
+ *
+ * \param list   list to add to
+ * \param alloc  number of entries allocated, updated on growth
+ * \param node   element to add
+ * \return true on success, false on failure
+ */
+static bool
+nscss_sibling_list_append(struct nscss_sibling_list *list,
+			  uint32_t *alloc,
+			  dom_node *node)
+{
+	struct nscss_sibling *child;
+	dom_string *name;
+	lwc_string *lname;
+	lwc_error lerror;
+	dom_exception exc;
+
+	if (list->count == *alloc) {
+		uint32_t nalloc = (*alloc == 0) ? 64 : *alloc * 2;
+
+		child = realloc(list->child, nalloc * sizeof(*child));
+		if (child == NULL) {
+			return false;
+		}
+		list->child = child;
+		*alloc = nalloc;
+	}
+
+	child = &list->child[list->count];
+	child->node = node;
+	child->name = NULL;
+	child->index = list->count;
+	list->count++;
+
+	exc = dom_node_get_node_name(node, &name);
+	if (exc != DOM_NO_ERR || name == NULL) {
+		return false;
+	}
+
+	exc = dom_string_intern(name, &lname);
+	dom_string_unref(name);
+	if (exc != DOM_NO_ERR) {
+		return false;
+	}
+
+	/* siblings of the same name are matched caselessly */
+	lerror = lwc_string_tolower(lname, &child->name);
+	lwc_string_unref(lname);
+	if (lerror != lwc_error_ok) {
+		child->name = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * Build the list of the element children of a node
+ *
+ * \param list    list to build
+ * \param parent  node whose children to list
+ * \return true on success, false on failure leaving the list empty
+ */
+static bool
+nscss_sibling_list_build(struct nscss_sibling_list *list, dom_node *parent)
+{
+	dom_node *node, *next;
+	dom_node_type type;
+	dom_exception exc;
+	uint32_t alloc = 0;
+	uint32_t run, i, j;
+
+	nscss_sibling_list_clear(list);
+	list->parent = dom_node_ref(parent);
+
+	exc = dom_node_get_first_child(parent, &node);
+	if (exc != DOM_NO_ERR) {
+		nscss_sibling_list_clear(list);
+		return false;
+	}
+
+	while (node != NULL) {
+		exc = dom_node_get_node_type(node, &type);
+		if (exc != DOM_NO_ERR ||
+		    (type == DOM_ELEMENT_NODE &&
+		     !nscss_sibling_list_append(list, &alloc, node))) {
+			dom_node_unref(node);
+			nscss_sibling_list_clear(list);
+			return false;
+		}
+
+		exc = dom_node_get_next_sibling(node, &next);
+		dom_node_unref(node);
+		if (exc != DOM_NO_ERR) {
+			nscss_sibling_list_clear(list);
+			return false;
+		}
+		node = next;
+	}
+
+	if (list->count == 0) {
+		return true;
+	}
+
+	/* number the siblings of each name */
+	qsort(list->child, list->count, sizeof(*list->child),
+			nscss_sibling_cmp_name);
+	for (run = 0; run != list->count; run = i) {
+		for (i = run; i != list->count; i++) {
+			if (list->child[i].name != list->child[run].name) {
+				break;
+			}
+		}
+		for (j = run; j != i; j++) {
+			list->child[j].name_index = j - run;
+			list->child[j].name_count = i - run;
+		}
+	}
+
+	for (i = 0; i != list->count; i++) {
+		lwc_string_unref(list->child[i].name);
+		list->child[i].name = NULL;
+	}
+
+	qsort(list->child, list->count, sizeof(*list->child),
+			nscss_sibling_cmp_node);
+
+	return true;
+}
+
+
+/**
+ * Count the siblings of an element using a sibling cache
+ *
+ * \param cache      sibling cache
+ * \param node       element whose siblings to count
+ * \param same_name  only count siblings with the same name
+ * \param after      count following instead of preceding siblings
+ * \param count      updated with the number of siblings
+ * \return true if the siblings were counted, false if they must be
+ *         counted by walking the document
+ */
+static bool
+nscss_sibling_cache_count(struct nscss_sibling_cache *cache,
+			  dom_node *node,
+			  bool same_name,
+			  bool after,
+			  int32_t *count)
+{
+	struct nscss_sibling_list *list;
+	const struct nscss_sibling *child;
+	struct nscss_sibling key;
+	dom_node *parent;
+	dom_exception exc;
+
+	exc = dom_node_get_parent_node(node, &parent);
+	if (exc != DOM_NO_ERR || parent == NULL) {
+		return false;
+	}
+
+	list = &cache->list[((uintptr_t) parent >> 4) %
+			    NSCSS_SIBLING_CACHE_SIZE];
+	if (list->parent != parent &&
+	    !nscss_sibling_list_build(list, parent)) {
+		dom_node_unref(parent);
+		return false;
+	}
+	dom_node_unref(parent);
+
+	key.node = node;
+	child = bsearch(&key, list->child, list->count, sizeof(*list->child),
+			nscss_sibling_cmp_node);
+	if (child == NULL) {
+		return false;
+	}
+
+	if (same_name) {
+		*count = after ?
+			child->name_count - child->name_index - 1 :
+			child->name_index;
+	} else {
+		*count = after ?
+			(int32_t) list->count - child->index - 1 :
+			child->index;
+	}
+
+	return true;
+}
+
+
+/* exported interface documented in css/select.h */
+struct nscss_sibling_cache *nscss_sibling_cache_create(void)
+{
+	return calloc(1, sizeof(struct nscss_sibling_cache));
+}
+
+
+/* exported interface documented in css/select.h */
+void nscss_sibling_cache_destroy(struct nscss_sibling_cache *cache)
+{
+	unsigned int i;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	for (i = 0; i != NSCSS_SIBLING_CACHE_SIZE; i++) {
+		nscss_sibling_list_clear(&cache->list[i]);
+	}
+	free(cache);
+}
+
+
+/* exported interface documented in css/select.h */
+void nscss_sibling_cache_invalidate(struct nscss_sibling_cache *cache,
+		dom_node *parent)
+{
+	struct nscss_sibling_list *list;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	list = &cache->list[((uintptr_t) parent >> 4) %
+			    NSCSS_SIBLING_CACHE_SIZE];
+	if (list->parent == parent) {
+		nscss_sibling_list_clear(list);
+	}
+}
+
 /******************************************************************************
  * Style selection callbacks                                                  *
  ******************************************************************************/
 
+/**
+ * Record that the style being selected depends on more than the
+ * element's name, classes and ancestors.
+ *
+ * Such styles may not be shared with similar sibling elements.
+ *
+ * \param pw  Selection context, or NULL
+ */
+static inline void nscss_select_depends(void *pw)
+{
+	nscss_select_ctx *ctx = pw;
+
+	if (ctx != NULL) {
+		ctx->dependent = true;
+	}
+}
+
 /**
  * Callback to retrieve a node's name.
  *
@@ -515,6 +859,8 @@ css_error named_sibling_node(void *pw, void *node,
 	dom_node *prev;
 	dom_exception err;
 
+	nscss_select_depends(pw);
+
 	*sibling = NULL;
 
 	/* Find sibling element */
@@ -583,6 +929,8 @@ css_error named_generic_sibling_node(void *pw, void *node,
 	dom_node *prev;
 	dom_exception err;
 
+	nscss_select_depends(pw);
+
 	*sibling = NULL;
 
 	err = dom_node_get_previous_sibling(n, &n);
@@ -662,6 +1010,8 @@ css_error sibling_node(void *pw, void *node, void **sibling)
 	dom_node *prev;
 	dom_exception err;
 
+	nscss_select_depends(pw);
+
 	*sibling = NULL;
 
 	/* Find sibling element */
@@ -815,6 +1165,8 @@ css_error node_has_attribute(void *pw, void *node,
 	dom_string *name;
 	dom_exception err;
 
+	nscss_select_depends(pw);
+
 	err = dom_string_create_interned(
 			(const uint8_t *) lwc_string_data(qname->name),
 			lwc_string_length(qname->name), &name);
@@ -856,6 +1208,8 @@ css_error node_has_attribute_equal(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	nscss_select_depends(pw);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -908,6 +1262,8 @@ css_error node_has_attribute_dashmatch(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	nscss_select_depends(pw);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -975,6 +1331,8 @@ css_error node_has_attribute_includes(void *pw, void *node,
 	const char *start;
 	const char *end;
 
+	nscss_select_depends(pw);
+
 	*match = false;
 
 	if (vlen == 0) {
@@ -1044,6 +1402,8 @@ css_error node_has_attribute_prefix(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	nscss_select_depends(pw);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1108,6 +1468,8 @@ css_error node_has_attribute_suffix(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	nscss_select_depends(pw);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1176,6 +1538,8 @@ css_error node_has_attribute_substring(void *pw, void *node,
 
 	size_t vlen = lwc_string_length(value);
 
+	nscss_select_depends(pw);
+
 	if (vlen == 0) {
 		*match = false;
 		return CSS_OK;
@@ -1316,10 +1680,19 @@ node_count_siblings_check(dom_node *node,
 css_error node_count_siblings(void *pw, void *n, bool same_name,
 		bool after, int32_t *count)
 {
+	nscss_select_ctx *ctx = pw;
 	int32_t cnt = 0;
 	dom_exception exc;
 	dom_string *node_name = NULL;
 
+	nscss_select_depends(pw);
+
+	if (ctx != NULL && ctx->siblings != NULL &&
+	    nscss_sibling_cache_count(ctx->siblings, n, same_name, after,
+			    count)) {
+		return CSS_OK;
+	}
+
 	if (same_name) {
 		dom_node *node = n;
 		exc = dom_node_get_node_name(node, &node_name);
@@ -1382,6 +1755,8 @@ css_error node_is_empty(void *pw, void *node, bool *match)
 	dom_node *n = node, *next;
 	dom_exception err;
 
+	nscss_select_depends(pw);
+
 	*match = true;
 
 	err = dom_node_get_first_child(n, &n);
@@ -1432,6 +1807,8 @@ css_error node_is_link(void *pw, void *n, bool *match)
 	dom_exception exc;
 	dom_string *node_name = NULL;
 
+	nscss_select_depends(pw);
+
 	exc = dom_node_get_node_name(node, &node_name);
 	if ((exc != DOM_NO_ERR) || (node_name == NULL)) {
 		return CSS_NOMEM;
@@ -1476,6 +1853,8 @@ css_error node_is_visited(void *pw, void *node, bool *match)
 	dom_node *n = node;
 	dom_string *s = NULL;
 
+	nscss_select_depends(pw);
+
 	*match = false;
 
 	exc = dom_node_get_node_name(n, &s);
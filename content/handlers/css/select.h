@@ -27,6 +27,7 @@
 
 struct content;
 struct nsurl;
+struct nscss_sibling_cache;
 
 /**
  * Selection context
@@ -39,6 +40,11 @@ typedef struct nscss_select_ctx
 	lwc_string *universal;
 	const css_computed_style *root_style;
 	const css_computed_style *parent_style;
+	/** Set by selection when the style depends on more than the
+	 *  element's name, classes and ancestors */
+	bool dependent;
+	/** Cache of element sibling positions, or NULL */
+	struct nscss_sibling_cache *siblings;
 } nscss_select_ctx;
 
 css_stylesheet *nscss_create_inline_style(const uint8_t *data, size_t len,
@@ -53,6 +59,34 @@ css_computed_style *nscss_get_blank_style(nscss_select_ctx *ctx,
 		const css_unit_ctx *unit_len_ctx,
 		const css_computed_style *parent);
 
+/**
+ * Create a cache of element sibling positions.
+ *
+ * Selection for structural pseudo classes such as :nth-child() uses
+ * the cache to count the siblings of elements without walking the
+ * document. The cache must be invalidated whenever the children of a
+ * node change.
+ *
+ * \return the new cache or NULL on memory exhaustion
+ */
+struct nscss_sibling_cache *nscss_sibling_cache_create(void);
+
+/**
+ * Destroy a cache of element sibling positions.
+ *
+ * \param cache  cache to destroy, may be NULL
+ */
+void nscss_sibling_cache_destroy(struct nscss_sibling_cache *cache);
+
+/**
+ * Discard the cached positions of the children of a node.
+ *
+ * \param cache   cache to invalidate, may be NULL
+ * \param parent  node whose children have changed
+ */
+void nscss_sibling_cache_invalidate(struct nscss_sibling_cache *cache,
+		dom_node *parent);
+
 
 css_error named_ancestor_node(void *pw, void *node,
 		const css_qname *qname, void **ancestor);
@@ -41,6 +41,8 @@ struct nsurl;
 struct dom_node;
 struct dom_string;
 struct rect;
+struct box_child_index;
+struct float_index;
 
 #define UNKNOWN_WIDTH INT_MAX
 #define UNKNOWN_MAX_WIDTH INT_MAX
@@ -86,7 +88,11 @@ typedef enum {
 	REPLACE_DIM = 1 << 9,	/* replaced element has given dimensions */
 	IFRAME      = 1 << 10,	/* box contains an iframe */
 	CONVERT_CHILDREN = 1 << 11,  /* wanted children converting */
-	IS_REPLACED = 1 << 12	/* box is a replaced element */
+	IS_REPLACED = 1 << 12,	/* box is a replaced element */
+	NEED_LAYOUT = 1 << 13,	/* box or a descendant needs layout */
+	HAS_POSITIONED = 1 << 14, /* box has positioned descendants */
+	STYLES_SHARED = 1 << 15, /* styles are shared and owned by the arena */
+	NORMALISED  = 1 << 16	/* box is complete and has been normalised */
 } box_flags;
 
 
@@ -144,6 +150,60 @@ struct column {
 };
 
 
+/**
+ * Record of the previous layout of a box.
+ *
+ * Block formatting context boxes and inline containers whose layout
+ * inputs are unchanged since this record was made, and which are not
+ * flagged as needing layout, keep their previous layout.
+ */
+struct box_layout_cache {
+	/**
+	 * Available width at last layout, or UNKNOWN_WIDTH if the box
+	 *  has not been laid out.
+	 */
+	int width;
+
+	/**
+	 * Height on entry to the last layout (may be AUTO).
+	 */
+	int height;
+
+	/**
+	 * Viewport height at last layout.
+	 */
+	int viewport_height;
+
+	/**
+	 * Top and left padding at last layout.
+	 */
+	int padding_top;
+	int padding_left;
+
+	/**
+	 * Resulting width and content height.
+	 */
+	int result_width;
+	int result_height;
+
+	/**
+	 * Float children placed by the last layout.
+	 */
+	struct box *float_children;
+
+	/**
+	 * Vertical offset applied to the children since the last layout,
+	 *  e.g. by table cell vertical alignment.
+	 */
+	int offset_y;
+
+	/**
+	 * Whether the layout was independent of the surrounding floats.
+	 */
+	bool reusable;
+};
+
+
 /**
  * Linked list of object element parameters.
  */
@@ -169,6 +229,46 @@ struct object_params {
 };
 
 
+/**
+ * Box properties which only a few boxes have.
+ *
+ * These are kept out of struct box so the fields walked by layout and
+ * redraw pack into fewer cache lines. Boxes without any of them share
+ * a single empty record.
+ */
+struct box_extra {
+	/**
+	 * Array of table column data for TABLE only.
+	 */
+	struct column *col;
+
+	/**
+	 * List marker box if this is a list-item, or NULL.
+	 */
+	struct box *list_marker;
+
+	/**
+	 * Form control data, or NULL if not a form control.
+	 */
+	struct form_control* gadget;
+
+	/**
+	 * (Image)map to use with this object, or NULL if none
+	 */
+	char *usemap;
+
+	/**
+	 * Parameters for the object, or NULL.
+	 */
+	struct object_params *object_params;
+
+	/**
+	 * Iframe's browser_window, or NULL if none
+	 */
+	struct browser_window *iframe;
+};
+
+
 /**
  * Node in box tree. All dimensions are in pixels.
  */
@@ -258,6 +358,16 @@ struct box {
 	 */
 	struct box *float_container;
 
+	/**
+	 * Spatial index of in-flow children, or NULL if not indexed.
+	 */
+	struct box_child_index *child_index;
+
+	/**
+	 * Index of float_children by vertical position, or NULL.
+	 */
+	struct float_index *float_index;
+
 	/**
 	 * Level below which subsequent floats must be cleared.  This
 	 * is used only for boxes with float_children
@@ -346,6 +456,11 @@ struct box {
 	 */
 	int max_width;
 
+	/**
+	 * Previous layout of this box.
+	 */
+	struct box_layout_cache layout_cache;
+
 
 	/**
 	 * Text, or NULL if none. Unterminated.
@@ -399,34 +514,11 @@ struct box {
 	 */
 	unsigned int start_column;
 
-	/**
-	 * Array of table column data for TABLE only.
-	 */
-	struct column *col;
-
 	/**
 	 * List item value.
 	 */
 	int list_value;
 
-	/**
-	 * List marker box if this is a list-item, or NULL.
-	 */
-	struct box *list_marker;
-
-
-	/**
-	 * Form control data, or NULL if not a form control.
-	 */
-	struct form_control* gadget;
-
-
-	/**
-	 * (Image)map to use with this object, or NULL if none
-	 */
-	char *usemap;
-
-
 	/**
 	 * Background image for this box, or NULL if none
 	 */
@@ -439,16 +531,9 @@ struct box {
 	struct hlcache_handle* object;
 
 	/**
-	 * Parameters for the object, or NULL.
+	 * Rarely used properties, never NULL.
 	 */
-	struct object_params *object_params;
-
-
-	/**
-	 * Iframe's browser_window, or NULL if none
-	 */
-	struct browser_window *iframe;
-
+	const struct box_extra *extra;
 };
 
 
@@ -27,14 +27,17 @@
 
 #include <string.h>
 #include <dom/dom.h>
+#include <nsutils/time.h>
 
 #include "utils/errors.h"
+#include "utils/log.h"
 #include "utils/nsoption.h"
 #include "utils/corestrings.h"
 #include "utils/talloc.h"
 #include "utils/string.h"
 #include "utils/ascii.h"
 #include "utils/nsurl.h"
+#include "utils/sys_time.h"
 #include "netsurf/misc.h"
 #include "css/select.h"
 #include "desktop/gui_internal.h"
@@ -48,6 +51,26 @@
 #include "html/box_normalise.h"
 #include "html/form_internal.h"
 
+/** Number of entries in the style sharing cache */
+#define STYLE_SHARE_CACHE_SIZE 64
+
+/**
+ * Entry in the style sharing cache
+ *
+ * Holds the selection results of an element whose style depended only
+ * on its name, classes and ancestors. Later siblings with the same name
+ * and classes, and no other attributes, use the results without
+ * selection.
+ */
+struct box_style_share {
+	dom_node *parent;		/**< Parent node, or NULL if unused */
+	const css_computed_style *parent_style; /**< Style inherited from */
+	dom_html_element_type tag_type;	/**< Element type */
+	lwc_string **classes;		/**< Element classes */
+	uint32_t n_classes;		/**< Number of element classes */
+	css_select_results *styles;	/**< Results, owned by the box arena */
+};
+
 /**
  * Context for box tree construction
  */
@@ -56,11 +79,24 @@ struct box_construct_ctx {
 
 	dom_node *n;			/**< Current node to process */
 
+	bool advance;			/**< Whether n has been converted */
+	bool convert_children;		/**< Whether to visit children of n */
+	bool progressive;		/**< Whether the parse is incomplete */
+
 	struct box *root_box;		/**< Root box in the tree */
 
 	box_construct_complete_cb cb;	/**< Callback to invoke on completion */
 
-	int *bctx;			/**< talloc context */
+	struct box_arena *bctx;		/**< box arena and talloc context */
+
+	unsigned int slice_count;	/**< Number of conversion slices */
+	unsigned int slice_max;		/**< Longest slice in ms */
+
+	/** Recently selected styles which may be shared */
+	struct box_style_share share[STYLE_SHARE_CACHE_SIZE];
+	unsigned int style_count;	/**< Number of element styles obtained */
+	unsigned int style_shared;	/**< Number of styles from the cache */
+	struct timeval style_time;	/**< Time spent obtaining styles */
 };
 
 /**
@@ -234,19 +270,22 @@ box_extract_properties(dom_node *n, struct box_construct_props *props)
 
 
 /**
- * Get the style for an element.
+ * Select the style for an element.
  *
  * \param  c               content of type CONTENT_HTML that is being processed
  * \param  parent_style    style at this point in xml tree, or NULL for root
  * \param  root_style      root node's style, or NULL for root
  * \param  n               node in xml tree
+ * \param  dependent       updated to whether the style depends on more than
+ *                         the element's name, classes and ancestors
  * \return  the new style, or NULL on memory exhaustion
  */
 static css_select_results *
-box_get_style(html_content *c,
-	      const css_computed_style *parent_style,
-	      const css_computed_style *root_style,
-	      dom_node *n)
+box_select_style(html_content *c,
+		 const css_computed_style *parent_style,
+		 const css_computed_style *root_style,
+		 dom_node *n,
+		 bool *dependent)
 {
 	dom_string *s;
 	dom_exception err;
@@ -280,11 +319,14 @@ box_get_style(html_content *c,
 	ctx.universal = c->universal;
 	ctx.root_style = root_style;
 	ctx.parent_style = parent_style;
+	ctx.siblings = c->sibling_cache;
 
 	/* Select style for element */
 	styles = nscss_get_style(&ctx, n, &c->media, &c->unit_len_ctx,
 			inline_style);
 
+	*dependent = ctx.dependent || (inline_style != NULL);
+
 	/* No longer need inline style */
 	if (inline_style != NULL)
 		css_stylesheet_destroy(inline_style);
@@ -293,6 +335,229 @@ box_get_style(html_content *c,
 }
 
 
+/**
+ * Release the references held by a style sharing cache entry.
+ *
+ * \param entry  entry to empty
+ */
+static void box_style_share_clear(struct box_style_share *entry)
+{
+	uint32_t i;
+
+	if (entry->parent == NULL) {
+		return;
+	}
+
+	for (i = 0; i != entry->n_classes; i++) {
+		lwc_string_unref(entry->classes[i]);
+	}
+	free(entry->classes);
+	dom_node_unref(entry->parent);
+
+	entry->parent = NULL;
+	entry->classes = NULL;
+	entry->n_classes = 0;
+	entry->styles = NULL;
+}
+
+
+/**
+ * Construct the style sharing cache key for an element.
+ *
+ * Only elements of a known type whose only attribute, if any, is class
+ * may share styles; any other attribute may affect selection through
+ * presentational hints.
+ *
+ * \param  n             element to construct key for
+ * \param  parent_style  style the element inherits from
+ * \param  key           updated to the key, which holds references
+ * \return  true if the element may share styles, else false
+ */
+static bool
+box_style_share_key(dom_node *n,
+		    const css_computed_style *parent_style,
+		    struct box_style_share *key)
+{
+	dom_namednodemap *attrs;
+	uint32_t num_attrs;
+	bool has_attrs;
+	bool has_class;
+	dom_exception err;
+
+	err = dom_html_element_get_tag_type(n, &key->tag_type);
+	if (err != DOM_NO_ERR ||
+	    key->tag_type == DOM_HTML_ELEMENT_TYPE__UNKNOWN) {
+		return false;
+	}
+
+	err = dom_node_has_attributes(n, &has_attrs);
+	if (err != DOM_NO_ERR) {
+		return false;
+	}
+
+	if (has_attrs) {
+		err = dom_node_get_attributes(n, &attrs);
+		if (err != DOM_NO_ERR || attrs == NULL) {
+			return false;
+		}
+
+		err = dom_namednodemap_get_length(attrs, &num_attrs);
+		dom_namednodemap_unref(attrs);
+		if (err != DOM_NO_ERR || num_attrs != 1) {
+			return false;
+		}
+
+		err = dom_element_has_attribute(n, corestring_dom_class,
+				&has_class);
+		if (err != DOM_NO_ERR || has_class == false) {
+			return false;
+		}
+	}
+
+	err = dom_node_get_parent_node(n, &key->parent);
+	if (err != DOM_NO_ERR || key->parent == NULL) {
+		return false;
+	}
+
+	key->classes = NULL;
+	key->n_classes = 0;
+	err = dom_element_get_classes(n, &key->classes, &key->n_classes);
+	if (err != DOM_NO_ERR) {
+		dom_node_unref(key->parent);
+		key->parent = NULL;
+		return false;
+	}
+
+	key->parent_style = parent_style;
+	key->styles = NULL;
+
+	return true;
+}
+
+
+/**
+ * Find the style sharing cache entry for a key.
+ *
+ * \param  ctx  tree construction context
+ * \param  key  key to find entry for
+ * \return  the entry the key belongs in, which may hold another key
+ */
+static struct box_style_share *
+box_style_share_find(struct box_construct_ctx *ctx,
+		     const struct box_style_share *key)
+{
+	uintptr_t hash;
+
+	hash = (uintptr_t) key->parent >> 4;
+	hash = hash * 31 + key->tag_type;
+	if (key->n_classes > 0) {
+		hash = hash * 31 + lwc_string_hash_value(key->classes[0]);
+	}
+
+	return &ctx->share[hash % STYLE_SHARE_CACHE_SIZE];
+}
+
+
+/**
+ * Determine if a style sharing cache entry holds a key.
+ *
+ * \param  entry  entry to check
+ * \param  key    key to check for
+ * \return  true if the entry's styles may be used for the key
+ */
+static bool
+box_style_share_match(const struct box_style_share *entry,
+		      const struct box_style_share *key)
+{
+	uint32_t i;
+	bool match;
+
+	if (entry->parent != key->parent ||
+	    entry->parent_style != key->parent_style ||
+	    entry->tag_type != key->tag_type ||
+	    entry->n_classes != key->n_classes) {
+		return false;
+	}
+
+	for (i = 0; i != key->n_classes; i++) {
+		if (lwc_string_isequal(entry->classes[i], key->classes[i],
+				&match) != lwc_error_ok || match == false) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * Get the style for an element.
+ *
+ * The style of an element is shared with an earlier sibling of the
+ * same type and classes whose selection did not depend on anything
+ * else. Shared results are owned by the box arena.
+ *
+ * \param  ctx           tree construction context
+ * \param  parent_style  style at this point in xml tree, or NULL for root
+ * \param  root_style    root node's style, or NULL for root
+ * \param  shared        updated to whether the results are shared
+ * \return  the new style, or NULL on memory exhaustion
+ */
+static css_select_results *
+box_get_style(struct box_construct_ctx *ctx,
+	      const css_computed_style *parent_style,
+	      const css_computed_style *root_style,
+	      bool *shared)
+{
+	struct box_style_share key;
+	struct box_style_share *entry = NULL;
+	css_select_results *styles = NULL;
+	struct timeval start, end, elapsed;
+	bool dependent;
+
+	gettimeofday(&start, NULL);
+
+	*shared = false;
+
+	if (parent_style != NULL &&
+	    box_style_share_key(ctx->n, parent_style, &key)) {
+		entry = box_style_share_find(ctx, &key);
+		if (box_style_share_match(entry, &key)) {
+			styles = entry->styles;
+			*shared = true;
+			ctx->style_shared++;
+			box_style_share_clear(&key);
+			entry = NULL;
+		}
+	}
+
+	if (styles == NULL) {
+		styles = box_select_style(ctx->content, parent_style,
+				root_style, ctx->n, &dependent);
+
+		if (entry != NULL) {
+			if (styles != NULL && dependent == false &&
+			    box_arena_share_styles(ctx->bctx,
+					    styles) == NSERROR_OK) {
+				box_style_share_clear(entry);
+				*entry = key;
+				entry->styles = styles;
+				*shared = true;
+			} else {
+				box_style_share_clear(&key);
+			}
+		}
+	}
+
+	gettimeofday(&end, NULL);
+	timersub(&end, &start, &elapsed);
+	timeradd(&ctx->style_time, &elapsed, &ctx->style_time);
+	ctx->style_count++;
+
+	return styles;
+}
+
+
 /**
  * Construct the box required for a generated element.
  *
@@ -365,6 +630,7 @@ box_construct_marker(struct box *box,
 		     struct box_construct_ctx *ctx,
 		     struct box *parent)
 {
+	struct box_extra *extra;
 	lwc_string *image_uri;
 	struct box *marker;
 	enum css_list_style_type_e list_style_type;
@@ -432,7 +698,10 @@ box_construct_marker(struct box *box,
 		nsurl_unref(url);
 	}
 
-	box->list_marker = marker;
+	extra = box_extra(box);
+	if (extra == NULL)
+		return false;
+	extra->list_marker = marker;
 	marker->parent = box;
 
 	return true;
@@ -457,6 +726,7 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 	dom_exception err;
 	struct box_construct_props props;
 	const css_computed_style *root_style = NULL;
+	bool shared_styles;
 
 	assert(ctx->n != NULL);
 
@@ -473,8 +743,8 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 		root_style = ctx->root_box->style;
 	}
 
-	styles = box_get_style(ctx->content, props.parent_style, root_style,
-			ctx->n);
+	styles = box_get_style(ctx, props.parent_style, root_style,
+			&shared_styles);
 	if (styles == NULL)
 		return false;
 
@@ -518,6 +788,9 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 	if (box == NULL)
 		return false;
 
+	if (shared_styles)
+		box->flags |= STYLES_SHARED;
+
 	/* If this is the root box, add it to the context */
 	if (props.node_is_root)
 		ctx->root_box = box;
@@ -581,6 +854,11 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 		return false;
 	}
 
+	/* Index the id once special elements, which may replace it, have
+	 * been handled */
+	if (box->id != NULL && box_arena_add_id(ctx->bctx, box) != NSERROR_OK)
+		return false;
+
 	/* Handle the :before pseudo element */
 	if (!(box->flags & IS_REPLACED)) {
 		box_construct_generate(ctx->n, ctx->content, box,
@@ -591,14 +869,16 @@ box_construct_element(struct box_construct_ctx *ctx, bool *convert_children)
 	    (ns_computed_display(box->style,
 				 props.node_is_root) == CSS_DISPLAY_NONE &&
 	     props.node_is_root == false)) {
-		css_select_results_destroy(styles);
+		if (!shared_styles)
+			css_select_results_destroy(styles);
 		box->styles = NULL;
 		box->style = NULL;
 
 		/* Invalidate associated gadget, if any */
-		if (box->gadget != NULL) {
-			box->gadget->box = NULL;
-			box->gadget = NULL;
+		if (box->extra->gadget != NULL) {
+			box->extra->gadget->box = NULL;
+			/* the box has its own record so this cannot fail */
+			box_extra(box)->gadget = NULL;
 		}
 
 		/* Can't do this, because the lifetimes of boxes and gadgets
@@ -905,6 +1185,222 @@ next_node(dom_node *n, html_content *content, bool convert_children)
 }
 
 
+/**
+ * Find the node next_node() would move to, without leaving any nodes.
+ *
+ * \param n                 Current node
+ * \param convert_children  Whether to consider children of \a n
+ * \return Next node to process (referenced), or NULL if there is none yet
+ */
+static dom_node *peek_next_node(dom_node *n, bool convert_children)
+{
+	dom_node *node;
+	dom_node *next = NULL;
+	dom_node *parent = NULL;
+	dom_exception err;
+
+	if (convert_children) {
+		err = dom_node_get_first_child(n, &next);
+		if (err != DOM_NO_ERR) {
+			return NULL;
+		}
+		if (next != NULL) {
+			return next;
+		}
+	}
+
+	node = dom_node_ref(n);
+	while (node != NULL) {
+		err = dom_node_get_next_sibling(node, &next);
+		if ((err != DOM_NO_ERR) || (next != NULL) ||
+				box_is_root(node)) {
+			break;
+		}
+
+		err = dom_node_get_parent_node(node, &parent);
+		if (err != DOM_NO_ERR) {
+			break;
+		}
+		dom_node_unref(node);
+		node = parent;
+	}
+
+	if (node != NULL) {
+		dom_node_unref(node);
+	}
+
+	return next;
+}
+
+
+/**
+ * Determine whether the parser may still add to a node.
+ *
+ * The parser appends to the elements it has open, which are the last
+ * node in the document and its ancestors.  A node with a following
+ * sibling, or with an ancestor that has one, is complete.
+ *
+ * \param n  Node to examine
+ * \return true if \a n may still change, else false
+ */
+static bool box_construct_node_open(dom_node *n)
+{
+	dom_node *node = dom_node_ref(n);
+	dom_node *next = NULL;
+	dom_node *parent = NULL;
+	dom_exception err;
+
+	while (node != NULL) {
+		err = dom_node_get_next_sibling(node, &next);
+		if (err != DOM_NO_ERR) {
+			dom_node_unref(node);
+			return true;
+		}
+		if (next != NULL) {
+			dom_node_unref(next);
+			dom_node_unref(node);
+			return false;
+		}
+
+		err = dom_node_get_parent_node(node, &parent);
+		dom_node_unref(node);
+		if (err != DOM_NO_ERR) {
+			return true;
+		}
+		node = parent;
+	}
+
+	return true;
+}
+
+
+/**
+ * Determine whether a node may be converted before the parse completes.
+ *
+ * \param n     Node which would be converted next
+ * \param type  DOM node type of \a n
+ * \return true if \a n may be converted now, false to wait for the parser
+ */
+static bool box_construct_node_ready(dom_node *n, dom_node_type type)
+{
+	dom_html_element_type tag_type;
+	dom_node *next = NULL;
+	dom_exception exc;
+	bool ready = true;
+
+	if (type == DOM_TEXT_NODE) {
+		/* Text is added to the last text node in an open element,
+		 * or to one directly before an open table when fostering
+		 * content misplaced within the table. */
+		if (box_construct_node_open(n)) {
+			return false;
+		}
+
+		exc = dom_node_get_next_sibling(n, &next);
+		if (exc != DOM_NO_ERR || next == NULL) {
+			return exc == DOM_NO_ERR;
+		}
+
+		exc = dom_node_get_node_type(next, &type);
+		if (exc == DOM_NO_ERR && type == DOM_ELEMENT_NODE) {
+			exc = dom_html_element_get_tag_type(next, &tag_type);
+			if (exc == DOM_NO_ERR &&
+					tag_type == DOM_HTML_ELEMENT_TYPE_TABLE) {
+				ready = !box_construct_node_open(next);
+			}
+		}
+		dom_node_unref(next);
+
+		return ready;
+	}
+
+	if (type != DOM_ELEMENT_NODE) {
+		return true;
+	}
+
+	exc = dom_html_element_get_tag_type(n, &tag_type);
+	if (exc != DOM_NO_ERR) {
+		tag_type = DOM_HTML_ELEMENT_TYPE__UNKNOWN;
+	}
+
+	switch (tag_type) {
+	case DOM_HTML_ELEMENT_TYPE_BUTTON:
+	case DOM_HTML_ELEMENT_TYPE_INPUT:
+	case DOM_HTML_ELEMENT_TYPE_SELECT:
+	case DOM_HTML_ELEMENT_TYPE_TEXTAREA:
+		/* Gadgets belong to forms, which are only found
+		 * once the parse completes. */
+	case DOM_HTML_ELEMENT_TYPE_IFRAME:
+		/* Iframe windows are created from the complete list. */
+		ready = false;
+		break;
+
+	case DOM_HTML_ELEMENT_TYPE_A:
+	case DOM_HTML_ELEMENT_TYPE_B:
+	case DOM_HTML_ELEMENT_TYPE_BIG:
+	case DOM_HTML_ELEMENT_TYPE_CODE:
+	case DOM_HTML_ELEMENT_TYPE_EM:
+	case DOM_HTML_ELEMENT_TYPE_FONT:
+	case DOM_HTML_ELEMENT_TYPE_I:
+	case DOM_HTML_ELEMENT_TYPE_NOBR:
+	case DOM_HTML_ELEMENT_TYPE_S:
+	case DOM_HTML_ELEMENT_TYPE_SMALL:
+	case DOM_HTML_ELEMENT_TYPE_STRIKE:
+	case DOM_HTML_ELEMENT_TYPE_STRONG:
+	case DOM_HTML_ELEMENT_TYPE_TT:
+	case DOM_HTML_ELEMENT_TYPE_U:
+		/* The parser may move the content of open formatting
+		 * elements when they are closed out of order. */
+	case DOM_HTML_ELEMENT_TYPE_TABLE:
+		/* Misplaced table content is inserted before the table. */
+	case DOM_HTML_ELEMENT_TYPE_OBJECT:
+		/* Object parameters are read from the children. */
+		ready = !box_construct_node_open(n);
+		break;
+
+	default:
+		break;
+	}
+
+	return ready;
+}
+
+
+/**
+ * Discard layout information made stale by extending a box tree which
+ * has already been laid out.
+ *
+ * \param n  Node whose box, or nearest ancestor's box, has changed
+ */
+static void box_construct_invalidate(dom_node *n)
+{
+	dom_node *node = dom_node_ref(n);
+	dom_node *parent = NULL;
+	struct box *box = NULL;
+	dom_exception err;
+
+	while (node != NULL) {
+		box = box_for_node(node);
+		if (box != NULL) {
+			break;
+		}
+
+		err = dom_node_get_parent_node(node, &parent);
+		dom_node_unref(node);
+		if (err != DOM_NO_ERR) {
+			return;
+		}
+		node = parent;
+	}
+
+	if (node != NULL) {
+		dom_node_unref(node);
+	}
+
+	box_invalidate_layout(box, true);
+}
+
+
 /**
  * Apply the CSS text-transform property to given text for its ASCII chars.
  *
@@ -1187,109 +1683,279 @@ static bool box_construct_text(struct box_construct_ctx *ctx)
 
 
 /**
- * Convert an ELEMENT node to a box tree fragment,
- * then schedule conversion of the next ELEMENT node
+ * Outcome of converting a run of nodes
  */
-static void convert_xml_to_box(struct box_construct_ctx *ctx)
-{
-	dom_node *next;
-	bool convert_children;
-	uint32_t num_processed = 0;
-	const uint32_t max_processed_before_yield = 10;
+typedef enum {
+	BOX_CONSTRUCT_ERROR,	/**< Conversion failed */
+	BOX_CONSTRUCT_YIELD,	/**< More nodes are ready for conversion */
+	BOX_CONSTRUCT_WAIT,	/**< Waiting for the parser to add nodes */
+	BOX_CONSTRUCT_DONE	/**< All nodes have been converted */
+} box_construct_status;
 
-	do {
-		convert_children = true;
 
-		assert(ctx->n != NULL);
+/**
+ * Convert nodes to box tree fragments, starting from the current node
+ *
+ * At least one element is converted before yielding.
+ *
+ * \param ctx       Tree construction context
+ * \param deadline  Monotonic time in ms to yield at, or UINT64_MAX to
+ *                  convert until waiting or done
+ * \return conversion status
+ */
+static box_construct_status
+box_construct_nodes(struct box_construct_ctx *ctx, uint64_t deadline)
+{
+	bool published = (ctx->content->layout != NULL);
+	dom_node_type type;
+	dom_exception err;
+	uint64_t now;
 
-		if (box_construct_element(ctx, &convert_children) == false) {
-			ctx->cb(ctx->content, false);
-			dom_node_unref(ctx->n);
-			free(ctx);
-			return;
-		}
+	while (true) {
+		if (ctx->advance) {
+			if (ctx->progressive) {
+				dom_node *next;
 
-		/* Find next element to process, converting text nodes as we go */
-		next = next_node(ctx->n, ctx->content, convert_children);
-		while (next != NULL) {
-			dom_node_type type;
-			dom_exception err;
+				next = peek_next_node(ctx->n,
+						ctx->convert_children);
+				if (next == NULL) {
+					return BOX_CONSTRUCT_WAIT;
+				}
 
-			err = dom_node_get_node_type(next, &type);
-			if (err != DOM_NO_ERR) {
-				ctx->cb(ctx->content, false);
+				err = dom_node_get_node_type(next, &type);
+				if (err != DOM_NO_ERR ||
+				    !box_construct_node_ready(next, type)) {
+					dom_node_unref(next);
+					return BOX_CONSTRUCT_WAIT;
+				}
 				dom_node_unref(next);
-				free(ctx);
-				return;
 			}
 
-			if (type == DOM_ELEMENT_NODE)
-				break;
-
-			if (type == DOM_TEXT_NODE) {
-				ctx->n = next;
-				if (box_construct_text(ctx) == false) {
-					ctx->cb(ctx->content, false);
-					dom_node_unref(ctx->n);
-					free(ctx);
-					return;
-				}
+			if (published) {
+				box_construct_invalidate(ctx->n);
 			}
 
-			next = next_node(next, ctx->content, true);
+			/* Find next node to process */
+			ctx->n = next_node(ctx->n, ctx->content,
+					ctx->convert_children);
+			ctx->advance = false;
+			if (ctx->n == NULL) {
+				return BOX_CONSTRUCT_DONE;
+			}
 		}
 
-		ctx->n = next;
+		err = dom_node_get_node_type(ctx->n, &type);
+		if (err != DOM_NO_ERR) {
+			return BOX_CONSTRUCT_ERROR;
+		}
 
-		if (next == NULL) {
-			/* Conversion complete */
-			struct box root;
+		ctx->convert_children = true;
 
-			memset(&root, 0, sizeof(root));
+		if (type == DOM_ELEMENT_NODE) {
+			if (box_construct_element(ctx,
+					&ctx->convert_children) == false) {
+				return BOX_CONSTRUCT_ERROR;
+			}
+		} else if (type == DOM_TEXT_NODE) {
+			if (box_construct_text(ctx) == false) {
+				return BOX_CONSTRUCT_ERROR;
+			}
+		}
 
-			root.type = BOX_BLOCK;
-			root.children = root.last = ctx->root_box;
-			root.children->parent = &root;
+		if (published) {
+			box_construct_invalidate(ctx->n);
+		}
 
-			/** \todo Remove box_normalise_block */
-			if (box_normalise_block(&root, ctx->root_box,
-					ctx->content) == false) {
-				ctx->cb(ctx->content, false);
-			} else {
-				ctx->content->layout = root.children;
-				ctx->content->layout->parent = NULL;
+		ctx->advance = true;
 
-				ctx->cb(ctx->content, true);
+		if (deadline != UINT64_MAX && type == DOM_ELEMENT_NODE) {
+			nsu_getmonotonic_ms(&now);
+			if (now >= deadline) {
+				return BOX_CONSTRUCT_YIELD;
 			}
+		}
+	}
+}
 
-			assert(ctx->n == NULL);
 
-			free(ctx);
-			return;
+/**
+ * Convert nodes to box tree fragments and record the time taken
+ *
+ * \param ctx      Tree construction context
+ * \param bounded  Whether to yield once the time slice has elapsed
+ * \return conversion status
+ */
+static box_construct_status
+box_construct_slice(struct box_construct_ctx *ctx, bool bounded)
+{
+	box_construct_status status;
+	uint64_t start, end;
+
+	nsu_getmonotonic_ms(&start);
+
+	status = box_construct_nodes(ctx, bounded ?
+			start + nsoption_uint(box_conversion_slice) :
+			UINT64_MAX);
+
+	nsu_getmonotonic_ms(&end);
+
+	ctx->slice_count++;
+	if (end - start > ctx->slice_max) {
+		ctx->slice_max = end - start;
+	}
+
+	return status;
+}
+
+
+/**
+ * Normalise the box tree constructed so far and make it the content layout
+ *
+ * Boxes which can no longer be extended are marked so later calls only
+ * normalise the boxes added since.
+ *
+ * \param ctx  Tree construction context
+ * \return true on success, false on memory exhaustion
+ */
+static bool box_construct_normalise(struct box_construct_ctx *ctx)
+{
+	struct box root;
+	struct box *box;
+	struct box *child;
+
+	memset(&root, 0, sizeof(root));
+
+	root.type = BOX_BLOCK;
+	root.children = root.last = ctx->root_box;
+	root.children->parent = &root;
+
+	/** \todo Remove box_normalise_block */
+	if (box_normalise_block(&root, ctx->root_box, ctx->content) == false) {
+		return false;
+	}
+
+	ctx->content->layout = root.children;
+	ctx->content->layout->parent = NULL;
+
+	/* Conversion only appends to the last child of each box on the
+	 * path to the most recent box, everything before it is final */
+	for (box = ctx->content->layout; box != NULL; box = box->last) {
+		for (child = (box->last != NULL) ? box->last->prev : NULL;
+		     (child != NULL) && ((child->flags & NORMALISED) == 0);
+		     child = child->prev) {
+			child->flags |= NORMALISED;
 		}
-	} while (++num_processed < max_processed_before_yield);
+	}
 
-	/* More work to do: schedule a continuation */
-	guit->misc->schedule(0, (void *)convert_xml_to_box, ctx);
+	return true;
 }
 
 
-/* exported function documented in html/box_construct.h */
-nserror
-dom_to_box(dom_node *n,
-	   html_content *c,
-	   box_construct_complete_cb cb,
-	   void **box_conversion_context)
+/**
+ * Empty the style sharing cache of a tree construction context
+ *
+ * \param ctx  Tree construction context
+ */
+static void box_construct_share_free(struct box_construct_ctx *ctx)
+{
+	unsigned int i;
+
+	for (i = 0; i != STYLE_SHARE_CACHE_SIZE; i++) {
+		box_style_share_clear(&ctx->share[i]);
+	}
+}
+
+
+/**
+ * Complete box tree construction and report the result
+ *
+ * \param ctx  Tree construction context, which is freed
+ * \param status  The conversion status
+ */
+static void
+box_construct_finish(struct box_construct_ctx *ctx,
+		     box_construct_status status)
+{
+	NSLOG(netsurf, INFO, "Box conversion used %u slices, longest %ums",
+	      ctx->slice_count, ctx->slice_max);
+	NSLOG(netsurf, INFO,
+	      "Style selection for %u elements took %ld.%06lds, %u shared (%u%%)",
+	      ctx->style_count,
+	      (long) ctx->style_time.tv_sec, (long) ctx->style_time.tv_usec,
+	      ctx->style_shared,
+	      (ctx->style_count == 0) ? 0 :
+			ctx->style_shared * 100 / ctx->style_count);
+
+	box_construct_share_free(ctx);
+	nscss_sibling_cache_destroy(ctx->content->sibling_cache);
+	ctx->content->sibling_cache = NULL;
+
+	if (status == BOX_CONSTRUCT_DONE) {
+		assert(ctx->n == NULL);
+
+		ctx->cb(ctx->content, box_construct_normalise(ctx));
+	} else {
+		ctx->cb(ctx->content, false);
+		dom_node_unref(ctx->n);
+	}
+
+	free(ctx);
+}
+
+
+/**
+ * Convert an ELEMENT node to a box tree fragment,
+ * then schedule conversion of the next ELEMENT node
+ */
+static void convert_xml_to_box(struct box_construct_ctx *ctx)
+{
+	box_construct_status status;
+
+	status = box_construct_slice(ctx, true);
+	switch (status) {
+	case BOX_CONSTRUCT_YIELD:
+		/* More work to do: schedule a continuation */
+		guit->misc->schedule(0, (void *)convert_xml_to_box, ctx);
+		break;
+
+	case BOX_CONSTRUCT_WAIT:
+		/* Resumed by dom_to_box_progress() */
+		break;
+
+	default:
+		box_construct_finish(ctx, status);
+		break;
+	}
+}
+
+
+/**
+ * Create a box tree construction context
+ *
+ * \param n dom node to begin construction at
+ * \param c content of type CONTENT_HTML to construct box tree in
+ * \param cb callback to report conversion completion
+ * \param progressive whether the parse of the document is incomplete
+ * \param box_conversion_context pointer that recives the conversion context
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+static nserror
+box_construct_ctx_create(dom_node *n,
+			 html_content *c,
+			 box_construct_complete_cb cb,
+			 bool progressive,
+			 void **box_conversion_context)
 {
 	struct box_construct_ctx *ctx;
+	nserror err;
 
 	assert(box_conversion_context != NULL);
 
 	if (c->bctx == NULL) {
-		/* create a context allocation for this box tree */
-		c->bctx = talloc_zero(0, int);
-		if (c->bctx == NULL) {
-			return NSERROR_NOMEM;
+		/* create an arena for this box tree */
+		err = box_arena_create(&c->bctx);
+		if (err != NSERROR_OK) {
+			return err;
 		}
 	}
 
@@ -1298,15 +1964,103 @@ dom_to_box(dom_node *n,
 		return NSERROR_NOMEM;
 	}
 
+	/* without a sibling cache selection walks the document instead */
+	if (c->sibling_cache == NULL) {
+		c->sibling_cache = nscss_sibling_cache_create();
+	}
+
 	ctx->content = c;
 	ctx->n = dom_node_ref(n);
+	ctx->advance = false;
+	ctx->convert_children = true;
+	ctx->progressive = progressive;
 	ctx->root_box = NULL;
 	ctx->cb = cb;
 	ctx->bctx = c->bctx;
+	ctx->slice_count = 0;
+	ctx->slice_max = 0;
+	memset(ctx->share, 0, sizeof(ctx->share));
+	ctx->style_count = 0;
+	ctx->style_shared = 0;
+	timerclear(&ctx->style_time);
 
 	*box_conversion_context = ctx;
 
-	return guit->misc->schedule(0, (void *)convert_xml_to_box, ctx);
+	return NSERROR_OK;
+}
+
+
+/* exported function documented in html/box_construct.h */
+nserror
+dom_to_box(dom_node *n,
+	   html_content *c,
+	   box_construct_complete_cb cb,
+	   void **box_conversion_context)
+{
+	nserror res;
+
+	res = box_construct_ctx_create(n, c, cb, false, box_conversion_context);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	return guit->misc->schedule(0, (void *)convert_xml_to_box,
+			*box_conversion_context);
+}
+
+
+/* exported function documented in html/box_construct.h */
+nserror
+dom_to_box_progressive(dom_node *n,
+		       html_content *c,
+		       box_construct_complete_cb cb,
+		       void **box_conversion_context)
+{
+	return box_construct_ctx_create(n, c, cb, true, box_conversion_context);
+}
+
+
+/* exported function documented in html/box_construct.h */
+nserror dom_to_box_progress(void *box_conversion_context, bool *more)
+{
+	struct box_construct_ctx *ctx = box_conversion_context;
+	box_construct_status status;
+
+	*more = false;
+
+	status = box_construct_slice(ctx, true);
+	switch (status) {
+	case BOX_CONSTRUCT_YIELD:
+		*more = true;
+		break;
+
+	case BOX_CONSTRUCT_WAIT:
+		break;
+
+	case BOX_CONSTRUCT_DONE:
+		/* Only once the parse is complete */
+		box_construct_finish(ctx, status);
+		return NSERROR_OK;
+
+	default:
+		return NSERROR_BOX_CONVERT;
+	}
+
+	if ((ctx->root_box != NULL) &&
+	    (box_construct_normalise(ctx) == false)) {
+		return NSERROR_BOX_CONVERT;
+	}
+
+	return NSERROR_OK;
+}
+
+
+/* exported function documented in html/box_construct.h */
+void dom_to_box_complete(void *box_conversion_context)
+{
+	struct box_construct_ctx *ctx = box_conversion_context;
+
+	ctx->progressive = false;
 }
 
 
@@ -1321,6 +2075,9 @@ nserror cancel_dom_to_box(void *box_conversion_context)
 		return err;
 	}
 
+	box_construct_share_free(ctx);
+	nscss_sibling_cache_destroy(ctx->content->sibling_cache);
+	ctx->content->sibling_cache = NULL;
 	dom_node_unref(ctx->n);
 	free(ctx);
 
@@ -84,6 +84,50 @@
 nserror dom_to_box(struct dom_node *n, struct html_content *c, box_construct_complete_cb cb, void **box_conversion_context);
 
 
+/**
+ * Construct a box tree from a dom which is still being parsed
+ *
+ * Nothing is converted until dom_to_box_progress() is called. Once the
+ * parse is complete dom_to_box_complete() must be used to finish the
+ * box tree.
+ *
+ * \param n dom document
+ * \param c content of type CONTENT_HTML to construct box tree in
+ * \param cb callback to report conversion completion
+ * \param box_conversion_context pointer that recives the conversion context
+ * \return netsurf error code indicating status of call
+ */
+nserror dom_to_box_progressive(struct dom_node *n, struct html_content *c, box_construct_complete_cb cb, void **box_conversion_context);
+
+
+/**
+ * Extend a progressively constructed box tree
+ *
+ * Converts the nodes the parser has finished with for at most the box
+ * conversion time slice and makes the box tree so far the content
+ * layout. Once dom_to_box_complete() has been called the conversion of
+ * the last node calls the completion callback, and releases the
+ * conversion context, before this returns. On error the conversion
+ * context must be released with cancel_dom_to_box().
+ *
+ * \param box_conversion_context context from dom_to_box_progressive()
+ * \param more set to true if nodes remain ready for conversion
+ * \return netsurf error code indicating status of call
+ */
+nserror dom_to_box_progress(void *box_conversion_context, bool *more);
+
+
+/**
+ * Mark the document of a progressively constructed box tree as parsed
+ *
+ * The remaining nodes are converted by further calls to
+ * dom_to_box_progress().
+ *
+ * \param box_conversion_context context from dom_to_box_progressive()
+ */
+void dom_to_box_complete(void *box_conversion_context);
+
+
 /**
  * aborts any ongoing box construction
  */
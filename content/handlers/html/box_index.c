@@ -0,0 +1,238 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * implementation of box tree spatial index.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "utils/errors.h"
+
+#include "html/box.h"
+#include "html/box_index.h"
+
+/**
+ * Minimum number of in-flow children a box must have to be indexed.
+ *
+ * Below this a linear walk of the children is as cheap as a search.
+ */
+#define BOX_INDEX_MIN_CHILDREN 32
+
+/**
+ * Entry in a box child index
+ */
+struct box_child_index_entry {
+	struct box *child; /**< in-flow child */
+	int max_y1; /**< greatest bottom edge of this and all prior children */
+	int min_y0; /**< least top edge of this and all later children */
+};
+
+/**
+ * Index of the in-flow children of a box in painting order
+ */
+struct box_child_index {
+	unsigned int count; /**< number of entries in use */
+	unsigned int alloc; /**< number of entries allocated */
+	struct box_child_index_entry *entry; /**< entries */
+};
+
+
+/**
+ * Get the vertical extent of a child, relative to its parent.
+ *
+ * This covers everything redraw or hit testing can find within the
+ * child, including its descendants and list marker.
+ *
+ * \param child the child box
+ * \param y0 updated to top of extent
+ * \param y1 updated to bottom of extent
+ */
+static void box_index_extent(const struct box *child, int *y0, int *y1)
+{
+	css_computed_clip_rect css_rect;
+
+	if (child->style != NULL &&
+	    css_computed_position(child->style) == CSS_POSITION_ABSOLUTE &&
+	    css_computed_clip(child->style, &css_rect) == CSS_CLIP_RECT) {
+		/* The clip rect may extend beyond the descendants */
+		*y0 = INT_MIN;
+		*y1 = INT_MAX;
+		return;
+	}
+
+	*y0 = child->y + child->descendant_y0;
+	*y1 = child->y + child->descendant_y1 + 1;
+}
+
+
+/* exported interface documented in html/box_index.h */
+void box_index_free(struct box *box)
+{
+	if (box->child_index == NULL) {
+		return;
+	}
+
+	free(box->child_index->entry);
+	free(box->child_index);
+	box->child_index = NULL;
+}
+
+
+/* exported interface documented in html/box_index.h */
+nserror box_index_build(struct box *box)
+{
+	struct box_child_index *index;
+	struct box *child;
+	unsigned int count = 0;
+	unsigned int idx;
+	int y0, y1;
+	int extreme;
+	nserror res = NSERROR_OK;
+
+	for (child = box->children; child != NULL; child = child->next) {
+		/* carry on after failure so no stale index remains */
+		if (box_index_build(child) != NSERROR_OK) {
+			res = NSERROR_NOMEM;
+		}
+		if (child->type != BOX_FLOAT_LEFT &&
+		    child->type != BOX_FLOAT_RIGHT) {
+			count++;
+		}
+	}
+
+	if ((count < BOX_INDEX_MIN_CHILDREN) || (box->flags & REPLACE_DIM)) {
+		/* too few children or children not displayed */
+		box_index_free(box);
+		return res;
+	}
+
+	index = box->child_index;
+	if (index == NULL) {
+		index = calloc(1, sizeof(*index));
+		if (index == NULL) {
+			return NSERROR_NOMEM;
+		}
+		box->child_index = index;
+	}
+
+	if (index->alloc < count) {
+		struct box_child_index_entry *entry;
+
+		entry = realloc(index->entry, count * sizeof(*entry));
+		if (entry == NULL) {
+			box_index_free(box);
+			return NSERROR_NOMEM;
+		}
+		index->entry = entry;
+		index->alloc = count;
+	}
+
+	/* record children with the running maximum of their bottoms */
+	idx = 0;
+	extreme = INT_MIN;
+	for (child = box->children; child != NULL; child = child->next) {
+		if (child->type == BOX_FLOAT_LEFT ||
+		    child->type == BOX_FLOAT_RIGHT) {
+			continue;
+		}
+		box_index_extent(child, &y0, &y1);
+		if (extreme < y1) {
+			extreme = y1;
+		}
+		index->entry[idx].child = child;
+		index->entry[idx].max_y1 = extreme;
+		index->entry[idx].min_y0 = y0;
+		idx++;
+	}
+	index->count = count;
+
+	/* and the running minimum of the tops from the end */
+	extreme = INT_MAX;
+	for (idx = count; idx > 0; idx--) {
+		if (index->entry[idx - 1].min_y0 < extreme) {
+			extreme = index->entry[idx - 1].min_y0;
+		}
+		index->entry[idx - 1].min_y0 = extreme;
+	}
+
+	return res;
+}
+
+
+/* exported interface documented in html/box_index.h */
+struct box *box_index_first(const struct box *box, int y)
+{
+	const struct box_child_index *index = box->child_index;
+	unsigned int lo = 0;
+	unsigned int hi;
+
+	if (index == NULL) {
+		return box->children;
+	}
+
+	/* max_y1 never decreases so search for the first which reaches y */
+	hi = index->count;
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (index->entry[mid].max_y1 < y) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo == index->count) {
+		return NULL;
+	}
+	return index->entry[lo].child;
+}
+
+
+/* exported interface documented in html/box_index.h */
+struct box *box_index_end(const struct box *box, int y)
+{
+	const struct box_child_index *index;
+	unsigned int lo = 0;
+	unsigned int hi;
+
+	if (box == NULL || box->child_index == NULL) {
+		return NULL;
+	}
+	index = box->child_index;
+
+	/* min_y0 never decreases so search for the first beyond y */
+	hi = index->count;
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (index->entry[mid].min_y0 <= y) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo == index->count) {
+		return NULL;
+	}
+	return index->entry[lo].child;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Box tree spatial index interface.
+ *
+ * Boxes with many in-flow children (long documents, large tables and
+ * the lines of big paragraphs) carry an index of those children in
+ * painting order together with the running extremes of their
+ * vertical extents. Redraw and hit testing use it to find the run of
+ * children which may intersect a vertical range without visiting the
+ * children either side of it.
+ *
+ * Queries return children in the same order as the children list so
+ * painting and interaction order are unchanged. A box without an
+ * index behaves as if every child may intersect.
+ */
+
+#ifndef NETSURF_HTML_BOX_INDEX_H
+#define NETSURF_HTML_BOX_INDEX_H
+
+struct box;
+
+/**
+ * (Re)build the spatial indexes of a laid-out box tree.
+ *
+ * Must be called after the descendant bounding boxes have been
+ * calculated. Boxes which no longer have enough children to be worth
+ * indexing have their index released, as do boxes whose index could
+ * not be allocated.
+ *
+ * \param box root of box tree to index
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+nserror box_index_build(struct box *box);
+
+
+/**
+ * Release the spatial index of a box, if it has one.
+ *
+ * Must be called whenever the children of a box are changed outside
+ * of layout.
+ *
+ * \param box box to release index of
+ */
+void box_index_free(struct box *box);
+
+
+/**
+ * Find the first child of a box which may reach a vertical position.
+ *
+ * \param box parent box
+ * \param y   top of range of interest, relative to box
+ * \return first child which may extend to y or below, box->children
+ *         if box is not indexed or NULL if no child can.
+ */
+struct box *box_index_first(const struct box *box, int y);
+
+
+/**
+ * Find the child of a box after which no child reaches a vertical
+ * position.
+ *
+ * \param box parent box, may be NULL
+ * \param y   bottom of range of interest, relative to box
+ * \return first child from which all subsequent children lie below
+ *         y or NULL if there is no such child or box is not indexed.
+ */
+struct box *box_index_end(const struct box *box, int y);
+
+#endif
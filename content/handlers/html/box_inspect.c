@@ -37,6 +37,7 @@
 #include "html/private.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_index.h"
 
 /**
  * Direction to move in a box-tree walk
@@ -149,20 +150,20 @@ box_contains_point(const css_unit_ctx *unit_len_ctx,
 		*physically = true;
 		return true;
 	}
-	if (box->list_marker && box->list_marker->x - box->x <= x +
-	    box->list_marker->border[LEFT].width &&
-	    x < box->list_marker->x - box->x +
-	    box->list_marker->padding[LEFT] +
-	    box->list_marker->width +
-	    box->list_marker->border[RIGHT].width +
-	    box->list_marker->padding[RIGHT] &&
-	    box->list_marker->y - box->y <= y +
-	    box->list_marker->border[TOP].width &&
-	    y < box->list_marker->y - box->y +
-	    box->list_marker->padding[TOP] +
-	    box->list_marker->height +
-	    box->list_marker->border[BOTTOM].width +
-	    box->list_marker->padding[BOTTOM]) {
+	if (box->extra->list_marker && box->extra->list_marker->x - box->x <= x +
+	    box->extra->list_marker->border[LEFT].width &&
+	    x < box->extra->list_marker->x - box->x +
+	    box->extra->list_marker->padding[LEFT] +
+	    box->extra->list_marker->width +
+	    box->extra->list_marker->border[RIGHT].width +
+	    box->extra->list_marker->padding[RIGHT] &&
+	    box->extra->list_marker->y - box->y <= y +
+	    box->extra->list_marker->border[TOP].width &&
+	    y < box->extra->list_marker->y - box->y +
+	    box->extra->list_marker->padding[TOP] +
+	    box->extra->list_marker->height +
+	    box->extra->list_marker->border[BOTTOM].width +
+	    box->extra->list_marker->padding[BOTTOM]) {
 		*physically = true;
 		return true;
 	}
@@ -193,17 +194,20 @@ box_contains_point(const css_unit_ctx *unit_len_ctx,
  * \param dir direction to move in
  * \param x box's global x-coord, updated to position of next box
  * \param y box's global y-coord, updated to position of next box
+ * \param py global y-coord of point of interest
  *
- * If no box can be found in given direction, NULL is returned.
+ * If no box can be found in given direction, NULL is returned.  In-flow
+ * children which cannot contain the point of interest may be skipped.
  */
 static inline struct box *
-box_move_xy(struct box *b, enum box_walk_dir dir, int *x, int *y)
+box_move_xy(struct box *b, enum box_walk_dir dir, int *x, int *y, int py)
 {
 	struct box *rb = NULL;
+	struct box *end;
 
 	switch (dir) {
 	case BOX_WALK_CHILDREN:
-		b = b->children;
+		b = box_index_first(b, py - *y);
 		if (b == NULL)
 			break;
 		*x += b->x;
@@ -215,10 +219,13 @@ box_move_xy(struct box *b, enum box_walk_dir dir, int *x, int *y)
 		/* fall through */
 
 	case BOX_WALK_NEXT_SIBLING:
+		end = box_index_end(b->parent, py - (*y - b->y));
 		do {
 			*x -= b->x;
 			*y -= b->y;
 			b = b->next;
+			if (b == end)
+				b = NULL;
 			if (b == NULL)
 				break;
 			*x += b->x;
@@ -274,12 +281,13 @@ box_move_xy(struct box *b, enum box_walk_dir dir, int *x, int *y)
  * \param x	box's global x-coord, updated to position of next box
  * \param y	box's global y-coord, updated to position of next box
  * \param skip_children	whether to skip box's children
+ * \param py	global y-coord of point of interest
  *
  * This walks to a boxes float children before its children.  When walking
  * children, floating boxes are skipped.
  */
 static inline struct box *
-box_next_xy(struct box *b, int *x, int *y, bool skip_children)
+box_next_xy(struct box *b, int *x, int *y, bool skip_children, int py)
 {
 	struct box *n;
 	int tx, ty;
@@ -292,7 +300,7 @@ box_next_xy(struct box *b, int *x, int *y, bool skip_children)
 	}
 
 	tx = *x; ty = *y;
-	n = box_move_xy(b, BOX_WALK_FLOAT_CHILDREN, &tx, &ty);
+	n = box_move_xy(b, BOX_WALK_FLOAT_CHILDREN, &tx, &ty, py);
 	if (n) {
 		/* Next node is float child */
 		*x = tx;
@@ -302,7 +310,7 @@ box_next_xy(struct box *b, int *x, int *y, bool skip_children)
  done_float_children:
 
 	tx = *x; ty = *y;
-	n = box_move_xy(b, BOX_WALK_CHILDREN, &tx, &ty);
+	n = box_move_xy(b, BOX_WALK_CHILDREN, &tx, &ty, py);
 	if (n) {
 		/* Next node is child */
 		*x = tx;
@@ -312,7 +320,7 @@ box_next_xy(struct box *b, int *x, int *y, bool skip_children)
 
  skip_children:
 	tx = *x; ty = *y;
-	n = box_move_xy(b, BOX_WALK_NEXT_FLOAT_SIBLING, &tx, &ty);
+	n = box_move_xy(b, BOX_WALK_NEXT_FLOAT_SIBLING, &tx, &ty, py);
 	if (n) {
 		/* Go to next float sibling */
 		*x = tx;
@@ -325,14 +333,14 @@ box_next_xy(struct box *b, int *x, int *y, bool skip_children)
 		 * or siblings, or ansestors with siblings.  Change to
 		 * float container and move past handling its float children.
 		 */
-		b = box_move_xy(b, BOX_WALK_FLOAT_CONTAINER, x, y);
+		b = box_move_xy(b, BOX_WALK_FLOAT_CONTAINER, x, y, py);
 		goto done_float_children;
 	}
 
 	/* Go to next sibling, or nearest ancestor with next sibling. */
 	while (b) {
 		while (!b->next && b->parent) {
-			b = box_move_xy(b, BOX_WALK_PARENT, x, y);
+			b = box_move_xy(b, BOX_WALK_PARENT, x, y, py);
 			if (box_is_float(b)) {
 				/* Go on to next float, if there is one */
 				goto skip_children;
@@ -344,7 +352,7 @@ box_next_xy(struct box *b, int *x, int *y, bool skip_children)
 		}
 
 		tx = *x; ty = *y;
-		n = box_move_xy(b, BOX_WALK_NEXT_SIBLING, &tx, &ty);
+		n = box_move_xy(b, BOX_WALK_NEXT_SIBLING, &tx, &ty, py);
 		if (n) {
 			/* Go to non-float (ancestor) sibling */
 			*x = tx;
@@ -352,7 +360,7 @@ box_next_xy(struct box *b, int *x, int *y, bool skip_children)
 			return n;
 
 		} else if (b->parent) {
-			b = box_move_xy(b, BOX_WALK_PARENT, x, y);
+			b = box_move_xy(b, BOX_WALK_PARENT, x, y, py);
 			if (box_is_float(b)) {
 				/* Go on to next float, if there is one */
 				goto skip_children;
@@ -414,7 +422,7 @@ box_nearer_text_box(struct box *box,
 		return true;
 	}
 
-	if (box->parent->list_marker != box) {
+	if (box->parent->extra->list_marker != box) {
 		if (dir < 0) {
 			/* consider only those children (partly) above-left */
 			if (by <= y && bx < x) {
@@ -522,11 +530,11 @@ box_nearest_text_box(struct box *box,
 						tx, ty, nr_xd, nr_yd))
 				return true;
 		} else {
-			if (child->list_marker) {
+			if (child->extra->list_marker) {
 				if (box_nearer_text_box(
-						child->list_marker,
-						c_bx + child->list_marker->x,
-						c_by + child->list_marker->y,
+						child->extra->list_marker,
+						c_bx + child->extra->list_marker->x,
+						c_by + child->extra->list_marker->y,
 						x, y, dir, nearest,
 						tx, ty, nr_xd, nr_yd))
 					return true;
@@ -590,7 +598,7 @@ box_at_point(const css_unit_ctx *unit_len_ctx,
 	assert(box);
 
 	skip_children = false;
-	while ((box = box_next_xy(box, box_x, box_y, skip_children))) {
+	while ((box = box_next_xy(box, box_x, box_y, skip_children, y))) {
 		if (box_contains_point(unit_len_ctx, box, x - *box_x, y - *box_y,
 				       &physically)) {
 			*box_x -= scrollbar_get_offset(box->scroll_x);
@@ -737,10 +745,10 @@ void box_dump(FILE *stream, struct box *box, unsigned int depth, bool style)
 		fprintf(stream, "(object '%s') ",
 			nsurl_access(hlcache_handle_get_url(box->object)));
 	}
-	if (box->iframe) {
+	if (box->extra->iframe) {
 		fprintf(stream, "(iframe) ");
 	}
-	if (box->gadget)
+	if (box->extra->gadget)
 		fprintf(stream, "(gadget) ");
 	if (style && box->style)
 		nscss_dump_computed_style(stream, box->style);
@@ -760,7 +768,7 @@ void box_dump(FILE *stream, struct box *box, unsigned int depth, bool style)
 		fprintf(stream, " next_float %p", box->next_float);
 	if (box->float_container)
 		fprintf(stream, " float_container %p", box->float_container);
-	if (box->col) {
+	if (box->extra->col) {
 		fprintf(stream, " (columns");
 		for (i = 0; i != box->columns; i++) {
 			fprintf(stream, " (%s %s %i %i %i)",
@@ -771,13 +779,13 @@ void box_dump(FILE *stream, struct box *box, unsigned int depth, bool style)
 					"PERCENT",
 					"RELATIVE"
 						})
-				[box->col[i].type],
+				[box->extra->col[i].type],
 				((const char *[]) {
 					"normal",
 					"positioned"})
-				[box->col[i].positioned],
-				box->col[i].width,
-				box->col[i].min, box->col[i].max);
+				[box->extra->col[i].positioned],
+				box->extra->col[i].width,
+				box->extra->col[i].min, box->extra->col[i].max);
 		}
 		fprintf(stream, ")");
 	}
@@ -790,11 +798,11 @@ void box_dump(FILE *stream, struct box *box, unsigned int depth, bool style)
 	}
 	fprintf(stream, "\n");
 
-	if (box->list_marker) {
+	if (box->extra->list_marker) {
 		for (i = 0; i != depth; i++)
 			fprintf(stream, "  ");
 		fprintf(stream, "list_marker:\n");
-		box_dump(stream, box->list_marker, depth + 1, style);
+		box_dump(stream, box->extra->list_marker, depth + 1, style);
 	}
 
 	for (c = box->children; c && c->next; c = c->next)
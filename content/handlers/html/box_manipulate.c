@@ -26,6 +26,8 @@
  */
 
 
+#include <stdlib.h>
+
 #include "utils/errors.h"
 #include "utils/talloc.h"
 #include "utils/nsurl.h"
@@ -38,15 +40,72 @@
 #include "html/interaction.h"
 #include "html/box.h"
 #include "html/box_manipulate.h"
+#include "html/box_index.h"
+#include "html/float_index.h"
+
+
+/** Number of boxes in each arena block */
+#define BOX_ARENA_BLOCK_SIZE 64
+
+/** Initial number of buckets in the element id index */
+#define BOX_ARENA_ID_BUCKETS 64
+
+/** Initial number of entries in the shared selection results table */
+#define BOX_ARENA_STYLES_ALLOC 32
+
+/**
+ * Block of boxes within an arena.
+ */
+struct box_arena_block {
+	struct box_arena_block *next; /**< next older block */
+	unsigned int used; /**< number of boxes allocated from the block */
+	struct box box[BOX_ARENA_BLOCK_SIZE]; /**< box storage */
+};
+
+/**
+ * Entry in the element id index of an arena.
+ *
+ * Entries are not removed when their box is freed; freed boxes remain
+ * part of the arena and are skipped by lookups.
+ */
+struct box_id_entry {
+	struct box_id_entry *next; /**< next entry in bucket */
+	struct box *box; /**< box with an id */
+};
+
+/**
+ * Arena all the boxes of a box tree are allocated from.
+ *
+ * The arena is a talloc context so allocations which live as long as
+ * the box tree, such as strings, may be made from it. Freeing it
+ * finalises and releases every box.
+ */
+struct box_arena {
+	struct box_arena_block *blocks; /**< blocks, newest first */
+
+	struct box_id_entry **ids; /**< element id index buckets */
+	unsigned int id_buckets; /**< number of id index buckets */
+	unsigned int id_count; /**< number of boxes in the id index */
 
+	css_select_results **styles; /**< selection results shared by boxes */
+	unsigned int styles_count; /**< number of shared selection results */
+	unsigned int styles_alloc; /**< number of shared results allocated */
+};
 
 /**
- * Destructor for box nodes which own styles
+ * Record shared by every box with no rarely used properties.
+ */
+static const struct box_extra box_extra_none;
+
+
+/**
+ * Release the resources held by a box.
+ *
+ * The box storage itself remains part of the arena.
  *
- * \param b The box being destroyed.
- * \return 0 to allow talloc to continue destroying the tree.
+ * \param b The box being finalised.
  */
-static int box_talloc_destructor(struct box *b)
+static void box_finalise(struct box *b)
 {
 	struct html_scrollbar_data *data;
 
@@ -55,7 +114,7 @@ static int box_talloc_destructor(struct box *b)
 		b->style = NULL;
 	}
 
-	if (b->styles != NULL) {
+	if (b->styles != NULL && !(b->flags & STYLES_SHARED)) {
 		css_select_results_destroy(b->styles);
 		b->styles = NULL;
 	}
@@ -83,10 +142,297 @@ static int box_talloc_destructor(struct box *b)
 		free(data);
 	}
 
+	box_index_free(b);
+	float_index_free(b);
+
+	if (b->extra != &box_extra_none) {
+		free(b->extra->col);
+		free((struct box_extra *)b->extra);
+	}
+
+	/* mark the box as released */
+	b->extra = NULL;
+}
+
+
+/**
+ * Free the buckets of an element id index.
+ *
+ * \param ids     id index buckets
+ * \param buckets number of buckets
+ */
+static void box_arena_free_ids(struct box_id_entry **ids, unsigned int buckets)
+{
+	struct box_id_entry *entry;
+	unsigned int i;
+
+	if (ids == NULL) {
+		return;
+	}
+
+	for (i = 0; i != buckets; i++) {
+		while (ids[i] != NULL) {
+			entry = ids[i];
+			ids[i] = entry->next;
+			free(entry);
+		}
+	}
+
+	free(ids);
+}
+
+
+/**
+ * Append an entry to an element id index bucket.
+ *
+ * Entries are kept in the order they were added so lookups find the
+ * earliest box with an id.
+ *
+ * \param ids     id index buckets
+ * \param buckets number of buckets
+ * \param entry   entry to append
+ */
+static void
+box_arena_append_id(struct box_id_entry **ids,
+		    unsigned int buckets,
+		    struct box_id_entry *entry)
+{
+	struct box_id_entry **tail;
+
+	tail = &ids[lwc_string_hash_value(entry->box->id) % buckets];
+	while (*tail != NULL) {
+		tail = &(*tail)->next;
+	}
+
+	entry->next = NULL;
+	*tail = entry;
+}
+
+
+/**
+ * Destructor for box arenas
+ *
+ * \param arena The arena being destroyed.
+ * \return 0 to allow talloc to continue destroying the context.
+ */
+static int box_arena_talloc_destructor(struct box_arena *arena)
+{
+	struct box_arena_block *block;
+	unsigned int i;
+
+	while (arena->blocks != NULL) {
+		block = arena->blocks;
+		arena->blocks = block->next;
+
+		for (i = 0; i != block->used; i++) {
+			if (block->box[i].extra != NULL &&
+			    !(block->box[i].flags & CLONE)) {
+				box_finalise(&block->box[i]);
+			}
+		}
+
+		free(block);
+	}
+
+	box_arena_free_ids(arena->ids, arena->id_buckets);
+
+	for (i = 0; i != arena->styles_count; i++) {
+		css_select_results_destroy(arena->styles[i]);
+	}
+	free(arena->styles);
+
 	return 0;
 }
 
 
+/**
+ * Allocate uninitialised storage for a box from an arena.
+ *
+ * \param arena arena to allocate from
+ * \return box storage or NULL on memory exhaustion
+ */
+static struct box *box_arena_alloc(struct box_arena *arena)
+{
+	struct box_arena_block *block = arena->blocks;
+
+	if (block == NULL || block->used == BOX_ARENA_BLOCK_SIZE) {
+		block = malloc(sizeof(*block));
+		if (block == NULL) {
+			return NULL;
+		}
+		block->used = 0;
+		block->next = arena->blocks;
+		arena->blocks = block;
+	}
+
+	return &block->box[block->used++];
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+nserror box_arena_create(struct box_arena **arena_out)
+{
+	struct box_arena *arena;
+
+	arena = talloc(NULL, struct box_arena);
+	if (arena == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	arena->blocks = NULL;
+	arena->ids = NULL;
+	arena->id_buckets = 0;
+	arena->id_count = 0;
+	arena->styles = NULL;
+	arena->styles_count = 0;
+	arena->styles_alloc = 0;
+	talloc_set_destructor(arena, box_arena_talloc_destructor);
+
+	*arena_out = arena;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+nserror box_arena_add_id(struct box_arena *arena, struct box *box)
+{
+	struct box_id_entry **ids;
+	struct box_id_entry *entry;
+	unsigned int buckets;
+	unsigned int i;
+
+	assert(box->id != NULL);
+
+	if (arena->id_count >= arena->id_buckets * 2) {
+		/* grow the index, preserving the order of each bucket */
+		buckets = (arena->ids == NULL) ?
+			BOX_ARENA_ID_BUCKETS : arena->id_buckets * 2;
+		ids = calloc(buckets, sizeof(*ids));
+		if (ids == NULL) {
+			return NSERROR_NOMEM;
+		}
+
+		for (i = 0; i != arena->id_buckets; i++) {
+			while (arena->ids[i] != NULL) {
+				entry = arena->ids[i];
+				arena->ids[i] = entry->next;
+				box_arena_append_id(ids, buckets, entry);
+			}
+		}
+
+		free(arena->ids);
+		arena->ids = ids;
+		arena->id_buckets = buckets;
+	}
+
+	entry = malloc(sizeof(*entry));
+	if (entry == NULL) {
+		return NSERROR_NOMEM;
+	}
+	entry->box = box;
+
+	box_arena_append_id(arena->ids, arena->id_buckets, entry);
+	arena->id_count++;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+nserror box_arena_share_styles(struct box_arena *arena,
+			       css_select_results *styles)
+{
+	css_select_results **shared;
+	unsigned int alloc;
+
+	if (arena->styles_count == arena->styles_alloc) {
+		alloc = (arena->styles_alloc == 0) ?
+			BOX_ARENA_STYLES_ALLOC : arena->styles_alloc * 2;
+		shared = realloc(arena->styles, alloc * sizeof(*shared));
+		if (shared == NULL) {
+			return NSERROR_NOMEM;
+		}
+		arena->styles = shared;
+		arena->styles_alloc = alloc;
+	}
+
+	arena->styles[arena->styles_count++] = styles;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+struct box *
+box_arena_find_id(const struct box_arena *arena,
+		  const struct box *root,
+		  lwc_string *id)
+{
+	const struct box_id_entry *entry;
+	const struct box *ancestor;
+	bool match;
+
+	if (arena->ids == NULL) {
+		return NULL;
+	}
+
+	entry = arena->ids[lwc_string_hash_value(id) % arena->id_buckets];
+	for (; entry != NULL; entry = entry->next) {
+		if (entry->box->extra == NULL) {
+			/* box has been freed */
+			continue;
+		}
+
+		if (lwc_string_isequal(id, entry->box->id, &match) !=
+				lwc_error_ok || match == false) {
+			continue;
+		}
+
+		/* boxes of hidden elements are not in the tree */
+		ancestor = entry->box;
+		while (ancestor != NULL && ancestor != root) {
+			ancestor = ancestor->parent;
+		}
+		if (ancestor == root) {
+			return entry->box;
+		}
+	}
+
+	return NULL;
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+void box_arena_usage(const struct box_arena *arena,
+		     unsigned int *count,
+		     unsigned int *extra,
+		     size_t *size)
+{
+	const struct box_arena_block *block;
+	unsigned int i;
+
+	*count = 0;
+	*extra = 0;
+	*size = 0;
+
+	for (block = arena->blocks; block != NULL; block = block->next) {
+		*size += sizeof(*block);
+		for (i = 0; i != block->used; i++) {
+			if (block->box[i].extra == NULL) {
+				continue;
+			}
+			(*count)++;
+			if (block->box[i].extra != &box_extra_none &&
+			    !(block->box[i].flags & CLONE)) {
+				(*extra)++;
+				*size += sizeof(struct box_extra);
+			}
+		}
+	}
+}
+
+
 /* Exported function documented in html/box.h */
 struct box *
 box_create(css_select_results *styles,
@@ -96,18 +442,16 @@ box_create(css_select_results *styles,
 	   const char *target,
 	   const char *title,
 	   lwc_string *id,
-	   void *context)
+	   struct box_arena *arena)
 {
 	unsigned int i;
 	struct box *box;
 
-	box = talloc(context, struct box);
+	box = box_arena_alloc(arena);
 	if (!box) {
 		return 0;
 	}
 
-	talloc_set_destructor(box, box_talloc_destructor);
-
 	box->type = BOX_INLINE;
 	box->flags = 0;
 	box->flags = style_owned ? (box->flags | STYLE_OWNED) : box->flags;
@@ -123,6 +467,7 @@ box_create(css_select_results *styles,
 	box->scroll_x = box->scroll_y = NULL;
 	box->min_width = 0;
 	box->max_width = UNKNOWN_MAX_WIDTH;
+	box->layout_cache.width = UNKNOWN_WIDTH;
 	box->byte_offset = 0;
 	box->text = NULL;
 	box->length = 0;
@@ -142,18 +487,15 @@ box_create(css_select_results *styles,
 	box->float_children = NULL;
 	box->float_container = NULL;
 	box->next_float = NULL;
+	box->child_index = NULL;
+	box->float_index = NULL;
 	box->cached_place_below_level = 0;
 	box->list_value = 1;
-	box->list_marker = NULL;
-	box->col = NULL;
-	box->gadget = NULL;
-	box->usemap = NULL;
 	box->id = id;
 	box->background = NULL;
 	box->object = NULL;
-	box->object_params = NULL;
-	box->iframe = NULL;
 	box->node = NULL;
+	box->extra = &box_extra_none;
 
 	return box;
 }
@@ -165,6 +507,8 @@ void box_add_child(struct box *parent, struct box *child)
 	assert(parent);
 	assert(child);
 
+	box_index_free(parent);
+
 	if (parent->children != 0) {	/* has children already */
 		parent->last->next = child;
 		child->prev = parent->last;
@@ -181,6 +525,10 @@ void box_add_child(struct box *parent, struct box *child)
 /* Exported function documented in html/box.h */
 void box_insert_sibling(struct box *box, struct box *new_box)
 {
+	if (box->parent != NULL) {
+		box_index_free(box->parent);
+	}
+
 	new_box->parent = box->parent;
 	new_box->prev = box;
 	new_box->next = box->next;
@@ -200,6 +548,7 @@ void box_unlink_and_free(struct box *box)
 	struct box *prev = box->prev;
 
 	if (parent) {
+		box_index_free(parent);
 		if (parent->children == box)
 			parent->children = next;
 		if (parent->last == box)
@@ -234,18 +583,70 @@ void box_free(struct box *box)
 /* Exported function documented in html/box.h */
 void box_free_box(struct box *box)
 {
-	if (!(box->flags & CLONE)) {
-		if (box->gadget)
-			form_free_control(box->gadget);
-		if (box->scroll_x != NULL)
-			scrollbar_destroy(box->scroll_x);
-		if (box->scroll_y != NULL)
-			scrollbar_destroy(box->scroll_y);
-		if (box->styles != NULL)
-			css_select_results_destroy(box->styles);
-	}
-
-	talloc_free(box);
+	if (box->extra == NULL) {
+		/* already released */
+		return;
+	}
+
+	if (box->flags & CLONE) {
+		/* clones share the resources of the box they were
+		 * split from */
+		box->extra = NULL;
+		return;
+	}
+
+	if (box->extra->gadget)
+		form_free_control(box->extra->gadget);
+
+	box_finalise(box);
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+struct box *box_clone(struct box_arena *arena, const struct box *box)
+{
+	struct box *clone;
+
+	clone = box_arena_alloc(arena);
+	if (clone == NULL) {
+		return NULL;
+	}
+
+	*clone = *box;
+	clone->flags |= CLONE;
+
+	return clone;
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+struct box_extra *box_extra(struct box *box)
+{
+	struct box_extra *extra;
+
+	if (box->extra != &box_extra_none) {
+		return (struct box_extra *)box->extra;
+	}
+
+	extra = calloc(1, sizeof(*extra));
+	if (extra == NULL) {
+		return NULL;
+	}
+	box->extra = extra;
+
+	return extra;
+}
+
+
+/* exported interface documented in html/box_manipulate.h */
+void box_invalidate_layout(struct box *box, bool minmax)
+{
+	for (; box != NULL; box = box->parent) {
+		box->flags |= NEED_LAYOUT;
+		if (minmax) {
+			box->max_width = UNKNOWN_MAX_WIDTH;
+		}
+	}
 }
 
 
@@ -25,6 +25,68 @@
 #ifndef NETSURF_HTML_BOX_MANIPULATE_H
 #define NETSURF_HTML_BOX_MANIPULATE_H
 
+struct box_arena;
+
+
+/**
+ * Create an arena to allocate the boxes of a box tree from.
+ *
+ * The arena is a talloc context and may be used as the parent of
+ * allocations with the same lifetime as the box tree. Freeing it
+ * with talloc_free() releases every box allocated from it.
+ *
+ * \param arena_out updated to the new arena
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+nserror box_arena_create(struct box_arena **arena_out);
+
+
+/**
+ * Add a box to the element id index of its arena.
+ *
+ * \param arena arena the box was allocated from
+ * \param box   box with an id
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+nserror box_arena_add_id(struct box_arena *arena, struct box *box);
+
+
+/**
+ * Find the box for an element id in a box tree.
+ *
+ * \param arena arena the tree was allocated from
+ * \param root  root of the tree to search
+ * \param id    element id to find
+ * \return the earliest added box with the id within the tree, or NULL
+ */
+struct box *box_arena_find_id(const struct box_arena *arena, const struct box *root, lwc_string *id);
+
+
+/**
+ * Transfer ownership of selection results to a box arena.
+ *
+ * The results may then be used by any number of boxes allocated from
+ * the arena, which must have the STYLES_SHARED flag set. They are
+ * destroyed with the arena.
+ *
+ * \param arena  arena to take ownership of the results
+ * \param styles selection results to share
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion,
+ *         in which case ownership is not transferred
+ */
+nserror box_arena_share_styles(struct box_arena *arena, css_select_results *styles);
+
+
+/**
+ * Obtain the memory usage of a box arena.
+ *
+ * \param arena arena to examine
+ * \param count updated with the number of live boxes
+ * \param extra updated with the number of boxes with rarely used properties
+ * \param size  updated with the number of bytes used by the boxes
+ */
+void box_arena_usage(const struct box_arena *arena, unsigned int *count, unsigned int *extra, size_t *size);
+
 
 /**
  * Create a box tree node.
@@ -36,13 +98,14 @@
  * \param  target       target for the box (not copied), or 0
  * \param  title        title for the box (not copied), or 0
  * \param  id           id for the box (not copied), or 0
- * \param  context      context for allocations
+ * \param  arena        arena to allocate the box from
  * \return  allocated and initialised box, or 0 on memory exhaustion
  *
- * styles is always owned by the box, if it is set.
+ * styles is owned by the box, if it is set, unless the STYLES_SHARED
+ * flag is set on the box after creation.
  * style is only owned by the box in the case of implied boxes.
  */
-struct box * box_create(css_select_results *styles, css_computed_style *style, bool style_owned, struct nsurl *href, const char *target, const char *title, lwc_string *id, void *context);
+struct box * box_create(css_select_results *styles, css_computed_style *style, bool style_owned, struct nsurl *href, const char *target, const char *title, lwc_string *id, struct box_arena *arena);
 
 
 /**
@@ -89,6 +152,43 @@ void box_free(struct box *box);
 void box_free_box(struct box *box);
 
 
+/**
+ * Create a copy of a box which is being split.
+ *
+ * The clone shares the resources of the original box, which must
+ * outlive it.
+ *
+ * \param arena arena to allocate the clone from
+ * \param box   box to copy
+ * \return the clone or NULL on memory exhaustion
+ */
+struct box *box_clone(struct box_arena *arena, const struct box *box);
+
+
+/**
+ * Get the rarely used properties of a box for modification.
+ *
+ * Boxes share an empty record until a property is set, so this must
+ * be used rather than box->extra to set a property.
+ *
+ * \param box box to get the properties of
+ * \return the properties of the box or NULL on memory exhaustion
+ */
+struct box_extra *box_extra(struct box *box);
+
+
+/**
+ * Mark a box as needing layout.
+ *
+ * The box and all its ancestors are flagged so the next layout does
+ * not reuse their previous layout.
+ *
+ * \param box     box whose layout has changed
+ * \param minmax  true if the minimum and maximum widths are also invalid
+ */
+void box_invalidate_layout(struct box *box, bool minmax);
+
+
 /**
  * Applies the given scroll setup to a box. This includes scroll
  * creation/deletion as well as scroll dimension updates.
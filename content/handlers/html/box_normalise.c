@@ -889,6 +889,37 @@ box_normalise_inline_container(struct box *cont,
 }
 
 
+/**
+ * Find the first child of a block which needs normalising.
+ *
+ * The children marked NORMALISED by an earlier normalisation of a
+ * partially constructed tree always precede those added since.
+ *
+ * \param block  box of type BLOCK, INLINE_BLOCK, or TABLE_CELL
+ * \return first child to normalise or NULL if there is none
+ */
+static struct box *box_normalise_first_pending(struct box *block)
+{
+	struct box *child = block->children;
+
+	if ((child == NULL) || ((child->flags & NORMALISED) == 0)) {
+		return child;
+	}
+
+	child = block->last;
+	while ((child->prev != NULL) &&
+	       ((child->prev->flags & NORMALISED) == 0)) {
+		child = child->prev;
+	}
+
+	if ((child->flags & NORMALISED) != 0) {
+		return NULL;
+	}
+
+	return child;
+}
+
+
 /* Exported function documented in html/box_normalise.h */
 bool
 box_normalise_block(struct box *block, const struct box *root, html_content *c)
@@ -911,7 +942,9 @@ box_normalise_block(struct box *block, const struct box *root, html_content *c)
 	assert(block->type == BOX_BLOCK || block->type == BOX_INLINE_BLOCK ||
 			block->type == BOX_TABLE_CELL);
 
-	for (child = block->children; child != NULL; child = next_child) {
+	for (child = box_normalise_first_pending(block);
+			child != NULL;
+			child = next_child) {
 #ifdef BOX_NORMALISE_DEBUG
 		NSLOG(netsurf, INFO, "child %p, child->type = %d", child,
 		      child->type);
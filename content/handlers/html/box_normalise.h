@@ -59,6 +59,9 @@
  * TABLE_CELL           BLOCK, INLINE_CONTAINER, TABLE (same as BLOCK)
  * FLOAT_(LEFT|RIGHT)   exactly 1 BLOCK or TABLE
  * \endcode
+ *
+ * Children of a block marked NORMALISED are not visited again, so a
+ * tree which is still being constructed may be normalised repeatedly.
  */
 bool box_normalise_block(struct box *block, const struct box *root, struct html_content *c);
 
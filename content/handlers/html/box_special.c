@@ -550,6 +550,36 @@ box_get_attribute(dom_node *n,
 }
 
 
+/**
+ * Set the imagemap used by a box from the usemap attribute of a node.
+ *
+ * \param  n        node with usemap attribute
+ * \param  content  content of type CONTENT_HTML that is being processed
+ * \param  box      box to set the imagemap of
+ * \return  true on success, false on memory exhaustion
+ */
+static bool
+box_set_usemap(dom_node *n, html_content *content, struct box *box)
+{
+	struct box_extra *extra;
+	char *usemap = NULL;
+
+	if (!box_get_attribute(n, "usemap", content->bctx, &usemap))
+		return false;
+	if (usemap == NULL)
+		return true;
+	if (usemap[0] == '#')
+		usemap++;
+
+	extra = box_extra(box);
+	if (extra == NULL)
+		return false;
+	extra->usemap = usemap;
+
+	return true;
+}
+
+
 /**
  * Helper function for adding textarea widget to box.
  *
@@ -792,13 +822,17 @@ box_button(dom_node *n,
 	   bool *convert_children)
 {
 	struct form_control *gadget;
+	struct box_extra *extra;
 
 	gadget = html_forms_get_control_for_node(content->forms, n);
 	if (!gadget)
 		return false;
 
 	gadget->html = content;
-	box->gadget = gadget;
+	extra = box_extra(box);
+	if (extra == NULL)
+		return false;
+	extra->gadget = gadget;
 	box->flags |= IS_REPLACED;
 	gadget->box = box;
 
@@ -848,6 +882,7 @@ box_embed(dom_node *n,
 {
 	struct object_params *params;
 	struct object_param *param;
+	struct box_extra *extra;
 	dom_namednodemap *attrs;
 	unsigned long idx;
 	uint32_t num_attrs;
@@ -963,7 +998,10 @@ box_embed(dom_node *n,
 
 	dom_namednodemap_unref(attrs);
 
-	box->object_params = params;
+	extra = box_extra(box);
+	if (extra == NULL)
+		return false;
+	extra->object_params = params;
 
 	/* start fetch */
 	box->flags |= IS_REPLACED;
@@ -1055,6 +1093,12 @@ box_iframe(dom_node *n,
 		return true;
 	}
 
+	/* the browser window is linked to the box when it is created */
+	if (box_extra(box) == NULL) {
+		nsurl_unref(url);
+		return false;
+	}
+
 	/* create a new iframe */
 	iframe = talloc(content->bctx, struct content_html_iframe);
 	if (iframe == NULL) {
@@ -1177,10 +1221,8 @@ box_image(dom_node *n,
 	}
 
 	/* imagemap associated with this image */
-	if (!box_get_attribute(n, "usemap", content->bctx, &box->usemap))
+	if (!box_set_usemap(n, content, box))
 		return false;
-	if (box->usemap && box->usemap[0] == '#')
-		box->usemap++;
 
 	/* get image URL */
 	err = dom_element_get_attribute(n, corestring_dom_src, &s);
@@ -1228,6 +1270,7 @@ box_input(dom_node *n,
 	  bool *convert_children)
 {
 	struct form_control *gadget;
+	struct box_extra *extra;
 	dom_string *type = NULL;
 	dom_exception err;
 	nsurl *url;
@@ -1238,7 +1281,10 @@ box_input(dom_node *n,
 		return false;
 	}
 
-	box->gadget = gadget;
+	extra = box_extra(box);
+	if (extra == NULL)
+		return false;
+	extra->gadget = gadget;
 	box->flags |= IS_REPLACED;
 	gadget->box = box;
 	gadget->html = content;
@@ -1296,13 +1342,13 @@ box_input(dom_node *n,
 
 		inline_box->type = BOX_TEXT;
 
-		if (box->gadget->value != NULL)
+		if (box->extra->gadget->value != NULL)
 			inline_box->text = talloc_strdup(content->bctx,
-					box->gadget->value);
-		else if (box->gadget->type == GADGET_SUBMIT)
+					box->extra->gadget->value);
+		else if (box->extra->gadget->type == GADGET_SUBMIT)
 			inline_box->text = talloc_strdup(content->bctx,
 					messages_get("Form_Submit"));
-		else if (box->gadget->type == GADGET_RESET)
+		else if (box->extra->gadget->type == GADGET_RESET)
 			inline_box->text = talloc_strdup(content->bctx,
 					messages_get("Form_Reset"));
 		else
@@ -1401,6 +1447,7 @@ box_object(dom_node *n,
 {
 	struct object_params *params;
 	struct object_param *param;
+	struct box_extra *extra;
 	dom_string *codebase, *classid, *data;
 	dom_node *c;
 	dom_exception err;
@@ -1409,11 +1456,8 @@ box_object(dom_node *n,
 	    ns_computed_display(box->style, box_is_root(n)) == CSS_DISPLAY_NONE)
 		return true;
 
-	if (box_get_attribute(n, "usemap", content->bctx, &box->usemap) ==
-			false)
+	if (box_set_usemap(n, content, box) == false)
 		return false;
-	if (box->usemap && box->usemap[0] == '#')
-		box->usemap++;
 
 	params = talloc(content->bctx, struct object_params);
 	if (params == NULL)
@@ -1617,7 +1661,10 @@ box_object(dom_node *n,
 		c = next;
 	}
 
-	box->object_params = params;
+	extra = box_extra(box);
+	if (extra == NULL)
+		return false;
+	extra->object_params = params;
 
 	/* start fetch (MIME type is ok or not specified) */
 	box->flags |= IS_REPLACED;
@@ -1659,6 +1706,7 @@ box_select(dom_node *n,
 	struct box *inline_container;
 	struct box *inline_box;
 	struct form_control *gadget;
+	struct box_extra *extra;
 	dom_node *c, *c2;
 	dom_node *next, *next2;
 	dom_exception err;
@@ -1762,8 +1810,12 @@ box_select(dom_node *n,
 		return true;
 	}
 
+	extra = box_extra(box);
+	if (extra == NULL)
+		goto no_memory;
+
 	box->type = BOX_INLINE_BLOCK;
-	box->gadget = gadget;
+	extra->gadget = gadget;
 	box->flags |= IS_REPLACED;
 	gadget->box = box;
 
@@ -1819,14 +1871,22 @@ static bool box_textarea(dom_node *n,
 			struct box *box,
 			bool *convert_children)
 {
+	struct form_control *gadget;
+	struct box_extra *extra;
+
 	/* Get the form_control for the DOM node */
-	box->gadget = html_forms_get_control_for_node(content->forms, n);
-	if (box->gadget == NULL)
+	gadget = html_forms_get_control_for_node(content->forms, n);
+	if (gadget == NULL)
 		return false;
 
+	extra = box_extra(box);
+	if (extra == NULL)
+		return false;
+	extra->gadget = gadget;
+
 	box->flags |= IS_REPLACED;
-	box->gadget->html = content;
-	box->gadget->box = box;
+	gadget->html = content;
+	gadget->box = box;
 
 	if (!box_input_text(content, box, n))
 		return false;
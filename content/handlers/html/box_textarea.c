@@ -42,9 +42,9 @@
 
 nserror box_textarea_keypress(html_content *html, struct box *box, uint32_t key)
 {
-	struct form_control *gadget = box->gadget;
+	struct form_control *gadget = box->extra->gadget;
 	struct textarea *ta = gadget->data.text.ta;
-	struct form* form = box->gadget->form;
+	struct form* form = box->extra->gadget->form;
 	struct content *c = (struct content *)html;
 	nserror res = NSERROR_OK;
 
@@ -194,6 +194,8 @@ static void box_textarea_callback(void *data, struct textarea_msg *msg)
 			break;
 		}
 
+		html_redraw_invalidate(html);
+
 		box_coords(box, &x, &y);
 
 		content__request_redraw((struct content *)html,
@@ -271,7 +273,7 @@ bool box_textarea_create_textarea(html_content *html,
 	};
 	bool read_only = false;
 	bool disabled = false;
-	struct form_control *gadget = box->gadget;
+	struct form_control *gadget = box->extra->gadget;
 	const char *text;
 
 	assert(gadget != NULL);
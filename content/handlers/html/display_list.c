@@ -0,0 +1,1249 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * implementation of HTML retained display list.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/errors.h"
+#include "utils/log.h"
+#include "netsurf/inttypes.h"
+#include "netsurf/types.h"
+#include "netsurf/plot_style.h"
+#include "netsurf/plotters.h"
+#include "netsurf/content.h"
+#include "netsurf/browser_window.h"
+#include "css/utils.h"
+
+#include "html/display_list.h"
+
+/** Number of operations summarised by each chunk. */
+#define DISPLAY_LIST_CHUNK 64
+
+/** Maximum number of operations a display list may hold. */
+#define DISPLAY_LIST_MAX_OPS (1 << 18)
+
+/** Index of clip operation used when no clip has been recorded. */
+#define DISPLAY_LIST_NO_CLIP UINT_MAX
+
+/**
+ * Type of a display list operation
+ */
+enum display_op_type {
+	DISPLAY_OP_CLIP,
+	DISPLAY_OP_ARC,
+	DISPLAY_OP_DISC,
+	DISPLAY_OP_LINE,
+	DISPLAY_OP_RECTANGLE,
+	DISPLAY_OP_POLYGON,
+	DISPLAY_OP_PATH,
+	DISPLAY_OP_BITMAP,
+	DISPLAY_OP_TEXT,
+	DISPLAY_OP_GROUP_START,
+	DISPLAY_OP_GROUP_END,
+	DISPLAY_OP_OBJECT,
+	DISPLAY_OP_IFRAME,
+};
+
+/**
+ * A recorded plot operation
+ *
+ * Variable sized parameters (points, text and group names) are held
+ * in the display list data buffer and referenced by offset.
+ */
+struct display_op {
+	enum display_op_type type;
+	struct rect bbox; /**< area the operation may plot within */
+	union {
+		struct rect clip;
+		struct {
+			plot_style_t style;
+			int x;
+			int y;
+			int radius;
+			int angle1;
+			int angle2;
+		} arc;
+		struct {
+			plot_style_t style;
+			struct rect rect;
+		} rect;
+		struct {
+			plot_style_t style;
+			size_t data;
+			unsigned int n;
+		} points;
+		struct {
+			struct bitmap *bitmap;
+			int x;
+			int y;
+			int width;
+			int height;
+			colour bg;
+			bitmap_flags_t flags;
+		} bitmap;
+		struct {
+			plot_font_style_t style;
+			int x;
+			int y;
+			size_t data;
+			size_t length;
+		} text;
+		struct {
+			size_t data;
+			bool named;
+		} group;
+		struct {
+			struct hlcache_handle *object;
+			struct content_redraw_data data;
+			struct rect clip;
+			/** following operations plotted only on failure */
+			unsigned int fallback;
+		} object;
+		struct {
+			struct browser_window *bw;
+			int x;
+			int y;
+			struct rect clip;
+		} iframe;
+	} u;
+};
+
+/**
+ * Summary of a run of consecutive operations
+ */
+struct display_chunk {
+	struct rect bbox; /**< union of the operation bounding boxes */
+	unsigned int clip; /**< clip operation in force at chunk start */
+	bool groups; /**< whether the chunk contains group operations */
+};
+
+/**
+ * Retained display list
+ */
+struct html_display_list {
+	struct display_op *op; /**< recorded operations */
+	unsigned int op_count; /**< number of operations recorded */
+	unsigned int op_alloc; /**< number of operations allocated */
+
+	char *data; /**< variable sized operation parameters */
+	size_t data_used; /**< bytes of data in use */
+	size_t data_alloc; /**< bytes of data allocated */
+
+	struct display_chunk *chunk; /**< operation chunk summaries */
+	unsigned int chunk_count; /**< number of chunks */
+	unsigned int chunk_alloc; /**< number of chunks allocated */
+
+	struct rect clip; /**< clip in force while recording */
+	unsigned int object; /**< index of last object operation */
+	bool failed; /**< recording could not be completed */
+};
+
+
+/**
+ * Test if two rectangles overlap.
+ */
+static inline bool
+display_list_intersects(const struct rect *a, const struct rect *b)
+{
+	return !(a->x1 < b->x0 || b->x1 < a->x0 ||
+		 a->y1 < b->y0 || b->y1 < a->y0);
+}
+
+
+/**
+ * Add an operation to a display list being recorded.
+ *
+ * \param list display list
+ * \param type type of operation
+ * \param bbox area the operation may plot within, limited to the
+ *             current clip
+ * \return the new operation or NULL on error
+ */
+static struct display_op *
+display_list_add(struct html_display_list *list,
+		 enum display_op_type type,
+		 const struct rect *bbox)
+{
+	struct display_op *op;
+
+	if (list->failed) {
+		return NULL;
+	}
+
+	if (list->op_count == list->op_alloc) {
+		unsigned int alloc = list->op_alloc ? list->op_alloc * 2 : 256;
+
+		if (list->op_count >= DISPLAY_LIST_MAX_OPS) {
+			NSLOG(netsurf, INFO,
+			      "display list exceeded %d operations",
+			      DISPLAY_LIST_MAX_OPS);
+			list->failed = true;
+			return NULL;
+		}
+
+		op = realloc(list->op, alloc * sizeof(*op));
+		if (op == NULL) {
+			list->failed = true;
+			return NULL;
+		}
+		list->op = op;
+		list->op_alloc = alloc;
+	}
+
+	op = &list->op[list->op_count++];
+	op->type = type;
+	op->bbox = *bbox;
+	if (op->bbox.x0 < list->clip.x0) op->bbox.x0 = list->clip.x0;
+	if (op->bbox.y0 < list->clip.y0) op->bbox.y0 = list->clip.y0;
+	if (op->bbox.x1 > list->clip.x1) op->bbox.x1 = list->clip.x1;
+	if (op->bbox.y1 > list->clip.y1) op->bbox.y1 = list->clip.y1;
+
+	return op;
+}
+
+
+/**
+ * Copy variable sized parameters into a display list being recorded.
+ *
+ * \param list display list
+ * \param src parameters to copy
+ * \param size size of parameters in bytes
+ * \param offset_out updated to offset of the copy in the data buffer
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+static nserror
+display_list_data(struct html_display_list *list,
+		  const void *src,
+		  size_t size,
+		  size_t *offset_out)
+{
+	/* keep parameters aligned for any type */
+	size_t offset = (list->data_used + 7) & ~(size_t)7;
+
+	if (offset + size > list->data_alloc) {
+		size_t alloc = list->data_alloc ? list->data_alloc : 4096;
+		char *data;
+
+		while (offset + size > alloc) {
+			alloc *= 2;
+		}
+
+		data = realloc(list->data, alloc);
+		if (data == NULL) {
+			list->failed = true;
+			return NSERROR_NOMEM;
+		}
+		list->data = data;
+		list->data_alloc = alloc;
+	}
+
+	if (size > 0) {
+		memcpy(list->data + offset, src, size);
+	}
+	list->data_used = offset + size;
+	*offset_out = offset;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Get the extra extent a plot style may stroke beyond its geometry.
+ */
+static inline int display_list_stroke(const plot_style_t *pstyle)
+{
+	return plot_style_fixed_to_int(pstyle->stroke_width) + 1;
+}
+
+
+/**
+ * Record a clip operation.
+ *
+ * \param ctx The current redraw context.
+ * \param clip The clip rectangle.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_clip(const struct redraw_context *ctx,
+		       const struct rect *clip)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_op *op;
+
+	/* clip operations replace the clip rather than nesting */
+	list->clip.x0 = INT_MIN;
+	list->clip.y0 = INT_MIN;
+	list->clip.x1 = INT_MAX;
+	list->clip.y1 = INT_MAX;
+
+	op = display_list_add(list, DISPLAY_OP_CLIP, clip);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.clip = *clip;
+	list->clip = *clip;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record an arc operation.
+ *
+ * \param ctx The current redraw context.
+ * \param pstyle Style controlling the arc plot.
+ * \param x The x coordinate of the arc.
+ * \param y The y coordinate of the arc.
+ * \param radius The radius of the arc.
+ * \param angle1 The start angle of the arc.
+ * \param angle2 The finish angle of the arc.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_arc(const struct redraw_context *ctx,
+		      const plot_style_t *pstyle,
+		      int x, int y, int radius, int angle1, int angle2)
+{
+	struct html_display_list *list = ctx->priv;
+	int extent = radius + display_list_stroke(pstyle);
+	struct rect bbox = {
+		x - extent, y - extent, x + extent, y + extent
+	};
+	struct display_op *op;
+
+	op = display_list_add(list, DISPLAY_OP_ARC, &bbox);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.arc.style = *pstyle;
+	op->u.arc.x = x;
+	op->u.arc.y = y;
+	op->u.arc.radius = radius;
+	op->u.arc.angle1 = angle1;
+	op->u.arc.angle2 = angle2;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record a circle operation.
+ *
+ * \param ctx The current redraw context.
+ * \param pstyle Style controlling the circle plot.
+ * \param x The x coordinate of the circle.
+ * \param y The y coordinate of the circle.
+ * \param radius The radius of the circle.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_disc(const struct redraw_context *ctx,
+		       const plot_style_t *pstyle,
+		       int x, int y, int radius)
+{
+	struct html_display_list *list = ctx->priv;
+	int extent = radius + display_list_stroke(pstyle);
+	struct rect bbox = {
+		x - extent, y - extent, x + extent, y + extent
+	};
+	struct display_op *op;
+
+	op = display_list_add(list, DISPLAY_OP_DISC, &bbox);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.arc.style = *pstyle;
+	op->u.arc.x = x;
+	op->u.arc.y = y;
+	op->u.arc.radius = radius;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record a line or rectangle operation.
+ *
+ * \param list display list
+ * \param type type of operation
+ * \param pstyle Style controlling the plot.
+ * \param rect The line or rectangle.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_rect(struct html_display_list *list,
+		  enum display_op_type type,
+		  const plot_style_t *pstyle,
+		  const struct rect *rect)
+{
+	int extent = display_list_stroke(pstyle);
+	struct rect bbox;
+	struct display_op *op;
+
+	bbox.x0 = ((rect->x0 < rect->x1) ? rect->x0 : rect->x1) - extent;
+	bbox.y0 = ((rect->y0 < rect->y1) ? rect->y0 : rect->y1) - extent;
+	bbox.x1 = ((rect->x0 < rect->x1) ? rect->x1 : rect->x0) + extent;
+	bbox.y1 = ((rect->y0 < rect->y1) ? rect->y1 : rect->y0) + extent;
+
+	op = display_list_add(list, type, &bbox);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.rect.style = *pstyle;
+	op->u.rect.rect = *rect;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record a line operation.
+ *
+ * \param ctx The current redraw context.
+ * \param pstyle Style controlling the line plot.
+ * \param line A rectangle defining the line to be drawn
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_line(const struct redraw_context *ctx,
+		       const plot_style_t *pstyle,
+		       const struct rect *line)
+{
+	return display_list_rect(ctx->priv, DISPLAY_OP_LINE, pstyle, line);
+}
+
+
+/**
+ * Record a rectangle operation.
+ *
+ * \param ctx The current redraw context.
+ * \param pstyle Style controlling the rectangle plot.
+ * \param rectangle A rectangle defining the rectangle to be drawn
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_rectangle(const struct redraw_context *ctx,
+			    const plot_style_t *pstyle,
+			    const struct rect *rectangle)
+{
+	return display_list_rect(ctx->priv, DISPLAY_OP_RECTANGLE,
+				 pstyle, rectangle);
+}
+
+
+/**
+ * Record a polygon operation.
+ *
+ * \param ctx The current redraw context.
+ * \param pstyle Style controlling the polygon plot.
+ * \param p verticies of polygon
+ * \param n number of verticies.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_polygon(const struct redraw_context *ctx,
+			  const plot_style_t *pstyle,
+			  const int *p,
+			  unsigned int n)
+{
+	struct html_display_list *list = ctx->priv;
+	struct rect bbox = { INT_MAX, INT_MAX, INT_MIN, INT_MIN };
+	struct display_op *op;
+	unsigned int idx;
+	size_t offset;
+	nserror res;
+
+	for (idx = 0; idx < n; idx++) {
+		if (p[idx * 2] < bbox.x0) bbox.x0 = p[idx * 2];
+		if (p[idx * 2] > bbox.x1) bbox.x1 = p[idx * 2];
+		if (p[idx * 2 + 1] < bbox.y0) bbox.y0 = p[idx * 2 + 1];
+		if (p[idx * 2 + 1] > bbox.y1) bbox.y1 = p[idx * 2 + 1];
+	}
+
+	res = display_list_data(list, p, n * 2 * sizeof(int), &offset);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	op = display_list_add(list, DISPLAY_OP_POLYGON, &bbox);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.points.style = *pstyle;
+	op->u.points.data = offset;
+	op->u.points.n = n;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record a path operation.
+ *
+ * The transform is stored ahead of the path elements.
+ *
+ * \param ctx The current redraw context.
+ * \param pstyle Style controlling the path plot.
+ * \param p elements of path
+ * \param n nunber of elements on path
+ * \param transform A transform to apply to the path.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_path(const struct redraw_context *ctx,
+		       const plot_style_t *pstyle,
+		       const float *p,
+		       unsigned int n,
+		       const float transform[6])
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_op *op;
+	size_t offset;
+	size_t unused;
+	nserror res;
+
+	res = display_list_data(list, transform, 6 * sizeof(float), &offset);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+	res = display_list_data(list, p, n * sizeof(float), &unused);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	/* path extent is not computed so bound it by the clip */
+	op = display_list_add(list, DISPLAY_OP_PATH, &list->clip);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.points.style = *pstyle;
+	op->u.points.data = offset;
+	op->u.points.n = n;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record a bitmap operation.
+ *
+ * \param ctx The current redraw context.
+ * \param bitmap The bitmap to plot
+ * \param x The x coordinate to plot the bitmap
+ * \param y The y coordiante to plot the bitmap
+ * \param width The width of area to plot the bitmap into
+ * \param height The height of area to plot the bitmap into
+ * \param bg the background colour to alpha blend into
+ * \param flags the flags controlling the type of plot operation
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_bitmap(const struct redraw_context *ctx,
+			 struct bitmap *bitmap,
+			 int x, int y,
+			 int width, int height,
+			 colour bg,
+			 bitmap_flags_t flags)
+{
+	struct html_display_list *list = ctx->priv;
+	struct rect bbox = list->clip;
+	struct display_op *op;
+
+	/* tiled bitmaps extend to the clip */
+	if ((flags & BITMAPF_REPEAT_X) == 0) {
+		bbox.x0 = x;
+		bbox.x1 = x + width;
+	}
+	if ((flags & BITMAPF_REPEAT_Y) == 0) {
+		bbox.y0 = y;
+		bbox.y1 = y + height;
+	}
+
+	op = display_list_add(list, DISPLAY_OP_BITMAP, &bbox);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.bitmap.bitmap = bitmap;
+	op->u.bitmap.x = x;
+	op->u.bitmap.y = y;
+	op->u.bitmap.width = width;
+	op->u.bitmap.height = height;
+	op->u.bitmap.bg = bg;
+	op->u.bitmap.flags = flags;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record a text operation.
+ *
+ * \param ctx The current redraw context.
+ * \param fstyle plot style for this text
+ * \param x x coordinate
+ * \param y y coordinate
+ * \param text UTF-8 string to plot
+ * \param length length of string, in bytes
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_text(const struct redraw_context *ctx,
+		       const plot_font_style_t *fstyle,
+		       int x, int y,
+		       const char *text,
+		       size_t length)
+{
+	struct html_display_list *list = ctx->priv;
+	struct rect bbox = list->clip;
+	struct display_op *op;
+	size_t offset;
+	int extent;
+	nserror res;
+
+	/* Text width is not measured; vertically allow twice the font
+	 * size in pixels at the screen resolution, which covers the
+	 * ascent and descent.
+	 */
+	extent = plot_style_fixed_to_int((int64_t)fstyle->size *
+					 FIXTOINT(nscss_screen_dpi) / 72) * 2 + 1;
+	bbox.x0 = x;
+	bbox.y0 = y - extent;
+	bbox.y1 = y + extent;
+
+	res = display_list_data(list, text, length, &offset);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	op = display_list_add(list, DISPLAY_OP_TEXT, &bbox);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.text.style = *fstyle;
+	op->u.text.x = x;
+	op->u.text.y = y;
+	op->u.text.data = offset;
+	op->u.text.length = length;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record the start of a group of operations.
+ *
+ * \param ctx The current redraw context.
+ * \param name The name of the group.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_plot_group_start(const struct redraw_context *ctx,
+			      const char *name)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_op *op;
+	size_t offset = 0;
+	nserror res;
+
+	if (name != NULL) {
+		res = display_list_data(list, name, strlen(name) + 1, &offset);
+		if (res != NSERROR_OK) {
+			return res;
+		}
+	}
+
+	op = display_list_add(list, DISPLAY_OP_GROUP_START, &list->clip);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.group.data = offset;
+	op->u.group.named = (name != NULL);
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Record the end of the most recently started group.
+ *
+ * \param ctx The current redraw context.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror display_list_plot_group_end(const struct redraw_context *ctx)
+{
+	struct html_display_list *list = ctx->priv;
+
+	if (display_list_add(list, DISPLAY_OP_GROUP_END, &list->clip) == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Plotter table which records into a display list.
+ */
+static const struct plotter_table display_list_plotters = {
+	.clip = display_list_plot_clip,
+	.arc = display_list_plot_arc,
+	.disc = display_list_plot_disc,
+	.line = display_list_plot_line,
+	.rectangle = display_list_plot_rectangle,
+	.polygon = display_list_plot_polygon,
+	.path = display_list_plot_path,
+	.bitmap = display_list_plot_bitmap,
+	.text = display_list_plot_text,
+	.group_start = display_list_plot_group_start,
+	.group_end = display_list_plot_group_end,
+	.flush = NULL,
+	.option_knockout = false,
+};
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_create(struct html_display_list **list_out)
+{
+	struct html_display_list *list;
+
+	list = calloc(1, sizeof(*list));
+	if (list == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	*list_out = list;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+void html_display_list_destroy(struct html_display_list *list)
+{
+	if (list == NULL) {
+		return;
+	}
+
+	free(list->op);
+	free(list->data);
+	free(list->chunk);
+	free(list);
+}
+
+
+/* exported interface documented in html/display_list.h */
+void html_display_list_record(struct html_display_list *list,
+			      struct redraw_context *ctx)
+{
+	list->op_count = 0;
+	list->data_used = 0;
+	list->chunk_count = 0;
+	list->clip.x0 = INT_MIN;
+	list->clip.y0 = INT_MIN;
+	list->clip.x1 = INT_MAX;
+	list->clip.y1 = INT_MAX;
+	list->object = UINT_MAX;
+	list->failed = false;
+
+	ctx->interactive = true;
+	ctx->background_images = true;
+	ctx->plot = &display_list_plotters;
+	ctx->priv = list;
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_finish(struct html_display_list *list)
+{
+	unsigned int clip = DISPLAY_LIST_NO_CLIP;
+	unsigned int count;
+	unsigned int idx;
+
+	if (list->failed) {
+		return NSERROR_NOMEM;
+	}
+
+	count = (list->op_count + DISPLAY_LIST_CHUNK - 1) / DISPLAY_LIST_CHUNK;
+	if (count > list->chunk_alloc) {
+		struct display_chunk *chunk;
+
+		chunk = realloc(list->chunk, count * sizeof(*chunk));
+		if (chunk == NULL) {
+			list->failed = true;
+			return NSERROR_NOMEM;
+		}
+		list->chunk = chunk;
+		list->chunk_alloc = count;
+	}
+	list->chunk_count = count;
+
+	for (idx = 0; idx < list->op_count; idx++) {
+		struct display_chunk *chunk;
+		struct display_op *op = &list->op[idx];
+
+		chunk = &list->chunk[idx / DISPLAY_LIST_CHUNK];
+		if ((idx % DISPLAY_LIST_CHUNK) == 0) {
+			chunk->bbox.x0 = INT_MAX;
+			chunk->bbox.y0 = INT_MAX;
+			chunk->bbox.x1 = INT_MIN;
+			chunk->bbox.y1 = INT_MIN;
+			chunk->clip = clip;
+			chunk->groups = false;
+		}
+
+		switch (op->type) {
+		case DISPLAY_OP_CLIP:
+			clip = idx;
+			break;
+
+		case DISPLAY_OP_GROUP_START:
+		case DISPLAY_OP_GROUP_END:
+			chunk->groups = true;
+			break;
+
+		default:
+			if (op->bbox.x0 < chunk->bbox.x0)
+				chunk->bbox.x0 = op->bbox.x0;
+			if (op->bbox.y0 < chunk->bbox.y0)
+				chunk->bbox.y0 = op->bbox.y0;
+			if (op->bbox.x1 > chunk->bbox.x1)
+				chunk->bbox.x1 = op->bbox.x1;
+			if (op->bbox.y1 > chunk->bbox.y1)
+				chunk->bbox.y1 = op->bbox.y1;
+			break;
+		}
+	}
+
+	NSLOG(netsurf, DEBUG,
+	      "display list of %u operations, %"PRIsizet" bytes data",
+	      list->op_count, list->data_used);
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+bool html_display_list_recording(const struct redraw_context *ctx)
+{
+	return (ctx->plot == &display_list_plotters);
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_object(const struct redraw_context *ctx,
+				 struct hlcache_handle *object,
+				 const struct content_redraw_data *data,
+				 const struct rect *clip)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_op *op;
+
+	op = display_list_add(list, DISPLAY_OP_OBJECT, clip);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.object.object = object;
+	op->u.object.data = *data;
+	op->u.object.clip = *clip;
+	op->u.object.fallback = 0;
+	list->object = op - list->op;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in html/display_list.h */
+void html_display_list_fallback(const struct redraw_context *ctx)
+{
+	struct html_display_list *list = ctx->priv;
+
+	if (list->failed || list->object >= list->op_count) {
+		return;
+	}
+
+	list->op[list->object].u.object.fallback =
+			list->op_count - list->object - 1;
+}
+
+
+/* exported interface documented in html/display_list.h */
+nserror html_display_list_iframe(const struct redraw_context *ctx,
+				 struct browser_window *bw,
+				 int x, int y,
+				 const struct rect *clip)
+{
+	struct html_display_list *list = ctx->priv;
+	struct display_op *op;
+
+	op = display_list_add(list, DISPLAY_OP_IFRAME, clip);
+	if (op == NULL) {
+		return NSERROR_NOMEM;
+	}
+	op->u.iframe.bw = bw;
+	op->u.iframe.x = x;
+	op->u.iframe.y = y;
+	op->u.iframe.clip = *clip;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Replay state
+ */
+struct display_list_replay {
+	const struct html_display_list *list;
+	const struct redraw_context *ctx;
+	int x; /**< offset to plot at */
+	int y; /**< offset to plot at */
+	struct rect area; /**< replay clip in content coordinates */
+	unsigned int clip; /**< recorded clip operation in force */
+	bool applied; /**< whether the clip in force has been plotted */
+	bool empty; /**< whether the clip in force is empty */
+	unsigned int skip; /**< operations before this are not plotted */
+	struct rect target; /**< clip in force, in target coordinates */
+};
+
+
+/**
+ * Intersect a recorded rectangle with the replay area.
+ *
+ * \param replay replay state
+ * \param r recorded rectangle, or NULL for the whole area
+ * \param out updated to the intersection, in target coordinates
+ * \return true if the intersection is not empty
+ */
+static bool
+display_list_target_rect(const struct display_list_replay *replay,
+			 const struct rect *r,
+			 struct rect *out)
+{
+	*out = replay->area;
+	if (r != NULL) {
+		if (r->x0 > out->x0) out->x0 = r->x0;
+		if (r->y0 > out->y0) out->y0 = r->y0;
+		if (r->x1 < out->x1) out->x1 = r->x1;
+		if (r->y1 < out->y1) out->y1 = r->y1;
+	}
+
+	out->x0 += replay->x;
+	out->y0 += replay->y;
+	out->x1 += replay->x;
+	out->y1 += replay->y;
+
+	return (out->x0 < out->x1) && (out->y0 < out->y1);
+}
+
+
+/**
+ * Plot the clip in force if it has not been already.
+ *
+ * \param replay replay state
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror display_list_apply_clip(struct display_list_replay *replay)
+{
+	const struct rect *r = NULL;
+
+	if (replay->applied) {
+		return NSERROR_OK;
+	}
+	replay->applied = true;
+
+	if (replay->clip != DISPLAY_LIST_NO_CLIP) {
+		r = &replay->list->op[replay->clip].u.clip;
+	}
+
+	replay->empty = !display_list_target_rect(replay, r, &replay->target);
+	if (replay->empty) {
+		return NSERROR_OK;
+	}
+
+	return replay->ctx->plot->clip(replay->ctx, &replay->target);
+}
+
+
+/**
+ * Replay the group operations of a chunk which is otherwise skipped.
+ *
+ * \param replay replay state
+ * \param first index of first operation of chunk
+ * \param last index after last operation of chunk
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_replay_groups(struct display_list_replay *replay,
+			   unsigned int first,
+			   unsigned int last)
+{
+	const struct redraw_context *ctx = replay->ctx;
+	const struct html_display_list *list = replay->list;
+	nserror res = NSERROR_OK;
+	unsigned int idx;
+
+	for (idx = first; (idx < last) && (res == NSERROR_OK); idx++) {
+		const struct display_op *op = &list->op[idx];
+
+		if (op->type == DISPLAY_OP_GROUP_START) {
+			res = ctx->plot->group_start(ctx, op->u.group.named ?
+					list->data + op->u.group.data : NULL);
+		} else if ((op->type == DISPLAY_OP_GROUP_END) &&
+			   (ctx->plot->group_end != NULL)) {
+			res = ctx->plot->group_end(ctx);
+		}
+	}
+
+	return res;
+}
+
+
+/**
+ * Replay a single drawing operation.
+ *
+ * \param replay replay state
+ * \param op operation to replay
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+display_list_replay_op(struct display_list_replay *replay,
+		       const struct display_op *op)
+{
+	const struct redraw_context *ctx = replay->ctx;
+	const struct html_display_list *list = replay->list;
+	int x = replay->x;
+	int y = replay->y;
+	struct rect r;
+	nserror res;
+
+	if (op->type == DISPLAY_OP_OBJECT) {
+		/* the fallback is only plotted if the object is not */
+		replay->skip = (op - list->op) + 1 + op->u.object.fallback;
+	}
+
+	res = display_list_apply_clip(replay);
+	if ((res != NSERROR_OK) || replay->empty) {
+		return res;
+	}
+
+	switch (op->type) {
+	case DISPLAY_OP_ARC:
+		res = ctx->plot->arc(ctx, &op->u.arc.style,
+				     op->u.arc.x + x, op->u.arc.y + y,
+				     op->u.arc.radius,
+				     op->u.arc.angle1, op->u.arc.angle2);
+		break;
+
+	case DISPLAY_OP_DISC:
+		res = ctx->plot->disc(ctx, &op->u.arc.style,
+				      op->u.arc.x + x, op->u.arc.y + y,
+				      op->u.arc.radius);
+		break;
+
+	case DISPLAY_OP_LINE:
+	case DISPLAY_OP_RECTANGLE:
+		r.x0 = op->u.rect.rect.x0 + x;
+		r.y0 = op->u.rect.rect.y0 + y;
+		r.x1 = op->u.rect.rect.x1 + x;
+		r.y1 = op->u.rect.rect.y1 + y;
+		if (op->type == DISPLAY_OP_LINE) {
+			res = ctx->plot->line(ctx, &op->u.rect.style, &r);
+		} else {
+			res = ctx->plot->rectangle(ctx, &op->u.rect.style, &r);
+		}
+		break;
+
+	case DISPLAY_OP_POLYGON: {
+		const int *p = (const int *)(list->data + op->u.points.data);
+		unsigned int n = op->u.points.n;
+		int stack[32];
+		int *points = stack;
+		unsigned int idx;
+
+		if (n * 2 > sizeof(stack) / sizeof(stack[0])) {
+			points = malloc(n * 2 * sizeof(int));
+			if (points == NULL) {
+				return NSERROR_NOMEM;
+			}
+		}
+		for (idx = 0; idx < n; idx++) {
+			points[idx * 2] = p[idx * 2] + x;
+			points[idx * 2 + 1] = p[idx * 2 + 1] + y;
+		}
+		res = ctx->plot->polygon(ctx, &op->u.points.style, points, n);
+		if (points != stack) {
+			free(points);
+		}
+		break;
+	}
+
+	case DISPLAY_OP_PATH: {
+		const float *p = (const float *)(list->data + op->u.points.data);
+		float transform[6];
+
+		memcpy(transform, p, sizeof(transform));
+		transform[4] += x;
+		transform[5] += y;
+		res = ctx->plot->path(ctx, &op->u.points.style,
+				      p + 6, op->u.points.n, transform);
+		break;
+	}
+
+	case DISPLAY_OP_BITMAP:
+		res = ctx->plot->bitmap(ctx, op->u.bitmap.bitmap,
+					op->u.bitmap.x + x, op->u.bitmap.y + y,
+					op->u.bitmap.width, op->u.bitmap.height,
+					op->u.bitmap.bg, op->u.bitmap.flags);
+		break;
+
+	case DISPLAY_OP_TEXT:
+		res = ctx->plot->text(ctx, &op->u.text.style,
+				      op->u.text.x + x, op->u.text.y + y,
+				      list->data + op->u.text.data,
+				      op->u.text.length);
+		break;
+
+	case DISPLAY_OP_OBJECT: {
+		struct content_redraw_data data = op->u.object.data;
+
+		if (display_list_target_rect(replay, &op->u.object.clip, &r)) {
+			data.x += x;
+			data.y += y;
+			if (!content_redraw(op->u.object.object,
+					    &data, &r, ctx)) {
+				replay->skip = 0;
+			}
+			/* the object may have changed the clip */
+			replay->applied = false;
+		}
+		break;
+	}
+
+	case DISPLAY_OP_IFRAME:
+		if (display_list_target_rect(replay, &op->u.iframe.clip, &r)) {
+			browser_window_redraw(op->u.iframe.bw,
+					      op->u.iframe.x + x,
+					      op->u.iframe.y + y,
+					      &r, ctx);
+			replay->applied = false;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return res;
+}
+
+
+/* exported interface documented in html/display_list.h */
+bool html_display_list_replay(const struct html_display_list *list,
+			      int x, int y,
+			      const struct rect *clip,
+			      const struct redraw_context *ctx)
+{
+	struct display_list_replay replay;
+	unsigned int chunk;
+	nserror res = NSERROR_OK;
+
+	replay.list = list;
+	replay.ctx = ctx;
+	replay.x = x;
+	replay.y = y;
+	replay.area.x0 = clip->x0 - x;
+	replay.area.y0 = clip->y0 - y;
+	replay.area.x1 = clip->x1 - x;
+	replay.area.y1 = clip->y1 - y;
+	replay.clip = DISPLAY_LIST_NO_CLIP;
+	replay.applied = false;
+	replay.empty = false;
+	replay.skip = 0;
+
+	for (chunk = 0;
+	     (chunk < list->chunk_count) && (res == NSERROR_OK);
+	     chunk++) {
+		const struct display_chunk *summary = &list->chunk[chunk];
+		unsigned int first = chunk * DISPLAY_LIST_CHUNK;
+		unsigned int last = first + DISPLAY_LIST_CHUNK;
+		unsigned int idx;
+
+		if (last > list->op_count) {
+			last = list->op_count;
+		}
+
+		if (!display_list_intersects(&summary->bbox, &replay.area)) {
+			/* nothing visible but groups must stay balanced */
+			if (summary->groups && ctx->plot->group_start != NULL) {
+				res = display_list_replay_groups(&replay,
+								 first, last);
+			}
+			continue;
+		}
+
+		if (replay.clip != summary->clip) {
+			replay.clip = summary->clip;
+			replay.applied = false;
+		}
+
+		for (idx = first; (idx < last) && (res == NSERROR_OK); idx++) {
+			const struct display_op *op = &list->op[idx];
+
+			if (idx < replay.skip) {
+				/* fallback of an object which was plotted */
+				continue;
+			}
+
+			switch (op->type) {
+			case DISPLAY_OP_CLIP:
+				replay.clip = idx;
+				replay.applied = false;
+				break;
+
+			case DISPLAY_OP_GROUP_START:
+			case DISPLAY_OP_GROUP_END:
+				if (ctx->plot->group_start != NULL) {
+					res = display_list_replay_groups(
+							&replay, idx, idx + 1);
+				}
+				break;
+
+			default:
+				if (display_list_intersects(&op->bbox,
+							    &replay.area)) {
+					res = display_list_replay_op(&replay,
+								     op);
+				} else if (op->type == DISPLAY_OP_OBJECT) {
+					replay.skip = idx + 1 +
+						op->u.object.fallback;
+				}
+				break;
+			}
+		}
+	}
+
+	return (res == NSERROR_OK);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * HTML retained display list interface.
+ *
+ * A display list records the plot operations for a whole laid-out
+ * document, in content coordinates, so that they can be replayed
+ * for any clip rectangle and offset without walking the box tree.
+ *
+ * Embedded objects and iframes are recorded as references and are
+ * redrawn through their own handlers on replay, so they may change
+ * without the list being rebuilt.
+ */
+
+#ifndef NETSURF_HTML_DISPLAY_LIST_H
+#define NETSURF_HTML_DISPLAY_LIST_H
+
+struct hlcache_handle;
+struct browser_window;
+struct content_redraw_data;
+struct redraw_context;
+struct rect;
+struct html_display_list;
+
+/**
+ * Create an empty display list.
+ *
+ * \param list_out updated to the new display list
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+nserror html_display_list_create(struct html_display_list **list_out);
+
+
+/**
+ * Destroy a display list.
+ *
+ * \param list display list to destroy, may be NULL
+ */
+void html_display_list_destroy(struct html_display_list *list);
+
+
+/**
+ * Empty a display list and set up a context which records into it.
+ *
+ * \param list display list to record into
+ * \param ctx  redraw context to initialise for recording
+ */
+void html_display_list_record(struct html_display_list *list,
+			      struct redraw_context *ctx);
+
+
+/**
+ * Complete recording into a display list.
+ *
+ * \param list display list which has been recorded into
+ * \return NSERROR_OK if the list may be replayed else error code
+ */
+nserror html_display_list_finish(struct html_display_list *list);
+
+
+/**
+ * Determine if a redraw context is recording into a display list.
+ *
+ * \param ctx redraw context
+ * \return true if plot operations are being recorded
+ */
+bool html_display_list_recording(const struct redraw_context *ctx);
+
+
+/**
+ * Record the redraw of an embedded object.
+ *
+ * \param ctx    recording redraw context
+ * \param object object to redraw on replay
+ * \param data   redraw data for the object
+ * \param clip   clip rectangle for the object
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+nserror html_display_list_object(const struct redraw_context *ctx,
+				 struct hlcache_handle *object,
+				 const struct content_redraw_data *data,
+				 const struct rect *clip);
+
+
+/**
+ * Mark the end of the fallback for the last recorded object.
+ *
+ * Operations recorded after html_display_list_object() and before
+ * this are only replayed if the object fails to redraw.
+ *
+ * \param ctx recording redraw context
+ */
+void html_display_list_fallback(const struct redraw_context *ctx);
+
+
+/**
+ * Record the redraw of an iframe.
+ *
+ * \param ctx  recording redraw context
+ * \param bw   browser window of the iframe
+ * \param x    x coordinate of the iframe
+ * \param y    y coordinate of the iframe
+ * \param clip clip rectangle for the iframe
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+nserror html_display_list_iframe(const struct redraw_context *ctx,
+				 struct browser_window *bw,
+				 int x, int y,
+				 const struct rect *clip);
+
+
+/**
+ * Replay a display list.
+ *
+ * Only the operations which may intersect the clip rectangle are
+ * plotted.
+ *
+ * \param list display list to replay
+ * \param x    offset to plot the list at
+ * \param y    offset to plot the list at
+ * \param clip clip rectangle, in target coordinates
+ * \param ctx  redraw context to plot with
+ * \return true if successful, false otherwise
+ */
+bool html_display_list_replay(const struct html_display_list *list,
+			      int x, int y,
+			      const struct rect *clip,
+			      const struct redraw_context *ctx);
+
+#endif
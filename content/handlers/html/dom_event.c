@@ -33,6 +33,7 @@
 #include "utils/nsurl.h"
 #include "content/content.h"
 #include "javascript/js.h"
+#include "css/select.h"
 
 #include "netsurf/bitmap.h"
 
@@ -568,10 +569,10 @@ static void html_texty_element_update(html_content *htmlc, dom_node *node)
 	if (box == NULL) {
 		return; /* No Box (yet?) so no gadget to update */
 	}
-	if (box->gadget == NULL) {
+	if (box->extra->gadget == NULL) {
 		return; /* No gadget yet (under construction perhaps?) */
 	}
-	form_gadget_sync_with_dom(box->gadget);
+	form_gadget_sync_with_dom(box->extra->gadget);
 	/* And schedule a redraw for the box */
 	html__redraw_a_box(htmlc, box);
 }
@@ -594,6 +595,18 @@ dom_default_action_DOMNodeInserted_cb(struct dom_event *evt, void *pw)
 		return;
 	}
 
+	if (htmlc->sibling_cache != NULL) {
+		/* the siblings of the node have changed */
+		dom_node *parent;
+
+		exc = dom_node_get_parent_node(node, &parent);
+		if ((exc == DOM_NO_ERR) && (parent != NULL)) {
+			nscss_sibling_cache_invalidate(htmlc->sibling_cache,
+						       parent);
+			dom_node_unref(parent);
+		}
+	}
+
 	exc = dom_node_get_node_type(node, &type);
 	if ((exc == DOM_NO_ERR) && (type == DOM_ELEMENT_NODE)) {
 		/* an element node has been inserted */
@@ -711,6 +724,10 @@ dom_default_action_DOMSubtreeModified_cb(struct dom_event *evt, void *pw)
 
 	exc = dom_event_get_target(evt, &node);
 	if ((exc == DOM_NO_ERR) && (node != NULL)) {
+		/* children may have been removed from the node */
+		nscss_sibling_cache_invalidate(htmlc->sibling_cache,
+					       (dom_node *)node);
+
 		if (htmlc->title == (dom_node *)node) {
 			/* Node is our title node */
 			html_process_title(htmlc, (dom_node *)node);
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * implementation of block formatting context float index.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/errors.h"
+
+#include "html/box.h"
+#include "html/float_index.h"
+
+/** Number of entries allocated when an index is first used */
+#define FLOAT_INDEX_INITIAL_ALLOC 16
+
+/**
+ * Entry in a float index
+ */
+struct float_index_entry {
+	struct box *fl; /**< float box */
+	int max_y1; /**< greatest bottom edge of this and all prior floats */
+};
+
+/**
+ * Index of the floats of a block formatting context by top edge
+ */
+struct float_index {
+	bool valid; /**< whether the index holds every float */
+	unsigned int count; /**< number of entries in use */
+	unsigned int alloc; /**< number of entries allocated */
+	int left_y1; /**< greatest bottom edge of the left floats */
+	int right_y1; /**< greatest bottom edge of the right floats */
+	struct float_index_entry *entry; /**< entries ordered by top edge */
+};
+
+
+/* exported interface documented in html/float_index.h */
+void float_index_reset(struct box *cont)
+{
+	struct float_index *index = cont->float_index;
+
+	if (index == NULL) {
+		return;
+	}
+
+	index->valid = true;
+	index->count = 0;
+	index->left_y1 = 0;
+	index->right_y1 = 0;
+}
+
+
+/* exported interface documented in html/float_index.h */
+void float_index_free(struct box *box)
+{
+	if (box->float_index == NULL) {
+		return;
+	}
+
+	free(box->float_index->entry);
+	free(box->float_index);
+	box->float_index = NULL;
+}
+
+
+/* exported interface documented in html/float_index.h */
+void float_index_add(struct box *cont, struct box *fl)
+{
+	struct float_index *index = cont->float_index;
+	int y1 = fl->y + fl->height;
+	unsigned int idx;
+	int extreme;
+
+	if (index == NULL) {
+		if (cont->float_children != fl || fl->next_float != NULL) {
+			/* earlier floats were not indexed */
+			return;
+		}
+		index = calloc(1, sizeof(*index));
+		if (index == NULL) {
+			return;
+		}
+		index->valid = true;
+		cont->float_index = index;
+	}
+
+	if (!index->valid) {
+		return;
+	}
+
+	if (index->count == index->alloc) {
+		struct float_index_entry *entry;
+		unsigned int alloc;
+
+		alloc = (index->alloc == 0) ?
+			FLOAT_INDEX_INITIAL_ALLOC : index->alloc * 2;
+		entry = realloc(index->entry, alloc * sizeof(*entry));
+		if (entry == NULL) {
+			/* the list must be searched from now on */
+			index->valid = false;
+			return;
+		}
+		index->entry = entry;
+		index->alloc = alloc;
+	}
+
+	/* floats are usually placed in order of their top edges */
+	idx = index->count;
+	while (idx > 0 && index->entry[idx - 1].fl->y > fl->y) {
+		idx--;
+	}
+	memmove(&index->entry[idx + 1], &index->entry[idx],
+			(index->count - idx) * sizeof(index->entry[0]));
+	index->entry[idx].fl = fl;
+	index->count++;
+
+	/* update the running maximum of the bottom edges */
+	extreme = (idx == 0) ? y1 : index->entry[idx - 1].max_y1;
+	for (; idx != index->count; idx++) {
+		int fy1 = index->entry[idx].fl->y + index->entry[idx].fl->height;
+
+		if (extreme < fy1) {
+			extreme = fy1;
+		}
+		index->entry[idx].max_y1 = extreme;
+	}
+
+	if (fl->type == BOX_FLOAT_LEFT) {
+		if (index->left_y1 < y1) {
+			index->left_y1 = y1;
+		}
+	} else {
+		if (index->right_y1 < y1) {
+			index->right_y1 = y1;
+		}
+	}
+}
+
+
+/* exported interface documented in html/float_index.h */
+bool float_index_find_sides(const struct box *cont, int y0, int y1,
+		int *x0, int *x1, struct box **left, struct box **right)
+{
+	const struct float_index *index = cont->float_index;
+	unsigned int lo = 0;
+	unsigned int hi;
+	int fy1, fx0, fx1;
+
+	if (index == NULL || !index->valid) {
+		return false;
+	}
+
+	*left = *right = NULL;
+
+	/* find the floats whose top edge is not below the range */
+	hi = index->count;
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (index->entry[mid].fl->y <= y1) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	/* walk back until no earlier float reaches the range */
+	while (lo > 0 && index->entry[lo - 1].max_y1 > y0) {
+		struct box *fl = index->entry[--lo].fl;
+
+		fy1 = fl->y + fl->height;
+		if (fy1 <= y0) {
+			continue;
+		}
+
+		/* on ties prefer the float the list would find first,
+		 * the one whose bottom edge is furthest down */
+		if (fl->type == BOX_FLOAT_LEFT) {
+			fx1 = fl->x + fl->width;
+			if (*x0 < fx1 || (*left != NULL && *x0 == fx1 &&
+					fy1 > (*left)->y + (*left)->height)) {
+				*x0 = fx1;
+				*left = fl;
+			}
+		} else {
+			fx0 = fl->x;
+			if (fx0 < *x1 || (*right != NULL && fx0 == *x1 &&
+					fy1 > (*right)->y + (*right)->height)) {
+				*x1 = fx0;
+				*right = fl;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/* exported interface documented in html/float_index.h */
+bool float_index_clear(const struct box *cont, enum css_clear_e clear, int *y)
+{
+	const struct float_index *index = cont->float_index;
+
+	if (index == NULL || !index->valid) {
+		return false;
+	}
+
+	*y = 0;
+	if ((clear == CSS_CLEAR_LEFT || clear == CSS_CLEAR_BOTH) &&
+	    *y < index->left_y1) {
+		*y = index->left_y1;
+	}
+	if ((clear == CSS_CLEAR_RIGHT || clear == CSS_CLEAR_BOTH) &&
+	    *y < index->right_y1) {
+		*y = index->right_y1;
+	}
+
+	return true;
+}
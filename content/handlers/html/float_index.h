@@ -0,0 +1,94 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Block formatting context float index interface.
+ *
+ * While a block formatting context is laid out its floats are also
+ * kept ordered by their top edge together with the running maximum
+ * of their bottom edges. The floats beside a vertical range are found
+ * with a binary search instead of a walk of the whole float list.
+ *
+ * The index is a cache of the float_children list. If it could not
+ * be allocated the queries report it is unavailable and the list must
+ * be used instead.
+ */
+
+#ifndef NETSURF_HTML_FLOAT_INDEX_H
+#define NETSURF_HTML_FLOAT_INDEX_H
+
+struct box;
+
+/**
+ * Empty the float index of a block formatting context.
+ *
+ * Must be called whenever the float_children list of the box is
+ * emptied.
+ *
+ * \param cont block formatting context box
+ */
+void float_index_reset(struct box *cont);
+
+
+/**
+ * Add a placed float to the index of a block formatting context.
+ *
+ * \param cont block formatting context box
+ * \param fl   float box, positioned relative to cont
+ */
+void float_index_add(struct box *cont, struct box *fl);
+
+
+/**
+ * Release the float index of a box, if it has one.
+ *
+ * \param box box to release index of
+ */
+void float_index_free(struct box *box);
+
+
+/**
+ * Find left and right edges in a vertical range.
+ *
+ * \param cont  block formatting context box
+ * \param y0    start of y range to search
+ * \param y1    end of y range to search
+ * \param x0    start left edge, updated to available left edge
+ * \param x1    start right edge, updated to available right edge
+ * \param left  returns float on left if present
+ * \param right returns float on right if present
+ * \return true if the index answered the query, false if the
+ *         float_children list must be searched
+ */
+bool float_index_find_sides(const struct box *cont, int y0, int y1,
+		int *x0, int *x1, struct box **left, struct box **right);
+
+
+/**
+ * Find y coordinate which clears floats on left and/or right.
+ *
+ * \param cont  block formatting context box
+ * \param clear type of clear
+ * \param y     updated to y coordinate relative to cont
+ * \return true if the index answered the query, false if the
+ *         float_children list must be searched
+ */
+bool float_index_clear(const struct box *cont, enum css_clear_e clear, int *y);
+
+#endif
@@ -22,8 +22,15 @@
  * HTML internal font handling implementation.
  */
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/errors.h"
+#include "utils/log.h"
 #include "utils/nsoption.h"
 #include "netsurf/plot_style.h"
+#include "netsurf/layout.h"
 #include "css/utils.h"
 
 #include "html/font.h"
@@ -163,3 +170,336 @@ void font_plot_style_from_css(
 	fstyle->foreground = nscss_color_to_ns(col);
 	fstyle->background = 0;
 }
+
+
+/** Number of entries in the text width cache */
+#define FONT_WIDTH_CACHE_SIZE 4096
+
+/** Longest string, in bytes, kept in the text width cache */
+#define FONT_WIDTH_CACHE_TEXT 31
+
+/** Most font family names kept in a text width cache entry */
+#define FONT_WIDTH_CACHE_FAMILIES 4
+
+/**
+ * Text width cache entry
+ *
+ * Everything in a plot font style except the colours affects the
+ * width. The family names are held by reference; unused trailing
+ * names are NULL.
+ */
+struct font_width_entry {
+	const struct gui_layout_table *font_func; /**< Measuring table */
+	lwc_string *families[FONT_WIDTH_CACHE_FAMILIES]; /**< Family names */
+	plot_style_fixed size; /**< Font size */
+	int weight; /**< Font weight */
+	plot_font_generic_family_t family; /**< Generic family */
+	plot_font_flags_t flags; /**< Font flags */
+	int width; /**< Measured width */
+	uint8_t length; /**< Length of text, 0 if entry unused */
+	char text[FONT_WIDTH_CACHE_TEXT]; /**< Measured text */
+};
+
+/**
+ * Font options the cached widths were measured with
+ */
+struct font_width_options {
+	char *names[PLOT_FONT_FAMILY_COUNT]; /**< Generic family fonts */
+	int font_default; /**< Default generic family */
+};
+
+/** Text width cache, direct mapped */
+static struct font_width_entry *font_width_cache;
+
+/** Options in force when the cache was filled */
+static struct font_width_options font_width_options;
+
+/** Text width cache statistics */
+static struct font_width_cache_stats font_width_stats;
+
+
+/**
+ * Hash the family names of a font style
+ *
+ * \param fstyle font style to hash
+ * \param count updated to the number of family names
+ * \return hash of the font family names
+ */
+static uint32_t
+font_width_families(const plot_font_style_t *fstyle, unsigned int *count)
+{
+	lwc_string * const *family;
+	uint32_t hash = 0x811c9dc5;
+
+	*count = 0;
+
+	if (fstyle->families == NULL) {
+		return hash;
+	}
+
+	for (family = fstyle->families; *family != NULL; family++) {
+		hash = (hash ^ lwc_string_hash_value(*family)) * 0x01000193;
+		hash = (hash ^ lwc_string_length(*family)) * 0x01000193;
+		(*count)++;
+	}
+
+	return hash;
+}
+
+
+/**
+ * Check whether a cache entry was measured with a style's family names
+ *
+ * Family names are interned so they are the same only if the pointers
+ * are.
+ *
+ * \param entry cache entry to check
+ * \param fstyle font style to compare with
+ * \param count number of family names in the style
+ * \return true if the entry has exactly the style's family names
+ */
+static bool
+font_width_families_match(const struct font_width_entry *entry,
+			  const plot_font_style_t *fstyle,
+			  unsigned int count)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < count; idx++) {
+		if (entry->families[idx] != fstyle->families[idx]) {
+			return false;
+		}
+	}
+
+	return (count == FONT_WIDTH_CACHE_FAMILIES) ||
+		(entry->families[count] == NULL);
+}
+
+
+/**
+ * Release the contents of a cache entry, leaving it unused
+ *
+ * \param entry cache entry to release
+ */
+static void font_width_entry_clear(struct font_width_entry *entry)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < FONT_WIDTH_CACHE_FAMILIES; idx++) {
+		if (entry->families[idx] != NULL) {
+			lwc_string_unref(entry->families[idx]);
+			entry->families[idx] = NULL;
+		}
+	}
+	entry->length = 0;
+}
+
+
+/**
+ * Release every entry of the text width cache
+ */
+static void font_width_cache_clear(void)
+{
+	int idx;
+
+	for (idx = 0; idx < FONT_WIDTH_CACHE_SIZE; idx++) {
+		font_width_entry_clear(&font_width_cache[idx]);
+	}
+}
+
+
+/**
+ * Find the cache slot for a measurement
+ *
+ * \param fstyle font style of the text
+ * \param families hash of the style's family names
+ * \param string text to measure
+ * \param length length of text in bytes
+ * \return the entry the measurement belongs in
+ */
+static struct font_width_entry *
+font_width_slot(const plot_font_style_t *fstyle,
+		uint32_t families,
+		const char *string,
+		size_t length)
+{
+	uint32_t hash = families;
+	size_t idx;
+
+	hash = (hash ^ fstyle->size) * 0x01000193;
+	hash = (hash ^ fstyle->weight) * 0x01000193;
+	hash = (hash ^ ((fstyle->family << 8) | fstyle->flags)) * 0x01000193;
+	for (idx = 0; idx < length; idx++) {
+		hash = (hash ^ (uint8_t)string[idx]) * 0x01000193;
+	}
+
+	return &font_width_cache[hash % FONT_WIDTH_CACHE_SIZE];
+}
+
+
+/**
+ * Check whether the font options differ from those the cache was filled
+ * with, updating the record of them if so.
+ *
+ * \return true if the options have changed
+ */
+static bool font_width_options_changed(void)
+{
+	const char *names[PLOT_FONT_FAMILY_COUNT];
+	bool changed = false;
+	int idx;
+
+	names[PLOT_FONT_FAMILY_SANS_SERIF] = nsoption_charp(font_sans);
+	names[PLOT_FONT_FAMILY_SERIF] = nsoption_charp(font_serif);
+	names[PLOT_FONT_FAMILY_MONOSPACE] = nsoption_charp(font_mono);
+	names[PLOT_FONT_FAMILY_CURSIVE] = nsoption_charp(font_cursive);
+	names[PLOT_FONT_FAMILY_FANTASY] = nsoption_charp(font_fantasy);
+
+	if (font_width_options.font_default != nsoption_int(font_default)) {
+		font_width_options.font_default = nsoption_int(font_default);
+		changed = true;
+	}
+
+	for (idx = 0; idx < PLOT_FONT_FAMILY_COUNT; idx++) {
+		char *old = font_width_options.names[idx];
+
+		if ((old == NULL) && (names[idx] == NULL)) {
+			continue;
+		}
+		if ((old != NULL) && (names[idx] != NULL) &&
+		    (strcmp(old, names[idx]) == 0)) {
+			continue;
+		}
+
+		free(old);
+		font_width_options.names[idx] = NULL;
+		if (names[idx] != NULL) {
+			font_width_options.names[idx] = strdup(names[idx]);
+		}
+		changed = true;
+	}
+
+	return changed;
+}
+
+
+/* exported function documented in html/font.h */
+void font_width_cache_validate(void)
+{
+	if (font_width_options_changed() && (font_width_cache != NULL)) {
+		NSLOG(netsurf, INFO, "Font options changed, flushing %u widths",
+		      font_width_stats.entries);
+		font_width_cache_clear();
+		font_width_stats.entries = 0;
+		font_width_stats.flushes++;
+	}
+}
+
+
+/* exported function documented in html/font.h */
+nserror
+font_width_cached(const struct gui_layout_table *font_func,
+		  const plot_font_style_t *fstyle,
+		  const char *string,
+		  size_t length,
+		  int *width)
+{
+	struct font_width_entry *entry;
+	uint32_t families;
+	unsigned int count;
+	unsigned int idx;
+	nserror res;
+
+	if (length > FONT_WIDTH_CACHE_TEXT) {
+		return font_func->width(fstyle, string, length, width);
+	}
+
+	families = font_width_families(fstyle, &count);
+	if (count > FONT_WIDTH_CACHE_FAMILIES) {
+		return font_func->width(fstyle, string, length, width);
+	}
+
+	if (font_width_cache == NULL) {
+		font_width_cache = calloc(FONT_WIDTH_CACHE_SIZE,
+					  sizeof(*font_width_cache));
+		if (font_width_cache == NULL) {
+			return font_func->width(fstyle, string, length, width);
+		}
+		font_width_options_changed();
+	}
+
+	entry = font_width_slot(fstyle, families, string, length);
+
+	if ((entry->length == length) &&
+	    (entry->font_func == font_func) &&
+	    font_width_families_match(entry, fstyle, count) &&
+	    (entry->size == fstyle->size) &&
+	    (entry->weight == fstyle->weight) &&
+	    (entry->family == fstyle->family) &&
+	    (entry->flags == fstyle->flags) &&
+	    (memcmp(entry->text, string, length) == 0)) {
+		font_width_stats.hits++;
+		*width = entry->width;
+		return NSERROR_OK;
+	}
+
+	font_width_stats.misses++;
+
+	res = font_func->width(fstyle, string, length, width);
+	if ((res != NSERROR_OK) || (length == 0)) {
+		return res;
+	}
+
+	if (entry->length == 0) {
+		font_width_stats.entries++;
+	} else {
+		font_width_stats.evictions++;
+		font_width_entry_clear(entry);
+	}
+
+	entry->font_func = font_func;
+	for (idx = 0; idx < count; idx++) {
+		entry->families[idx] = lwc_string_ref(fstyle->families[idx]);
+	}
+	entry->size = fstyle->size;
+	entry->weight = fstyle->weight;
+	entry->family = fstyle->family;
+	entry->flags = fstyle->flags;
+	entry->width = *width;
+	entry->length = length;
+	memcpy(entry->text, string, length);
+
+	return NSERROR_OK;
+}
+
+
+/* exported function documented in html/font.h */
+void font_width_cache_get_stats(struct font_width_cache_stats *stats)
+{
+	*stats = font_width_stats;
+}
+
+
+/* exported function documented in html/font.h */
+void font_width_cache_fini(void)
+{
+	int idx;
+
+	NSLOG(netsurf, INFO,
+	      "Text width cache: %u hits, %u misses, %u evictions, %u flushes",
+	      font_width_stats.hits, font_width_stats.misses,
+	      font_width_stats.evictions, font_width_stats.flushes);
+
+	if (font_width_cache != NULL) {
+		font_width_cache_clear();
+		free(font_width_cache);
+		font_width_cache = NULL;
+	}
+
+	for (idx = 0; idx < PLOT_FONT_FAMILY_COUNT; idx++) {
+		free(font_width_options.names[idx]);
+		font_width_options.names[idx] = NULL;
+	}
+
+	memset(&font_width_stats, 0, sizeof(font_width_stats));
+}
@@ -28,6 +28,18 @@
 #define NETSURF_HTML_FONT_H
 
 struct plot_font_style;
+struct gui_layout_table;
+
+/**
+ * Text width cache statistics
+ */
+struct font_width_cache_stats {
+	unsigned int hits; /**< Widths found in the cache */
+	unsigned int misses; /**< Widths which had to be measured */
+	unsigned int evictions; /**< Widths replaced by another */
+	unsigned int flushes; /**< Times the cache was emptied */
+	unsigned int entries; /**< Widths currently in the cache */
+};
 
 /**
  * Populate a font style using data from a computed CSS style
@@ -40,4 +52,41 @@ void font_plot_style_from_css(const css_unit_ctx *unit_len_ctx,
 			      const css_computed_style *css,
 			      struct plot_font_style *fstyle);
 
+/**
+ * Measure the width of a string, avoiding the measurement if the same
+ * text has been measured in an equivalent style before.
+ *
+ * The cache has a fixed size and only holds short strings such as
+ * the words of a paragraph.
+ *
+ * \param font_func  Layout table to measure with
+ * \param fstyle     Plot style for the text
+ * \param string     UTF-8 string to measure
+ * \param length     Length of string, in bytes
+ * \param width      Updated to width of string[0..length)
+ * \return NSERROR_OK and width updated or appropriate error code
+ */
+nserror font_width_cached(const struct gui_layout_table *font_func,
+			  const struct plot_font_style *fstyle,
+			  const char *string,
+			  size_t length,
+			  int *width);
+
+/**
+ * Discard cached text widths if the font options have changed.
+ */
+void font_width_cache_validate(void);
+
+/**
+ * Get the text width cache statistics
+ *
+ * \param stats  Updated with the statistics
+ */
+void font_width_cache_get_stats(struct font_width_cache_stats *stats);
+
+/**
+ * Release the text width cache
+ */
+void font_width_cache_fini(void);
+
 #endif
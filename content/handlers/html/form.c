@@ -56,6 +56,7 @@
 #include "html/layout.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_manipulate.h"
 #include "html/font.h"
 #include "html/form_internal.h"
 
@@ -1383,6 +1384,9 @@ form__select_process_selection(html_content *html,
 	}
 	inline_box->width = control->box->width;
 
+	/* the text changed so any later layout must not reuse the old one */
+	box_invalidate_layout(inline_box, false);
+
 	html__redraw_a_box(html, control->box);
 
 	return ret;
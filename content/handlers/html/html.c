@@ -41,6 +41,7 @@
 #include "utils/nsoption.h"
 #include "utils/string.h"
 #include "utils/ascii.h"
+#include "netsurf/inttypes.h"
 #include "netsurf/content.h"
 #include "netsurf/browser_window.h"
 #include "netsurf/utf8.h"
@@ -53,6 +54,7 @@
 #include "desktop/selection.h"
 #include "desktop/scrollbar.h"
 #include "desktop/textarea.h"
+#include "desktop/frames.h"
 #include "netsurf/bitmap.h"
 #include "javascript/js.h"
 #include "desktop/gui_internal.h"
@@ -66,11 +68,14 @@
 #include "html/interaction.h"
 #include "html/box.h"
 #include "html/box_construct.h"
+#include "html/box_manipulate.h"
 #include "html/box_inspect.h"
 #include "html/form_internal.h"
 #include "html/imagemap.h"
 #include "html/layout.h"
+#include "html/font.h"
 #include "html/textselection.h"
+#include "html/display_list.h"
 
 #define CHUNK 4096
 
@@ -246,6 +251,18 @@ static void html_box_convert_done(html_content *c, bool success)
 		html_dump_frameset(c->frameset, 0);
 #endif
 
+	if (c->bctx != NULL) {
+		unsigned int box_count;
+		unsigned int extra_count;
+		size_t box_size;
+
+		box_arena_usage(c->bctx, &box_count, &extra_count, &box_size);
+		NSLOG(netsurf, DEBUG,
+		      "%u boxes (%u with extra properties) using %"PRIsizet" bytes, %"PRIsizet" per box",
+		      box_count, extra_count, box_size,
+		      (box_count != 0) ? box_size / box_count : 0);
+	}
+
 	exc = dom_document_get_document_element(c->document, (void *) &html);
 	if ((exc != DOM_NO_ERR) || (html == NULL)) {
 		/** @todo should this call html_object_free_objects(c);
@@ -273,7 +290,29 @@ static void html_box_convert_done(html_content *c, bool success)
 	dom_hubbub_parser_destroy(c->parser);
 	c->parser = NULL;
 
-	content_set_ready(&c->base);
+	/* start any object fetches held back during progressive conversion */
+	err = html_object_fetch_deferred(c);
+	if (err != NSERROR_OK) {
+		html_object_free_objects(c);
+		content_broadcast_error(&c->base, err, NULL);
+		content_set_error(&c->base);
+		dom_node_unref(html);
+		return;
+	}
+
+	if (content__get_status(&c->base) == CONTENT_STATUS_LOADING) {
+		content_set_ready(&c->base);
+	} else {
+		/* A partial box tree has been displayed already */
+		if ((c->iframe != NULL) && (c->bw != NULL) && (c->page == NULL)) {
+			browser_window_create_iframes(c->bw);
+		}
+
+		c->relayout_all = true;
+		content__reformat(&c->base, false,
+				c->base.available_width,
+				c->base.available_height);
+	}
 
 	html_proceed_to_done(c);
 
@@ -337,6 +376,278 @@ static void html_get_dimensions(html_content *htmlc)
 	htmlc->unit_len_ctx.font_size_minimum = f_min;
 }
 
+/**
+ * Determine whether box tree construction may begin before the parse of
+ * a document has completed.
+ *
+ * \param htmlc html content to check
+ * \return true if the document may be displayed progressively
+ */
+static bool html_can_begin_progressive(html_content *htmlc)
+{
+	dom_hubbub_encoding_source encoding_source;
+	dom_document_quirks_mode quirks;
+	dom_html_body_element *body = NULL;
+	dom_html_element_type tag_type;
+	bool has_children = false;
+	dom_exception exc;
+	unsigned int i;
+
+	/* Scripts may change the document under the box construction */
+	if (htmlc->enable_scripting || htmlc->aborted) {
+		return false;
+	}
+
+	/* Only while the document is still arriving */
+	if ((htmlc->base.status != CONTENT_STATUS_LOADING) ||
+	    (htmlc->base.locked) ||
+	    (htmlc->parse_completed) ||
+	    (htmlc->select_ctx != NULL)) {
+		return false;
+	}
+
+	/* The styles must be complete, so the only active fetch may be
+	 * the html itself */
+	if (htmlc->base.active != 1) {
+		return false;
+	}
+
+	for (i = 0; i != htmlc->stylesheet_count; i++) {
+		if (htmlc->stylesheets[i].modified) {
+			return false;
+		}
+	}
+
+	/* A quirks mode document requires a further stylesheet fetch */
+	exc = dom_document_get_quirks_mode(htmlc->document, &quirks);
+	if ((exc != DOM_NO_ERR) || (quirks != DOM_DOCUMENT_QUIRKS_MODE_NONE)) {
+		return false;
+	}
+
+	/* A detected encoding may yet be changed, restarting the parse */
+	if ((dom_hubbub_parser_get_encoding(htmlc->parser,
+			&encoding_source) == NULL) ||
+	    (encoding_source == DOM_HUBBUB_ENCODING_SOURCE_DETECTED)) {
+		return false;
+	}
+
+	/* Wait until there is some body content to display */
+	exc = dom_html_document_get_body(htmlc->document, &body);
+	if ((exc != DOM_NO_ERR) || (body == NULL)) {
+		return false;
+	}
+
+	exc = dom_html_element_get_tag_type((dom_html_element *)body,
+			&tag_type);
+	if ((exc == DOM_NO_ERR) && (tag_type == DOM_HTML_ELEMENT_TYPE_BODY)) {
+		exc = dom_node_has_child_nodes(body, &has_children);
+		if (exc != DOM_NO_ERR) {
+			has_children = false;
+		}
+	}
+
+	dom_node_unref(body);
+
+	return has_children;
+}
+
+
+/**
+ * Begin constructing the box tree of a partially parsed document.
+ *
+ * \param htmlc html content to convert
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+static nserror html_begin_progressive(html_content *htmlc)
+{
+	dom_exception exc; /* returned by libdom functions */
+	dom_node *html;
+	nserror error;
+
+	NSLOG(netsurf, INFO, "Progressive DOM to box (%p)", htmlc);
+
+	error = html_css_new_selection_context(htmlc, &htmlc->select_ctx);
+	if (error != NSERROR_OK) {
+		return error;
+	}
+
+	exc = dom_document_get_document_element(htmlc->document, (void *) &html);
+	if ((exc != DOM_NO_ERR) || (html == NULL)) {
+		return NSERROR_DOM;
+	}
+
+	html_get_dimensions(htmlc);
+
+	error = dom_to_box_progressive(html, htmlc, html_box_convert_done,
+			&htmlc->box_conversion_context);
+	if (error == NSERROR_OK) {
+		htmlc->progressive = true;
+	}
+
+	dom_node_unref(html);
+
+	return error;
+}
+
+
+/**
+ * Abandon a progressively constructed box tree.
+ *
+ * \param htmlc html content being converted
+ * \param error the reason the conversion failed
+ */
+static void html_progressive_failed(html_content *htmlc, nserror error)
+{
+	NSLOG(netsurf, INFO, "Progressive conversion failed (%p)", htmlc);
+
+	if (htmlc->box_conversion_context != NULL) {
+		cancel_dom_to_box(htmlc->box_conversion_context);
+		htmlc->box_conversion_context = NULL;
+	}
+	htmlc->progressive = false;
+
+	html_object_free_objects(htmlc);
+	content_broadcast_error(&htmlc->base, error, NULL);
+	content_set_error(&htmlc->base);
+}
+
+
+static void html_progressive_schedule(html_content *htmlc);
+
+
+/**
+ * Convert and display more of a partially parsed document.
+ *
+ * \param p html content to update
+ */
+static void html_progressive_update(void *p)
+{
+	html_content *htmlc = p;
+	bool more;
+	nserror error;
+
+	if (htmlc->progressive == false) {
+		if (html_can_begin_progressive(htmlc) == false) {
+			return;
+		}
+
+		error = html_begin_progressive(htmlc);
+		if (error != NSERROR_OK) {
+			html_progressive_failed(htmlc, error);
+			return;
+		}
+	}
+
+	if (htmlc->parse_completed || htmlc->aborted) {
+		/* html_finish_conversion() will complete the box tree */
+		return;
+	}
+
+	error = dom_to_box_progress(htmlc->box_conversion_context, &more);
+	if (error != NSERROR_OK) {
+		html_progressive_failed(htmlc, error);
+		return;
+	}
+
+	/* Box construction invalidated the layout of the boxes it
+	 * extended so the rest of the layout is kept */
+	if (htmlc->layout == NULL) {
+		/* Nothing has been converted yet */
+	} else if (htmlc->base.status == CONTENT_STATUS_LOADING) {
+		content_set_ready_partial(&htmlc->base);
+	} else {
+		content__reformat(&htmlc->base, false,
+				htmlc->base.available_width,
+				htmlc->base.available_height);
+	}
+
+	if (more) {
+		/* Continue once the document may be reflowed again */
+		html_progressive_schedule(htmlc);
+	}
+}
+
+
+/**
+ * Convert more of a progressively displayed document once it is parsed.
+ *
+ * Each time slice of conversion is laid out before the next is
+ * scheduled so the displayed box tree is never left without a layout.
+ *
+ * \param p html content being completed
+ */
+static void html_progressive_finish(void *p)
+{
+	html_content *htmlc = p;
+	bool more;
+	nserror error;
+
+	error = dom_to_box_progress(htmlc->box_conversion_context, &more);
+	if (error != NSERROR_OK) {
+		html_progressive_failed(htmlc, error);
+		return;
+	}
+
+	if (htmlc->box_conversion_context == NULL) {
+		/* html_box_convert_done() has completed the content */
+		return;
+	}
+
+	if (htmlc->base.status != CONTENT_STATUS_LOADING) {
+		content__reformat(&htmlc->base, false,
+				htmlc->base.available_width,
+				htmlc->base.available_height);
+	}
+
+	guit->misc->schedule(0, html_progressive_finish, htmlc);
+}
+
+
+/**
+ * Schedule display of more of a partially parsed document.
+ *
+ * Updates are made no more often than the document may be reflowed.
+ *
+ * \param htmlc html content being parsed
+ */
+static void html_progressive_schedule(html_content *htmlc)
+{
+	uint64_t now;
+	int delay = 0;
+
+	if ((nsoption_bool(progressive_render) == false) ||
+	    (htmlc->base.status == CONTENT_STATUS_ERROR)) {
+		return;
+	}
+
+	nsu_getmonotonic_ms(&now);
+	if (htmlc->base.reformat_time > now) {
+		delay = htmlc->base.reformat_time - now;
+	}
+
+	guit->misc->schedule(delay, html_progressive_update, htmlc);
+}
+
+
+/**
+ * Complete the box tree of a progressively displayed document.
+ *
+ * \param htmlc html content whose parse has completed
+ */
+static void html_progressive_complete(html_content *htmlc)
+{
+	NSLOG(netsurf, INFO, "Completing progressive DOM to box (%p)", htmlc);
+
+	guit->misc->schedule(-1, html_progressive_update, htmlc);
+
+	htmlc->progressive = false;
+
+	/* the completion callback reports the outcome */
+	dom_to_box_complete(htmlc->box_conversion_context);
+	html_progressive_finish(htmlc);
+}
+
+
 /* exported function documented in html/html_internal.h */
 void html_finish_conversion(html_content *htmlc)
 {
@@ -363,6 +674,11 @@ void html_finish_conversion(html_content *htmlc)
 	 * would break badly.
 	 */
 	if (htmlc->select_ctx != NULL) {
+		if (htmlc->progressive) {
+			/* The box tree was begun before the parse completed */
+			html_progressive_complete(htmlc);
+			return;
+		}
 		NSLOG(netsurf, INFO,
 				"Ignoring style change: NS layout is static.");
 		return;
@@ -472,13 +788,17 @@ html_create_html_data(html_content *c, const http_parameter *params)
 	c->reflowing = false;
 	c->title = NULL;
 	c->bctx = NULL;
+	c->progressive = false;
 	c->layout = NULL;
 	c->background_colour = NS_TRANSPARENT;
+	c->display_list = NULL;
+	c->display_list_state = HTML_DISPLAY_LIST_INVALID;
 	c->stylesheet_count = 0;
 	c->stylesheets = NULL;
 	c->select_ctx = NULL;
 	c->media.type = CSS_MEDIA_SCREEN;
 	c->universal = NULL;
+	c->sibling_cache = NULL;
 	c->num_objects = 0;
 	c->object_list = NULL;
 	c->forms = NULL;
@@ -741,6 +1061,9 @@ html_process_data(struct content *c, const char *data, unsigned int size)
 		return false;
 	}
 
+	/* display the document parsed so far */
+	html_progressive_schedule(html);
+
 	return true;
 }
 
@@ -1012,8 +1335,11 @@ static void html_stop(struct content *c)
 		html_object_abort_objects(htmlc);
 
 		/* If there are no further active fetches and we're still
-		 * in the READY state, transition to the DONE state. */
-		if (c->status == CONTENT_STATUS_READY && c->active == 0) {
+		 * in the READY state, transition to the DONE state. A
+		 * progressively displayed box tree which is still being
+		 * completed does that itself. */
+		if (c->status == CONTENT_STATUS_READY && c->active == 0 &&
+		    htmlc->box_conversion_context == NULL) {
 			content_set_done(c);
 		}
 
@@ -1056,6 +1382,8 @@ static void html_reformat(struct content *c, int width, int height)
 	layout_document(htmlc, width, height);
 	layout = htmlc->layout;
 
+	html_redraw_invalidate(htmlc);
+
 	/* width and height are at least margin box of document */
 	c->width = layout->x + layout->padding[LEFT] + layout->width +
 		layout->padding[RIGHT] + layout->border[RIGHT].width +
@@ -1083,6 +1411,9 @@ static void html_reformat(struct content *c, int width, int height)
 		ms_interval = nsoption_uint(min_reflow_period) * 10;
 	}
 	c->reformat_time = ms_after + ms_interval;
+
+	/* the layout may have moved lazily loaded objects into view */
+	html_object_check_lazy(htmlc);
 }
 
 
@@ -1097,6 +1428,9 @@ void html_redraw_a_box(hlcache_handle *h, struct box *box)
 {
 	int x, y;
 
+	html_redraw_invalidate(
+			(html_content *)hlcache_handle_get_content(h));
+
 	box_coords(box, &x, &y);
 
 	content_request_redraw(h, x, y,
@@ -1116,6 +1450,8 @@ void html__redraw_a_box(struct html_content *html, struct box *box)
 {
 	int x, y;
 
+	html_redraw_invalidate(html);
+
 	box_coords(box, &x, &y);
 
 	content__request_redraw((struct content *)html, x, y,
@@ -1191,6 +1527,9 @@ static void html_destroy(struct content *c)
 
 	NSLOG(netsurf, INFO, "content %p", c);
 
+	guit->misc->schedule(-1, html_progressive_update, html);
+	guit->misc->schedule(-1, html_progressive_finish, html);
+
 	/* If we're still converting a layout, cancel it */
 	if (html->box_conversion_context != NULL) {
 		if (cancel_dom_to_box(html->box_conversion_context) != NSERROR_OK) {
@@ -1263,6 +1602,10 @@ static void html_destroy(struct content *c)
 		html->iframe = NULL;
 	}
 
+	/* Free retained display list */
+	html_display_list_destroy(html->display_list);
+	html->display_list = NULL;
+
 	/* Destroy selection context */
 	if (html->select_ctx != NULL) {
 		css_select_ctx_destroy(html->select_ctx);
@@ -1451,9 +1794,9 @@ html_get_contextual_content(struct content *c, int x, int y,
 			continue;
 		}
 
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
-			browser_window_get_features(box->iframe,
+		if (box->extra->iframe) {
+			float scale = browser_window_get_scale(box->extra->iframe);
+			browser_window_get_features(box->extra->iframe,
 						    (x - box_x) * scale,
 						    (y - box_y) * scale,
 						    data);
@@ -1469,17 +1812,17 @@ html_get_contextual_content(struct content *c, int x, int y,
 		if (box->href)
 			data->link = box->href;
 
-		if (box->usemap) {
+		if (box->extra->usemap) {
 			const char *target = NULL;
-			nsurl *url = imagemap_get(html, box->usemap, box_x,
+			nsurl *url = imagemap_get(html, box->extra->usemap, box_x,
 					box_y, x, y, &target);
 			/* Box might have imagemap, but no actual link area
 			 * at point */
 			if (url != NULL)
 				data->link = url;
 		}
-		if (box->gadget) {
-			switch (box->gadget->type) {
+		if (box->extra->gadget) {
+			switch (box->extra->gadget->type) {
 			case GADGET_TEXTBOX:
 			case GADGET_TEXTAREA:
 			case GADGET_PASSWORD:
@@ -1531,10 +1874,10 @@ html_scroll_at_point(struct content *c, int x, int y, int scrx, int scry)
 			continue;
 
 		/* Pass into iframe */
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
+		if (box->extra->iframe) {
+			float scale = browser_window_get_scale(box->extra->iframe);
 
-			if (browser_window_scroll_at_point(box->iframe,
+			if (browser_window_scroll_at_point(box->extra->iframe,
 							   (x - box_x) * scale,
 							   (y - box_y) * scale,
 							   scrx, scry) == true)
@@ -1542,10 +1885,10 @@ html_scroll_at_point(struct content *c, int x, int y, int scrx, int scry)
 		}
 
 		/* Pass into textarea widget */
-		if (box->gadget && (box->gadget->type == GADGET_TEXTAREA ||
-				box->gadget->type == GADGET_PASSWORD ||
-				box->gadget->type == GADGET_TEXTBOX) &&
-				textarea_scroll(box->gadget->data.text.ta,
+		if (box->extra->gadget && (box->extra->gadget->type == GADGET_TEXTAREA ||
+				box->extra->gadget->type == GADGET_PASSWORD ||
+				box->extra->gadget->type == GADGET_TEXTBOX) &&
+				textarea_scroll(box->extra->gadget->data.text.ta,
 						scrx, scry) == true)
 			return true;
 
@@ -1631,7 +1974,7 @@ static void html__set_file_gadget_filename(struct content *c,
 	form_gadget_update_value(gadget, utf8_fn);
 
 	/* corestring_dom___ns_key_file_name_node_data */
-	if (dom_node_set_user_data((dom_node *)file_box->gadget->node,
+	if (dom_node_set_user_data((dom_node *)file_box->extra->gadget->node,
 				   corestring_dom___ns_key_file_name_node_data,
 				   strdup(fn), html__dom_user_data_handler,
 				   &oldfile) == DOM_NO_ERR) {
@@ -1679,10 +2022,10 @@ static bool html_drop_file_at_point(struct content *c, int x, int y, char *file)
 		    css_computed_visibility(box->style) == CSS_VISIBILITY_HIDDEN)
 			continue;
 
-		if (box->iframe) {
-			float scale = browser_window_get_scale(box->iframe);
+		if (box->extra->iframe) {
+			float scale = browser_window_get_scale(box->extra->iframe);
 			return browser_window_drop_file_at_point(
-				box->iframe,
+				box->extra->iframe,
 				(x - box_x) * scale,
 				(y - box_y) * scale,
 				file);
@@ -1693,8 +2036,8 @@ static bool html_drop_file_at_point(struct content *c, int x, int y, char *file)
 					x - box_x, y - box_y, file) == true)
 			return true;
 
-		if (box->gadget) {
-			switch (box->gadget->type) {
+		if (box->extra->gadget) {
+			switch (box->extra->gadget->type) {
 				case GADGET_FILE:
 					file_box = box;
 				break;
@@ -1722,7 +2065,7 @@ static bool html_drop_file_at_point(struct content *c, int x, int y, char *file)
 	/* Handle the drop */
 	if (file_box) {
 		/* File dropped on file input */
-		html__set_file_gadget_filename(c, file_box->gadget, file);
+		html__set_file_gadget_filename(c, file_box->extra->gadget, file);
 
 	} else {
 		/* File dropped on text input */
@@ -1797,11 +2140,11 @@ static bool html_drop_file_at_point(struct content *c, int x, int y, char *file)
 
 		/* Simulate a click over the input box, to place caret */
 		box_coords(text_box, &bx, &by);
-		textarea_mouse_action(text_box->gadget->data.text.ta,
+		textarea_mouse_action(text_box->extra->gadget->data.text.ta,
 				BROWSER_MOUSE_PRESS_1, x - bx, y - by);
 
 		/* Paste the file as text */
-		textarea_drop_text(text_box->gadget->data.text.ta,
+		textarea_drop_text(text_box->extra->gadget->data.text.ta,
 				utf8_buff, size);
 
 		free(utf8_buff);
@@ -2052,15 +2395,22 @@ const char *html_get_base_target(hlcache_handle *h)
  */
 bool html_get_id_offset(hlcache_handle *h, lwc_string *frag_id, int *x, int *y)
 {
+	html_content *htmlc;
 	struct box *pos;
-	struct box *layout;
 
 	if (content_get_type(h) != CONTENT_HTML)
 		return false;
 
-	layout = html_get_box_tree(h);
+	htmlc = (html_content *) hlcache_handle_get_content(h);
+	if (htmlc->layout == NULL || htmlc->bctx == NULL)
+		return false;
 
-	if ((pos = box_find_by_id(layout, frag_id)) != 0) {
+	pos = box_arena_find_id(htmlc->bctx, htmlc->layout, frag_id);
+	if (pos == NULL) {
+		/* the index is only a fast path, fall back to a search */
+		pos = box_find_by_id(htmlc->layout, frag_id);
+	}
+	if (pos != NULL) {
 		box_coords(pos, x, y);
 		return true;
 	}
@@ -2193,6 +2543,7 @@ static content_type html_content_type(void)
 
 static void html_fini(void)
 {
+	font_width_cache_fini();
 	html_css_fini();
 }
 
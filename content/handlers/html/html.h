@@ -95,10 +95,13 @@ struct content_html_object {
 	struct content_html_object *next; /**< Next in chain */
 
 	struct hlcache_handle *content;  /**< Content, or 0. */
+	struct nsurl *url;  /**< URL of a deferred fetch, or NULL. */
 	struct box *box;  /**< Node in box tree containing it. */
 	/** Bitmap of acceptable content types */
 	content_type permitted_types;
 	bool background;  /**< This object is a background image. */
+	bool lazy;  /**< Fetch waits until the box is near the viewport. */
+	bool fetched_lazily;  /**< Fetch was started by html_object_check_lazy(). */
 };
 
 
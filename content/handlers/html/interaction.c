@@ -85,16 +85,16 @@ static browser_pointer_shape get_pointer_shape(struct box *box, bool imagemap)
 
 	switch (cursor) {
 	case CSS_CURSOR_AUTO:
-		if (box->href || (box->gadget &&
-				(box->gadget->type == GADGET_IMAGE ||
-				box->gadget->type == GADGET_SUBMIT)) ||
+		if (box->href || (box->extra->gadget &&
+				(box->extra->gadget->type == GADGET_IMAGE ||
+				box->extra->gadget->type == GADGET_SUBMIT)) ||
 				imagemap) {
 			/* link */
 			pointer = BROWSER_POINTER_POINT;
-		} else if (box->gadget &&
-				(box->gadget->type == GADGET_TEXTBOX ||
-				box->gadget->type == GADGET_PASSWORD ||
-				box->gadget->type == GADGET_TEXTAREA)) {
+		} else if (box->extra->gadget &&
+				(box->extra->gadget->type == GADGET_TEXTBOX ||
+				box->extra->gadget->type == GADGET_PASSWORD ||
+				box->extra->gadget->type == GADGET_TEXTAREA)) {
 			/* text input */
 			pointer = BROWSER_POINTER_CARET;
 		} else {
@@ -521,13 +521,13 @@ mouse_action_drag_textarea(html_content *html,
 
 	box = html->drag_owner.textarea;
 
-	assert(box->gadget != NULL);
-	assert(box->gadget->type == GADGET_TEXTAREA ||
-	       box->gadget->type == GADGET_PASSWORD ||
-	       box->gadget->type == GADGET_TEXTBOX);
+	assert(box->extra->gadget != NULL);
+	assert(box->extra->gadget->type == GADGET_TEXTAREA ||
+	       box->extra->gadget->type == GADGET_PASSWORD ||
+	       box->extra->gadget->type == GADGET_TEXTBOX);
 
 	box_coords(box, &box_x, &box_y);
-	textarea_mouse_action(box->gadget->data.text.ta,
+	textarea_mouse_action(box->extra->gadget->data.text.ta,
 			      mouse,
 			      x - box_x,
 			      y - box_y);
@@ -712,8 +712,8 @@ get_mouse_action_node(html_content *html,
 			}
 		}
 
-		if (box->iframe) {
-			man->iframe = box->iframe;
+		if (box->extra->iframe) {
+			man->iframe = box->extra->iframe;
 		}
 
 		if (box->href) {
@@ -723,9 +723,9 @@ get_mouse_action_node(html_content *html,
 			man->link.is_imagemap = false;
 		}
 
-		if (box->usemap) {
+		if (box->extra->usemap) {
 			man->link.url = imagemap_get(html,
-						     box->usemap,
+						     box->extra->usemap,
 						     box_x,
 						     box_y,
 						     x, y,
@@ -734,13 +734,13 @@ get_mouse_action_node(html_content *html,
 			man->link.is_imagemap = true;
 		}
 
-		if (box->gadget) {
-			man->gadget.control = box->gadget;
+		if (box->extra->gadget) {
+			man->gadget.control = box->extra->gadget;
 			man->gadget.box = box;
 			man->gadget.box_x = box_x;
 			man->gadget.box_y = box_y;
-			if (box->gadget->form) {
-				man->gadget.target = box->gadget->form->target;
+			if (box->extra->gadget->form) {
+				man->gadget.target = box->extra->gadget->form->target;
 			}
 		}
 
@@ -1771,7 +1771,7 @@ void html_set_selection(html_content *html, html_selection_type selection_type,
 					selection_owner.textarea)
 				break;
 			box = html->selection_owner.textarea;
-			textarea_clear_selection(box->gadget->data.text.ta);
+			textarea_clear_selection(box->extra->gadget->data.text.ta);
 			break;
 		case HTML_SELECTION_CONTENT:
 			if (same_type && html->selection_owner.content ==
@@ -64,6 +64,9 @@
 #include "html/private.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_manipulate.h"
+#include "html/box_index.h"
+#include "html/float_index.h"
 #include "html/font.h"
 #include "html/form_internal.h"
 #include "html/layout.h"
@@ -364,7 +367,7 @@ static void layout_minmax_table(struct box *table,
 				"Could not establish table column types.");
 		return;
 	}
-	col = table->col;
+	col = table->extra->col;
 
 	/* start with 0 except for fixed-width columns */
 	for (i = 0; i != table->columns; i++) {
@@ -388,6 +391,11 @@ static void layout_minmax_table(struct box *table,
 				h, hu));
 	}
 
+	/* with fixed layout the cell contents do not affect the column
+	 * widths; cells are measured when they are laid out */
+	if (table_is_fixed_layout(table))
+		goto layout_minmax_table_columns;
+
 	/* 1st pass: consider cells with colspan 1 only */
 	for (row_group = table->children; row_group; row_group =row_group->next)
 	for (row = row_group->children; row; row = row->next)
@@ -478,6 +486,7 @@ static void layout_minmax_table(struct box *table,
 		}
 	}
 
+layout_minmax_table_columns:
 	for (i = 0; i != table->columns; i++) {
 		if (col[i].max < col[i].min) {
 			box_dump(stderr, table, 0, true);
@@ -658,7 +667,7 @@ layout_minmax_line(struct box *first,
 
 			if (b->next) {
 				if (b->space == UNKNOWN_WIDTH) {
-					font_func->width(&fstyle, " ", 1,
+					font_width_cached(font_func, &fstyle, " ", 1,
 							 &b->space);
 				}
 				max += b->space;
@@ -668,7 +677,7 @@ layout_minmax_line(struct box *first,
 			continue;
 		}
 
-		if (!b->object && !(b->flags & IFRAME) && !b->gadget &&
+		if (!b->object && !(b->flags & IFRAME) && !b->extra->gadget &&
 				!(b->flags & REPLACE_DIM)) {
 			/* inline non-replaced, 10.3.1 and 10.6.1 */
 			bool no_wrap_box;
@@ -685,17 +694,17 @@ layout_minmax_line(struct box *first,
 
 				/* If it's a select element, we must use the
 				 * width of the widest option text */
-				if (b->parent->parent->gadget &&
-						b->parent->parent->gadget->type
+				if (b->parent->parent->extra->gadget &&
+						b->parent->parent->extra->gadget->type
 						== GADGET_SELECT) {
 					int opt_maxwidth = 0;
 					struct form_option *o;
 
-					for (o = b->parent->parent->gadget->
+					for (o = b->parent->parent->extra->gadget->
 							data.select.items; o;
 							o = o->next) {
 						int opt_width;
-						font_func->width(&fstyle,
+						font_width_cached(font_func, &fstyle,
 								o->text,
 								strlen(o->text),
 								&opt_width);
@@ -709,7 +718,7 @@ layout_minmax_line(struct box *first,
 						b->width += SCROLLBAR_WIDTH;
 
 				} else {
-					font_func->width(&fstyle, b->text,
+					font_width_cached(font_func, &fstyle, b->text,
 						b->length, &b->width);
 					b->flags |= MEASURED;
 				}
@@ -717,7 +726,7 @@ layout_minmax_line(struct box *first,
 			max += b->width;
 			if (b->next) {
 				if (b->space == UNKNOWN_WIDTH) {
-					font_func->width(&fstyle, " ", 1,
+					font_width_cached(font_func, &fstyle, " ", 1,
 							 &b->space);
 				}
 				max += b->space;
@@ -744,7 +753,7 @@ layout_minmax_line(struct box *first,
 					for (j = i; j != b->length &&
 							b->text[j] != ' '; j++)
 						;
-					font_func->width(&fstyle, b->text + i,
+					font_width_cached(font_func, &fstyle, b->text + i,
 							 j - i, &width);
 					if (min < width)
 						min = width;
@@ -1009,10 +1018,10 @@ static void layout_minmax_block(
 		block->flags |= NEED_MIN;
 	}
 
-	if (block->gadget && (block->gadget->type == GADGET_TEXTBOX ||
-			block->gadget->type == GADGET_PASSWORD ||
-			block->gadget->type == GADGET_FILE ||
-			block->gadget->type == GADGET_TEXTAREA) &&
+	if (block->extra->gadget && (block->extra->gadget->type == GADGET_TEXTBOX ||
+			block->extra->gadget->type == GADGET_PASSWORD ||
+			block->extra->gadget->type == GADGET_FILE ||
+			block->extra->gadget->type == GADGET_TEXTAREA) &&
 			block->style && wtype == CSS_WIDTH_AUTO) {
 		css_fixed size = INTTOFIX(10);
 		css_unit unit = CSS_UNIT_EM;
@@ -1023,8 +1032,8 @@ static void layout_minmax_block(
 		block->flags |= HAS_HEIGHT;
 	}
 
-	if (block->gadget && (block->gadget->type == GADGET_RADIO ||
-			block->gadget->type == GADGET_CHECKBOX) &&
+	if (block->extra->gadget && (block->extra->gadget->type == GADGET_RADIO ||
+			block->extra->gadget->type == GADGET_CHECKBOX) &&
 			block->style && wtype == CSS_WIDTH_AUTO) {
 		css_fixed size = INTTOFIX(1);
 		css_unit unit = CSS_UNIT_EM;
@@ -1675,14 +1684,19 @@ layout_next_margin_block(const css_unit_ctx *unit_len_ctx,
 /**
  * Find y coordinate which clears all floats on left and/or right.
  *
- * \param  fl	  first float in float list
+ * \param  cont   block formatting context box containing the floats
  * \param  clear  type of clear
  * \return  y coordinate relative to ancestor box for floats
  */
-static int layout_clear(struct box *fl, enum css_clear_e clear)
+static int layout_clear(const struct box *cont, enum css_clear_e clear)
 {
+	const struct box *fl;
 	int y = 0;
-	for (; fl; fl = fl->next_float) {
+
+	if (float_index_clear(cont, clear, &y))
+		return y;
+
+	for (fl = cont->float_children; fl; fl = fl->next_float) {
 		if ((clear == CSS_CLEAR_LEFT || clear == CSS_CLEAR_BOTH) &&
 				fl->type == BOX_FLOAT_LEFT)
 			if (y < fl->y + fl->height)
@@ -1699,7 +1713,7 @@ static int layout_clear(struct box *fl, enum css_clear_e clear)
 /**
  * Find left and right edges in a vertical range.
  *
- * \param  fl	  first float in float list
+ * \param  cont   block formatting context box containing the floats
  * \param  y0	  start of y range to search
  * \param  y1	  end of y range to search
  * \param  x0	  start left edge, updated to available left edge
@@ -1708,18 +1722,25 @@ static int layout_clear(struct box *fl, enum css_clear_e clear)
  * \param  right  returns float on right if present
  */
 static void
-find_sides(struct box *fl,
+find_sides(const struct box *cont,
 	   int y0, int y1,
 	   int *x0, int *x1,
 	   struct box **left,
 	   struct box **right)
 {
+	struct box *fl;
 	int fy0, fy1, fx0, fx1;
 
 	NSLOG(layout, DEBUG, "y0 %i, y1 %i, x0 %i, x1 %i", y0, y1, *x0, *x1);
 
+	if (float_index_find_sides(cont, y0, y1, x0, x1, left, right)) {
+		NSLOG(layout, DEBUG, "x0 %i, x1 %i, left %p, right %p",
+		      *x0, *x1, *left, *right);
+		return;
+	}
+
 	*left = *right = 0;
-	for (; fl; fl = fl->next_float) {
+	for (fl = cont->float_children; fl; fl = fl->next_float) {
 		fy1 = fl->y + fl->height;
 		if (fy1 < y0) {
 			/* Floats are sorted in order of decreasing bottom pos.
@@ -2072,7 +2093,7 @@ static bool layout_table(struct box *table, int available_width,
 		return false;
 	}
 
-	memcpy(col, table->col, sizeof(col[0]) * columns);
+	memcpy(col, table->extra->col, sizeof(col[0]) * columns);
 
 	/* find margins, paddings, and borders for table and cells */
 	layout_find_dimensions(&content->unit_len_ctx, available_width, -1, table,
@@ -2418,8 +2439,14 @@ static bool layout_table(struct box *table, int available_width,
 						c->padding[RIGHT] -
 						c->border[RIGHT].width;
 				c->float_children = 0;
+				float_index_reset(c);
 				c->cached_place_below_level = 0;
 
+				/* cells of fixed layout tables are not
+				 * measured by layout_minmax_table() */
+				layout_minmax_block(c, content->font_func,
+						content);
+
 				c->height = AUTO;
 				if (!layout_block_context(c, -1, content)) {
 					free(col);
@@ -2553,12 +2580,16 @@ static bool layout_table(struct box *table, int available_width,
 					c->padding[BOTTOM] -= spare_height / 2;
 					layout_move_children(c, 0,
 							spare_height / 2);
+					c->layout_cache.offset_y +=
+							spare_height / 2;
 					break;
 				case CSS_VERTICAL_ALIGN_BOTTOM:
 					c->padding[TOP] += spare_height;
 					c->padding[BOTTOM] -= spare_height;
 					layout_move_children(c, 0,
 							spare_height);
+					c->layout_cache.offset_y +=
+							spare_height;
 					break;
 				case CSS_VERTICAL_ALIGN_INHERIT:
 					assert(0);
@@ -2752,7 +2783,6 @@ static void add_float_to_container(struct box *cont, struct box *b)
 		/* No other float children */
 		b->next_float = NULL;
 		cont->float_children = b;
-		return;
 	} else if (b_bottom >= box->y + box->height) {
 		/* Goes at start of list */
 		b->next_float = cont->float_children;
@@ -2768,6 +2798,8 @@ static void add_float_to_container(struct box *cont, struct box *b)
 			prev->next_float = b;
 		}
 	}
+
+	float_index_add(cont, b);
 }
 
 
@@ -2801,7 +2833,7 @@ layout_text_box_split(html_content *content,
 		/* We're need to add a space, and we don't know how big
 		 * it's to be, OR we have a space of unknown width anyway;
 		 * Calculate space width */
-		font_func->width(fstyle, " ", 1, &space_width);
+		font_width_cached(font_func, fstyle, " ", 1, &space_width);
 	}
 
 	if (split_box->space == UNKNOWN_WIDTH)
@@ -2810,10 +2842,9 @@ layout_text_box_split(html_content *content,
 		space_width = 0;
 
 	/* Create clone of split_box, c2 */
-	c2 = talloc_memdup(content->bctx, split_box, sizeof *c2);
+	c2 = box_clone(content->bctx, split_box);
 	if (!c2)
 		return false;
-	c2->flags |= CLONE;
 
 	/* Set remaining text in c2 */
 	c2->text += used_length;
@@ -2897,7 +2928,7 @@ layout_float_find_dimensions(
 	if (margin[RIGHT] == AUTO)
 		margin[RIGHT] = 0;
 
-	if (box->gadget == NULL) {
+	if (box->extra->gadget == NULL) {
 		padding[RIGHT] += scrollbar_width_y;
 		padding[BOTTOM] += scrollbar_width_x;
 	}
@@ -2908,10 +2939,10 @@ layout_float_find_dimensions(
 		 * See 10.3.6 and 10.6.2 */
 		layout_get_object_dimensions(box, &width, &height,
 				min_width, max_width, min_height, max_height);
-	} else if (box->gadget && (box->gadget->type == GADGET_TEXTBOX ||
-			box->gadget->type == GADGET_PASSWORD ||
-			box->gadget->type == GADGET_FILE ||
-			box->gadget->type == GADGET_TEXTAREA)) {
+	} else if (box->extra->gadget && (box->extra->gadget->type == GADGET_TEXTBOX ||
+			box->extra->gadget->type == GADGET_PASSWORD ||
+			box->extra->gadget->type == GADGET_FILE ||
+			box->extra->gadget->type == GADGET_TEXTAREA)) {
 		css_fixed size = 0;
 		css_unit unit = CSS_UNIT_EM;
 
@@ -2919,16 +2950,16 @@ layout_float_find_dimensions(
 		 * that don't shrink to fit contained text. */
 		assert(box->style);
 
-		if (box->gadget->type == GADGET_TEXTBOX ||
-				box->gadget->type == GADGET_PASSWORD ||
-				box->gadget->type == GADGET_FILE) {
+		if (box->extra->gadget->type == GADGET_TEXTBOX ||
+				box->extra->gadget->type == GADGET_PASSWORD ||
+				box->extra->gadget->type == GADGET_FILE) {
 			if (width == AUTO) {
 				size = INTTOFIX(10);
 				width = FIXTOINT(css_unit_len2device_px(
 						box->style, unit_len_ctx,
 						size, unit));
 			}
-			if (box->gadget->type == GADGET_FILE &&
+			if (box->extra->gadget->type == GADGET_FILE &&
 					height == AUTO) {
 				size = FLTTOFIX(1.5);
 				height = FIXTOINT(css_unit_len2device_px(
@@ -2936,7 +2967,7 @@ layout_float_find_dimensions(
 						size, unit));
 			}
 		}
-		if (box->gadget->type == GADGET_TEXTAREA) {
+		if (box->extra->gadget->type == GADGET_TEXTAREA) {
 			if (width == AUTO) {
 				size = INTTOFIX(10);
 				width = FIXTOINT(css_unit_len2device_px(
@@ -3054,7 +3085,7 @@ place_float_below(struct box *c, int width, int cx, int y, struct box *cont)
 		y = yy;
 		x0 = cx;
 		x1 = cx + width;
-		find_sides(cont->float_children, y, y + c->height, &x0, &x1,
+		find_sides(cont, y, y + c->height, &x0, &x1,
 				&left, &right);
 		if (left != 0 && right != 0) {
 			yy = (left->y + left->height <
@@ -3177,7 +3208,7 @@ layout_line(struct box *first,
 	/* find sides at top of line */
 	x0 += cx;
 	x1 += cx;
-	find_sides(cont->float_children, cy, cy, &x0, &x1, &left, &right);
+	find_sides(cont, cy, cy, &x0, &x1, &left, &right);
 	x0 -= cx;
 	x1 -= cx;
 
@@ -3191,7 +3222,7 @@ layout_line(struct box *first,
 	/* get minimum line height from containing block.
 	 * this is the line-height if there are text children and also in the
 	 * case of an initially empty text input */
-	if (has_text_children || first->parent->parent->gadget)
+	if (has_text_children || first->parent->parent->extra->gadget)
 		used_height = height = line_height(&content->unit_len_ctx,
 				first->parent->parent->style);
 	else
@@ -3278,7 +3309,7 @@ layout_line(struct box *first,
 		} else if (b->type == BOX_INLINE_END) {
 			b->width = 0;
 			if (b->space == UNKNOWN_WIDTH) {
-				font_func->width(&fstyle, " ", 1, &b->space);
+				font_width_cached(font_func, &fstyle, " ", 1, &b->space);
 				/** \todo handle errors */
 			}
 			space_after = b->space;
@@ -3288,7 +3319,7 @@ layout_line(struct box *first,
 			continue;
 		}
 
-		if (!b->object && !(b->flags & IFRAME) && !b->gadget &&
+		if (!b->object && !(b->flags & IFRAME) && !b->extra->gadget &&
 				!(b->flags & REPLACE_DIM)) {
 			/* inline non-replaced, 10.3.1 and 10.6.1 */
 			b->height = line_height(&content->unit_len_ctx,
@@ -3308,17 +3339,17 @@ layout_line(struct box *first,
 
 				/* If it's a select element, we must use the
 				 * width of the widest option text */
-				if (b->parent->parent->gadget &&
-						b->parent->parent->gadget->type
+				if (b->parent->parent->extra->gadget &&
+						b->parent->parent->extra->gadget->type
 						== GADGET_SELECT) {
 					int opt_maxwidth = 0;
 					struct form_option *o;
 
-					for (o = b->parent->parent->gadget->
+					for (o = b->parent->parent->extra->gadget->
 							data.select.items; o;
 							o = o->next) {
 						int opt_width;
-						font_func->width(&fstyle,
+						font_width_cached(font_func, &fstyle,
 								o->text,
 								strlen(o->text),
 								&opt_width);
@@ -3330,7 +3361,7 @@ layout_line(struct box *first,
 					if (nsoption_bool(core_select_menu))
 						b->width += SCROLLBAR_WIDTH;
 				} else {
-					font_func->width(&fstyle, b->text,
+					font_width_cached(font_func, &fstyle, b->text,
 							b->length, &b->width);
 					b->flags |= MEASURED;
 				}
@@ -3343,14 +3374,14 @@ layout_line(struct box *first,
 			if (b->text && (x + b->width < x1 - x0) &&
 					!(b->flags & MEASURED) &&
 					b->next) {
-				font_func->width(&fstyle, b->text,
+				font_width_cached(font_func, &fstyle, b->text,
 						 b->length, &b->width);
 				b->flags |= MEASURED;
 			}
 
 			x += b->width;
 			if (b->space == UNKNOWN_WIDTH) {
-				font_func->width(&fstyle, " ", 1, &b->space);
+				font_width_cached(font_func, &fstyle, " ", 1, &b->space);
 				/** \todo handle errors */
 			}
 			space_after = b->space;
@@ -3420,7 +3451,7 @@ layout_line(struct box *first,
 	/* find new sides using this height */
 	x0 = cx;
 	x1 = cx + *width;
-	find_sides(cont->float_children, cy, cy + height, &x0, &x1,
+	find_sides(cont, cy, cy + height, &x0, &x1,
 			&left, &right);
 	x0 -= cx;
 	x1 -= cx;
@@ -3488,7 +3519,7 @@ layout_line(struct box *first,
 							&content->unit_len_ctx,
 							b->style, &fstyle);
 					/** \todo handle errors */
-					font_func->width(&fstyle, " ", 1,
+					font_width_cached(font_func, &fstyle, " ", 1,
 							 &b->space);
 				}
 				space_after = b->space;
@@ -3513,6 +3544,7 @@ layout_line(struct box *first,
 
 			d = b->children;
 			d->float_children = 0;
+			float_index_reset(d);
 			d->cached_place_below_level = 0;
 			b->float_container = d->float_container = cont;
 
@@ -3602,7 +3634,7 @@ layout_line(struct box *first,
 					else
 						b->x = cx + *width - b->width;
 
-					fcy = layout_clear(cont->float_children,
+					fcy = layout_clear(cont,
 						css_computed_clear(d->style));
 					if (fcy > cont->clear_level)
 						cont->clear_level = fcy;
@@ -3637,7 +3669,7 @@ layout_line(struct box *first,
 		    !split_box->object &&
 		    !(split_box->flags & REPLACE_DIM) &&
 		    !(split_box->flags & IFRAME) &&
-		    !split_box->gadget && split_box->text) {
+		    !split_box->extra->gadget && split_box->text) {
 
 			font_plot_style_from_css(&content->unit_len_ctx,
 					split_box->style, &fstyle);
@@ -3791,7 +3823,7 @@ layout_line(struct box *first,
 			d->y = *y;
 			continue;
 		} else if ((d->type == BOX_INLINE &&
-				((d->object || d->gadget) == false) &&
+				((d->object || d->extra->gadget) == false) &&
 				!(d->flags & IFRAME) &&
 				!(d->flags & REPLACE_DIM)) ||
 				d->type == BOX_BR ||
@@ -3855,7 +3887,7 @@ layout_line(struct box *first,
 
 	/* handle clearance for br */
 	if (br_box && css_computed_clear(br_box->style) != CSS_CLEAR_NONE) {
-		int clear_y = layout_clear(cont->float_children,
+		int clear_y = layout_clear(cont,
 				css_computed_clear(br_box->style));
 		if (used_height < clear_y - cy)
 			used_height = clear_y - cy;
@@ -3945,6 +3977,146 @@ static bool layout_inline_container(struct box *inline_container, int width,
 }
 
 
+/**
+ * Check whether the previous layout of a box can be kept.
+ *
+ * \param  box              block formatting context or inline container
+ * \param  width            available width for the box
+ * \param  height           height of the box on entry to layout
+ * \param  viewport_height  height of viewport in pixels or -ve if unknown
+ * \param  content          the html content being laid out
+ * \return  true if the previous layout is still valid
+ */
+static bool
+layout_cache_valid(const struct box *box,
+		   int width,
+		   int height,
+		   int viewport_height,
+		   const html_content *content)
+{
+	const struct box_layout_cache *cache = &box->layout_cache;
+
+	if (content->relayout_all ||
+	    (box->flags & (NEED_LAYOUT | HAS_POSITIONED)) ||
+	    cache->width == UNKNOWN_WIDTH ||
+	    cache->reusable == false) {
+		return false;
+	}
+
+	return (cache->width == width &&
+		cache->height == height &&
+		cache->viewport_height == viewport_height &&
+		cache->padding_top == box->padding[TOP] &&
+		cache->padding_left == box->padding[LEFT]);
+}
+
+
+/**
+ * Record the inputs and result of laying out a box.
+ *
+ * \param  box              block formatting context or inline container
+ * \param  width            available width the box was laid out with
+ * \param  height           height of the box on entry to layout
+ * \param  viewport_height  height of viewport in pixels or -ve if unknown
+ * \param  result_height    resulting content height
+ * \param  reusable         whether the layout is independent of floats
+ *                          outside the box
+ */
+static void
+layout_cache_store(struct box *box,
+		   int width,
+		   int height,
+		   int viewport_height,
+		   int result_height,
+		   bool reusable)
+{
+	struct box_layout_cache *cache = &box->layout_cache;
+
+	cache->width = width;
+	cache->height = height;
+	cache->viewport_height = viewport_height;
+	cache->padding_top = box->padding[TOP];
+	cache->padding_left = box->padding[LEFT];
+	cache->result_width = box->width;
+	cache->result_height = result_height;
+	cache->float_children = box->float_children;
+	cache->offset_y = 0;
+	cache->reusable = reusable;
+
+	box->flags &= ~NEED_LAYOUT;
+}
+
+
+/**
+ * Check whether an inline container has any float children.
+ *
+ * \param  inline_container  inline container to check
+ * \return  true if a float is placed from within the container
+ */
+static bool layout_inline_container_has_floats(struct box *inline_container)
+{
+	struct box *c;
+
+	for (c = inline_container->children; c != NULL; c = c->next) {
+		if (c->type == BOX_FLOAT_LEFT || c->type == BOX_FLOAT_RIGHT) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/**
+ * Check whether any float in a block formatting context reaches below
+ * a vertical position.
+ *
+ * \param  cont  block formatting context box
+ * \param  y     position relative to cont
+ * \return  true if a float extends below y
+ */
+static inline bool layout_floats_below(const struct box *cont, int y)
+{
+	/* Floats are sorted in order of decreasing bottom position, so
+	 * only the first one needs checking. */
+	const struct box *fl = cont->float_children;
+
+	return (fl != NULL && fl->y + fl->height > y);
+}
+
+
+/**
+ * Flag boxes which have positioned descendants.
+ *
+ * Positioning is applied after the normal flow layout and adjusts
+ * descendant coordinates in place, so the layout of these boxes is
+ * never kept.
+ *
+ * \param  box  box tree to mark
+ * \return  true if the box or any of its descendants is positioned
+ */
+static bool layout_mark_positioned(struct box *box)
+{
+	struct box *child;
+	bool positioned = false;
+
+	for (child = box->children; child != NULL; child = child->next) {
+		if (layout_mark_positioned(child)) {
+			positioned = true;
+		}
+	}
+
+	if (positioned) {
+		box->flags |= HAS_POSITIONED;
+	} else {
+		box->flags &= ~HAS_POSITIONED;
+	}
+
+	return positioned || (box->style != NULL &&
+			css_computed_position(box->style) !=
+					CSS_POSITION_STATIC);
+}
+
+
 /**
  * Layout a block formatting context.
  *
@@ -3971,6 +4143,7 @@ layout_block_context(struct box *block,
 	bool in_margin = false;
 	css_fixed gadget_size;
 	css_unit gadget_unit; /* Checkbox / radio buttons */
+	int entry_height;
 
 	assert(block->type == BOX_BLOCK ||
 			block->type == BOX_INLINE_BLOCK ||
@@ -3978,10 +4151,6 @@ layout_block_context(struct box *block,
 	assert(block->width != UNKNOWN_WIDTH);
 	assert(block->width != AUTO);
 
-	block->float_children = NULL;
-	block->cached_place_below_level = 0;
-	block->clear_level = 0;
-
 	/* special case if the block contains an object */
 	if (block->object) {
 		int temp_width = block->width;
@@ -3996,8 +4165,8 @@ layout_block_context(struct box *block,
 	}
 
 	/* special case if the block contains an radio button or checkbox */
-	if (block->gadget && (block->gadget->type == GADGET_RADIO ||
-			block->gadget->type == GADGET_CHECKBOX)) {
+	if (block->extra->gadget && (block->extra->gadget->type == GADGET_RADIO ||
+			block->extra->gadget->type == GADGET_CHECKBOX)) {
 		/* form checkbox or radio button
 		 * if width or height is AUTO, set it to 1em */
 		gadget_unit = CSS_UNIT_EM;
@@ -4009,6 +4178,30 @@ layout_block_context(struct box *block,
 					gadget_size, gadget_unit));
 	}
 
+	entry_height = block->height;
+
+	if (layout_cache_valid(block, block->width, entry_height,
+			viewport_height, content)) {
+		/* Nothing within the block has changed; keep the previous
+		 * layout of its descendants. */
+		block->float_children = block->layout_cache.float_children;
+		/* the index may have been emptied since; it is only
+		 * needed while the block's contents are laid out */
+		float_index_free(block);
+		if (block->layout_cache.offset_y != 0) {
+			layout_move_children(block, 0,
+					-block->layout_cache.offset_y);
+			block->layout_cache.offset_y = 0;
+		}
+		cy = block->padding[TOP] + block->layout_cache.result_height;
+		goto layout_block_context_done;
+	}
+
+	block->float_children = NULL;
+	float_index_reset(block);
+	block->cached_place_below_level = 0;
+	block->clear_level = 0;
+
 	box = block->children;
 	/* set current coordinates to top-left of the block */
 	cx = 0;
@@ -4081,7 +4274,7 @@ layout_block_context(struct box *block,
 		y = 0;
 		if (box->style && css_computed_clear(box->style) !=
 				CSS_CLEAR_NONE)
-			y = layout_clear(block->float_children,
+			y = layout_clear(block,
 					css_computed_clear(box->style));
 
 		/* Find box's overflow properties */
@@ -4111,7 +4304,7 @@ layout_block_context(struct box *block,
 				x1 = cx + box->parent->width -
 						box->parent->padding[LEFT] -
 						box->parent->padding[RIGHT];
-				find_sides(block->float_children, top, top,
+				find_sides(block, top, top,
 						&x0, &x1, &left, &right);
 				/* calculate min required left & right margins
 				 * needed to avoid floats */
@@ -4149,7 +4342,7 @@ layout_block_context(struct box *block,
 					x1 = cx + box->parent->width -
 						box->parent->padding[LEFT] -
 						box->parent->padding[RIGHT];
-					find_sides(block->float_children,
+					find_sides(block,
 						top, top, &x0, &x1,
 						&left, &right);
 					/* calculate min required left & right
@@ -4238,10 +4431,27 @@ layout_block_context(struct box *block,
 				return false;
 
 		} else if (box->type == BOX_INLINE_CONTAINER) {
+			bool intruded = layout_floats_below(block, cy);
+
 			box->width = box->parent->width;
-			if (!layout_inline_container(box, box->width, block,
-					cx, cy, content))
-				return false;
+			if (!intruded && layout_cache_valid(box, box->width,
+					0, -1, content)) {
+				/* Lines are unchanged and no float intrudes,
+				 * so keep their previous layout. */
+				box->width = box->layout_cache.result_width;
+				box->height = box->layout_cache.result_height;
+			} else {
+				if (!layout_inline_container(box, box->width,
+						block, cx, cy, content))
+					return false;
+				/* Lines placed around floats from outside
+				 * the container depend on where they are. */
+				layout_cache_store(box, box->parent->width,
+						0, -1, box->height,
+						!intruded &&
+						!layout_inline_container_has_floats(
+								box));
+			}
 
 		} else if (box->type == BOX_TABLE) {
 			/* Move down to avoid floats if necessary. */
@@ -4258,7 +4468,7 @@ layout_block_context(struct box *block,
 
 				x0 = cx;
 				x1 = cx + box->parent->width;
-				find_sides(block->float_children, y,
+				find_sides(block, y,
 						y + box->height,
 						&x0, &x1, &left, &right);
 				if (wtype == CSS_WIDTH_AUTO)
@@ -4284,7 +4494,7 @@ layout_block_context(struct box *block,
 		}
 
 		/* Advance to next box. */
-		if (box->type == BOX_BLOCK && !box->object && !(box->iframe) &&
+		if (box->type == BOX_BLOCK && !box->object && !(box->extra->iframe) &&
 				box->children) {
 			/* Down into children. */
 
@@ -4410,6 +4620,10 @@ layout_block_context(struct box *block,
 			cy = y;
 	}
 
+	layout_cache_store(block, block->width, entry_height, viewport_height,
+			cy - block->padding[TOP], true);
+
+layout_block_context_done:
 	if (block->height == AUTO) {
 		block->height = cy - block->padding[TOP];
 		if (block->type == BOX_BLOCK)
@@ -4422,10 +4636,10 @@ layout_block_context(struct box *block,
 		layout_apply_minmax_height(&content->unit_len_ctx, block, NULL);
 	}
 
-	if (block->gadget &&
-			(block->gadget->type == GADGET_TEXTAREA ||
-			block->gadget->type == GADGET_PASSWORD ||
-			block->gadget->type == GADGET_TEXTBOX)) {
+	if (block->extra->gadget &&
+			(block->extra->gadget->type == GADGET_TEXTAREA ||
+			block->extra->gadget->type == GADGET_PASSWORD ||
+			block->extra->gadget->type == GADGET_TEXTBOX)) {
 		plot_font_style_t fstyle;
 		int ta_width = block->padding[LEFT] + block->width +
 				block->padding[RIGHT];
@@ -4434,7 +4648,7 @@ layout_block_context(struct box *block,
 		font_plot_style_from_css(&content->unit_len_ctx,
 				block->style, &fstyle);
 		fstyle.background = NS_TRANSPARENT;
-		textarea_set_layout(block->gadget->data.text.ta,
+		textarea_set_layout(block->extra->gadget->data.text.ta,
 				&fstyle, ta_width, ta_height,
 				block->padding[TOP], block->padding[RIGHT],
 				block->padding[BOTTOM], block->padding[LEFT]);
@@ -4647,7 +4861,7 @@ layout__get_list_item_count(
 			}
 
 			if (child_box != NULL &&
-			    child_box->list_marker != NULL) {
+			    child_box->extra->list_marker != NULL) {
 				count++;
 			}
 		}
@@ -4728,9 +4942,9 @@ layout__ordered_list_count(
 			}
 
 			if (child_box != NULL &&
-			    child_box->list_marker != NULL) {
+			    child_box->extra->list_marker != NULL) {
 				dom_long value;
-				struct box *marker = child_box->list_marker;
+				struct box *marker = child_box->extra->list_marker;
 				if (layout__get_li_value(child, &value)) {
 					marker->list_value = value;
 					next = marker->list_value;
@@ -4762,7 +4976,7 @@ layout__set_numerical_marker_text(
 		const html_content *content,
 		struct box *box)
 {
-	struct box *marker = box->list_marker;
+	struct box *marker = box->extra->list_marker;
 	size_t counter_len;
 	css_error css_res;
 	enum {
@@ -4836,8 +5050,8 @@ layout_lists(const html_content *content, struct box *box)
 	layout__ordered_list_count(box);
 
 	for (child = box->children; child; child = child->next) {
-		if (child->list_marker) {
-			struct box *marker = child->list_marker;
+		if (child->extra->list_marker) {
+			struct box *marker = child->extra->list_marker;
 
 			if (layout__list_item_is_numerical(child)) {
 				if (marker->text == NULL) {
@@ -4862,7 +5076,7 @@ layout_lists(const html_content *content, struct box *box)
 							&content->unit_len_ctx,
 							marker->style,
 							&fstyle);
-					content->font_func->width(&fstyle,
+					font_width_cached(content->font_func, &fstyle,
 							marker->text,
 							marker->length,
 							&marker->width);
@@ -5750,14 +5964,14 @@ static void layout_calculate_descendant_bboxes(
 			box->descendant_y1 = content_get_height(box->object);
 	}
 
-	if (box->iframe != NULL) {
+	if (box->extra->iframe != NULL) {
 		int x, y;
 		box_coords(box, &x, &y);
 
-		browser_window_set_position(box->iframe, x, y);
-		browser_window_set_dimensions(box->iframe,
+		browser_window_set_position(box->extra->iframe, x, y);
+		browser_window_set_dimensions(box->extra->iframe,
 				box->width, box->height);
-		browser_window_reformat(box->iframe, true,
+		browser_window_reformat(box->extra->iframe, true,
 				box->width, box->height);
 	}
 
@@ -5810,8 +6024,8 @@ static void layout_calculate_descendant_bboxes(
 		layout_update_descendant_bbox(unit_len_ctx, box, child, 0, 0);
 	}
 
-	if (box->list_marker) {
-		child = box->list_marker;
+	if (box->extra->list_marker) {
+		child = box->extra->list_marker;
 		layout_calculate_descendant_bboxes(unit_len_ctx, child);
 
 		layout_update_descendant_bbox(unit_len_ctx, box, child, 0, 0);
@@ -5819,6 +6033,25 @@ static void layout_calculate_descendant_bboxes(
 }
 
 
+/**
+ * Compare two length conversion contexts.
+ *
+ * \param  a  first context
+ * \param  b  second context
+ * \return  true if lengths convert identically in both contexts
+ */
+static bool
+layout_unit_len_ctx_equal(const css_unit_ctx *a, const css_unit_ctx *b)
+{
+	return (a->viewport_width == b->viewport_width &&
+		a->viewport_height == b->viewport_height &&
+		a->font_size_default == b->font_size_default &&
+		a->font_size_minimum == b->font_size_minimum &&
+		a->device_dpi == b->device_dpi &&
+		a->root_style == b->root_style);
+}
+
+
 /* exported function documented in html/layout.h */
 bool layout_document(html_content *content, int width, int height)
 {
@@ -5830,6 +6063,23 @@ bool layout_document(html_content *content, int width, int height)
 			width, height, nsurl_access(content_get_url(
 					&content->base)));
 
+	font_width_cache_validate();
+
+	if (nsoption_bool(incremental_layout) == false) {
+		content->relayout_all = true;
+	}
+
+	/* Any change to the length conversion context may change the
+	 * layout of every box, so nothing can be kept. */
+	if (!layout_unit_len_ctx_equal(&content->layout_unit_len_ctx,
+			&content->unit_len_ctx)) {
+		content->relayout_all = true;
+	}
+	if (content->relayout_all) {
+		layout_mark_positioned(doc);
+		content->layout_unit_len_ctx = content->unit_len_ctx;
+	}
+
 	layout_minmax_block(doc, font_func, content);
 
 	layout_block_find_dimensions(&content->unit_len_ctx,
@@ -5870,5 +6120,19 @@ bool layout_document(html_content *content, int width, int height)
 
 	layout_calculate_descendant_bboxes(&content->unit_len_ctx, doc);
 
+	if (box_index_build(doc) != NSERROR_OK) {
+		NSLOG(layout, INFO, "Unable to index box tree");
+	}
+
+	content->relayout_all = false;
+
+	if (NSLOG_COMPILED_MIN_LEVEL <= NSLOG_LEVEL_DEBUG) {
+		struct font_width_cache_stats stats;
+
+		font_width_cache_get_stats(&stats);
+		NSLOG(layout, DEBUG, "Text width cache %u hits %u misses "
+		      "%u entries", stats.hits, stats.misses, stats.entries);
+	}
+
 	return ret;
 }
@@ -38,6 +38,7 @@
 #include "content/hlcache.h"
 #include "css/utils.h"
 #include "desktop/scrollbar.h"
+#include "desktop/browser_private.h"
 #include "desktop/gui_internal.h"
 
 #include "html/html.h"
@@ -45,10 +46,12 @@
 #include "html/interaction.h"
 #include "html/box.h"
 #include "html/box_inspect.h"
+#include "html/box_manipulate.h"
 #include "html/object.h"
 
 /* break reference loop */
 static void html_object_refresh(void *p);
+static void html_object_lazy_callback(void *p);
 
 /**
  * Retrieve objects used by HTML document
@@ -93,8 +96,6 @@ html_object_done(struct box *box,
 		 hlcache_handle *object,
 		 bool background)
 {
-	struct box *b;
-
 	if (background) {
 		box->background = object;
 		return;
@@ -112,11 +113,11 @@ html_object_done(struct box *box,
 		break;
 	}
 
-	if (!(box->flags & REPLACE_DIM)) {
-		/* invalidate parent min, max widths */
-		for (b = box; b; b = b->parent)
-			b->max_width = UNKNOWN_MAX_WIDTH;
+	/* invalidate layout, and parent min, max widths unless the
+	 * dimensions were given */
+	box_invalidate_layout(box, !(box->flags & REPLACE_DIM));
 
+	if (!(box->flags & REPLACE_DIM)) {
 		/* delete any clones of this box */
 		while (box->next && (box->next->flags & CLONE)) {
 			/* box_free_box(box->next); */
@@ -151,6 +152,42 @@ html_object_nobox_callback(hlcache_handle *object,
 }
 
 
+/**
+ * schedule callback for reformatting after lazily fetched objects arrive
+ */
+static void html_object_lazy_reformat(void *p)
+{
+	html_content *c = p;
+
+	content__reformat(&c->base,
+			  false,
+			  c->base.available_width,
+			  c->base.available_height);
+}
+
+
+/**
+ * Schedule a reformat to resize the boxes of lazily fetched objects.
+ *
+ * Objects which arrive before the scheduled reformat share it and it
+ * is not run until the minimum time between reformats has passed.
+ *
+ * \param c content of type CONTENT_HTML
+ */
+static void html_object_schedule_lazy_reformat(html_content *c)
+{
+	uint64_t ms_now;
+	int delay = 0;
+
+	nsu_getmonotonic_ms(&ms_now);
+	if (ms_now < c->base.reformat_time) {
+		delay = c->base.reformat_time - ms_now;
+	}
+
+	guit->misc->schedule(delay, html_object_lazy_reformat, c);
+}
+
+
 /**
  * Callback for hlcache_handle_retrieve() for objects with a box.
  */
@@ -171,7 +208,7 @@ html_object_callback(hlcache_handle *object,
 		if (c->base.status != CONTENT_STATUS_LOADING && c->bw != NULL)
 			content_open(object,
 					c->bw, &c->base,
-					box->object_params);
+					box->extra->object_params);
 		break;
 
 	case CONTENT_MSG_READY:
@@ -185,6 +222,7 @@ html_object_callback(hlcache_handle *object,
 
 			/* Adjust parent content for new object size */
 			html_object_done(box, object, o->background);
+			html_redraw_invalidate(c);
 			if (c->base.status == CONTENT_STATUS_READY ||
 					c->base.status == CONTENT_STATUS_DONE)
 				content__reformat(&c->base, false,
@@ -198,6 +236,7 @@ html_object_callback(hlcache_handle *object,
 		NSLOG(netsurf, INFO, "%d fetches active", c->base.active);
 
 		html_object_done(box, object, o->background);
+		html_redraw_invalidate(c);
 
 		if (c->base.status != CONTENT_STATUS_LOADING &&
 				box->flags & REPLACE_DIM) {
@@ -230,6 +269,7 @@ html_object_callback(hlcache_handle *object,
 		NSLOG(netsurf, INFO, "%d fetches active", c->base.active);
 
 		html_object_failed(box, c, o->background);
+		html_redraw_invalidate(c);
 
 		break;
 
@@ -482,6 +522,20 @@ html_object_callback(hlcache_handle *object,
 		content__reformat(&c->base, false, c->base.available_width,
 				c->base.available_height);
 		content_set_done(&c->base);
+	} else if (event->type == CONTENT_MSG_DONE &&
+		   box != NULL &&
+		   !(box->flags & REPLACE_DIM) &&
+		   o->fetched_lazily &&
+		   c->base.status == CONTENT_STATUS_DONE) {
+		/* A lazily fetched object arrived after the document
+		 * was done so its box must be resized. Without
+		 * incremental reflow wait until the other lazily
+		 * fetched objects have arrived too.
+		 */
+		if (nsoption_bool(incremental_reflow) ||
+		    c->base.active == 0) {
+			html_object_schedule_lazy_reformat(c);
+		}
 	} else if (nsoption_bool(incremental_reflow) &&
 		   event->type == CONTENT_MSG_DONE &&
 		   box != NULL &&
@@ -547,6 +601,7 @@ static bool html_replace_object(struct content_html_object *object, nsurl *url)
 		object->content = NULL;
 
 		object->box->object = NULL;
+		html_redraw_invalidate(c);
 	}
 
 	/* initialise fetch */
@@ -611,7 +666,7 @@ nserror html_object_open_objects(html_content *html, struct browser_window *bw)
 		content_open(object->content,
 			     bw,
 			     &html->base,
-			     object->box->object_params);
+			     object->box->extra->object_params);
 	}
 	return NSERROR_OK;
 }
@@ -625,6 +680,13 @@ nserror html_object_abort_objects(html_content *htmlc)
 	for (object = htmlc->object_list;
 	     object != NULL;
 	     object = object->next) {
+		if (object->url != NULL) {
+			/* deferred fetch which has not started */
+			nsurl_unref(object->url);
+			object->url = NULL;
+			object->lazy = false;
+		}
+
 		if (object->content == NULL)
 			continue;
 
@@ -655,6 +717,8 @@ nserror html_object_abort_objects(html_content *htmlc)
 		}
 	}
 
+	htmlc->lazy_objects = 0;
+
 	return NSERROR_OK;
 }
 
@@ -664,6 +728,9 @@ nserror html_object_close_objects(html_content *html)
 {
 	struct content_html_object *object, *next;
 
+	guit->misc->schedule(-1, html_object_lazy_callback, html);
+	guit->misc->schedule(-1, html_object_lazy_reformat, html);
+
 	for (object = html->object_list; object != NULL; object = next) {
 		next = object->next;
 
@@ -686,6 +753,9 @@ nserror html_object_close_objects(html_content *html)
 /* exported interface documented in html/object.h */
 nserror html_object_free_objects(html_content *html)
 {
+	guit->misc->schedule(-1, html_object_lazy_callback, html);
+	guit->misc->schedule(-1, html_object_lazy_reformat, html);
+
 	while (html->object_list != NULL) {
 		struct content_html_object *victim = html->object_list;
 
@@ -698,13 +768,110 @@ nserror html_object_free_objects(html_content *html)
 			hlcache_handle_release(victim->content);
 		}
 
+		if (victim->url != NULL) {
+			nsurl_unref(victim->url);
+		}
+
 		html->object_list = victim->next;
 		free(victim);
 	}
+	html->lazy_objects = 0;
 	return NSERROR_OK;
 }
 
 
+/**
+ * Start the fetch for an object
+ *
+ * \param c content of type CONTENT_HTML
+ * \param object The object to fetch
+ * \param url URL of object to fetch
+ * \return NSERROR_OK on success, appropriate error otherwise
+ */
+static nserror
+html_object_retrieve(html_content *c,
+		     struct content_html_object *object,
+		     nsurl *url)
+{
+	hlcache_handle_callback object_callback;
+	hlcache_child_context child;
+	nserror error;
+
+	child.charset = c->encoding;
+	child.quirks = c->base.quirks;
+
+	if (object->box == NULL) {
+		object_callback = html_object_nobox_callback;
+	} else {
+		object_callback = html_object_callback;
+	}
+
+	error = hlcache_handle_retrieve(url,
+					HLCACHE_RETRIEVE_SNIFF_TYPE,
+					content_get_url(&c->base),
+					NULL,
+					object_callback,
+					object,
+					&child,
+					object->permitted_types,
+					&object->content);
+	if (error != NSERROR_OK) {
+		return error;
+	}
+
+	if (object->box != NULL) {
+		c->base.active++;
+		NSLOG(netsurf, INFO, "%d fetches active", c->base.active);
+	}
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Determine if the fetch for an object should wait until its box is
+ * near the viewport.
+ *
+ * Objects are fetched lazily if their element has a loading attribute
+ * of lazy or, unless it is eager, when every image is to be fetched
+ * lazily.
+ *
+ * \param box box that will contain the object or NULL if none
+ * \param background this is a background image
+ * \return true if the fetch should wait
+ */
+static bool html_object_is_lazy(struct box *box, bool background)
+{
+	dom_string *s;
+	dom_exception err;
+	bool lazy;
+
+	if (box == NULL) {
+		/* objects without a box must always be fetched */
+		return false;
+	}
+
+	lazy = nsoption_bool(lazy_load_images);
+
+	if (background || box->node == NULL) {
+		return lazy;
+	}
+
+	err = dom_element_get_attribute(box->node, corestring_dom_loading, &s);
+	if (err == DOM_NO_ERR && s != NULL) {
+		if (dom_string_caseless_lwc_isequal(s, corestring_lwc_lazy)) {
+			lazy = true;
+		} else if (dom_string_caseless_lwc_isequal(s,
+				corestring_lwc_eager)) {
+			lazy = false;
+		}
+		dom_string_unref(s);
+	}
+
+	return lazy;
+}
+
+
 /* exported interface documented in html/object.h */
 bool
 html_fetch_object(html_content *c,
@@ -714,47 +881,40 @@ html_fetch_object(html_content *c,
 		  bool background)
 {
 	struct content_html_object *object;
-	hlcache_handle_callback object_callback;
-	hlcache_child_context child;
 	nserror error;
 
 	/* If we've already been aborted, don't bother attempting the fetch */
 	if (c->aborted)
 		return true;
 
-	child.charset = c->encoding;
-	child.quirks = c->base.quirks;
-
 	object = calloc(1, sizeof(struct content_html_object));
 	if (object == NULL) {
 		return false;
 	}
 
-	if (box == NULL) {
-		object_callback = html_object_nobox_callback;
-	} else {
-		object_callback = html_object_callback;
-	}
-
 	object->parent = (struct content *) c;
 	object->next = NULL;
 	object->content = NULL;
+	object->url = NULL;
 	object->box = box;
 	object->permitted_types = permitted_types;
 	object->background = background;
 
-	error = hlcache_handle_retrieve(url,
-					HLCACHE_RETRIEVE_SNIFF_TYPE,
-					content_get_url(&c->base),
-					NULL,
-					object_callback,
-					object,
-					&child,
-					object->permitted_types,
-					&object->content);
-	if (error != NSERROR_OK) {
-		free(object);
-		return error != NSERROR_NOMEM;
+	if (html_object_is_lazy(box, background)) {
+		/* Fetch when layout places the box near the viewport */
+		object->url = nsurl_ref(url);
+		object->lazy = true;
+		c->lazy_objects++;
+	} else if (c->progressive) {
+		/* Objects must not delay completion of the document
+		 * conversion, so wait until it has finished */
+		object->url = nsurl_ref(url);
+	} else {
+		error = html_object_retrieve(c, object, url);
+		if (error != NSERROR_OK) {
+			free(object);
+			return error != NSERROR_NOMEM;
+		}
 	}
 
 	/* add to content object list */
@@ -762,10 +922,177 @@ html_fetch_object(html_content *c,
 	c->object_list = object;
 
 	c->num_objects++;
-	if (box != NULL) {
-		c->base.active++;
-		NSLOG(netsurf, INFO, "%d fetches active", c->base.active);
-	}
 
 	return true;
 }
+
+
+/* exported interface documented in html/object.h */
+nserror html_object_fetch_deferred(html_content *c)
+{
+	struct content_html_object **link = &c->object_list;
+	struct content_html_object *object;
+	nserror error;
+
+	while ((object = *link) != NULL) {
+		if (object->url == NULL || object->lazy) {
+			link = &object->next;
+			continue;
+		}
+
+		error = NSERROR_STOPPED;
+		if (c->aborted == false) {
+			error = html_object_retrieve(c, object, object->url);
+		}
+
+		nsurl_unref(object->url);
+		object->url = NULL;
+
+		if (error == NSERROR_OK) {
+			link = &object->next;
+			continue;
+		}
+
+		/* drop the object from the list as the fetch failed */
+		*link = object->next;
+		c->num_objects--;
+		free(object);
+
+		if (error == NSERROR_NOMEM) {
+			return error;
+		}
+	}
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Determine if the box of an object is within a rectangle.
+ *
+ * \param box box to test
+ * \param area rectangle in document coordinates
+ * \return true if any of the box is within the area
+ */
+static bool html_object_box_near(struct box *box, const struct rect *area)
+{
+	int x, y;
+
+	box_coords(box, &x, &y);
+
+	return ((x + box->padding[LEFT] + box->width + box->padding[RIGHT] >=
+		 area->x0) &&
+		(x <= area->x1) &&
+		(y + box->padding[TOP] + box->height + box->padding[BOTTOM] >=
+		 area->y0) &&
+		(y <= area->y1));
+}
+
+
+/**
+ * Start the lazy fetches of objects whose boxes are near the viewport.
+ *
+ * \param c content of type CONTENT_HTML
+ * \return NSERROR_OK on success else appropriate error code.
+ */
+static nserror html_object_fetch_lazy(html_content *c)
+{
+	struct content_html_object **link = &c->object_list;
+	struct content_html_object *object;
+	struct rect area;
+	int width = c->base.available_width;
+	int height = c->base.available_height;
+	int distance = nsoption_uint(lazy_load_distance);
+	int sx = 0;
+	int sy = 0;
+	nserror error;
+
+	if (c->bw != NULL) {
+		browser_window_get_scroll(c->bw, &sx, &sy);
+	}
+	c->lazy_scroll_x = sx;
+	c->lazy_scroll_y = sy;
+
+	area.x0 = sx - width * distance;
+	area.y0 = sy - height * distance;
+	area.x1 = sx + width * (distance + 1);
+	area.y1 = sy + height * (distance + 1);
+
+	while ((object = *link) != NULL && c->lazy_objects != 0) {
+		if (object->lazy == false ||
+		    html_object_box_near(object->box, &area) == false) {
+			link = &object->next;
+			continue;
+		}
+
+		object->lazy = false;
+		c->lazy_objects--;
+		object->fetched_lazily = true;
+
+		error = html_object_retrieve(c, object, object->url);
+
+		nsurl_unref(object->url);
+		object->url = NULL;
+
+		if (error == NSERROR_OK) {
+			link = &object->next;
+			continue;
+		}
+
+		/* drop the object from the list as the fetch failed */
+		*link = object->next;
+		c->num_objects--;
+		free(object);
+
+		if (error == NSERROR_NOMEM) {
+			return error;
+		}
+	}
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * schedule callback for lazy object fetching
+ */
+static void html_object_lazy_callback(void *p)
+{
+	html_content *c = p;
+	nserror error;
+
+	error = html_object_fetch_lazy(c);
+	if (error != NSERROR_OK) {
+		NSLOG(netsurf, INFO, "lazy object fetch failed");
+	}
+}
+
+
+/* exported interface documented in html/object.h */
+void html_object_check_lazy(html_content *c)
+{
+	if (c->lazy_objects == 0 ||
+	    c->had_initial_layout == false ||
+	    c->aborted) {
+		return;
+	}
+
+	guit->misc->schedule(0, html_object_lazy_callback, c);
+}
+
+
+/* exported interface documented in html/object.h */
+void html_object_check_lazy_scroll(html_content *c)
+{
+	int sx, sy;
+
+	if (c->lazy_objects == 0 ||
+	    c->bw == NULL ||
+	    browser_window_get_scroll(c->bw, &sx, &sy) != NSERROR_OK) {
+		return;
+	}
+
+	if (sx != c->lazy_scroll_x || sy != c->lazy_scroll_y) {
+		html_object_check_lazy(c);
+	}
+}
@@ -34,7 +34,11 @@ struct nsurl;
  *
  * The created content object is added to the HTML content which is
  *  updated as the fetch progresses. The box (if any) is updated when
- *  the object content becomes done.
+ *  the object content becomes done. While the box tree is being
+ *  constructed progressively the fetch is deferred until
+ *  html_object_fetch_deferred() is called. Lazily loaded objects are
+ *  not fetched until html_object_check_lazy() finds their box is near
+ *  the viewport.
  *
  * \param c content of type CONTENT_HTML
  * \param url URL of object to fetch
@@ -45,6 +49,36 @@ struct nsurl;
  */
 bool html_fetch_object(struct html_content *c, struct nsurl *url, struct box *box, content_type permitted_types, bool background);
 
+/**
+ * Start the object fetches deferred while the box tree was being
+ * constructed before the document parse completed.
+ *
+ * \param c content of type CONTENT_HTML
+ * \return NSERROR_OK on success else appropriate error code.
+ */
+nserror html_object_fetch_deferred(struct html_content *c);
+
+/**
+ * Schedule the fetches of lazily loaded objects whose boxes have
+ * come near the viewport.
+ *
+ * Called whenever the layout may have changed.
+ *
+ * \param c content of type CONTENT_HTML
+ */
+void html_object_check_lazy(struct html_content *c);
+
+/**
+ * Schedule the fetches of lazily loaded objects if the window has
+ * scrolled since they were last checked.
+ *
+ * Front ends scroll their windows without telling the core, so this
+ * is called when the document is redrawn.
+ *
+ * \param c content of type CONTENT_HTML
+ */
+void html_object_check_lazy_scroll(struct html_content *c);
+
 /**
  * release memory of content objects associated with a HTML content
  *
@@ -35,6 +35,9 @@ struct gui_layout_table;
 struct scrollbar_msg_data;
 struct content_redraw_data;
 struct selection;
+struct html_display_list;
+struct box_arena;
+struct nscss_sibling_cache;
 
 typedef enum {
 	HTML_DRAG_NONE,			/** No drag */
@@ -87,6 +90,16 @@ union html_focus_owner {
 	struct box *content;
 };
 
+/**
+ * State of the retained display list
+ */
+typedef enum {
+	HTML_DISPLAY_LIST_INVALID,	/**< Out of date, draw directly */
+	HTML_DISPLAY_LIST_PENDING,	/**< Out of date, record on redraw */
+	HTML_DISPLAY_LIST_VALID,	/**< Up to date, replay on redraw */
+	HTML_DISPLAY_LIST_FAILED	/**< Could not be recorded */
+} html_display_list_state;
+
 /**
  * Data specific to CONTENT_HTML.
  */
@@ -130,17 +143,30 @@ typedef struct html_content {
 	/* Title element node */
 	dom_node *title;
 
-	/** A talloc context purely for the render box tree */
-	int *bctx;
+	/** Arena for the render box tree, also used as its talloc context */
+	struct box_arena *bctx;
 	/** A context pointer for the box conversion, NULL if no conversion
 	 * is in progress.
 	 */
 	void *box_conversion_context;
+	/** Whether the box tree is being constructed as the document is
+	 * parsed, displaying the part converted so far.
+	 */
+	bool progressive;
 	/** Box tree, or NULL. */
 	struct box *layout;
 	/** Document background colour. */
 	colour background_colour;
 
+	/** Retained plot operations for the box tree, or NULL. */
+	struct html_display_list *display_list;
+	/** State of the retained display list */
+	html_display_list_state display_list_state;
+	/** Background colour the display list was recorded with */
+	colour display_list_background;
+	/** Value of html_redraw_debug the display list was recorded with */
+	bool display_list_debug;
+
 	/** Font callback table */
 	const struct gui_layout_table *font_func;
 
@@ -161,11 +187,21 @@ typedef struct html_content {
 	css_media media;
 	/** CSS length conversion context for document. */
 	css_unit_ctx unit_len_ctx;
+	/** CSS length conversion context of the previous layout. */
+	css_unit_ctx layout_unit_len_ctx;
+	/** Whether the next layout must ignore previous box layouts */
+	bool relayout_all;
 	/**< Universal selector */
 	lwc_string *universal;
+	/** Sibling positions cached while boxes are constructed, or NULL */
+	struct nscss_sibling_cache *sibling_cache;
 
 	/** Number of entries in object_list. */
 	unsigned int num_objects;
+	/** Number of objects waiting to be near the viewport to fetch. */
+	unsigned int lazy_objects;
+	/** Scroll offsets when lazily loaded objects were last checked. */
+	int lazy_scroll_x, lazy_scroll_y;
 	/** List of objects. */
 	struct content_html_object *object_list;
 	/** Forms, in reverse order to document. */
@@ -298,6 +334,15 @@ nserror html_proceed_to_done(html_content *html);
 bool html_redraw(struct content *c, struct content_redraw_data *data,
 		const struct rect *clip, const struct redraw_context *ctx);
 
+/**
+ * Discard the retained display list of a content.
+ *
+ * Must be called whenever anything the box tree plots changes.
+ *
+ * \param htmlc HTML content whose rendering has changed
+ */
+void html_redraw_invalidate(html_content *htmlc);
+
 
 /* in html/redraw_border.c */
 bool html_redraw_borders(struct box *box, int x_parent, int y_parent,
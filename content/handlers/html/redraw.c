@@ -59,14 +59,44 @@
 #include "html/box.h"
 #include "html/box_inspect.h"
 #include "html/box_manipulate.h"
+#include "html/box_index.h"
+#include "html/display_list.h"
 #include "html/font.h"
 #include "html/form_internal.h"
 #include "html/private.h"
 #include "html/layout.h"
+#include "html/object.h"
 
 
 bool html_redraw_debug = false;
 
+
+/**
+ * Redraw a background image.
+ *
+ * When recording a display list the image is recorded by reference
+ * so it is drawn by its own handler whenever the list is replayed.
+ *
+ * \param object content to redraw
+ * \param data   redraw data for the object
+ * \param clip   clip rectangle
+ * \param ctx    current redraw context
+ * \return true if successful, false otherwise
+ */
+static bool
+html_redraw_background_object(struct hlcache_handle *object,
+		struct content_redraw_data *data,
+		const struct rect *clip,
+		const struct redraw_context *ctx)
+{
+	if (html_display_list_recording(ctx)) {
+		return (html_display_list_object(ctx, object,
+						 data, clip) == NSERROR_OK);
+	}
+
+	return content_redraw(object, data, clip, ctx);
+}
+
 /**
  * Determine if a box has a background that needs drawing
  *
@@ -547,8 +577,8 @@ static bool html_redraw_file(int x, int y, int width, int height,
 	font_plot_style_from_css(unit_len_ctx, box->style, &fstyle);
 	fstyle.background = background_colour;
 
-	if (box->gadget->value) {
-		text = box->gadget->value;
+	if (box->extra->gadget->value) {
+		text = box->extra->gadget->value;
 	} else {
 		text = messages_get("Form_Drop");
 	}
@@ -791,7 +821,8 @@ static bool html_redraw_background(int x, int y, struct box *box, float scale,
 				bg_data.repeat_y = repeat_y;
 
 				/* We just continue if redraw fails */
-				content_redraw(background->background,
+				html_redraw_background_object(
+						background->background,
 						&bg_data, &r, ctx);
 			}
 		}
@@ -951,7 +982,8 @@ static bool html_redraw_inline_background(int x, int y, struct box *box,
 			bg_data.repeat_y = repeat_y;
 
 			/* We just continue if redraw fails */
-			content_redraw(box->background, &bg_data, &r, ctx);
+			html_redraw_background_object(box->background,
+					&bg_data, &r, ctx);
 		}
 	}
 
@@ -1186,8 +1218,15 @@ static bool html_redraw_box_children(const html_content *html, struct box *box,
 		const struct redraw_context *ctx)
 {
 	struct box *c;
+	struct box *end;
+	int origin_y;
 
-	for (c = box->children; c; c = c->next) {
+	/* restrict to the children which may intersect the clip */
+	origin_y = y_parent + box->y - scrollbar_get_offset(box->scroll_y);
+	c = box_index_first(box, (int)floorf(clip->y0 / scale) - origin_y - 1);
+	end = box_index_end(box, (int)ceilf(clip->y1 / scale) - origin_y + 1);
+
+	for (; c != end; c = c->next) {
 
 		if (c->type != BOX_FLOAT_LEFT && c->type != BOX_FLOAT_RIGHT)
 			if (!html_redraw_box(html, c,
@@ -1374,7 +1413,7 @@ bool html_redraw_box(const html_content *html, struct box *box,
 			if (r.y1 - r.y0 <= html_redraw_printing_border &&
 					(box->type == BOX_TEXT ||
 					box->type == BOX_TABLE_CELL
-					|| box->object || box->gadget)) {
+					|| box->object || box->extra->gadget)) {
 				/*remember the highest of all points from the
 				not printed elements*/
 				if (r.y0 < html_redraw_printing_top_cropped)
@@ -1478,10 +1517,10 @@ bool html_redraw_box(const html_content *html, struct box *box,
 			bg_box->type != BOX_INLINE_END &&
 			(bg_box->type != BOX_INLINE || bg_box->object ||
 			bg_box->flags & IFRAME || box->flags & REPLACE_DIM ||
-			(bg_box->gadget != NULL &&
-			(bg_box->gadget->type == GADGET_TEXTAREA ||
-			bg_box->gadget->type == GADGET_TEXTBOX ||
-			bg_box->gadget->type == GADGET_PASSWORD)))) {
+			(bg_box->extra->gadget != NULL &&
+			(bg_box->extra->gadget->type == GADGET_TEXTAREA ||
+			bg_box->extra->gadget->type == GADGET_TEXTBOX ||
+			bg_box->extra->gadget->type == GADGET_PASSWORD)))) {
 		/* find intersection of clip box and border edge */
 		struct rect p;
 		p.x0 = x - border_left < r.x0 ? r.x0 : x - border_left;
@@ -1529,10 +1568,10 @@ bool html_redraw_box(const html_content *html, struct box *box,
 	    box->type != BOX_INLINE_END &&
 	    (box->type != BOX_INLINE || box->object ||
 	     box->flags & IFRAME || box->flags & REPLACE_DIM ||
-	     (box->gadget != NULL &&
-	      (box->gadget->type == GADGET_TEXTAREA ||
-	       box->gadget->type == GADGET_TEXTBOX ||
-	       box->gadget->type == GADGET_PASSWORD))) &&
+	     (box->extra->gadget != NULL &&
+	      (box->extra->gadget->type == GADGET_TEXTAREA ||
+	       box->extra->gadget->type == GADGET_TEXTBOX ||
+	       box->extra->gadget->type == GADGET_PASSWORD))) &&
 	    (border_top || border_right || border_bottom || border_left)) {
 		if (!html_redraw_borders(box, x_parent, y_parent,
 				padding_width, padding_height, &r,
@@ -1757,6 +1796,7 @@ bool html_redraw_box(const html_content *html, struct box *box,
 
 	if (box->object && width != 0 && height != 0) {
 		struct content_redraw_data obj_data;
+		bool recording;
 
 		x_scrolled = x - scrollbar_get_offset(box->scroll_x) * scale;
 		y_scrolled = y - scrollbar_get_offset(box->scroll_y) * scale;
@@ -1775,7 +1815,17 @@ bool html_redraw_box(const html_content *html, struct box *box,
 			obj_data.y /= scale;
 		}
 
-		if (!content_redraw(box->object, &obj_data, &r, ctx)) {
+		/* When recording, the image fail is recorded as a fallback
+		 * to plot if the object fails to redraw on replay.
+		 */
+		recording = html_display_list_recording(ctx);
+		if (recording && html_display_list_object(ctx, box->object,
+				&obj_data, &r) != NSERROR_OK) {
+			return false;
+		}
+
+		if (recording ||
+		    !content_redraw(box->object, &obj_data, &r, ctx)) {
 			/* Show image fail */
 			/* Unicode (U+FFFC) 'OBJECT REPLACEMENT CHARACTER' */
 			const char *obj = "\xef\xbf\xbc";
@@ -1807,6 +1857,10 @@ bool html_redraw_box(const html_content *html, struct box *box,
 					    obj_x, y + padding_top + (int)(height * 0.75),
 					    obj, sizeof(obj) - 1) != NSERROR_OK)
 				return false;
+
+			if (recording) {
+				html_display_list_fallback(ctx);
+			}
 		}
 	} else if (tag_type == DOM_HTML_ELEMENT_TYPE_CANVAS &&
 		   box->node != NULL &&
@@ -1824,33 +1878,39 @@ bool html_redraw_box(const html_content *html, struct box *box,
 				      width, height, current_background_color,
 				      BITMAPF_NONE) != NSERROR_OK)
 			return false;
-	} else if (box->iframe) {
+	} else if (box->extra->iframe) {
 		/* Offset is passed to browser window redraw unscaled */
-		browser_window_redraw(box->iframe,
-				x + padding_left,
-				y + padding_top, &r, ctx);
+		if (!html_display_list_recording(ctx)) {
+			browser_window_redraw(box->extra->iframe,
+					x + padding_left,
+					y + padding_top, &r, ctx);
+		} else if (html_display_list_iframe(ctx, box->extra->iframe,
+				x + padding_left, y + padding_top,
+				&r) != NSERROR_OK) {
+			return false;
+		}
 
-	} else if (box->gadget && box->gadget->type == GADGET_CHECKBOX) {
+	} else if (box->extra->gadget && box->extra->gadget->type == GADGET_CHECKBOX) {
 		if (!html_redraw_checkbox(x + padding_left, y + padding_top,
-				width, height, box->gadget->selected, ctx))
+				width, height, box->extra->gadget->selected, ctx))
 			return false;
 
-	} else if (box->gadget && box->gadget->type == GADGET_RADIO) {
+	} else if (box->extra->gadget && box->extra->gadget->type == GADGET_RADIO) {
 		if (!html_redraw_radio(x + padding_left, y + padding_top,
-				width, height, box->gadget->selected, ctx))
+				width, height, box->extra->gadget->selected, ctx))
 			return false;
 
-	} else if (box->gadget && box->gadget->type == GADGET_FILE) {
+	} else if (box->extra->gadget && box->extra->gadget->type == GADGET_FILE) {
 		if (!html_redraw_file(x + padding_left, y + padding_top,
 				width, height, box, scale,
 				current_background_color, &html->unit_len_ctx, ctx))
 			return false;
 
-	} else if (box->gadget &&
-			(box->gadget->type == GADGET_TEXTAREA ||
-			box->gadget->type == GADGET_PASSWORD ||
-			box->gadget->type == GADGET_TEXTBOX)) {
-		textarea_redraw(box->gadget->data.text.ta, x, y,
+	} else if (box->extra->gadget &&
+			(box->extra->gadget->type == GADGET_TEXTAREA ||
+			box->extra->gadget->type == GADGET_PASSWORD ||
+			box->extra->gadget->type == GADGET_TEXTBOX)) {
+		textarea_redraw(box->extra->gadget->data.text.ta, x, y,
 				current_background_color, scale, &r, ctx);
 
 	} else if (box->text) {
@@ -1870,8 +1930,8 @@ bool html_redraw_box(const html_content *html, struct box *box,
 			return false;
 
 	/* list marker */
-	if (box->list_marker) {
-		if (!html_redraw_box(html, box->list_marker,
+	if (box->extra->list_marker) {
+		if (!html_redraw_box(html, box->extra->list_marker,
 				x_parent + box->x -
 				scrollbar_get_offset(box->scroll_x),
 				y_parent + box->y -
@@ -1883,7 +1943,7 @@ bool html_redraw_box(const html_content *html, struct box *box,
 	/* scrollbars */
 	if (((box->style && box->type != BOX_BR &&
 	      box->type != BOX_TABLE && box->type != BOX_INLINE &&
-	      (box->gadget == NULL || box->gadget->type != GADGET_TEXTAREA) &&
+	      (box->extra->gadget == NULL || box->extra->gadget->type != GADGET_TEXTAREA) &&
 	      (overflow_x == CSS_OVERFLOW_SCROLL ||
 	       overflow_x == CSS_OVERFLOW_AUTO ||
 	       overflow_y == CSS_OVERFLOW_SCROLL ||
@@ -1929,6 +1989,109 @@ bool html_redraw_box(const html_content *html, struct box *box,
 	return ((!plot->group_end) || (ctx->plot->group_end(ctx) == NSERROR_OK));
 }
 
+/* exported interface documented in html/private.h */
+void html_redraw_invalidate(html_content *htmlc)
+{
+	htmlc->display_list_state = HTML_DISPLAY_LIST_INVALID;
+}
+
+
+/**
+ * Record the box tree of a content into its display list.
+ *
+ * \param html      content to record
+ * \param background colour of the document background
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+html_redraw_record(html_content *html, colour background)
+{
+	struct box *box = html->layout;
+	struct redraw_context rctx;
+	struct rect extent;
+	nserror res;
+
+	if (html->display_list == NULL) {
+		res = html_display_list_create(&html->display_list);
+		if (res != NSERROR_OK) {
+			return res;
+		}
+	}
+
+	/* the whole document, which may reach beyond the content */
+	extent.x0 = min(0, box->x + box->descendant_x0);
+	extent.y0 = min(0, box->y + box->descendant_y0);
+	extent.x1 = max(html->base.width, box->x + box->descendant_x1) + 1;
+	extent.y1 = max(html->base.height, box->y + box->descendant_y1) + 1;
+
+	html_display_list_record(html->display_list, &rctx);
+
+	if (!html_redraw_box(html, box, 0, 0, &extent, 1.0,
+			background, &rctx)) {
+		return NSERROR_NOMEM;
+	}
+
+	return html_display_list_finish(html->display_list);
+}
+
+
+/**
+ * Draw the box tree of a content through its display list.
+ *
+ * The display list is recorded on the second redraw after the
+ * rendering changes, so content which changes continually is drawn
+ * directly rather than recorded each time.
+ *
+ * \param html      content to draw
+ * \param data      redraw data for this content redraw
+ * \param clip      current clip region
+ * \param background colour of the document background
+ * \param ctx       current redraw context
+ * \return true if successful, false otherwise
+ */
+static bool
+html_redraw_retained(html_content *html,
+		     struct content_redraw_data *data,
+		     const struct rect *clip,
+		     colour background,
+		     const struct redraw_context *ctx)
+{
+	if (html->display_list_state == HTML_DISPLAY_LIST_VALID &&
+	    (html->display_list_background != background ||
+	     html->display_list_debug != html_redraw_debug)) {
+		html->display_list_state = HTML_DISPLAY_LIST_PENDING;
+	}
+
+	switch (html->display_list_state) {
+	case HTML_DISPLAY_LIST_INVALID:
+		html->display_list_state = HTML_DISPLAY_LIST_PENDING;
+		break;
+
+	case HTML_DISPLAY_LIST_PENDING:
+		if (html_redraw_record(html, background) != NSERROR_OK) {
+			NSLOG(netsurf, INFO,
+			      "unable to record display list for %p", html);
+			html->display_list_state = HTML_DISPLAY_LIST_FAILED;
+			break;
+		}
+		html->display_list_state = HTML_DISPLAY_LIST_VALID;
+		html->display_list_background = background;
+		html->display_list_debug = html_redraw_debug;
+		/* fallthrough */
+
+	case HTML_DISPLAY_LIST_VALID:
+		return html_display_list_replay(html->display_list,
+				data->x, data->y, clip, ctx);
+
+	case HTML_DISPLAY_LIST_FAILED:
+		break;
+	}
+
+	return html_redraw_box(html, html->layout, data->x, data->y, clip,
+			data->scale, background, ctx);
+}
+
+
 /**
  * Draw a CONTENT_HTML using the current set of plotters (plot).
  *
@@ -1979,8 +2142,18 @@ bool html_redraw(struct content *c, struct content_redraw_data *data,
 
 		result &= (ctx->plot->rectangle(ctx, &pstyle_fill_bg, clip) == NSERROR_OK);
 
-		result &= html_redraw_box(html, box, data->x, data->y, clip,
-				data->scale, pstyle_fill_bg.fill_colour, ctx);
+		if (data->scale == 1.0 &&
+		    ctx->interactive &&
+		    ctx->background_images &&
+		    !html_redraw_printing &&
+		    c->textsearch.context == NULL) {
+			result &= html_redraw_retained(html, data, clip,
+					pstyle_fill_bg.fill_colour, ctx);
+		} else {
+			result &= html_redraw_box(html, box, data->x, data->y,
+					clip, data->scale,
+					pstyle_fill_bg.fill_colour, ctx);
+		}
 	}
 
 	if (select) {
@@ -1996,6 +2169,11 @@ bool html_redraw(struct content *c, struct content_redraw_data *data,
 				data->scale, clip, ctx);
 	}
 
+	if (ctx->interactive) {
+		/* the window may have been scrolled to lazily loaded objects */
+		html_object_check_lazy_scroll(html);
+	}
+
 	return result;
 
 }
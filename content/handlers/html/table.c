@@ -23,13 +23,14 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <dom/dom.h>
 
 #include "utils/log.h"
-#include "utils/talloc.h"
 #include "css/utils.h"
 
 #include "html/box.h"
+#include "html/box_manipulate.h"
 #include "html/table.h"
 
 /* Define to enable verbose table debug */
@@ -807,19 +808,109 @@ table_used_bottom_border_for_cell(const css_unit_ctx *unit_len_ctx,
 }
 
 
+/* exported interface documented in html/table.h */
+bool table_is_fixed_layout(const struct box *table)
+{
+	css_fixed value = 0;
+	css_unit unit = CSS_UNIT_PX;
+
+	if (table->style == NULL ||
+	    css_computed_table_layout(table->style) != CSS_TABLE_LAYOUT_FIXED) {
+		return false;
+	}
+
+	/* the fixed algorithm is only used if the table width is not auto */
+	return css_computed_width(table->style, &value, &unit) ==
+			CSS_WIDTH_SET;
+}
+
+
+/**
+ * Determine the column width types for a table with fixed layout.
+ *
+ * Only the cells of the first row are considered (CSS 2.1 17.5.2.1).
+ * Columns without a specified width share the remaining table width.
+ *
+ * \param unit_len_ctx Length conversion context
+ * \param table box of type BOX_TABLE
+ * \param col column array for the table
+ */
+static void
+table_calculate_fixed_column_types(const css_unit_ctx *unit_len_ctx,
+				   struct box *table,
+				   struct column *col)
+{
+	struct box *row_group, *row = NULL, *cell;
+	unsigned int i, j;
+
+	for (i = 0; i != table->columns; i++) {
+		/* cell positioning does not affect fixed layout */
+		col[i].positioned = false;
+	}
+
+	/* find the first row */
+	for (row_group = table->children; row_group; row_group = row_group->next) {
+		row = row_group->children;
+		if (row != NULL)
+			break;
+	}
+	if (row == NULL)
+		return;
+
+	for (cell = row->children; cell; cell = cell->next) {
+		enum css_width_e type;
+		css_fixed value = 0;
+		css_unit unit = CSS_UNIT_PX;
+		int width;
+
+		assert(cell->type == BOX_TABLE_CELL);
+		assert(cell->style);
+
+		type = css_computed_width(cell->style, &value, &unit);
+		if (type != CSS_WIDTH_SET)
+			continue;
+
+		i = cell->start_column;
+
+		/* width of a spanning cell is divided between its columns */
+		if (unit == CSS_UNIT_PCT) {
+			width = FIXTOINT(value) / (int)cell->columns;
+		} else {
+			width = FIXTOINT(css_unit_len2device_px(cell->style,
+					unit_len_ctx, value, unit)) /
+					(int)cell->columns;
+		}
+		if (width < 0)
+			width = 0;
+
+		for (j = i; j != i + cell->columns; j++) {
+			col[j].type = (unit == CSS_UNIT_PCT) ?
+					COLUMN_WIDTH_PERCENT :
+					COLUMN_WIDTH_FIXED;
+			col[j].width = width;
+		}
+	}
+}
+
+
 /* exported interface documented in html/table.h */
 bool
 table_calculate_column_types(const css_unit_ctx *unit_len_ctx, struct box *table)
 {
 	unsigned int i, j;
 	struct column *col;
+	struct box_extra *extra;
 	struct box *row_group, *row, *cell;
 
-	if (table->col)
+	if (table->extra->col)
 		/* table->col already constructed, for example frameset table */
 		return true;
 
-	table->col = col = talloc_array(table, struct column, table->columns);
+	extra = box_extra(table);
+	if (extra == NULL)
+		return false;
+
+	extra->col = col = malloc(table->columns * sizeof(*col));
 	if (!col)
 		return false;
 
@@ -829,6 +920,11 @@ table_calculate_column_types(const css_unit_ctx *unit_len_ctx, struct box *table
 		col[i].positioned = true;
 	}
 
+	if (table_is_fixed_layout(table)) {
+		table_calculate_fixed_column_types(unit_len_ctx, table, col);
+		goto done;
+	}
+
 	/* 1st pass: cells with colspan 1 only */
 	for (row_group = table->children; row_group; row_group =row_group->next)
 		for (row = row_group->children; row; row = row->next)
@@ -957,6 +1053,7 @@ table_calculate_column_types(const css_unit_ctx *unit_len_ctx, struct box *table
 				}
 			}
 
+done:
 	/* use AUTO if no width type was specified */
 	for (i = 0; i != table->columns; i++) {
 		if (col[i].type == COLUMN_WIDTH_UNKNOWN)
@@ -30,6 +30,15 @@
 struct box;
 
 
+/**
+ * Determine if a table uses the fixed table layout algorithm.
+ *
+ * \param table box of type BOX_TABLE
+ * \return true if column widths do not depend on the cell contents
+ */
+bool table_is_fixed_layout(const struct box *table);
+
+
 /**
  * Determine the column width types for a table.
  *
@@ -38,7 +47,7 @@ struct box;
  * \return true on success, false on memory exhaustion
  *
  * The table->col array is allocated and type and width are filled in for each
- * column.
+ * column. Tables with fixed layout only consider their first row.
  */
 bool table_calculate_column_types(const css_unit_ctx *unit_len_ctx,	struct box *table);
 
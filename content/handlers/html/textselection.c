@@ -124,17 +124,17 @@ coords_from_range(struct box *box,
 
 	/* If selection starts inside marker */
 	if (box->parent &&
-	    box->parent->list_marker == box &&
+	    box->parent->extra->list_marker == box &&
 	    !do_marker) {
 		/* set box to main list element */
 		box = box->parent;
 	}
 
 	/* If box has a list marker */
-	if (box->list_marker) {
+	if (box->extra->list_marker) {
 		/* do the marker box before continuing with the rest of the
 		 * list element */
-		res = coords_from_range(box->list_marker,
+		res = coords_from_range(box->extra->list_marker,
 					start_idx,
 					end_idx,
 					rdwi,
@@ -329,17 +329,17 @@ selection_copy(struct box *box,
 
 	/* If selection starts inside marker */
 	if (box->parent &&
-	    box->parent->list_marker == box &&
+	    box->parent->extra->list_marker == box &&
 	    !do_marker) {
 		/* set box to main list element */
 		box = box->parent;
 	}
 
 	/* If box has a list marker */
-	if (box->list_marker) {
+	if (box->extra->list_marker) {
 		/* do the marker box before continuing with the rest of the
 		 * list element */
-		res = selection_copy(box->list_marker,
+		res = selection_copy(box->extra->list_marker,
 				     unit_len_ctx,
 				     start_idx,
 				     end_idx,
@@ -457,8 +457,8 @@ static unsigned selection_label_subtree(struct box *box, unsigned idx)
 	}
 
 	while (child) {
-		if (child->list_marker) {
-			idx = selection_label_subtree(child->list_marker, idx);
+		if (child->extra->list_marker) {
+			idx = selection_label_subtree(child->extra->list_marker, idx);
 		}
 
 		idx = selection_label_subtree(child, idx);
@@ -491,6 +491,7 @@ html_textselection_redraw(struct content *c,
 	}
 
 	if (rdw.inited) {
+		html_redraw_invalidate(html);
 		content__request_redraw(c,
 					rdw.r.x0,
 					rdw.r.y0,
@@ -35,6 +35,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <libnsgif.h>
+#include <nsutils/time.h>
 
 #include "utils/utils.h"
 #include "utils/messages.h"
@@ -56,6 +57,10 @@ typedef struct nsgif_content {
 
 	struct gif_animation *gif; /**< GIF animation data */
 	int current_frame;   /**< current frame to display [0...(max-1)] */
+
+	uint64_t frame_time; /**< time the current frame was reached (ms) */
+	bool plotted; /**< the current frame has been plotted */
+	bool paused; /**< animation is stopped until it is next plotted */
 } nsgif_content;
 
 
@@ -126,18 +131,31 @@ static nserror nsgif_create(const content_handler *handler,
 }
 
 /**
- * Performs any necessary animation.
+ * Get the time a frame of an animation is displayed for.
  *
- * \param p  The content to animate
-*/
-static void nsgif_animate(void *p)
+ * \param gif   The gif content
+ * \param frame The frame index
+ * \return The frame delay in ms
+ */
+static int nsgif_frame_delay(nsgif_content *gif, int frame)
 {
-	nsgif_content *gif = p;
-	union content_msg_data data;
-	int delay;
-	int f;
+	int delay = gif->gif->frames[frame].frame_delay;
 
-	/* Advance by a frame, updating the loop count accordingly */
+	if (delay <= 1) {
+		/* Assuming too fast to be intended, set default. */
+		delay = 10;
+	}
+	return delay * 10;
+}
+
+/**
+ * Advance an animation by a frame, updating the loop count accordingly
+ *
+ * \param gif The gif content
+ * \return true if the animation continues after this frame
+ */
+static bool nsgif_advance(nsgif_content *gif)
+{
 	gif->current_frame++;
 	if (gif->current_frame == (int)gif->gif->frame_count_partial) {
 		gif->current_frame = 0;
@@ -153,14 +171,54 @@ static void nsgif_animate(void *p)
 		}
 	}
 
+	return gif->gif->loop_count >= 0;
+}
+
+/**
+ * Request a redraw of the whole image
+ *
+ * \param gif The gif content
+ */
+static void nsgif_redraw_all(nsgif_content *gif)
+{
+	union content_msg_data data;
+
+	data.redraw.x = 0;
+	data.redraw.y = 0;
+	data.redraw.width = gif->base.width;
+	data.redraw.height = gif->base.height;
+
+	gif->plotted = false;
+	content_broadcast(&gif->base, CONTENT_MSG_REDRAW, &data);
+}
+
+/**
+ * Performs any necessary animation.
+ *
+ * The animation only runs while its frames are being plotted. When
+ * the previous frame was not plotted the image is not visible, being
+ * scrolled out of view or in a hidden window, and the animation is
+ * paused until the image is next plotted.
+ *
+ * \param p  The content to animate
+*/
+static void nsgif_animate(void *p)
+{
+	nsgif_content *gif = p;
+	union content_msg_data data;
+	int f;
+
+	if (!gif->plotted) {
+		gif->paused = true;
+		return;
+	}
+
+	nsu_getmonotonic_ms(&gif->frame_time);
+
 	/* Continue animating if we should */
-	if (gif->gif->loop_count >= 0) {
-		delay = gif->gif->frames[gif->current_frame].frame_delay;
-		if (delay <= 1) {
-			/* Assuming too fast to be intended, set default. */
-			delay = 10;
-		}
-		guit->misc->schedule(delay * 10, nsgif_animate, gif);
+	if (nsgif_advance(gif)) {
+		guit->misc->schedule(nsgif_frame_delay(gif, gif->current_frame),
+				     nsgif_animate, gif);
 	}
 
 	if ((!nsoption_bool(animate_images)) ||
@@ -211,9 +269,75 @@ static void nsgif_animate(void *p)
 		}
 	}
 
+	gif->plotted = false;
 	content_broadcast(&gif->base, CONTENT_MSG_REDRAW, &data);
 }
 
+/**
+ * Restarts a paused animation at the frame it would have reached.
+ *
+ * \param p  The content to resume
+ */
+static void nsgif_resume(void *p)
+{
+	nsgif_content *gif = p;
+	int start_frame = gif->current_frame;
+	uint64_t elapsed;
+	uint64_t now;
+	int delay;
+
+	nsu_getmonotonic_ms(&now);
+	elapsed = now - gif->frame_time;
+
+	if (gif->gif->loop_count == 0) {
+		/* skip the whole loops of an endless animation */
+		uint64_t loop_time = 0;
+		unsigned int frame;
+
+		for (frame = 0; frame < gif->gif->frame_count_partial; frame++) {
+			loop_time += nsgif_frame_delay(gif, frame);
+		}
+		elapsed %= loop_time;
+	}
+
+	gif->paused = false;
+
+	delay = nsgif_frame_delay(gif, gif->current_frame);
+	while (elapsed >= (uint64_t)delay) {
+		elapsed -= delay;
+		if (!nsgif_advance(gif)) {
+			/* the animation finished while it was not visible */
+			delay = 0;
+			break;
+		}
+		delay = nsgif_frame_delay(gif, gif->current_frame);
+	}
+
+	if (delay != 0) {
+		gif->frame_time = now - elapsed;
+		guit->misc->schedule(delay - elapsed, nsgif_animate, gif);
+	}
+
+	if (gif->current_frame != start_frame) {
+		nsgif_redraw_all(gif);
+	}
+}
+
+/**
+ * Start the animation of a gif from its first frame.
+ *
+ * \param gif The gif content
+ */
+static void nsgif_start(nsgif_content *gif)
+{
+	nsu_getmonotonic_ms(&gif->frame_time);
+	gif->paused = false;
+
+	guit->misc->schedule(gif->gif->frames[0].frame_delay * 10,
+			     nsgif_animate,
+			     gif);
+}
+
 static bool nsgif_convert(struct content *c)
 {
 	nsgif_content *gif = (nsgif_content *) c;
@@ -270,9 +394,7 @@ static bool nsgif_convert(struct content *c)
 	/* Schedule the animation if we have one */
 	gif->current_frame = 0;
 	if (gif->gif->frame_count_partial > 1)
-		guit->misc->schedule(gif->gif->frames[0].frame_delay * 10,
-					nsgif_animate,
-					c);
+		nsgif_start(gif);
 
 	/* Exit as a success */
 	content_set_ready(c);
@@ -318,6 +440,13 @@ static bool nsgif_redraw(struct content *c, struct content_redraw_data *data,
 {
 	nsgif_content *gif = (nsgif_content *) c;
 
+	gif->plotted = true;
+	if (gif->paused) {
+		/* the image is visible again, catch up outside of redraw */
+		gif->paused = false;
+		guit->misc->schedule(0, nsgif_resume, gif);
+	}
+
 	if (gif->current_frame != gif->gif->decoded_frame) {
 		if (nsgif_get_frame(gif) != GIF_OK) {
 			return false;
@@ -334,6 +463,7 @@ static void nsgif_destroy(struct content *c)
 
 	/* Free all the associated memory buffers */
 	guit->misc->schedule(-1, nsgif_animate, c);
+	guit->misc->schedule(-1, nsgif_resume, c);
 	gif_finalise(gif->gif);
 	free(gif->gif);
 }
@@ -385,8 +515,7 @@ static void nsgif_add_user(struct content *c)
 	if (content_count_users(c) == 1) {
 		/* First user, and content already converted, so start the animation. */
 		if (gif->gif->frame_count_partial > 1) {
-			guit->misc->schedule(gif->gif->frames[0].frame_delay * 10,
-				nsgif_animate, c);
+			nsgif_start(gif);
 		}
 	}
 }
@@ -396,6 +525,7 @@ static void nsgif_remove_user(struct content *c)
 	if (content_count_users(c) == 1) {
 		/* Last user is about to be removed from this content, so stop the animation. */
 		guit->misc->schedule(-1, nsgif_animate, c);
+		guit->misc->schedule(-1, nsgif_resume, c);
 	}
 }
 
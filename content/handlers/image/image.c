@@ -18,6 +18,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <nsutils/time.h>
 
 #include "utils/utils.h"
 #include "utils/log.h"
@@ -25,6 +26,8 @@
 #include "netsurf/plotters.h"
 #include "netsurf/bitmap.h"
 #include "netsurf/content.h"
+#include "content/content.h"
+#include "content/content_protected.h"
 #include "desktop/gui_internal.h"
 
 #include "image/bmp.h"
@@ -37,6 +40,10 @@
 #include "image/svg.h"
 #include "image/webp.h"
 #include "image/image.h"
+#include "image/image_cache.h"
+
+/** Minimum time (in ms) between redraws of a partially decoded image */
+#define IMAGE_PARTIAL_PERIOD 100
 
 /**
  * Initialise image content handlers
@@ -168,3 +175,53 @@ bool image_bitmap_plot(struct bitmap *bitmap,
 				  data->background_colour,
 				  flags) == NSERROR_OK);
 }
+
+
+/* exported interface documented in image/image.h */
+bool image_partial_due(uint64_t redraw_time)
+{
+	uint64_t now;
+
+	nsu_getmonotonic_ms(&now);
+
+	return (now >= redraw_time + IMAGE_PARTIAL_PERIOD);
+}
+
+
+/* exported interface documented in image/image.h */
+bool image_partial_redraw(struct content *c,
+			  struct bitmap *bitmap,
+			  int y0, int y1,
+			  uint64_t *redraw_time)
+{
+	union content_msg_data data;
+	uint64_t now;
+
+	if (image_partial_due(*redraw_time) == false) {
+		return false;
+	}
+	nsu_getmonotonic_ms(&now);
+
+	guit->bitmap->modified(bitmap);
+
+	if (c->status == CONTENT_STATUS_LOADING) {
+		/* The image is taking a while to arrive so display
+		 * what there is of it. The bitmap belongs to the image
+		 * cache from now on.
+		 */
+		if (image_cache_add(c, bitmap, NULL) != NSERROR_OK) {
+			return false;
+		}
+		content_set_ready_partial(c);
+	} else {
+		data.redraw.x = 0;
+		data.redraw.y = y0;
+		data.redraw.width = c->width;
+		data.redraw.height = y1 - y0;
+		content_broadcast(c, CONTENT_MSG_REDRAW, &data);
+	}
+
+	*redraw_time = now;
+
+	return true;
+}
@@ -23,8 +23,11 @@
 #ifndef NETSURF_IMAGE_IMAGE_H_
 #define NETSURF_IMAGE_IMAGE_H_
 
+#include <stdint.h>
+
 #include "utils/errors.h"
 
+struct content;
 struct content_redraw_data;
 
 /** Initialise the content handlers for image types.
@@ -42,4 +45,32 @@ bool image_bitmap_plot(struct bitmap *bitmap,
 		       const struct rect *clip,
 		       const struct redraw_context *ctx);
 
+/**
+ * Determine if a partially decoded image may be redrawn.
+ *
+ * \param redraw_time The time of the previous redraw.
+ * \return true if a frame period has passed since the previous redraw.
+ */
+bool image_partial_due(uint64_t redraw_time);
+
+/**
+ * Display the rows of an image decoded so far while its data arrives.
+ *
+ * Nothing is done until a frame period has passed since the previous
+ * redraw. The first time the image is displayed the content becomes
+ * ready and the image cache takes ownership of the bitmap, afterwards
+ * a redraw of the changed rows is requested.
+ *
+ * \param c           The image content.
+ * \param bitmap      The bitmap being decoded into.
+ * \param y0          The first changed row.
+ * \param y1          The row after the last changed row.
+ * \param redraw_time The time of the previous redraw, updated on redraw.
+ * \return true if the image was redrawn else false.
+ */
+bool image_partial_redraw(struct content *c,
+			  struct bitmap *bitmap,
+			  int y0, int y1,
+			  uint64_t *redraw_time);
+
 #endif
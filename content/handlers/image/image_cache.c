@@ -30,9 +30,13 @@
 #include "netsurf/inttypes.h"
 #include "utils/utils.h"
 #include "utils/log.h"
+#include "utils/sys_time.h"
 #include "netsurf/misc.h"
 #include "netsurf/bitmap.h"
+#include "netsurf/content.h"
+#include "netsurf/plotters.h"
 #include "content/llcache.h"
+#include "content/content.h"
 #include "content/content_protected.h"
 #include "desktop/gui_internal.h"
 
@@ -47,17 +51,33 @@
  */
 typedef unsigned int cache_age;
 
+/**
+ * Bitmap converted from the source data of a low level cache object
+ *
+ * Image contents whose data comes from the same low level cache
+ * object share the bitmaps converted from it.
+ */
+struct image_cache_bitmap_s {
+	struct bitmap *bitmap; /**< the converted bitmap */
+	image_cache_convert_fn *convert; /**< routine which converted it */
+	bool scaled; /**< bitmap is smaller than the content */
+	unsigned int refcount; /**< number of entries using the bitmap */
+};
+
 /**
  * Image cache entry
  */
 struct image_cache_entry_s {
 	struct image_cache_entry_s *next; /**< next cache entry in list */
 	struct image_cache_entry_s *prev; /**< previous cache entry in list */
+	struct image_cache_entry_s *hash_next; /**< next entry in index chain */
 
 	/** content is used as a key */
 	struct content *content;
 	/** associated bitmap entry */
 	struct bitmap *bitmap;
+	/** shared record of a converted bitmap or NULL if it is private */
+	struct image_cache_bitmap_s *shared;
 	/** routine to convert content into bitmap */
 	image_cache_convert_fn *convert;
 
@@ -69,6 +89,14 @@ struct image_cache_entry_s {
 	cache_age bitmap_age; /**< Age of last conversion to a bitmap by cache*/
 
 	int conversion_count; /**< Number of times image has been converted */
+	uint64_t decode_time; /**< Time taken by last conversion in us */
+	uint64_t priority; /**< Cost aware replacement priority */
+
+	bool pending; /**< Conversion is scheduled outside of redraw */
+
+	bool scaled; /**< bitmap is smaller than the content */
+	int target_width; /**< largest width plotted since bitmap was freed */
+	int target_height; /**< largest height plotted since bitmap was freed */
 };
 
 /**
@@ -89,6 +117,19 @@ struct image_cache_s {
 	/* The objects the cache holds */
 	struct image_cache_entry_s *entries;
 
+	/** Index of the entries by content */
+	struct image_cache_entry_s **index;
+	/** Number of chains in the index */
+	unsigned int index_size;
+	/** Number of entries the cache holds */
+	unsigned int entry_count;
+
+	/** Priority of the last bitmap released by the cost aware policy */
+	uint64_t inflation;
+
+	/** Number of entries with a scheduled conversion */
+	unsigned int pending_count;
+
 
 	/* Statistics for management algorithm */
 
@@ -98,6 +139,13 @@ struct image_cache_s {
 	/** Total count of bitmaps currently allocated */
 	int bitmap_count;
 
+	/** Number of entries currently using a bitmap */
+	int bitmap_users;
+	/** Number of entries using a bitmap converted for another entry */
+	int shared_users;
+	/** Total number of conversions avoided by sharing a bitmap */
+	int total_shared;
+
 	/** Maximum size of bitmaps allocated at any one time */
 	size_t max_bitmap_size;
 	/** The number of objects when maximum bitmap usage occurred */
@@ -130,6 +178,11 @@ struct image_cache_s {
 	/** counts total number of images with more than one conversion */
 	int total_extra_conversions_count;
 
+	/** Total time spent converting in us */
+	uint64_t total_decode_time;
+	/** Total size of the bitmaps whose conversion was timed */
+	uint64_t total_decode_size;
+
 	/** Bitmap with most conversions was converted this many times */
 	int peak_conversions;
 	/** Size of bitmap with most conversions */
@@ -139,6 +192,23 @@ struct image_cache_s {
 /** image cache state */
 static struct image_cache_s *image_cache = NULL;
 
+/**
+ * Largest factor a bitmap is reduced by.
+ *
+ * Limits the number of pixels summed for each output pixel.
+ */
+#define IMAGE_CACHE_MAX_REDUCTION 256
+
+/** Number of chains the content index starts with */
+#define IMAGE_CACHE_INDEX_SIZE 64
+
+/**
+ * Scale applied to the decode cost per byte of a bitmap.
+ *
+ * Keeps the integer priorities of small decode times distinct.
+ */
+#define IMAGE_CACHE_COST_SHIFT 20
+
 
 /**
  * Find a cache entry by index.
@@ -159,6 +229,51 @@ static struct image_cache_entry_s *image_cache__findn(int entryn)
 }
 
 
+/**
+ * Compute the index chain of a content
+ *
+ * \param c The content to hash
+ * \param size The number of chains in the index, a power of two
+ * \return The chain the content belongs on
+ */
+static inline unsigned int
+image_cache__hash(const struct content *c, unsigned int size)
+{
+	/* allocations are aligned so the low bits carry no information */
+	uintptr_t key = ((uintptr_t)c >> 4) * 2654435761u;
+
+	return (key >> 8) & (size - 1);
+}
+
+/**
+ * Double the number of chains in the content index.
+ *
+ * Failure to grow the index is not fatal, the chains just get longer.
+ */
+static void image_cache__index_grow(void)
+{
+	struct image_cache_entry_s **index;
+	struct image_cache_entry_s *centry;
+	unsigned int size = image_cache->index_size * 2;
+
+	index = calloc(size, sizeof(*index));
+	if (index == NULL) {
+		return;
+	}
+
+	for (centry = image_cache->entries;
+	     centry != NULL;
+	     centry = centry->next) {
+		unsigned int chain = image_cache__hash(centry->content, size);
+		centry->hash_next = index[chain];
+		index[chain] = centry;
+	}
+
+	free(image_cache->index);
+	image_cache->index = index;
+	image_cache->index_size = size;
+}
+
 /**
  * Find the cache entry for a content
  *
@@ -169,9 +284,9 @@ static struct image_cache_entry_s *image_cache__find(const struct content *c)
 {
 	struct image_cache_entry_s *found;
 
-	found = image_cache->entries;
+	found = image_cache->index[image_cache__hash(c, image_cache->index_size)];
 	while ((found != NULL) && (found->content != c)) {
-		found = found->next;
+		found = found->hash_next;
 	}
 	return found;
 }
@@ -188,6 +303,7 @@ static void image_cache_stats_bitmap_add(struct image_cache_entry_s *centry)
 
 	image_cache->total_bitmap_size += centry->bitmap_size;
 	image_cache->bitmap_count++;
+	image_cache->bitmap_users++;
 
 	if (image_cache->total_bitmap_size > image_cache->max_bitmap_size) {
 		image_cache->max_bitmap_size = image_cache->total_bitmap_size;
@@ -218,16 +334,37 @@ static void image_cache_stats_bitmap_add(struct image_cache_entry_s *centry)
 
 static void image_cache__link(struct image_cache_entry_s *centry)
 {
+	unsigned int chain;
+
 	centry->next = image_cache->entries;
 	centry->prev = NULL;
 	if (centry->next != NULL) {
 		centry->next->prev = centry;
 	}
 	image_cache->entries = centry;
+
+	if (++image_cache->entry_count > image_cache->index_size) {
+		image_cache__index_grow();
+	}
+
+	chain = image_cache__hash(centry->content, image_cache->index_size);
+	centry->hash_next = image_cache->index[chain];
+	image_cache->index[chain] = centry;
 }
 
 static void image_cache__unlink(struct image_cache_entry_s *centry)
 {
+	struct image_cache_entry_s **chain;
+
+	/* remove from the index */
+	chain = &image_cache->index[image_cache__hash(centry->content,
+						      image_cache->index_size)];
+	while (*chain != centry) {
+		chain = &(*chain)->hash_next;
+	}
+	*chain = centry->hash_next;
+	image_cache->entry_count--;
+
 	/* unlink entry */
 	if (centry->prev == NULL) {
 		/* first in list */
@@ -263,15 +400,121 @@ static void image_cache__free_bitmap(struct image_cache_entry_s *centry)
 		      image_cache->current_age - centry->bitmap_age,
 		      centry->redraw_count);
 #endif
-		guit->bitmap->destroy(centry->bitmap);
+		image_cache->bitmap_users--;
+		if ((centry->shared != NULL) &&
+		    (--centry->shared->refcount > 0)) {
+			/* other entries still use the bitmap */
+			image_cache->shared_users--;
+		} else {
+			guit->bitmap->destroy(centry->bitmap);
+			image_cache->total_bitmap_size -= centry->bitmap_size;
+			image_cache->bitmap_count--;
+			if (centry->redraw_count == 0) {
+				image_cache->specultive_miss_count++;
+			}
+			free(centry->shared);
+		}
 		centry->bitmap = NULL;
-		image_cache->total_bitmap_size -= centry->bitmap_size;
-		image_cache->bitmap_count--;
-		if (centry->redraw_count == 0) {
-			image_cache->specultive_miss_count++;
+		centry->shared = NULL;
+	}
+
+}
+
+/**
+ * Determine if the bitmaps of an entry may be shared.
+ *
+ * Only bitmaps converted by the cache from complete source data are
+ * shared, bitmaps given to the cache belong to their content.
+ *
+ * \param centry The image cache entry.
+ * \return true if bitmaps converted for the entry may be shared.
+ */
+static bool image_cache__shareable(struct image_cache_entry_s *centry)
+{
+	struct content *c = centry->content;
+
+	return (centry->convert != NULL) &&
+		((c->status == CONTENT_STATUS_DONE) || c->locked);
+}
+
+/**
+ * Find a bitmap converted from the same source as an entry.
+ *
+ * A bitmap is suitable if converting the entry at the requested
+ * size would produce it.
+ *
+ * \param centry The image cache entry.
+ * \param width The width to convert at or 0 for the content size.
+ * \param height The height to convert at or 0 for the content size.
+ * \return The shared bitmap record or NULL if there is none.
+ */
+static struct image_cache_bitmap_s *
+image_cache__find_shared(struct image_cache_entry_s *centry,
+			 int width,
+			 int height)
+{
+	struct image_cache_entry_s *other;
+	struct image_cache_bitmap_s *shared;
+	int bw, bh;
+
+	if (image_cache__shareable(centry) == false) {
+		return NULL;
+	}
+
+	for (other = image_cache->entries; other != NULL; other = other->next) {
+		shared = other->shared;
+		if ((shared == NULL) ||
+		    (shared == centry->shared) ||
+		    (shared->convert != centry->convert) ||
+		    (llcache_handle_references_same_object(
+			    other->content->llcache,
+			    centry->content->llcache) == false)) {
+			continue;
+		}
+
+		if (width == 0) {
+			if (shared->scaled == false) {
+				return shared;
+			}
+			continue;
+		}
+
+		/* reduced bitmaps must suit the size without being
+		 * large enough to reduce again */
+		bw = guit->bitmap->get_width(shared->bitmap);
+		bh = guit->bitmap->get_height(shared->bitmap);
+		if (shared->scaled &&
+		    (bw >= width) && (bh >= height) &&
+		    ((bw < width * 2) || (bh < height * 2))) {
+			return shared;
 		}
 	}
 
+	return NULL;
+}
+
+/**
+ * Use a shared bitmap for an entry.
+ *
+ * \param centry The image cache entry, which must hold no bitmap.
+ * \param shared The shared bitmap record.
+ */
+static void
+image_cache__share(struct image_cache_entry_s *centry,
+		   struct image_cache_bitmap_s *shared)
+{
+	shared->refcount++;
+
+	centry->shared = shared;
+	centry->bitmap = shared->bitmap;
+	centry->scaled = shared->scaled;
+	centry->bitmap_size = guit->bitmap->get_rowstride(shared->bitmap) *
+		guit->bitmap->get_height(shared->bitmap);
+	centry->bitmap_age = image_cache->current_age;
+
+	image_cache->bitmap_users++;
+	image_cache->shared_users++;
+	image_cache->total_shared++;
 }
 
 /**
@@ -291,34 +534,164 @@ static void image_cache__free_entry(struct image_cache_entry_s *centry)
 
 	image_cache__free_bitmap(centry);
 
+	if (centry->pending) {
+		image_cache->pending_count--;
+	}
+
 	image_cache__unlink(centry);
 
 	free(centry);
 }
 
 /**
- * Image cache cleaner
+ * Update the replacement priority of an entry which has been used.
+ *
+ * The priority is the GreedyDual-Size value, the cost of converting
+ * the bitmap again per byte it occupies added to the priority of the
+ * last bitmap released. Entries which have not been timed are costed
+ * at the mean rate of the timed conversions.
+ *
+ * \param centry The image cache entry.
+ */
+static void image_cache__touch(struct image_cache_entry_s *centry)
+{
+	uint64_t cost;
+
+	if ((centry->decode_time != 0) && (centry->bitmap_size != 0)) {
+		cost = (centry->decode_time << IMAGE_CACHE_COST_SHIFT) /
+			centry->bitmap_size;
+	} else if (image_cache->total_decode_size != 0) {
+		cost = (image_cache->total_decode_time <<
+			IMAGE_CACHE_COST_SHIFT) /
+			image_cache->total_decode_size;
+	} else {
+		cost = 1;
+	}
+
+	centry->priority = image_cache->inflation + cost;
+}
+
+/**
+ * Order image cache entries by replacement priority.
+ *
+ * qsort comparison routine.
+ */
+static int image_cache__priority_cmp(const void *a, const void *b)
+{
+	const struct image_cache_entry_s *ea;
+	const struct image_cache_entry_s *eb;
+
+	ea = *(const struct image_cache_entry_s * const *)a;
+	eb = *(const struct image_cache_entry_s * const *)b;
+
+	if (ea->priority < eb->priority) {
+		return -1;
+	}
+	return (ea->priority > eb->priority) ? 1 : 0;
+}
+
+/**
+ * Determine if the cleaner may release an entry's bitmap.
  *
  * \param icache The image cache context.
+ * \param centry The image cache entry.
+ * \return true if the entry has not been redrawn recently.
  */
-static void image_cache__clean(struct image_cache_s *icache)
+static inline bool
+image_cache__idle(struct image_cache_s *icache,
+		  struct image_cache_entry_s *centry)
+{
+	/* only consider older entries, avoids active entries */
+	return (icache->current_age - centry->redraw_age) >
+		icache->params.bg_clean_time;
+}
+
+/**
+ * Release the bitmap of an entry for the cleaner.
+ *
+ * \param centry The image cache entry.
+ */
+static void image_cache__release(struct image_cache_entry_s *centry)
+{
+	image_cache__free_bitmap(centry);
+	centry->target_width = 0;
+	centry->target_height = 0;
+}
+
+/**
+ * Image cache cleaner releasing bitmaps at random.
+ *
+ * \param icache The image cache context.
+ */
+static void image_cache__clean_random(struct image_cache_s *icache)
 {
 	struct image_cache_entry_s *centry = icache->entries;
 
 	while (centry != NULL) {
-		if ((icache->current_age - centry->redraw_age) >
-		    icache->params.bg_clean_time) {
-			/* only consider older entries, avoids active entries */
+		if (image_cache__idle(icache, centry)) {
 			if ((icache->total_bitmap_size >
 			     (icache->params.limit - icache->params.hysteresis)) &&
 			    (rand() > (RAND_MAX / 2))) {
-				image_cache__free_bitmap(centry);
+				image_cache__release(centry);
 			}
 		}
 		centry=centry->next;
 	}
 }
 
+/**
+ * Image cache cleaner
+ *
+ * When the cost aware policy is in use the idle bitmaps are released
+ * in priority order until the cache is within its hysteresis. Bitmaps
+ * which cannot be converted again are kept.
+ *
+ * \param icache The image cache context.
+ */
+static void image_cache__clean(struct image_cache_s *icache)
+{
+	struct image_cache_entry_s *centry;
+	struct image_cache_entry_s **victims;
+	size_t target = icache->params.limit - icache->params.hysteresis;
+	unsigned int count = 0;
+	unsigned int idx;
+
+	if (icache->total_bitmap_size <= target) {
+		return;
+	}
+
+	if (!icache->params.cost_aware) {
+		image_cache__clean_random(icache);
+		return;
+	}
+
+	victims = malloc(icache->bitmap_count * sizeof(*victims));
+	if (victims == NULL) {
+		image_cache__clean_random(icache);
+		return;
+	}
+
+	for (centry = icache->entries; centry != NULL; centry = centry->next) {
+		if ((centry->bitmap != NULL) &&
+		    (centry->convert != NULL) &&
+		    (count < (unsigned int)icache->bitmap_count) &&
+		    image_cache__idle(icache, centry)) {
+			victims[count++] = centry;
+		}
+	}
+
+	qsort(victims, count, sizeof(*victims), image_cache__priority_cmp);
+
+	for (idx = 0;
+	     (idx < count) && (icache->total_bitmap_size > target);
+	     idx++) {
+		icache->inflation = victims[idx]->priority;
+		image_cache__release(victims[idx]);
+	}
+
+	free(victims);
+}
+
 /**
  * Cache background scheduled callback.
  *
@@ -342,6 +715,348 @@ static void image_cache__background_update(void *p)
 				icache);
 }
 
+/**
+ * Reduce a bitmap with a box filter.
+ *
+ * \param bitmap The bitmap to reduce.
+ * \param factor The factor to reduce both dimensions by.
+ * \return The reduced bitmap or NULL on failure.
+ */
+static struct bitmap *
+image_cache__reduce(struct bitmap *bitmap, int factor)
+{
+	struct bitmap *reduced;
+	const uint8_t *src;
+	uint8_t *dst;
+	size_t src_stride, dst_stride;
+	int src_width, src_height;
+	int width, height;
+	bool opaque;
+	int x, y;
+
+	src_width = guit->bitmap->get_width(bitmap);
+	src_height = guit->bitmap->get_height(bitmap);
+	width = (src_width + factor - 1) / factor;
+	height = (src_height + factor - 1) / factor;
+	opaque = guit->bitmap->get_opaque(bitmap);
+
+	reduced = guit->bitmap->create(width, height,
+			opaque ? (BITMAP_NEW | BITMAP_OPAQUE) : BITMAP_NEW);
+	if (reduced == NULL) {
+		return NULL;
+	}
+
+	src = guit->bitmap->get_buffer(bitmap);
+	dst = guit->bitmap->get_buffer(reduced);
+	if ((src == NULL) || (dst == NULL)) {
+		guit->bitmap->destroy(reduced);
+		return NULL;
+	}
+	src_stride = guit->bitmap->get_rowstride(bitmap);
+	dst_stride = guit->bitmap->get_rowstride(reduced);
+
+	for (y = 0; y < height; y++) {
+		int y0 = y * factor;
+		int y1 = min(y0 + factor, src_height);
+
+		for (x = 0; x < width; x++) {
+			int x0 = x * factor;
+			int x1 = min(x0 + factor, src_width);
+			uint32_t sum[4] = { 0, 0, 0, 0 };
+			uint32_t count = (y1 - y0) * (x1 - x0);
+			uint8_t *out = dst + y * dst_stride + x * 4;
+			int sx, sy;
+
+			for (sy = y0; sy < y1; sy++) {
+				const uint8_t *in = src + sy * src_stride + x0 * 4;
+
+				for (sx = x0; sx < x1; sx++) {
+					sum[0] += in[0];
+					sum[1] += in[1];
+					sum[2] += in[2];
+					sum[3] += in[3];
+					in += 4;
+				}
+			}
+
+			out[0] = sum[0] / count;
+			out[1] = sum[1] / count;
+			out[2] = sum[2] / count;
+			out[3] = sum[3] / count;
+		}
+	}
+
+	guit->bitmap->modified(reduced);
+
+	return reduced;
+}
+
+/**
+ * Determine if an entry's bitmap must be converted for its plot size.
+ *
+ * \param centry The image cache entry.
+ * \return true if the bitmap is missing, too small or could be reduced.
+ */
+static bool image_cache__wants_convert(struct image_cache_entry_s *centry)
+{
+	int width, height;
+
+	if (centry->bitmap == NULL) {
+		return true;
+	}
+
+	if (centry->convert == NULL) {
+		/* the bitmap cannot be replaced */
+		return false;
+	}
+
+	width = guit->bitmap->get_width(centry->bitmap);
+	height = guit->bitmap->get_height(centry->bitmap);
+
+	if (centry->scaled) {
+		return ((width < centry->target_width) ||
+			(height < centry->target_height));
+	}
+
+	return ((centry->target_width > 0) &&
+		(centry->target_height > 0) &&
+		(width >= centry->target_width * 2) &&
+		(height >= centry->target_height * 2));
+}
+
+/**
+ * Convert the content of an image cache entry into a bitmap.
+ *
+ * The bitmap is converted at the size of the largest plot since the
+ * bitmap was last freed, if that is at most half the content size.
+ * A held full size bitmap is reduced instead of being converted again.
+ *
+ * \param centry The image cache entry.
+ * \return true if the bitmap was converted else false.
+ */
+static bool image_cache__convert(struct image_cache_entry_s *centry)
+{
+	struct content *c = centry->content;
+	struct bitmap *bitmap = NULL;
+	struct bitmap *reduced;
+	int width = centry->target_width;
+	int height = centry->target_height;
+	int factor;
+	struct image_cache_bitmap_s *shared;
+	struct timeval start, end, elapsed;
+	bool timed = false;
+
+	if (centry->pending) {
+		/* converting now satisfies the scheduled conversion */
+		centry->pending = false;
+		image_cache->pending_count--;
+	}
+
+	if ((width <= 0) || (height <= 0) ||
+	    (width * 2 > c->width) || (height * 2 > c->height)) {
+		/* convert at full size */
+		width = 0;
+		height = 0;
+	}
+
+	/* another content with the same source may have converted it */
+	shared = image_cache__find_shared(centry, width, height);
+	if (shared != NULL) {
+		image_cache__free_bitmap(centry);
+		image_cache__share(centry, shared);
+		image_cache__touch(centry);
+		image_cache->hit_count++;
+		image_cache->hit_size += centry->bitmap_size;
+		return true;
+	}
+
+	if ((width > 0) &&
+	    ((centry->bitmap == NULL) || centry->scaled)) {
+		/* a full size bitmap of the same source can be reduced */
+		shared = image_cache__find_shared(centry, 0, 0);
+		if (shared != NULL) {
+			image_cache__free_bitmap(centry);
+			image_cache__share(centry, shared);
+		}
+	}
+
+	if ((centry->bitmap != NULL) &&
+	    (centry->scaled == false) &&
+	    (width > 0)) {
+		/* reduce the full size bitmap already held */
+		bitmap = centry->bitmap;
+	} else {
+		image_cache__free_bitmap(centry);
+		if (centry->convert != NULL) {
+			gettimeofday(&start, NULL);
+			bitmap = centry->convert(c, width, height);
+			timed = true;
+		}
+	}
+
+	if (bitmap == NULL) {
+		image_cache->fail_count++;
+		image_cache->fail_size += centry->bitmap_size;
+		return false;
+	}
+
+	if (width > 0) {
+		factor = min(guit->bitmap->get_width(bitmap) / width,
+			     guit->bitmap->get_height(bitmap) / height);
+		factor = min(factor, IMAGE_CACHE_MAX_REDUCTION);
+		if (factor >= 2) {
+			reduced = image_cache__reduce(bitmap, factor);
+			if (reduced != NULL) {
+				if (bitmap == centry->bitmap) {
+					image_cache__free_bitmap(centry);
+				} else {
+					guit->bitmap->destroy(bitmap);
+				}
+				bitmap = reduced;
+			}
+		}
+	}
+
+	if (bitmap == centry->bitmap) {
+		/* the held bitmap could not be reduced so keep using it */
+		image_cache__touch(centry);
+		return true;
+	}
+
+	centry->bitmap = bitmap;
+	centry->scaled = (guit->bitmap->get_width(bitmap) < c->width) ||
+		(guit->bitmap->get_height(bitmap) < c->height);
+	centry->bitmap_size = guit->bitmap->get_rowstride(bitmap) *
+		guit->bitmap->get_height(bitmap);
+
+	if (timed) {
+		/* a held bitmap being reduced says nothing of the cost
+		 * of converting it again */
+		gettimeofday(&end, NULL);
+		timersub(&end, &start, &elapsed);
+		centry->decode_time = (uint64_t)elapsed.tv_sec * 1000000 +
+			elapsed.tv_usec + 1;
+		image_cache->total_decode_time += centry->decode_time;
+		image_cache->total_decode_size += centry->bitmap_size;
+	}
+	image_cache__touch(centry);
+
+	if (image_cache__shareable(centry)) {
+		/* failing to share the bitmap is not fatal */
+		shared = calloc(1, sizeof(struct image_cache_bitmap_s));
+		if (shared != NULL) {
+			shared->bitmap = bitmap;
+			shared->convert = centry->convert;
+			shared->scaled = centry->scaled;
+			shared->refcount = 1;
+		}
+		centry->shared = shared;
+	}
+
+	image_cache_stats_bitmap_add(centry);
+	image_cache->miss_count++;
+	image_cache->miss_size += centry->bitmap_size;
+
+	return true;
+}
+
+/**
+ * Scheduled conversion callback.
+ *
+ * Converts one entry whose conversion was deferred by redraw and
+ * requests a redraw of its content. Further pending entries are left
+ * to later callbacks so other events are processed between them.
+ *
+ * \param p The image cache context.
+ */
+static void image_cache__pending_convert(void *p)
+{
+	struct image_cache_s *icache = p;
+	struct image_cache_entry_s *centry;
+	union content_msg_data data;
+
+	centry = icache->entries;
+	while ((centry != NULL) && (centry->pending == false)) {
+		centry = centry->next;
+	}
+
+	if (centry == NULL) {
+		return;
+	}
+
+	if (image_cache__convert(centry)) {
+		data.redraw.x = 0;
+		data.redraw.y = 0;
+		data.redraw.width = centry->content->width;
+		data.redraw.height = centry->content->height;
+
+		content_broadcast(centry->content, CONTENT_MSG_REDRAW, &data);
+	}
+
+	if (icache->pending_count > 0) {
+		guit->misc->schedule(0, image_cache__pending_convert, icache);
+	}
+}
+
+/**
+ * Defer conversion of an image cache entry until after redraw.
+ *
+ * \param centry The image cache entry to convert.
+ */
+static void image_cache__defer_convert(struct image_cache_entry_s *centry)
+{
+	if (centry->pending) {
+		return;
+	}
+
+	centry->pending = true;
+	image_cache->pending_count++;
+
+	guit->misc->schedule(0, image_cache__pending_convert, image_cache);
+}
+
+/**
+ * Plot a placeholder for an image whose conversion has been deferred.
+ *
+ * The area the image will occupy is filled with the redraw background
+ * colour so nothing stale shows through until the conversion completes.
+ *
+ * \param data The redraw data for the image.
+ * \param clip The current clip rectangle.
+ * \param ctx The redraw context.
+ * \return true on success else false.
+ */
+static bool
+image_cache__plot_pending(struct content_redraw_data *data,
+			  const struct rect *clip,
+			  const struct redraw_context *ctx)
+{
+	plot_style_t fill_style;
+	struct rect area;
+
+	area = *clip;
+
+	if (data->repeat_x != true) {
+		area.x0 = max(area.x0, data->x);
+		area.x1 = min(area.x1, data->x + data->width);
+	}
+
+	if (data->repeat_y != true) {
+		area.y0 = max(area.y0, data->y);
+		area.y1 = min(area.y1, data->y + data->height);
+	}
+
+	if ((area.x0 >= area.x1) || (area.y0 >= area.y1)) {
+		return true;
+	}
+
+	fill_style.stroke_type = PLOT_OP_TYPE_NONE;
+	fill_style.fill_type = PLOT_OP_TYPE_SOLID;
+	fill_style.fill_colour = data->background_colour;
+
+	return (ctx->plot->rectangle(ctx, &fill_style, &area) == NSERROR_OK);
+}
+
 /* exported interface documented in image_cache.h */
 struct bitmap *image_cache_get_bitmap(const struct content *c)
 {
@@ -352,22 +1067,16 @@ struct bitmap *image_cache_get_bitmap(const struct content *c)
 		return NULL;
 	}
 
-	if (centry->bitmap == NULL) {
-		if (centry->convert != NULL) {
-			centry->bitmap = centry->convert(centry->content);
-		}
+	/* callers expect the bitmap at the content size */
+	centry->target_width = c->width;
+	centry->target_height = c->height;
 
-		if (centry->bitmap != NULL) {
-			image_cache_stats_bitmap_add(centry);
-			image_cache->miss_count++;
-			image_cache->miss_size += centry->bitmap_size;
-		} else {
-			image_cache->fail_count++;
-			image_cache->fail_size += centry->bitmap_size;
-		}
+	if (image_cache__wants_convert(centry)) {
+		image_cache__convert(centry);
 	} else {
 		image_cache->hit_count++;
 		image_cache->hit_size += centry->bitmap_size;
+		image_cache__touch(centry);
 	}
 
 	return centry->bitmap;
@@ -422,6 +1131,15 @@ image_cache_init(const struct image_cache_parameters *image_cache_parameters)
 
 	image_cache->params = *image_cache_parameters;
 
+	image_cache->index_size = IMAGE_CACHE_INDEX_SIZE;
+	image_cache->index = calloc(image_cache->index_size,
+				    sizeof(*image_cache->index));
+	if (image_cache->index == NULL) {
+		free(image_cache);
+		image_cache = NULL;
+		return NSERROR_NOMEM;
+	}
+
 	guit->misc->schedule(image_cache->params.bg_clean_time,
 				image_cache__background_update,
 				image_cache);
@@ -440,6 +1158,7 @@ nserror image_cache_fini(void)
 	unsigned int op_count;
 
 	guit->misc->schedule(-1, image_cache__background_update, image_cache);
+	guit->misc->schedule(-1, image_cache__pending_convert, image_cache);
 
 	NSLOG(netsurf, INFO, "Size at finish %"PRIsizet" (in %d)",
 	      image_cache->total_bitmap_size, image_cache->bitmap_count);
@@ -501,6 +1220,17 @@ nserror image_cache_fini(void)
 	      image_cache->peak_conversions_size,
 	      image_cache->peak_conversions);
 
+	NSLOG(netsurf, INFO,
+	      "Total conversions avoided by sharing bitmaps: %d",
+	      image_cache->total_shared);
+
+	NSLOG(netsurf, INFO,
+	      "Total conversion time %"PRIu64"us for %"PRIu64" bytes (%s policy)",
+	      image_cache->total_decode_time,
+	      image_cache->total_decode_size,
+	      image_cache->params.cost_aware ? "cost aware" : "random");
+
+	free(image_cache->index);
 	free(image_cache);
 
 	return NSERROR_OK;
@@ -525,8 +1255,8 @@ nserror image_cache_add(struct content *content,
 		if (centry == NULL) {
 			return NSERROR_NOMEM;
 		}
-		image_cache__link(centry);
 		centry->content = content;
+		image_cache__link(centry);
 
 		centry->bitmap_size = content->width * content->height * 4;
 	}
@@ -536,25 +1266,23 @@ nserror image_cache_add(struct content *content,
 
 	centry->convert = convert;
 
-	/* set bitmap entry if one is passed, free extant one if present */
+	/* set bitmap entry if one is passed, free extant one if present
+	 * unless it is the bitmap a partial image was displayed from */
 	if (bitmap != NULL) {
-		if (centry->bitmap != NULL) {
-			guit->bitmap->destroy(centry->bitmap);
-		} else {
+		if (centry->bitmap != bitmap) {
+			image_cache__free_bitmap(centry);
+			centry->bitmap = bitmap;
+			centry->bitmap_size = guit->bitmap->get_rowstride(bitmap) *
+				guit->bitmap->get_height(bitmap);
 			image_cache_stats_bitmap_add(centry);
 		}
-		centry->bitmap = bitmap;
+		centry->scaled = false;
+		image_cache__touch(centry);
 	} else {
 		/* no bitmap, check to see if we should speculatively convert */
 		if ((centry->convert != NULL) &&
 		    (image_cache_speculate(content) == true)) {
-			centry->bitmap = centry->convert(centry->content);
-
-			if (centry->bitmap != NULL) {
-				image_cache_stats_bitmap_add(centry);
-			} else {
-				image_cache->fail_count++;
-			}
+			image_cache__convert(centry);
 		}
 	}
 
@@ -667,6 +1395,11 @@ case chr :					\
 			FMTCHR('v', "d", total_extra_conversions_count);
 			FMTCHR('w', "u", peak_conversions_size);
 			FMTCHR('x', "d", peak_conversions);
+			FMTCHR('y', "d", bitmap_users);
+
+			FMTPCHR('z', "d", shared_users, image_cache->bitmap_users);
+
+			FMTCHR('A', "d", total_shared);
 
 
 			}
@@ -810,23 +1543,34 @@ bool image_cache_redraw(struct content *c,
 		return false;
 	}
 
-	if (centry->bitmap == NULL) {
-		if (centry->convert != NULL) {
-			centry->bitmap = centry->convert(centry->content);
-		}
+	/* track the largest size the content is plotted at */
+	if (centry->target_width < data->width) {
+		centry->target_width = data->width;
+	}
+	if (centry->target_height < data->height) {
+		centry->target_height = data->height;
+	}
 
-		if (centry->bitmap != NULL) {
-			image_cache_stats_bitmap_add(centry);
-			image_cache->miss_count++;
-			image_cache->miss_size += centry->bitmap_size;
-		} else {
-			image_cache->fail_count++;
-			image_cache->fail_size += centry->bitmap_size;
+	if (image_cache__wants_convert(centry)) {
+		if (image_cache->params.async &&
+		    ctx->interactive &&
+		    centry->convert != NULL) {
+			/* plot any bitmap already held, or a placeholder,
+			 * until the conversion completes and a redraw is
+			 * requested */
+			image_cache__defer_convert(centry);
+			if (centry->bitmap == NULL) {
+				return image_cache__plot_pending(data,
+								 clip,
+								 ctx);
+			}
+		} else if (image_cache__convert(centry) == false) {
 			return false;
 		}
 	} else {
 		image_cache->hit_count++;
 		image_cache->hit_size += centry->bitmap_size;
+		image_cache__touch(centry);
 	}
 
 
@@ -861,8 +1605,17 @@ void *image_cache_get_internal(const struct content *c, void *context)
 /* exported interface documented in image_cache.h */
 bool image_cache_is_opaque(struct content *c)
 {
-	struct bitmap *bmp;
-	bmp = image_cache_get_bitmap(c);
+	struct image_cache_entry_s *centry;
+	struct bitmap *bmp = NULL;
+
+	/* a reduced bitmap has the same opacity as the full size one */
+	centry = image_cache__find(c);
+	if (centry != NULL) {
+		bmp = centry->bitmap;
+	}
+	if (bmp == NULL) {
+		bmp = image_cache_get_bitmap(c);
+	}
 	if (bmp != NULL) {
 		return guit->bitmap->get_opaque(bmp);
 	}
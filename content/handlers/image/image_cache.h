@@ -32,6 +32,10 @@
  * and the intermediate representation. It is intended to be flexable
  * and either manage the bitmap plotting completely or give the image
  * content handler complete control.
+ *
+ * Bitmaps the cache converts from complete source data are shared by
+ * every image content backed by the same low level cache object, so
+ * contents which could not share a content still share their bitmaps.
  */
 
 #ifndef NETSURF_IMAGE_IMAGE_CACHE_H_
@@ -44,7 +48,21 @@ struct content;
 struct content_redraw_data;
 struct redraw_context;
 
-typedef struct bitmap * (image_cache_convert_fn) (struct content *content);
+/**
+ * Convert a content into a bitmap.
+ *
+ * The width and height are the size the content will be plotted at
+ * or zero when the full size bitmap is required. Converters may
+ * return a bitmap of any size between the requested size and the
+ * content size; the cache reduces it further if that is worthwhile.
+ *
+ * \param content The content to convert.
+ * \param width The width the bitmap is wanted at or zero.
+ * \param height The height the bitmap is wanted at or zero.
+ * \return The converted bitmap or NULL on failure.
+ */
+typedef struct bitmap * (image_cache_convert_fn) (struct content *content,
+		int width, int height);
 
 struct image_cache_parameters {
 	/** How frequently the background cache clean process is run (ms) */
@@ -58,6 +76,14 @@ struct image_cache_parameters {
 
 	/** The speculative conversion "small" size */
 	size_t speculative_small;
+
+	/** Whether interactive redraws defer conversion to a scheduled
+	 * callback instead of converting while plotting */
+	bool async;
+
+	/** Whether the cleaner releases bitmaps by their conversion cost,
+	 * size and recency instead of at random */
+	bool cost_aware;
 };
 
 /** Initialise the image cache 
@@ -156,6 +182,11 @@ int image_cache_snentryf(char *string, size_t size, unsigned int entryn,
  *     of times.
  * x The number of times the image that was converted (read missed cache) 
  *     highest number of times.
+ * y The number of images currently using a bitmap.
+ * z The number of images currently using a bitmap converted for another
+ *     image from the same source data.
+ * A The number of conversions avoided by using a bitmap converted for
+ *     another image from the same source data.
  *
  * format modifiers:
  * A p before the value modifies the replacement to be a percentage.
@@ -27,10 +27,12 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <setjmp.h>
+#include <nsutils/time.h>
 
 #include "utils/utils.h"
 #include "utils/log.h"
 #include "utils/messages.h"
+#include "utils/pixel.h"
 #include "netsurf/bitmap.h"
 #include "content/llcache.h"
 #include "content/content.h"
@@ -38,6 +40,7 @@
 #include "content/content_factory.h"
 #include "desktop/gui_internal.h"
 
+#include "image/image.h"
 #include "image/image_cache.h"
 
 #define JPEG_INTERNAL_OPTIONS
@@ -62,6 +65,42 @@ static char nsjpeg_error_buffer[JMSG_LENGTH_MAX];
 
 static unsigned char nsjpeg_eoi[] = { 0xff, JPEG_EOI };
 
+/**
+ * Progress of the decode of a partially received progressive JPEG
+ */
+enum nsjpeg_partial_state {
+	NSJPEG_PARTIAL_HEADER, /**< reading the header */
+	NSJPEG_PARTIAL_START, /**< starting decompression */
+	NSJPEG_PARTIAL_INPUT, /**< absorbing scans as they arrive */
+	NSJPEG_PARTIAL_START_OUTPUT, /**< starting output of a scan */
+	NSJPEG_PARTIAL_OUTPUT, /**< outputting a scan to the bitmap */
+	NSJPEG_PARTIAL_FINISH_OUTPUT, /**< finishing output of a scan */
+};
+
+/**
+ * Decoder displaying a progressive JPEG while its data arrives
+ */
+struct nsjpeg_partial {
+	struct jpeg_decompress_struct cinfo; /**< decompressor, must be first */
+	struct jpeg_error_mgr jerr; /**< decompressor error handler */
+	struct jpeg_source_mgr source_mgr; /**< suspending data source */
+	jmp_buf setjmp_buffer; /**< fatal error return */
+	enum nsjpeg_partial_state state; /**< decode progress */
+	size_t offset; /**< offset of source data not yet consumed */
+	size_t skip; /**< source data to skip once it arrives */
+	int output_scan; /**< scan last output to the bitmap */
+	struct bitmap *bitmap; /**< bitmap scans are output to */
+	uint64_t redraw_time; /**< time of last partial image redraw */
+};
+
+typedef struct nsjpeg_content {
+	struct content base; /**< base content structure */
+
+	struct nsjpeg_partial *partial; /**< decoder of partial image */
+	bool no_partial; /**< partial image is not to be displayed */
+	uint64_t create_time; /**< time the content was created */
+} nsjpeg_content;
+
 /**
  * Content create entry point.
  */
@@ -70,21 +109,23 @@ static nserror nsjpeg_create(const content_handler *handler,
 		llcache_handle *llcache, const char *fallback_charset,
 		bool quirks, struct content **c)
 {
-	struct content *jpeg;
+	nsjpeg_content *jpeg;
 	nserror error;
 
-	jpeg = calloc(1, sizeof(struct content));
+	jpeg = calloc(1, sizeof(nsjpeg_content));
 	if (jpeg == NULL)
 		return NSERROR_NOMEM;
 
-	error = content__init(jpeg, handler, imime_type, params,
+	error = content__init(&jpeg->base, handler, imime_type, params,
 			      llcache, fallback_charset, quirks);
 	if (error != NSERROR_OK) {
 		free(jpeg);
 		return error;
 	}
 
-	*c = jpeg;
+	nsu_getmonotonic_ms(&jpeg->create_time);
+
+	*c = (struct content *)jpeg;
 
 	return NSERROR_OK;
 }
@@ -164,11 +205,66 @@ static void nsjpeg_error_exit(j_common_ptr cinfo)
 	longjmp(*setjmp_buffer, 1);
 }
 
+/**
+ * Convert a row of decoded pixels to the bitmap format in place.
+ *
+ * \param cinfo The decompressor which output the row.
+ * \param row The row of pixels.
+ */
+static void nsjpeg_convert_row(j_decompress_ptr cinfo, JSAMPROW row)
+{
+	unsigned int width = cinfo->output_width;
+
+	if (cinfo->out_color_space == JCS_CMYK) {
+		/* Trivial inverse CMYK -> RGBA */
+		pixel_cmyk_to_rgba(row, width);
+	} else {
+#if RGB_RED == 0 && RGB_GREEN == 1 && RGB_BLUE == 2 && RGB_PIXELSIZE == 3
+		/* libjpeg produces packed RGB, expand to RGBA */
+		pixel_rgb_to_rgba(row, row, width);
+#elif RGB_RED != 0 || RGB_GREEN != 1 || RGB_BLUE != 2 || RGB_PIXELSIZE != 4
+		/* Missmatch between configured libjpeg pixel format and
+		 * NetSurf pixel format.  Convert to RGBA */
+		int i;
+		for (i = width - 1; 0 <= i; i--) {
+			int r = row[i * RGB_PIXELSIZE + RGB_RED];
+			int g = row[i * RGB_PIXELSIZE + RGB_GREEN];
+			int b = row[i * RGB_PIXELSIZE + RGB_BLUE];
+			row[i * 4 + 0] = r;
+			row[i * 4 + 1] = g;
+			row[i * 4 + 2] = b;
+			row[i * 4 + 3] = 0xff;
+		}
+#endif
+	}
+}
+
+
+/**
+ * Set the output colour space of a decompressor from its header.
+ *
+ * \param cinfo The decompressor.
+ */
+static void nsjpeg_set_output(j_decompress_ptr cinfo)
+{
+	if (cinfo->jpeg_color_space == JCS_CMYK ||
+			cinfo->jpeg_color_space == JCS_YCCK) {
+		cinfo->out_color_space = JCS_CMYK;
+	} else {
+		cinfo->out_color_space = JCS_RGB;
+	}
+	cinfo->dct_method = JDCT_ISLOW;
+}
+
+
 /**
  * create a bitmap from jpeg content.
+ *
+ * When a size is requested the image is decoded with the largest
+ * DCT scaling (1/2, 1/4 or 1/8) which keeps it at least that size.
  */
 static struct bitmap *
-jpeg_cache_convert(struct content *c)
+jpeg_cache_convert(struct content *c, int target_width, int target_height)
 {
 	const uint8_t *source_data; /* Jpeg source data */
 	size_t source_size; /* length of Jpeg source data */
@@ -220,13 +316,22 @@ jpeg_cache_convert(struct content *c)
 	jpeg_read_header(&cinfo, TRUE);
 
 	/* set output processing parameters */
-	if (cinfo.jpeg_color_space == JCS_CMYK ||
-			cinfo.jpeg_color_space == JCS_YCCK) {
-		cinfo.out_color_space = JCS_CMYK;
-	} else {
-		cinfo.out_color_space = JCS_RGB;
+	nsjpeg_set_output(&cinfo);
+
+	/* scale down in the decoder when a smaller bitmap will do */
+	if ((target_width > 0) && (target_height > 0)) {
+		unsigned int denom = 8;
+
+		while ((denom > 1) &&
+		       ((cinfo.image_width / denom <
+			 (unsigned int)target_width) ||
+			(cinfo.image_height / denom <
+			 (unsigned int)target_height))) {
+			denom /= 2;
+		}
+		cinfo.scale_num = 1;
+		cinfo.scale_denom = denom;
 	}
-	cinfo.dct_method = JDCT_ISLOW;
 
 	/* commence the decompression, output parameters now valid */
 	jpeg_start_decompress(&cinfo);
@@ -259,42 +364,7 @@ jpeg_cache_convert(struct content *c)
 					   rowstride * cinfo.output_scanline);
 		jpeg_read_scanlines(&cinfo, scanlines, 1);
 
-		if (cinfo.out_color_space == JCS_CMYK) {
-			int i;
-			for (i = width - 1; 0 <= i; i--) {
-				/* Trivial inverse CMYK -> RGBA */
-				const int c = scanlines[0][i * 4 + 0];
-				const int m = scanlines[0][i * 4 + 1];
-				const int y = scanlines[0][i * 4 + 2];
-				const int k = scanlines[0][i * 4 + 3];
-
-				const int ck = c * k;
-				const int mk = m * k;
-				const int yk = y * k;
-
-#define DIV255(x) ((x) + 1 + ((x) >> 8)) >> 8
-				scanlines[0][i * 4 + 0] = DIV255(ck);
-				scanlines[0][i * 4 + 1] = DIV255(mk);
-				scanlines[0][i * 4 + 2] = DIV255(yk);
-				scanlines[0][i * 4 + 3] = 0xff;
-#undef DIV255
-			}
-		} else {
-#if RGB_RED != 0 || RGB_GREEN != 1 || RGB_BLUE != 2 || RGB_PIXELSIZE != 4
-			/* Missmatch between configured libjpeg pixel format and
-			 * NetSurf pixel format.  Convert to RGBA */
-			int i;
-			for (i = width - 1; 0 <= i; i--) {
-				int r = scanlines[0][i * RGB_PIXELSIZE + RGB_RED];
-				int g = scanlines[0][i * RGB_PIXELSIZE + RGB_GREEN];
-				int b = scanlines[0][i * RGB_PIXELSIZE + RGB_BLUE];
-				scanlines[0][i * 4 + 0] = r;
-				scanlines[0][i * 4 + 1] = g;
-				scanlines[0][i * 4 + 2] = b;
-				scanlines[0][i * 4 + 3] = 0xff;
-			}
-#endif
-		}
+		nsjpeg_convert_row(&cinfo, scanlines[0]);
 	} while (cinfo.output_scanline != cinfo.output_height);
 	guit->bitmap->modified(bitmap);
 
@@ -304,11 +374,322 @@ jpeg_cache_convert(struct content *c)
 	return bitmap;
 }
 
+/**
+ * JPEG partial data source manager: fill the input buffer.
+ *
+ * Suspend the decompressor until more data arrives.
+ */
+static boolean nsjpeg_partial_fill_input_buffer(j_decompress_ptr cinfo)
+{
+	return FALSE;
+}
+
+
+/**
+ * JPEG partial data source manager: skip num_bytes worth of data.
+ *
+ * Data which has not arrived yet is skipped once it does.
+ */
+static void nsjpeg_partial_skip_input_data(j_decompress_ptr cinfo,
+		long num_bytes)
+{
+	struct nsjpeg_partial *partial = (struct nsjpeg_partial *)cinfo;
+
+	if (num_bytes <= 0) {
+		return;
+	}
+
+	if ((long) cinfo->src->bytes_in_buffer < num_bytes) {
+		partial->skip += num_bytes - cinfo->src->bytes_in_buffer;
+		cinfo->src->next_input_byte += cinfo->src->bytes_in_buffer;
+		cinfo->src->bytes_in_buffer = 0;
+	} else {
+		cinfo->src->next_input_byte += num_bytes;
+		cinfo->src->bytes_in_buffer -= num_bytes;
+	}
+}
+
+
+/**
+ * Create the decoder of a partially received progressive JPEG.
+ *
+ * \param jpeg The jpeg content.
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror nsjpeg_partial_create(nsjpeg_content *jpeg)
+{
+	struct nsjpeg_partial *partial;
+
+	partial = calloc(1, sizeof(struct nsjpeg_partial));
+	if (partial == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	partial->cinfo.err = jpeg_std_error(&partial->jerr);
+	partial->jerr.error_exit = nsjpeg_error_exit;
+	partial->jerr.output_message = nsjpeg_error_log;
+
+	if (setjmp(partial->setjmp_buffer)) {
+		free(partial);
+		return NSERROR_NOMEM;
+	}
+
+	partial->cinfo.client_data = &partial->setjmp_buffer;
+	jpeg_create_decompress(&partial->cinfo);
+
+	partial->source_mgr.init_source = nsjpeg_init_source;
+	partial->source_mgr.fill_input_buffer = nsjpeg_partial_fill_input_buffer;
+	partial->source_mgr.skip_input_data = nsjpeg_partial_skip_input_data;
+	partial->source_mgr.resync_to_restart = jpeg_resync_to_restart;
+	partial->source_mgr.term_source = nsjpeg_term_source;
+	partial->cinfo.src = &partial->source_mgr;
+
+	/* display the first scan as soon as it has arrived */
+	partial->redraw_time = jpeg->create_time;
+
+	jpeg->partial = partial;
+
+	return NSERROR_OK;
+}
+
+
+/**
+ * Destroy the decoder of a partially received progressive JPEG.
+ *
+ * \param jpeg The jpeg content.
+ */
+static void nsjpeg_partial_destroy(nsjpeg_content *jpeg)
+{
+	struct nsjpeg_partial *partial = jpeg->partial;
+
+	if (partial == NULL) {
+		return;
+	}
+
+	jpeg_destroy_decompress(&partial->cinfo);
+
+	if ((partial->bitmap != NULL) &&
+	    (jpeg->base.status == CONTENT_STATUS_LOADING)) {
+		/* the bitmap was never given to the image cache */
+		guit->bitmap->destroy(partial->bitmap);
+	}
+
+	free(partial);
+	jpeg->partial = NULL;
+}
+
+
+/**
+ * Output the scan being displayed to the bitmap.
+ *
+ * \param partial The partial image decoder.
+ * \return true if the scan was output, false if the decoder suspended.
+ */
+static bool nsjpeg_partial_output(struct nsjpeg_partial *partial)
+{
+	j_decompress_ptr cinfo = &partial->cinfo;
+	uint8_t *pixels;
+	size_t rowstride;
+	JSAMPROW scanlines[1];
+
+	pixels = guit->bitmap->get_buffer(partial->bitmap);
+	rowstride = guit->bitmap->get_rowstride(partial->bitmap);
+
+	while (cinfo->output_scanline < cinfo->output_height) {
+		scanlines[0] = (JSAMPROW) (pixels +
+					   rowstride * cinfo->output_scanline);
+		if (jpeg_read_scanlines(cinfo, scanlines, 1) != 1) {
+			return false;
+		}
+
+		nsjpeg_convert_row(cinfo, scanlines[0]);
+	}
+
+	return true;
+}
+
+
+/**
+ * Decode the data of a progressive JPEG received so far.
+ *
+ * The decompressor is run in buffered image mode with a data source
+ * which suspends it when it runs out of data. The most recent
+ * completely received scan is output to the bitmap and displayed
+ * each frame period.
+ *
+ * Sequential JPEGs are only displayed once they are complete and
+ * partial display of them is abandoned.
+ *
+ * \param jpeg The jpeg content.
+ */
+static void nsjpeg_partial_decode(nsjpeg_content *jpeg)
+{
+	struct nsjpeg_partial *partial = jpeg->partial;
+	j_decompress_ptr cinfo = &partial->cinfo;
+	const uint8_t *source_data;
+	size_t source_size;
+	size_t skip;
+	int scan;
+	int ret;
+
+	/* the source data may have moved as more arrived */
+	source_data = content__get_source_data(&jpeg->base, &source_size);
+	if (source_data == NULL) {
+		return;
+	}
+
+	skip = min(partial->skip, source_size - partial->offset);
+	partial->offset += skip;
+	partial->skip -= skip;
+
+	partial->source_mgr.next_input_byte = source_data + partial->offset;
+	partial->source_mgr.bytes_in_buffer = source_size - partial->offset;
+
+	if (setjmp(partial->setjmp_buffer)) {
+		nsjpeg_partial_destroy(jpeg);
+		jpeg->no_partial = true;
+		return;
+	}
+
+	switch (partial->state) {
+	case NSJPEG_PARTIAL_HEADER:
+		if (jpeg_read_header(cinfo, TRUE) == JPEG_SUSPENDED) {
+			break;
+		}
+
+		if (jpeg_has_multiple_scans(cinfo) == FALSE) {
+			nsjpeg_partial_destroy(jpeg);
+			jpeg->no_partial = true;
+			return;
+		}
+
+		nsjpeg_set_output(cinfo);
+		cinfo->buffered_image = TRUE;
+		partial->state = NSJPEG_PARTIAL_START;
+		/* fall through */
+
+	case NSJPEG_PARTIAL_START:
+		if (jpeg_start_decompress(cinfo) == FALSE) {
+			break;
+		}
+
+		partial->bitmap = guit->bitmap->create(cinfo->output_width,
+						       cinfo->output_height,
+						       BITMAP_NEW | BITMAP_OPAQUE);
+		if ((partial->bitmap == NULL) ||
+		    (guit->bitmap->get_buffer(partial->bitmap) == NULL)) {
+			nsjpeg_partial_destroy(jpeg);
+			jpeg->no_partial = true;
+			return;
+		}
+
+		jpeg->base.width = cinfo->output_width;
+		jpeg->base.height = cinfo->output_height;
+		partial->state = NSJPEG_PARTIAL_INPUT;
+		/* fall through */
+
+	case NSJPEG_PARTIAL_INPUT:
+		do {
+			ret = jpeg_consume_input(cinfo);
+		} while ((ret != JPEG_SUSPENDED) && (ret != JPEG_REACHED_EOI));
+
+		/* only output complete scans, the output of the scan
+		 * being received would suspend waiting for its data */
+		scan = cinfo->input_scan_number;
+		if ((jpeg_input_complete(cinfo) == FALSE) &&
+		    (cinfo->input_iMCU_row < cinfo->total_iMCU_rows)) {
+			scan--;
+		}
+
+		if ((scan <= partial->output_scan) ||
+		    (image_partial_due(partial->redraw_time) == false)) {
+			break;
+		}
+
+		partial->output_scan = scan;
+		partial->state = NSJPEG_PARTIAL_START_OUTPUT;
+		/* fall through */
+
+	case NSJPEG_PARTIAL_START_OUTPUT:
+		if (jpeg_start_output(cinfo, partial->output_scan) == FALSE) {
+			break;
+		}
+		partial->state = NSJPEG_PARTIAL_OUTPUT;
+		/* fall through */
+
+	case NSJPEG_PARTIAL_OUTPUT:
+		if (nsjpeg_partial_output(partial) == false) {
+			break;
+		}
+		partial->state = NSJPEG_PARTIAL_FINISH_OUTPUT;
+		/* fall through */
+
+	case NSJPEG_PARTIAL_FINISH_OUTPUT:
+		if (jpeg_finish_output(cinfo) == FALSE) {
+			break;
+		}
+		partial->state = NSJPEG_PARTIAL_INPUT;
+
+		image_partial_redraw(&jpeg->base, partial->bitmap,
+				     0, jpeg->base.height,
+				     &partial->redraw_time);
+		break;
+	}
+
+	partial->offset = partial->source_mgr.next_input_byte - source_data;
+}
+
+
+/**
+ * Process data for a CONTENT_JPEG.
+ *
+ * Progressive images which are slow to arrive are displayed as each
+ * scan is received.
+ */
+static bool nsjpeg_process_data(struct content *c, const char *data,
+		unsigned int size)
+{
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
+
+	if (jpeg->no_partial) {
+		return true;
+	}
+
+	if (jpeg->partial == NULL) {
+		/* images which arrive quickly are only decoded once */
+		if (image_partial_due(jpeg->create_time) == false) {
+			return true;
+		}
+
+		if (nsjpeg_partial_create(jpeg) != NSERROR_OK) {
+			jpeg->no_partial = true;
+			return true;
+		}
+	}
+
+	nsjpeg_partial_decode(jpeg);
+
+	return true;
+}
+
+
+/**
+ * Destroy a CONTENT_JPEG and free all resources it owns.
+ */
+static void nsjpeg_destroy(struct content *c)
+{
+	nsjpeg_partial_destroy((nsjpeg_content *)c);
+
+	image_cache_destroy(c);
+}
+
+
 /**
  * Convert a CONTENT_JPEG for display.
  */
 static bool nsjpeg_convert(struct content *c)
 {
+	nsjpeg_content *jpeg = (nsjpeg_content *)c;
 	struct jpeg_decompress_struct cinfo;
 	struct jpeg_error_mgr jerr;
 	jmp_buf setjmp_buffer;
@@ -321,6 +702,9 @@ static bool nsjpeg_convert(struct content *c)
 	size_t size;
 	char *title;
 
+	/* the complete image is decoded by the image cache */
+	nsjpeg_partial_destroy(jpeg);
+
 	/* check image header is valid and get width/height */
 	data = content__get_source_data(c, &size);
 
@@ -354,6 +738,10 @@ static bool nsjpeg_convert(struct content *c)
 
 	jpeg_destroy_decompress(&cinfo);
 
+	if (c->status != CONTENT_STATUS_LOADING) {
+		/* replace the partial image already displayed */
+		image_cache_remove(c);
+	}
 	image_cache_add(c, NULL, jpeg_cache_convert);
 
 	/* set title text */
@@ -365,8 +753,16 @@ static bool nsjpeg_convert(struct content *c)
 		free(title);
 	}
 
-	content_set_ready(c);
-	content_set_done(c);	
+	if (c->status == CONTENT_STATUS_LOADING) {
+		content_set_ready(c);
+	} else {
+		msg_data.redraw.x = 0;
+		msg_data.redraw.y = 0;
+		msg_data.redraw.width = c->width;
+		msg_data.redraw.height = c->height;
+		content_broadcast(c, CONTENT_MSG_REDRAW, &msg_data);
+	}
+	content_set_done(c);
 	content_set_status(c, ""); /* Done: update status bar */
 
 	return true;
@@ -379,37 +775,43 @@ static bool nsjpeg_convert(struct content *c)
  */
 static nserror nsjpeg_clone(const struct content *old, struct content **newc)
 {
-	struct content *jpeg_c;
+	nsjpeg_content *jpeg_c;
 	nserror error;
 
-	jpeg_c = calloc(1, sizeof(struct content));
+	jpeg_c = calloc(1, sizeof(nsjpeg_content));
 	if (jpeg_c == NULL)
 		return NSERROR_NOMEM;
 
-	error = content__clone(old, jpeg_c);
+	error = content__clone(old, &jpeg_c->base);
 	if (error != NSERROR_OK) {
-		content_destroy(jpeg_c);
+		content_destroy(&jpeg_c->base);
 		return error;
 	}
 
+	/* the clone is displayed from all the data received so far */
+	jpeg_c->no_partial = true;
+
 	/* re-convert if the content is ready */
-	if ((old->status == CONTENT_STATUS_READY) ||
-	    (old->status == CONTENT_STATUS_DONE)) {
-		if (nsjpeg_convert(jpeg_c) == false) {
-			content_destroy(jpeg_c);
+	if (old->status == CONTENT_STATUS_DONE) {
+		if (nsjpeg_convert(&jpeg_c->base) == false) {
+			content_destroy(&jpeg_c->base);
 			return NSERROR_CLONE_FAILED;
 		}
+	} else if (old->status == CONTENT_STATUS_READY) {
+		/* the original is displaying a partial image */
+		image_cache_add(&jpeg_c->base, NULL, jpeg_cache_convert);
 	}
 
-	*newc = jpeg_c;
+	*newc = (struct content *)jpeg_c;
 
 	return NSERROR_OK;
 }
 
 static const content_handler nsjpeg_content_handler = {
 	.create = nsjpeg_create,
+	.process_data = nsjpeg_process_data,
 	.data_complete = nsjpeg_convert,
-	.destroy = image_cache_destroy,
+	.destroy = nsjpeg_destroy,
 	.redraw = image_cache_redraw,
 	.clone = nsjpeg_clone,
 	.get_internal = image_cache_get_internal,
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <png.h>
+#include <nsutils/time.h>
 
 #include "netsurf/inttypes.h"
 #include "utils/utils.h"
@@ -29,10 +30,12 @@
 #include "utils/messages.h"
 #include "netsurf/bitmap.h"
 #include "content/llcache.h"
+#include "content/content.h"
 #include "content/content_protected.h"
 #include "content/content_factory.h"
 #include "desktop/gui_internal.h"
 
+#include "image/image.h"
 #include "image/image_cache.h"
 #include "image/png.h"
 
@@ -57,12 +60,17 @@ typedef struct nspng_content {
 	struct bitmap *bitmap;	/**< Created NetSurf bitmap */
 	size_t rowstride, bpp; /**< Bitmap rowstride and bpp */
 	size_t rowbytes; /**< Number of bytes per row */
+	uint64_t redraw_time; /**< Time of last partial image redraw */
+	png_uint_32 dirty_y0; /**< First row changed since last redraw */
+	png_uint_32 dirty_y1; /**< Row after last changed since last redraw */
 } nspng_content;
 
 static unsigned int interlace_start[8] = {0, 16, 0, 8, 0, 4, 0};
 static unsigned int interlace_step[8] = {28, 28, 12, 12, 4, 4, 0};
 static unsigned int interlace_row_start[8] = {0, 0, 4, 0, 2, 0, 1};
 static unsigned int interlace_row_step[8] = {8, 8, 8, 4, 4, 2, 2};
+static unsigned int interlace_block_width[8] = {8, 4, 4, 2, 2, 1, 1};
+static unsigned int interlace_block_height[8] = {8, 8, 4, 4, 2, 2, 1};
 
 /** Callbak error numbers*/
 enum nspng_cberr {
@@ -177,16 +185,67 @@ static void info_callback(png_structp png_s, png_infop info)
 	png_c->rowbytes = png_get_rowbytes(png_s, info);
 	png_c->interlace = (interlace == PNG_INTERLACE_ADAM7);
 
+	/* the image is displayed early if it is slow to arrive */
+	nsu_getmonotonic_ms(&png_c->redraw_time);
+	png_c->dirty_y0 = height;
+	png_c->dirty_y1 = 0;
+
 	NSLOG(netsurf, INFO, "size %li * %li, rowbytes %"PRIsizet,
 	      (unsigned long)width, (unsigned long)height, png_c->rowbytes);
 }
 
+/**
+ * Fill the area of an interlaced image below and right of a decoded row
+ *
+ * Each pixel of an Adam7 pass is repeated over the block of pixels
+ * which only later passes decode. A partially decoded image is then
+ * displayed at low resolution instead of as scattered pixels.
+ *
+ * \param png_c The png content
+ * \param row The start of the decoded row in the bitmap
+ * \param row_num The row number
+ * \param pass The Adam7 pass the row was decoded in
+ * \return The row after the last one filled
+ */
+static png_uint_32 interlace_fill(nspng_content *png_c, unsigned char *row,
+		png_uint_32 row_num, int pass)
+{
+	unsigned long rowbytes = png_c->rowbytes;
+	unsigned long block_bytes = interlace_block_width[pass] * 4;
+	unsigned long dst_off, fill_off;
+	png_uint_32 last = row_num + interlace_block_height[pass];
+
+	if (block_bytes > 4) {
+		for (dst_off = interlace_start[pass];
+		     dst_off < rowbytes;
+		     dst_off += interlace_step[pass] + 4) {
+			for (fill_off = dst_off + 4;
+			     (fill_off < dst_off + block_bytes) &&
+				     (fill_off < rowbytes);
+			     fill_off += 4) {
+				memcpy(row + fill_off, row + dst_off, 4);
+			}
+		}
+	}
+
+	if (last > (png_uint_32)png_c->base.height) {
+		last = png_c->base.height;
+	}
+	for (row_num++; row_num < last; row_num++) {
+		row += png_c->rowstride;
+		memcpy(row, row - png_c->rowstride, rowbytes);
+	}
+
+	return last;
+}
+
 static void row_callback(png_structp png_s, png_bytep new_row,
 			 png_uint_32 row_num, int pass)
 {
 	nspng_content *png_c = png_get_progressive_ptr(png_s);
 	unsigned long rowbytes = png_c->rowbytes;
 	unsigned char *buffer, *row;
+	png_uint_32 last;
 
 	/* Give up if there's no bitmap */
 	if (png_c->bitmap == NULL)
@@ -227,9 +286,21 @@ static void row_callback(png_structp png_s, png_bytep new_row,
 			row[dst_off++] = new_row[src_off++];
 			row[dst_off++] = new_row[src_off++];
 		}
+
+		last = interlace_fill(png_c, row, row_num, pass);
 	} else {
 		/* Do a fast memcpy of the row data */
 		memcpy(row, new_row, rowbytes);
+
+		last = row_num + 1;
+	}
+
+	/* track the rows to redraw */
+	if (png_c->dirty_y0 > row_num) {
+		png_c->dirty_y0 = row_num;
+	}
+	if (png_c->dirty_y1 < last) {
+		png_c->dirty_y1 = last;
 	}
 }
 
@@ -327,6 +398,16 @@ static bool nspng_process_data(struct content *c, const char *data,
 	switch (setjmp(png_jmpbuf(png_c->png))) {
 	case CBERR_NONE: /* direct return */	
 		png_process_data(png_c->png, png_c->info, (uint8_t *)data, size);
+
+		/* display the rows decoded so far */
+		if ((png_c->bitmap != NULL) &&
+		    (png_c->dirty_y0 < png_c->dirty_y1) &&
+		    image_partial_redraw(c, png_c->bitmap,
+					 png_c->dirty_y0, png_c->dirty_y1,
+					 &png_c->redraw_time)) {
+			png_c->dirty_y0 = c->height;
+			png_c->dirty_y1 = 0;
+		}
 		break;
 
 	case CBERR_NOPRE: /* not going to progressive convert */
@@ -425,10 +506,12 @@ static png_bytep *calc_row_pointers(struct bitmap *bitmap)
 
 /** PNG content to bitmap conversion.
  *
- * This routine generates a bitmap object from a PNG image content
+ * This routine generates a bitmap object from a PNG image content.
+ * The full size image is always decoded, the image cache reduces it
+ * when a smaller size was requested.
  */
 static struct bitmap *
-png_cache_convert(struct content *c)
+png_cache_convert(struct content *c, int target_width, int target_height)
 {
 	png_structp png_ptr;
 	png_infop info_ptr;
@@ -541,7 +624,18 @@ static bool nspng_convert(struct content *c)
 
 	image_cache_add(c, png_c->bitmap, png_cache_convert);
 
-	content_set_ready(c);
+	if (c->status == CONTENT_STATUS_LOADING) {
+		content_set_ready(c);
+	} else {
+		/* replace the partial image already displayed */
+		union content_msg_data data;
+
+		data.redraw.x = 0;
+		data.redraw.y = 0;
+		data.redraw.width = c->width;
+		data.redraw.height = c->height;
+		content_broadcast(c, CONTENT_MSG_REDRAW, &data);
+	}
 	content_set_done(c);
 	content_set_status(c, "");
 
@@ -581,12 +675,16 @@ static nserror nspng_clone(const struct content *old_c, struct content **new_c)
 		}
 	}
 
-	if ((old_c->status == CONTENT_STATUS_READY) ||
-	    (old_c->status == CONTENT_STATUS_DONE)) {
+	if (old_c->status == CONTENT_STATUS_DONE) {
 		if (nspng_convert(&clone_png_c->base) == false) {
 			content_destroy(&clone_png_c->base);
 			return NSERROR_CLONE_FAILED;
 		}
+	} else if ((old_c->status == CONTENT_STATUS_READY) &&
+		   (clone_png_c->bitmap != NULL)) {
+		/* the original is displaying a partial image */
+		guit->bitmap->modified(clone_png_c->bitmap);
+		image_cache_add(&clone_png_c->base, clone_png_c->bitmap, NULL);
 	}
 
 	*new_c = (struct content *)clone_png_c;
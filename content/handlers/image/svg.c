@@ -38,25 +38,47 @@
 
 #include "image/svg.h"
 
+/**
+ * Number of parsed diagrams kept for each SVG content.
+ *
+ * Lengths in an SVG may be relative to the viewport so the diagram is
+ * parsed for a particular size. Pages commonly alternate between a
+ * few sizes as the window is resized or the layout is reflowed, so the
+ * most recently used sizes are kept to avoid parsing again.
+ */
+#define SVG_DIAGRAM_CACHE_SIZE 4
+
+/**
+ * A diagram parsed for a viewport size
+ */
+struct svg_diagram_entry {
+	struct svgtiny_diagram *diagram; /**< parsed diagram or NULL */
+	int width; /**< viewport width diagram was parsed for */
+	int height; /**< viewport height diagram was parsed for */
+	unsigned int used; /**< reformat count when last used */
+};
+
 typedef struct svg_content {
 	struct content base;
 
-	struct svgtiny_diagram *diagram;
+	struct svgtiny_diagram *diagram; /**< diagram for the current size */
 
-	int current_width;
-	int current_height;
+	/** recently parsed diagrams */
+	struct svg_diagram_entry cache[SVG_DIAGRAM_CACHE_SIZE];
+	unsigned int reformat_count; /**< number of reformats performed */
 } svg_content;
 
 
 
 static nserror svg_create_svg_data(svg_content *c)
 {
-	c->diagram = svgtiny_create();
-	if (c->diagram == NULL)
+	c->cache[0].diagram = svgtiny_create();
+	if (c->cache[0].diagram == NULL)
 		goto no_memory;
 
-	c->current_width = INT_MAX;
-	c->current_height = INT_MAX;
+	c->cache[0].width = INT_MAX;
+	c->cache[0].height = INT_MAX;
+	c->diagram = c->cache[0].diagram;
 
 	return NSERROR_OK;
 
@@ -66,6 +88,61 @@ no_memory:
 }
 
 
+/**
+ * Find the diagram to use for a viewport size.
+ *
+ * A diagram already parsed for the size is used if there is one,
+ * otherwise an unused entry gets a new diagram or, when all are in use
+ * or a diagram cannot be created, the least recently used diagram is
+ * parsed again.
+ *
+ * \param svg    The SVG content
+ * \param width  viewport width
+ * \param height viewport height
+ * \param parse  updated to true if the diagram must be parsed
+ * \return the entry for the viewport size
+ */
+static struct svg_diagram_entry *
+svg_find_diagram(svg_content *svg, int width, int height, bool *parse)
+{
+	struct svg_diagram_entry *victim = NULL;
+	struct svg_diagram_entry *entry;
+	unsigned int i;
+
+	for (i = 0; i != SVG_DIAGRAM_CACHE_SIZE; i++) {
+		entry = &svg->cache[i];
+		if (entry->diagram == NULL) {
+			continue;
+		}
+		if (entry->width == width && entry->height == height) {
+			*parse = false;
+			return entry;
+		}
+		if (victim == NULL || entry->used < victim->used) {
+			victim = entry;
+		}
+	}
+
+	*parse = true;
+
+	for (i = 0; i != SVG_DIAGRAM_CACHE_SIZE; i++) {
+		entry = &svg->cache[i];
+		if (entry->diagram == NULL) {
+			entry->diagram = svgtiny_create();
+			if (entry->diagram != NULL) {
+				return entry;
+			}
+			break;
+		}
+	}
+
+	/* there is always at least the diagram made on creation */
+	assert(victim != NULL);
+
+	return victim;
+}
+
+
 /**
  * Create a CONTENT_SVG.
  */
@@ -128,25 +205,30 @@ static bool svg_convert(struct content *c)
 static void svg_reformat(struct content *c, int width, int height)
 {
 	svg_content *svg = (svg_content *) c;
+	struct svg_diagram_entry *entry;
 	const uint8_t *source_data;
 	size_t source_size;
+	bool parse;
 
 	assert(svg->diagram);
 
-	/* Avoid reformats to same width/height as we already reformatted to */
-	if (width != svg->current_width || height != svg->current_height) {
+	/* Avoid parsing again for a size a diagram was parsed for */
+	entry = svg_find_diagram(svg, width, height, &parse);
+	if (parse) {
 		source_data = content__get_source_data(c, &source_size);
 
-		svgtiny_parse(svg->diagram,
+		svgtiny_parse(entry->diagram,
 			      (const char *)source_data,
 			      source_size,
 			      nsurl_access(content_get_url(c)),
 			      width,
 			      height);
 
-		svg->current_width = width;
-		svg->current_height = height;
+		entry->width = width;
+		entry->height = height;
 	}
+	entry->used = ++svg->reformat_count;
+	svg->diagram = entry->diagram;
 
 	c->width = svg->diagram->width;
 	c->height = svg->diagram->height;
@@ -302,9 +384,12 @@ static bool svg_redraw(struct content *c, struct content_redraw_data *data,
 static void svg_destroy(struct content *c)
 {
 	svg_content *svg = (svg_content *) c;
+	unsigned int i;
 
-	if (svg->diagram != NULL)
-		svgtiny_free(svg->diagram);
+	for (i = 0; i != SVG_DIAGRAM_CACHE_SIZE; i++) {
+		if (svg->cache[i].diagram != NULL)
+			svgtiny_free(svg->cache[i].diagram);
+	}
 }
 
 
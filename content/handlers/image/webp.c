@@ -86,7 +86,7 @@ webp_create(const content_handler *handler,
  * create a bitmap from webp content.
  */
 static struct bitmap *
-webp_cache_convert(struct content *c)
+webp_cache_convert(struct content *c, int target_width, int target_height)
 {
 	const uint8_t *source_data; /* webp source data */
 	size_t source_size; /* length of webp source data */
@@ -30,6 +30,7 @@
 #include "utils/messages.h"
 #include "utils/ring.h"
 #include "utils/utils.h"
+#include "utils/nsoption.h"
 #include "netsurf/misc.h"
 #include "netsurf/content.h"
 #include "desktop/gui_internal.h"
@@ -711,6 +712,13 @@ hlcache_handle_retrieve(nsurl *url,
 		ctx->child.quirks = child->quirks;
 	}
 
+	/* When browsing offline every retrieval is only satisfied
+	 * from the cache.
+	 */
+	if (nsoption_bool(offline_mode)) {
+		flags |= LLCACHE_RETRIEVE_CACHE_ONLY;
+	}
+
 	ctx->flags = flags;
 	ctx->accepted_types = accepted_types;
 
@@ -108,6 +108,9 @@ void hlcache_finalise(void);
  * \param result          Pointer to location to recieve cache handle
  * \return NSERROR_OK on success, appropriate error otherwise
  *
+ * If the offline_mode option is set the ::LLCACHE_RETRIEVE_CACHE_ONLY
+ * flag is added to every retrieval.
+ *
  * Child contents are keyed on the tuple < URL, quirks >.
  * The quirks field is ignored for child contents whose behaviour is not
  * affected by quirks mode.
@@ -261,6 +261,29 @@ struct llcache_s {
 	 */
 	uint64_t total_elapsed;
 
+
+	/* statistics */
+
+	/** Total activity since initialisation */
+	struct llcache_stats_sample total;
+
+	/** Activity totals when the last history sample was taken */
+	struct llcache_stats_sample last_sample;
+
+	/** Ring of activity samples */
+	struct llcache_stats_sample history[LLCACHE_STATS_HISTORY];
+
+	/** Index of the next history sample to be written */
+	unsigned int history_next;
+
+	/** Number of valid samples in the history ring */
+	unsigned int history_len;
+
+	/** Number of objects discarded to meet the configured limit */
+	unsigned int evict_count;
+
+	/** Size of objects discarded to meet the configured limit */
+	uint64_t evict_size;
 };
 
 /** low level cache state */
@@ -272,6 +295,9 @@ static void llcache_fetch_callback(const fetch_msg *msg, void *p);
 /* forward referenced catch up function */
 static void llcache_users_not_caught_up(void);
 
+/* forward referenced scheme check */
+static inline bool llcache__scheme_is_persistable(const nsurl *url);
+
 
 /******************************************************************************
  * Low-level cache internals						      *
@@ -888,6 +914,39 @@ static nserror get_referer_header(nsurl *url, nsurl *referer, char **header_out)
 	return res;
 }
 
+/**
+ * Report an object as unavailable in cache only mode.
+ *
+ * This is scheduled in place of starting a network fetch so users
+ * attached once retrieval completes receive the error.
+ *
+ * \param p The object which is not cached.
+ */
+static void llcache_object_not_cached(void *p)
+{
+	llcache_object *object = p;
+	llcache_event event;
+
+	object->fetch.state = LLCACHE_FETCH_COMPLETE;
+
+	/* Release candidate, if any */
+	if (object->candidate != NULL) {
+		object->candidate->candidate_count--;
+		object->candidate = NULL;
+	}
+
+	/* Invalidate cache control data */
+	llcache_invalidate_cache_control_data(object);
+
+	event.type = LLCACHE_EVENT_ERROR;
+	event.data.error.code = NSERROR_NOT_CACHED;
+	event.data.error.msg = NULL;
+
+	llcache_send_event_to_users(object, &event);
+
+	llcache_users_not_caught_up();
+}
+
 /**
  * (Re)fetch an object
  *
@@ -908,6 +967,18 @@ static nserror llcache_object_refetch(llcache_object *object)
 	int header_idx = 0;
 	nserror res;
 
+	/* In cache only mode network fetches are never started */
+	if (((object->fetch.flags & LLCACHE_RETRIEVE_CACHE_ONLY) != 0) &&
+	    llcache__scheme_is_persistable(object->url)) {
+		NSLOG(llcache, DEBUG, "Not fetching %p in cache only mode",
+		      object);
+
+		object->fetch.state = LLCACHE_FETCH_INIT;
+		object->fetch.fetch = NULL;
+
+		return guit->misc->schedule(0, llcache_object_not_cached, object);
+	}
+
 	if (object->fetch.post != NULL) {
 		if (object->fetch.post->type == LLCACHE_POST_URL_ENCODED) {
 			urlenc = object->fetch.post->data.urlenc;
@@ -1062,6 +1133,11 @@ static nserror llcache_object_destroy(llcache_object *object)
 	NSLOG(llcache, DEBUG, "Destroying object %p, %s", object,
 	      nsurl_access(object->url));
 
+	if ((object->fetch.flags & LLCACHE_RETRIEVE_CACHE_ONLY) != 0) {
+		/* ensure any pending cache miss report is removed */
+		guit->misc->schedule(-1, llcache_object_not_cached, object);
+	}
+
 	cert_chain_free(object->chain);
 
 	if (object->source_data != NULL) {
@@ -1968,8 +2044,12 @@ llcache_object_retrieve_from_cache(nsurl *url,
 		 */
 	}
 
-	if ((newest != NULL) && (llcache_object_is_fresh(newest))) {
-		/* Found a suitable object, and it's still fresh */
+	if ((newest != NULL) &&
+	    (((flags & LLCACHE_RETRIEVE_CACHE_ONLY) != 0) ||
+	     llcache_object_is_fresh(newest))) {
+		/* Found a suitable object, and it's still fresh or
+		 * cannot be validated as only cached data may be used.
+		 */
 		NSLOG(llcache, DEBUG, "Found fresh %p", newest);
 
 		/* The client needs to catch up with the object's state.
@@ -1982,6 +2062,8 @@ llcache_object_retrieve_from_cache(nsurl *url,
 			/* source data was successfully retrieved from
 			 * persistent store
 			 */
+			llcache->total.hit_count++;
+
 			*result = newest;
 
 			return NSERROR_OK;
@@ -2037,6 +2119,8 @@ llcache_object_retrieve_from_cache(nsurl *url,
 			/* Add new object to cache */
 			llcache_object_add_to_list(obj, &llcache->cached_objects);
 
+			llcache->total.revalidate_count++;
+
 			*result = obj;
 
 			return NSERROR_OK;
@@ -2069,6 +2153,8 @@ llcache_object_retrieve_from_cache(nsurl *url,
 	/* Add new object to cache */
 	llcache_object_add_to_list(obj, &llcache->cached_objects);
 
+	llcache->total.miss_count++;
+
 	*result = obj;
 
 	return NSERROR_OK;
@@ -3704,6 +3790,71 @@ static void llcache_users_not_caught_up(void)
 }
 
 
+/**
+ * Record the cache activity since the previous sample in the history.
+ */
+static void llcache_stats_sample(void)
+{
+	struct llcache_stats_sample *sample;
+
+	sample = &llcache->history[llcache->history_next];
+
+	sample->hit_count = llcache->total.hit_count -
+		llcache->last_sample.hit_count;
+	sample->revalidate_count = llcache->total.revalidate_count -
+		llcache->last_sample.revalidate_count;
+	sample->miss_count = llcache->total.miss_count -
+		llcache->last_sample.miss_count;
+
+	llcache->last_sample = llcache->total;
+
+	llcache->history_next = (llcache->history_next + 1) %
+		LLCACHE_STATS_HISTORY;
+	if (llcache->history_len < LLCACHE_STATS_HISTORY) {
+		llcache->history_len++;
+	}
+}
+
+/**
+ * Insert an object into the largest object table if it qualifies.
+ *
+ * \param stats The statistics being gathered.
+ * \param object The object to consider.
+ */
+static void
+llcache_stats_consider_object(struct llcache_stats *stats,
+			      llcache_object *object)
+{
+	unsigned int idx;
+
+	/* find the insertion point */
+	for (idx = stats->top_len; idx > 0; idx--) {
+		if (stats->top[idx - 1].size >= object->source_len) {
+			break;
+		}
+	}
+
+	if (idx == LLCACHE_STATS_TOP_OBJECTS) {
+		/* smaller than all the entries in a full table */
+		return;
+	}
+
+	if (stats->top_len == LLCACHE_STATS_TOP_OBJECTS) {
+		/* drop the smallest entry */
+		stats->top_len--;
+		nsurl_unref(stats->top[stats->top_len].url);
+	}
+
+	memmove(&stats->top[idx + 1],
+		&stats->top[idx],
+		(stats->top_len - idx) * sizeof(stats->top[0]));
+
+	stats->top[idx].url = nsurl_ref(object->url);
+	stats->top[idx].size = object->source_len;
+	stats->top_len++;
+}
+
+
 /******************************************************************************
  * Public API								      *
  ******************************************************************************/
@@ -3840,6 +3991,9 @@ void llcache_clean(bool purge)
 
 			llcache_size -=	total_object_size(object);
 
+			llcache->evict_count++;
+			llcache->evict_size += object->source_len;
+
 			llcache_object_remove_from_list(object,
 						&llcache->cached_objects);
 			llcache_object_destroy(object);
@@ -3870,6 +4024,9 @@ void llcache_clean(bool purge)
 
 			llcache_size -=	object->source_len + sizeof(*object);
 
+			llcache->evict_count++;
+			llcache->evict_size += object->source_len;
+
 			llcache_object_remove_from_list(object,
 						&llcache->cached_objects);
 			llcache_object_destroy(object);
@@ -3877,8 +4034,83 @@ void llcache_clean(bool purge)
 	}
 
 	NSLOG(llcache, DEBUG, "Size: %u (limit: %u)", llcache_size, limit);
+
+	if (!purge) {
+		llcache_stats_sample();
+	}
+}
+
+/* Exported interface documented in content/llcache.h */
+nserror llcache_get_stats(struct llcache_stats *stats)
+{
+	llcache_object *object;
+	unsigned int idx;
+	unsigned int hidx;
+
+	if (llcache == NULL) {
+		return NSERROR_INIT_FAILED;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+
+	stats->limit = llcache->limit;
+
+	for (object = llcache->cached_objects;
+	     object != NULL;
+	     object = object->next) {
+		stats->object_count++;
+		stats->size += total_object_size(object);
+		if (object->store_state == LLCACHE_STATE_DISC) {
+			stats->disc_count++;
+		}
+		llcache_stats_consider_object(stats, object);
+	}
+
+	for (object = llcache->uncached_objects;
+	     object != NULL;
+	     object = object->next) {
+		stats->uncached_count++;
+		stats->size += total_object_size(object);
+	}
+
+	stats->hit_count = llcache->total.hit_count;
+	stats->revalidate_count = llcache->total.revalidate_count;
+	stats->miss_count = llcache->total.miss_count;
+	stats->evict_count = llcache->evict_count;
+	stats->evict_size = llcache->evict_size;
+	stats->total_written = llcache->total_written;
+	stats->total_elapsed = llcache->total_elapsed;
+
+	if ((guit->llcache->stats != NULL) &&
+	    (guit->llcache->stats(&stats->store) == NSERROR_OK)) {
+		stats->store_valid = true;
+	}
+
+	/* copy history out of the ring oldest first */
+	hidx = (llcache->history_next + LLCACHE_STATS_HISTORY -
+		llcache->history_len) % LLCACHE_STATS_HISTORY;
+	for (idx = 0; idx < llcache->history_len; idx++) {
+		stats->history[idx] = llcache->history[hidx];
+		hidx = (hidx + 1) % LLCACHE_STATS_HISTORY;
+	}
+	stats->history_len = llcache->history_len;
+
+	return NSERROR_OK;
+}
+
+
+/* Exported interface documented in content/llcache.h */
+void llcache_stats_release(struct llcache_stats *stats)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < stats->top_len; idx++) {
+		nsurl_unref(stats->top[idx].url);
+	}
+	stats->top_len = 0;
 }
 
+
 /* Exported interface documented in content/llcache.h */
 nserror
 llcache_initialise(const struct llcache_parameters *prm)
@@ -60,7 +60,9 @@ enum llcache_retrieve_flag {
 	/**< No error pages */
 	LLCACHE_RETRIEVE_NO_ERROR_PAGES = (1 << 2),
 	/**< Stream data (implies that object is not cacheable) */
-	LLCACHE_RETRIEVE_STREAM_DATA    = (1 << 3)
+	LLCACHE_RETRIEVE_STREAM_DATA    = (1 << 3),
+	/**< Only use cached data, never start a network fetch */
+	LLCACHE_RETRIEVE_CACHE_ONLY     = (1 << 4)
 };
 
 /** Low-level cache event types */
@@ -123,6 +125,89 @@ struct llcache_store_parameters {
 	size_t hysteresis; /**< The hysteresis around the target size */
 };
 
+/** number of buckets in the backing store latency histograms */
+#define LLCACHE_STORE_LATENCY_BUCKETS 8
+
+/**
+ * Low level cache backing store statistics.
+ *
+ * The latency histograms are log2 buckets of milliseconds, bucket n
+ * counts operations which took less than 2^n ms and the final bucket
+ * counts everything slower.
+ */
+struct llcache_store_stats {
+	uint64_t limit; /**< The backing store upper bound target size */
+	uint64_t total_alloc; /**< size of all allocated storage */
+	size_t entry_count; /**< number of entries in the store */
+
+	size_t hit_count; /**< number of retrievals satisfied */
+	uint64_t hit_size; /**< size of storage served */
+	size_t miss_count; /**< number of retrievals not satisfied */
+
+	size_t evict_runs; /**< number of times eviction was performed */
+	size_t evict_count; /**< number of entries evicted */
+	uint64_t evict_size; /**< size of entries evicted */
+
+	/** read latency histogram */
+	unsigned int read_latency[LLCACHE_STORE_LATENCY_BUCKETS];
+	/** write latency histogram */
+	unsigned int write_latency[LLCACHE_STORE_LATENCY_BUCKETS];
+};
+
+/** number of samples of cache activity retained in the history */
+#define LLCACHE_STATS_HISTORY 32
+
+/** number of the largest objects reported in the statistics */
+#define LLCACHE_STATS_TOP_OBJECTS 10
+
+/**
+ * Low level cache activity within a single sample period.
+ */
+struct llcache_stats_sample {
+	unsigned int hit_count; /**< retrievals satisfied by a fresh object */
+	unsigned int revalidate_count; /**< retrievals needing validation */
+	unsigned int miss_count; /**< retrievals requiring a fetch */
+};
+
+/**
+ * Low level cache statistics.
+ */
+struct llcache_stats {
+	size_t limit; /**< The target upper bound for the RAM cache size */
+	size_t size; /**< RAM in use by cache objects */
+	unsigned int object_count; /**< number of cacheable objects */
+	unsigned int uncached_count; /**< number of uncacheable objects */
+	unsigned int disc_count; /**< number of objects placed on disc */
+
+	unsigned int hit_count; /**< retrievals satisfied by a fresh object */
+	unsigned int revalidate_count; /**< retrievals needing validation */
+	unsigned int miss_count; /**< retrievals requiring a fetch */
+
+	unsigned int evict_count; /**< objects discarded to meet the limit */
+	uint64_t evict_size; /**< size of objects discarded */
+
+	uint64_t total_written; /**< bytes written to the backing store */
+	uint64_t total_elapsed; /**< ms taken writing to the backing store */
+
+	/** true if the backing store provided statistics */
+	bool store_valid;
+	/** backing store statistics */
+	struct llcache_store_stats store;
+
+	/** number of valid entries in the history */
+	unsigned int history_len;
+	/** cache activity history, oldest first */
+	struct llcache_stats_sample history[LLCACHE_STATS_HISTORY];
+
+	/** number of valid entries in the largest object table */
+	unsigned int top_len;
+	/** largest objects in the cache, largest first */
+	struct {
+		nsurl *url; /**< object url (referenced) */
+		size_t size; /**< object source data size */
+	} top[LLCACHE_STATS_TOP_OBJECTS];
+};
+
 /**
  * Parameters to configure the low level cache.
  */
@@ -177,6 +262,25 @@ void llcache_finalise(void);
  */
 void llcache_clean(bool purge);
 
+/**
+ * Obtain low level cache statistics.
+ *
+ * The largest object table holds references to the object urls which
+ * must be released with llcache_stats_release()
+ *
+ * \param stats The statistics structure to fill.
+ * \return NSERROR_OK on success, appropriate error otherwise.
+ */
+nserror llcache_get_stats(struct llcache_stats *stats);
+
+/**
+ * Release resources held by low level cache statistics.
+ *
+ * \param stats The statistics structure previously filled by
+ *              llcache_get_stats().
+ */
+void llcache_stats_release(struct llcache_stats *stats);
+
 /**
  * Retrieve a handle for a low-level cache object
  *
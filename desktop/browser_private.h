@@ -211,6 +211,9 @@ struct browser_window {
 	/** scale of window contents */
 	float scale;
 
+	/** Rendered tiles of a root window, or NULL if none are cached */
+	struct tile_cache *tile_cache;
+
 	/** Window characteristics */
 	enum {
 		BROWSER_WINDOW_NORMAL,
@@ -305,6 +308,16 @@ nserror browser_window_destroy_internal(struct browser_window *bw);
 nserror browser_window_get_dimensions(struct browser_window *bw,
 		int *width, int *height);
 
+/**
+ * Get the scroll offsets of a browser window
+ *
+ * \param  bw  The browser window to get the scroll offsets of
+ * \param  x   Updated to the unscaled horizontal scroll offset in px
+ * \param  y   Updated to the unscaled vertical scroll offset in px
+ * \return NSERROR_OK and x and y updated otherwise error code
+ */
+nserror browser_window_get_scroll(struct browser_window *bw, int *x, int *y);
+
 
 /**
  * Update the extent of the inside of a browser window to that of the current
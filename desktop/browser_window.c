@@ -61,6 +61,7 @@
 #include "desktop/textinput.h"
 #include "desktop/hotlist.h"
 #include "desktop/knockout.h"
+#include "desktop/tile_cache.h"
 #include "desktop/browser_history.h"
 
 /**
@@ -758,6 +759,7 @@ static void browser_window_update(struct browser_window *bw, bool scroll_to_top)
 			}
 		}
 
+		tile_cache_invalidate(bw->tile_cache, NULL);
 		guit->window->invalidate(bw->window, NULL);
 
 		break;
@@ -827,6 +829,7 @@ static nserror browser_window_content_ready(struct browser_window *bw)
 
 	bw->current_content = bw->loading_content;
 	bw->loading_content = NULL;
+	tile_cache_invalidate(bw->tile_cache, NULL);
 
 	if (!bw->internal_nav) {
 		/* Transfer the fetch parameters */
@@ -1320,6 +1323,41 @@ browser_window__handle_timeout(struct browser_window *bw, nsurl *url)
 }
 
 
+/**
+ * Handle an object being unavailable in offline mode
+ */
+static nserror
+browser_window__handle_offline(struct browser_window *bw, nsurl *url)
+{
+	struct browser_fetch_parameters params;
+	nserror err;
+
+	memset(&params, 0, sizeof(params));
+
+	params.url = nsurl_ref(corestring_nsurl_about_query_offline);
+	params.referrer = nsurl_ref(url);
+	params.flags = BW_NAVIGATE_HISTORY | BW_NAVIGATE_NO_TERMINAL_HISTORY_UPDATE | BW_NAVIGATE_INTERNAL;
+
+	err = fetch_multipart_data_new_kv(&params.post_multipart,
+					  "siteurl",
+					  nsurl_access(url));
+	if (err != NSERROR_OK) {
+		goto out;
+	}
+
+	/* Now we issue the fetch */
+	bw->internal_nav = true;
+	err = browser_window__navigate_internal(bw, &params);
+	if (err != NSERROR_OK) {
+		goto out;
+	}
+
+ out:
+	browser_window__free_fetch_parameters(&params);
+	return err;
+}
+
+
 /**
  * Handle non specific errors during a fetch
  */
@@ -1390,6 +1428,7 @@ browser_window__handle_error(struct browser_window *bw,
 		bw->loading_content = NULL;
 	} else if (c == bw->current_content) {
 		bw->current_content = NULL;
+		tile_cache_invalidate(bw->tile_cache, NULL);
 		browser_window_remove_caret(bw, false);
 	}
 
@@ -1408,6 +1447,10 @@ browser_window__handle_error(struct browser_window *bw,
 		res = browser_window__handle_timeout(bw, url);
 		break;
 
+	case NSERROR_NOT_CACHED:
+		res = browser_window__handle_offline(bw, url);
+		break;
+
 	default:
 		res = browser_window__handle_fetcherror(bw, message, url);
 		break;
@@ -1548,6 +1591,10 @@ browser_window_callback(hlcache_handle *c, const hlcache_event *event, void *pw)
 		/* Hide any caret, but don't remove it */
 		browser_window_remove_caret(bw, true);
 
+		/* Cached rendering is stale even if not redrawn yet */
+		tile_cache_invalidate(browser_window_get_root(bw)->tile_cache,
+				      NULL);
+
 		if (!(event->data.background)) {
 			/* Reformatted content should be redrawn */
 			browser_window_update(bw, false);
@@ -1840,6 +1887,9 @@ nserror browser_window_destroy_internal(struct browser_window *bw)
 		scrollbar_destroy(bw->scroll_y);
 	}
 
+	tile_cache_destroy(bw->tile_cache);
+	bw->tile_cache = NULL;
+
 	/* clear any pending callbacks */
 	guit->misc->schedule(-1, browser_window_refresh, bw);
 	NSLOG(netsurf, INFO,
@@ -1941,6 +1991,7 @@ browser_window_set_scale_internal(struct browser_window *bw, float scale)
 		return res;
 
 	bw->scale = scale;
+	tile_cache_invalidate(bw->tile_cache, NULL);
 
 	if (bw->current_content != NULL) {
 		if (content_can_reformat(bw->current_content) == false) {
@@ -2536,6 +2587,8 @@ is_internal_navigate_url(nsurl *url)
 					is_internal = true;
 				} else if (path == corestring_lwc_query_fetcherror) {
 					is_internal = true;
+				} else if (path == corestring_lwc_query_offline) {
+					is_internal = true;
 				}
 			}
 			lwc_string_unref(path);
@@ -2583,12 +2636,21 @@ browser_window_set_name(struct browser_window *bw, const char *name)
 }
 
 
-/* exported interface, documented in netsurf/browser_window.h */
-bool
-browser_window_redraw(struct browser_window *bw,
-		      int x, int y,
-		      const struct rect *clip,
-		      const struct redraw_context *ctx)
+/**
+ * Redraw an area of a browser window without the tile cache.
+ *
+ * \param bw   The window to redraw
+ * \param x    coordinate for top-left of redraw
+ * \param y    coordinate for top-left of redraw
+ * \param clip clip rectangle coordinates
+ * \param ctx  redraw context
+ * \return true if successful, false otherwise
+ */
+static bool
+browser_window_redraw_direct(struct browser_window *bw,
+			     int x, int y,
+			     const struct rect *clip,
+			     const struct redraw_context *ctx)
 {
 	struct redraw_context new_ctx = *ctx;
 	int width = 0;
@@ -2766,6 +2828,65 @@ browser_window_redraw(struct browser_window *bw,
 }
 
 
+/**
+ * Render an area of a browser window into a cached tile.
+ *
+ * \param pw   The browser window
+ * \param x    coordinate for top-left of redraw
+ * \param y    coordinate for top-left of redraw
+ * \param clip clip rectangle coordinates
+ * \param ctx  redraw context plotting into the tile
+ * \return true if successful, false otherwise
+ */
+static bool
+browser_window_redraw_tile(void *pw,
+			   int x, int y,
+			   const struct rect *clip,
+			   const struct redraw_context *ctx)
+{
+	return browser_window_redraw_direct(pw, x, y, clip, ctx);
+}
+
+
+/* exported interface, documented in netsurf/browser_window.h */
+bool
+browser_window_redraw(struct browser_window *bw,
+		      int x, int y,
+		      const struct rect *clip,
+		      const struct redraw_context *ctx)
+{
+	nserror res;
+
+	if ((bw == NULL) ||
+	    (bw->window == NULL) ||
+	    (!ctx->interactive) ||
+	    (!tile_cache_available())) {
+		/* Only the root window of screen redraws is cached */
+		if ((bw != NULL) && (bw->tile_cache != NULL)) {
+			tile_cache_destroy(bw->tile_cache);
+			bw->tile_cache = NULL;
+		}
+		return browser_window_redraw_direct(bw, x, y, clip, ctx);
+	}
+
+	if (bw->tile_cache == NULL) {
+		res = tile_cache_create(&bw->tile_cache);
+		if (res != NSERROR_OK) {
+			return browser_window_redraw_direct(bw, x, y,
+							    clip, ctx);
+		}
+	}
+
+	res = tile_cache_redraw(bw->tile_cache, x, y, clip, ctx,
+				browser_window_redraw_tile, bw);
+	if (res != NSERROR_OK) {
+		return browser_window_redraw_direct(bw, x, y, clip, ctx);
+	}
+
+	return true;
+}
+
+
 /* exported interface, documented in netsurf/browser_window.h */
 bool browser_window_redraw_ready(struct browser_window *bw)
 {
@@ -3782,6 +3903,42 @@ navigate_internal_query_fetcherror(struct browser_window *bw,
 }
 
 
+/**
+ * Internal navigation handler for the offline query page.
+ *
+ * If the parameters indicate we're processing a *response* from the handler
+ * then we deal with that, otherwise we pass it on to the about: handler
+ */
+static nserror
+navigate_internal_query_offline(struct browser_window *bw,
+				struct browser_fetch_parameters *params)
+{
+	bool is_retry = false, is_back = false;
+
+	NSLOG(netsurf, INFO, "bw:%p params:%p", bw, params);
+
+	assert(params->post_multipart != NULL);
+
+	is_retry = fetch_multipart_data_find(params->post_multipart, "retry") != NULL;
+	is_back = fetch_multipart_data_find(params->post_multipart, "back") != NULL;
+
+	if (is_back) {
+		/* do a rough-and-ready nav to the old 'current'
+		 * parameters, with any post data stripped away
+		 */
+		return browser_window__reload_current_parameters(bw);
+	}
+
+	if (is_retry) {
+		/* Finally navigate to the original loading parameters */
+		bw->internal_nav = false;
+		return navigate_internal_real(bw, &bw->loading_parameters);
+	}
+
+	return navigate_internal_real(bw, params);
+}
+
+
 /**
  * dispatch to internal query handlers or normal navigation
  *
@@ -3824,6 +3981,10 @@ browser_window__navigate_internal(struct browser_window *bw,
 		lwc_string_unref(path);
 		return navigate_internal_query_fetcherror(bw, params);
 	}
+	if (path == corestring_lwc_query_offline) {
+		lwc_string_unref(path);
+		return navigate_internal_query_offline(bw, params);
+	}
 	if (path != NULL) {
 		lwc_string_unref(path);
 	}
@@ -4007,6 +4168,32 @@ nserror browser_window_get_extents(struct browser_window *bw, bool scaled,
 }
 
 
+/* exported internal interface, documented in desktop/browser_private.h */
+nserror browser_window_get_scroll(struct browser_window *bw, int *x, int *y)
+{
+	assert(bw != NULL);
+
+	if (bw->window == NULL) {
+		/* Core managed browser window */
+		*x = scrollbar_get_offset(bw->scroll_x);
+		*y = scrollbar_get_offset(bw->scroll_y);
+		return NSERROR_OK;
+	}
+
+	/* Front end window */
+	if (!guit->window->get_scroll(bw->window, x, y)) {
+		*x = 0;
+		*y = 0;
+		return NSERROR_INVALID;
+	}
+
+	*x /= bw->scale;
+	*y /= bw->scale;
+
+	return NSERROR_OK;
+}
+
+
 /* exported internal interface, documented in desktop/browser_private.h */
 nserror
 browser_window_get_dimensions(struct browser_window *bw,
@@ -4074,6 +4261,8 @@ browser_window_invalidate_rect(struct browser_window *bw, struct rect *rect)
 	rect->x1 *= top->scale;
 	rect->y1 *= top->scale;
 
+	tile_cache_invalidate(top->tile_cache, rect);
+
 	return guit->window->invalidate(top->window, rect);
 }
 
@@ -160,6 +160,12 @@ nserror netsurf_init(const char *store_path)
 	/* image cache hysteresis is 20% of the image cache size */
 	image_cache_parameters.hysteresis = image_cache_parameters.limit / 5;
 
+	/* decode images outside of redraw */
+	image_cache_parameters.async = nsoption_bool(async_image_decode);
+
+	/* release image cache bitmaps by the cost of converting them */
+	image_cache_parameters.cost_aware = nsoption_bool(image_cache_cost_aware);
+
 	/* account for image cache use from total */
 	hlcache_parameters.llcache.limit -= image_cache_parameters.limit;
 
@@ -101,6 +101,9 @@ NSOPTION_UINT(disc_cache_size, 1024 * 1024 * 1024)
 /** Preferred expiry age of disc cache / days. */
 NSOPTION_INTEGER(disc_cache_age, 28)
 
+/** Whether to only satisfy retrievals from the cache */
+NSOPTION_BOOL(offline_mode, false)
+
 /** Whether to block advertisements */
 NSOPTION_BOOL(block_advertisements, false)
 
@@ -120,6 +123,12 @@ NSOPTION_BOOL(background_images, true)
 /** Whether to animate images */
 NSOPTION_BOOL(animate_images, true)
 
+/** Whether to defer fetching all images until they are near the viewport */
+NSOPTION_BOOL(lazy_load_images, false)
+
+/** Distance (in viewports) from the viewport to fetch deferred images */
+NSOPTION_UINT(lazy_load_distance, 2)
+
 /** Whether to execute javascript */
 NSOPTION_BOOL(enable_javascript, false)
 
@@ -180,6 +189,25 @@ NSOPTION_BOOL(incremental_reflow, true)
 /* Minimum time (in cs) between HTML reflows while objects are fetching */
 NSOPTION_UINT(min_reflow_period, DEFAULT_REFLOW_PERIOD)
 
+/* Whether to keep the layout of unchanged parts of web pages on reflow */
+NSOPTION_BOOL(incremental_layout, true)
+
+/* Whether to display web pages while they are still being parsed.
+ * Stylesheets found in the body once display has begun are not applied. */
+NSOPTION_BOOL(progressive_render, false)
+
+/* Time (in ms) to spend building the box tree before yielding */
+NSOPTION_UINT(box_conversion_slice, 8)
+
+/* Whether to decode images in the background instead of during redraw */
+NSOPTION_BOOL(async_image_decode, true)
+
+/* Whether the image cache weighs decode cost when releasing bitmaps */
+NSOPTION_BOOL(image_cache_cost_aware, true)
+
+/* Memory for cached rendered tiles of browser windows / bytes, 0 disables */
+NSOPTION_UINT(tile_cache_size, 0)
+
 /* use core selection menu */
 NSOPTION_BOOL(core_select_menu, false)
 
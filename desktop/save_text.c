@@ -135,18 +135,18 @@ void save_text_solve_whitespace(struct box *box, bool *first,
 			 box->type == BOX_FLOAT_LEFT ||
 			 box->type == BOX_FLOAT_RIGHT) &&
 			/* and not a list element */
-			!box->list_marker &&
+			!box->extra->list_marker &&
 			/* and not a marker... */
-			(!(box->parent && box->parent->list_marker == box) ||
+			(!(box->parent && box->parent->extra->list_marker == box) ||
 			 /* ...unless marker follows WHITESPACE_TAB */
-			 ((box->parent && box->parent->list_marker == box) &&
+			 ((box->parent && box->parent->extra->list_marker == box) &&
 			  *before == WHITESPACE_TAB))) {
 		*before = WHITESPACE_TWO_NEW_LINES;
 	} else if (*before <= WHITESPACE_ONE_NEW_LINE &&
 			(box->type == BOX_TABLE_ROW ||
 			 box->type == BOX_BR ||
 			 (box->type != BOX_INLINE &&
-			 (box->parent && box->parent->list_marker == box)) ||
+			 (box->parent && box->parent->extra->list_marker == box)) ||
 			 (box->parent && box->parent->style &&
 			  (css_computed_white_space(box->parent->style) ==
 			   CSS_WHITE_SPACE_PRE ||
@@ -160,7 +160,7 @@ void save_text_solve_whitespace(struct box *box, bool *first,
 	}
 	else if (*before < WHITESPACE_TAB &&
 			(box->type == BOX_TABLE_CELL ||
-			 box->list_marker)) {
+			 box->extra->list_marker)) {
 		*before = WHITESPACE_TAB;
 	}
 
@@ -221,10 +221,10 @@ void extract_text(struct box *box, bool *first, save_text_whitespace *before,
 	assert(box);
 
 	/* If box has a list marker */
-	if (box->list_marker) {
+	if (box->extra->list_marker) {
 		/* do the marker box before continuing with the rest of the
 		 * list element */
-		extract_text(box->list_marker, first, before, save);
+		extract_text(box->extra->list_marker, first, before, save);
 	}
 
 	/* read before calling the handler in case it modifies the tree */
@@ -0,0 +1,453 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Browser window rendered tile cache implementation.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "utils/errors.h"
+#include "utils/log.h"
+#include "utils/nsoption.h"
+#include "netsurf/types.h"
+#include "netsurf/bitmap.h"
+#include "netsurf/plotters.h"
+
+#include "desktop/gui_internal.h"
+#include "desktop/tile_cache.h"
+
+/** Width and height of a tile in pixels. */
+#define TILE_SIZE 256
+
+/** Bytes a tile is assumed to use when planning against the budget. */
+#define TILE_BYTES (TILE_SIZE * TILE_SIZE * 4)
+
+/** Number of hash buckets in each tile cache; must be a power of two. */
+#define TILE_CACHE_BUCKETS 64
+
+/**
+ * A rendered tile
+ */
+struct tile {
+	struct tile_cache *cache; /**< cache holding the tile */
+	int col; /**< column of tile, in tiles from the document origin */
+	int row; /**< row of tile, in tiles from the document origin */
+	struct bitmap *bitmap; /**< rendering of tile */
+	bool valid; /**< whether the rendering is up to date */
+
+	struct tile *hash_next; /**< next tile in hash bucket */
+	struct tile *lru_prev; /**< more recently plotted tile */
+	struct tile *lru_next; /**< less recently plotted tile */
+};
+
+/**
+ * Tiles of a browser window
+ */
+struct tile_cache {
+	struct tile *bucket[TILE_CACHE_BUCKETS]; /**< tiles by position */
+	unsigned int count; /**< number of tiles held */
+};
+
+/** Most recently plotted tile of every cache. */
+static struct tile *tile_lru_head;
+/** Least recently plotted tile of every cache. */
+static struct tile *tile_lru_tail;
+/** Total size of every cached tile in bytes. */
+static size_t tile_total_size;
+
+
+/**
+ * Divide rounding towards negative infinity.
+ */
+static inline int tile_floor_div(int a, int b)
+{
+	return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+
+/**
+ * Get the hash bucket of a tile position.
+ */
+static inline unsigned int tile_bucket(int col, int row)
+{
+	return ((unsigned int)col * 31 + (unsigned int)row) &
+		(TILE_CACHE_BUCKETS - 1);
+}
+
+
+/**
+ * Remove a tile from the recently plotted list.
+ */
+static void tile_lru_unlink(struct tile *tile)
+{
+	if (tile->lru_prev != NULL) {
+		tile->lru_prev->lru_next = tile->lru_next;
+	} else {
+		tile_lru_head = tile->lru_next;
+	}
+	if (tile->lru_next != NULL) {
+		tile->lru_next->lru_prev = tile->lru_prev;
+	} else {
+		tile_lru_tail = tile->lru_prev;
+	}
+	tile->lru_prev = NULL;
+	tile->lru_next = NULL;
+}
+
+
+/**
+ * Make a tile the most recently plotted.
+ */
+static void tile_lru_touch(struct tile *tile)
+{
+	if (tile_lru_head == tile) {
+		return;
+	}
+	if ((tile->lru_prev != NULL) || (tile->lru_next != NULL) ||
+	    (tile_lru_tail == tile)) {
+		tile_lru_unlink(tile);
+	}
+
+	tile->lru_next = tile_lru_head;
+	if (tile_lru_head != NULL) {
+		tile_lru_head->lru_prev = tile;
+	}
+	tile_lru_head = tile;
+	if (tile_lru_tail == NULL) {
+		tile_lru_tail = tile;
+	}
+}
+
+
+/**
+ * Find a tile in a cache.
+ */
+static struct tile *tile_find(struct tile_cache *cache, int col, int row)
+{
+	struct tile *tile;
+
+	for (tile = cache->bucket[tile_bucket(col, row)];
+	     tile != NULL;
+	     tile = tile->hash_next) {
+		if ((tile->col == col) && (tile->row == row)) {
+			return tile;
+		}
+	}
+	return NULL;
+}
+
+
+/**
+ * Release a tile, removing it from its cache.
+ */
+static void tile_free(struct tile *tile)
+{
+	struct tile_cache *cache = tile->cache;
+	struct tile **link;
+
+	link = &cache->bucket[tile_bucket(tile->col, tile->row)];
+	while (*link != tile) {
+		link = &(*link)->hash_next;
+	}
+	*link = tile->hash_next;
+	cache->count--;
+
+	tile_lru_unlink(tile);
+
+	guit->bitmap->destroy(tile->bitmap);
+	tile_total_size -= TILE_BYTES;
+
+	free(tile);
+}
+
+
+/**
+ * Get a tile from a cache, creating it if required.
+ *
+ * Creating a tile releases the least recently plotted tiles of any
+ * cache until the new tile fits the budget.
+ *
+ * \param cache tile cache
+ * \param col column of tile
+ * \param row row of tile
+ * \param budget memory budget in bytes
+ * \return the tile or NULL on memory exhaustion
+ */
+static struct tile *
+tile_get(struct tile_cache *cache, int col, int row, size_t budget)
+{
+	struct tile *tile;
+
+	tile = tile_find(cache, col, row);
+	if (tile != NULL) {
+		return tile;
+	}
+
+	while ((tile_lru_tail != NULL) &&
+	       (tile_total_size + TILE_BYTES > budget)) {
+		tile_free(tile_lru_tail);
+	}
+
+	tile = calloc(1, sizeof(*tile));
+	if (tile == NULL) {
+		return NULL;
+	}
+
+	tile->bitmap = guit->bitmap->create(TILE_SIZE, TILE_SIZE,
+					    BITMAP_OPAQUE);
+	if (tile->bitmap == NULL) {
+		free(tile);
+		return NULL;
+	}
+	guit->bitmap->set_opaque(tile->bitmap, true);
+	tile_total_size += TILE_BYTES;
+
+	tile->cache = cache;
+	tile->col = col;
+	tile->row = row;
+	tile->valid = false;
+	tile->hash_next = cache->bucket[tile_bucket(col, row)];
+	cache->bucket[tile_bucket(col, row)] = tile;
+	cache->count++;
+
+	return tile;
+}
+
+
+/**
+ * Render the content of a tile.
+ *
+ * \param tile tile to render
+ * \param ctx redraw context the tile will be plotted with
+ * \param render callback to render the tile
+ * \param pw private data for the callback
+ * \return NSERROR_OK on success else error code.
+ */
+static nserror
+tile_render(struct tile *tile,
+	    const struct redraw_context *ctx,
+	    tile_cache_render_cb *render,
+	    void *pw)
+{
+	struct redraw_context tile_ctx = {
+		.interactive = ctx->interactive,
+		.background_images = ctx->background_images,
+	};
+	struct rect clip = { 0, 0, TILE_SIZE, TILE_SIZE };
+	bool ok;
+	nserror res;
+
+	res = guit->bitmap->plot_start(tile->bitmap, &tile_ctx);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	ok = render(pw,
+		    -tile->col * TILE_SIZE,
+		    -tile->row * TILE_SIZE,
+		    &clip, &tile_ctx);
+
+	res = guit->bitmap->plot_end(tile->bitmap, &tile_ctx);
+	if (!ok) {
+		return NSERROR_INVALID;
+	}
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	guit->bitmap->modified(tile->bitmap);
+	tile->valid = true;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in desktop/tile_cache.h */
+bool tile_cache_available(void)
+{
+	return (guit->bitmap->plot_start != NULL) &&
+		(guit->bitmap->plot_end != NULL) &&
+		(nsoption_uint(tile_cache_size) >= TILE_BYTES);
+}
+
+
+/* exported interface documented in desktop/tile_cache.h */
+nserror tile_cache_create(struct tile_cache **cache_out)
+{
+	struct tile_cache *cache;
+
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		return NSERROR_NOMEM;
+	}
+
+	*cache_out = cache;
+
+	return NSERROR_OK;
+}
+
+
+/* exported interface documented in desktop/tile_cache.h */
+void tile_cache_destroy(struct tile_cache *cache)
+{
+	unsigned int bucket;
+
+	if (cache == NULL) {
+		return;
+	}
+
+	for (bucket = 0; bucket < TILE_CACHE_BUCKETS; bucket++) {
+		while (cache->bucket[bucket] != NULL) {
+			tile_free(cache->bucket[bucket]);
+		}
+	}
+
+	free(cache);
+}
+
+
+/* exported interface documented in desktop/tile_cache.h */
+void tile_cache_invalidate(struct tile_cache *cache, const struct rect *rect)
+{
+	struct tile *tile;
+	unsigned int bucket;
+	int col0, row0, col1, row1;
+	int col, row;
+
+	if ((cache == NULL) || (cache->count == 0)) {
+		return;
+	}
+
+	if (rect != NULL) {
+		if ((rect->x0 >= rect->x1) || (rect->y0 >= rect->y1)) {
+			return;
+		}
+
+		col0 = tile_floor_div(rect->x0, TILE_SIZE);
+		row0 = tile_floor_div(rect->y0, TILE_SIZE);
+		col1 = tile_floor_div(rect->x1 - 1, TILE_SIZE);
+		row1 = tile_floor_div(rect->y1 - 1, TILE_SIZE);
+
+		/* look up each tile when the area covers fewer tiles
+		 * than are held
+		 */
+		if ((unsigned int)(col1 - col0 + 1) *
+		    (unsigned int)(row1 - row0 + 1) <= cache->count) {
+			for (row = row0; row <= row1; row++) {
+				for (col = col0; col <= col1; col++) {
+					tile = tile_find(cache, col, row);
+					if (tile != NULL) {
+						tile->valid = false;
+					}
+				}
+			}
+			return;
+		}
+	} else {
+		col0 = row0 = 0;
+		col1 = row1 = -1;
+	}
+
+	for (bucket = 0; bucket < TILE_CACHE_BUCKETS; bucket++) {
+		for (tile = cache->bucket[bucket];
+		     tile != NULL;
+		     tile = tile->hash_next) {
+			if ((rect == NULL) ||
+			    ((tile->col >= col0) && (tile->col <= col1) &&
+			     (tile->row >= row0) && (tile->row <= row1))) {
+				tile->valid = false;
+			}
+		}
+	}
+}
+
+
+/* exported interface documented in desktop/tile_cache.h */
+nserror tile_cache_redraw(struct tile_cache *cache,
+		int x, int y,
+		const struct rect *clip,
+		const struct redraw_context *ctx,
+		tile_cache_render_cb *render,
+		void *pw)
+{
+	size_t budget = nsoption_uint(tile_cache_size);
+	struct tile *tile;
+	int col0, row0, col1, row1;
+	int col, row;
+	nserror res;
+
+	if ((clip->x0 >= clip->x1) || (clip->y0 >= clip->y1)) {
+		return NSERROR_OK;
+	}
+
+	col0 = tile_floor_div(clip->x0 - x, TILE_SIZE);
+	row0 = tile_floor_div(clip->y0 - y, TILE_SIZE);
+	col1 = tile_floor_div(clip->x1 - x - 1, TILE_SIZE);
+	row1 = tile_floor_div(clip->y1 - y - 1, TILE_SIZE);
+
+	/* every tile of the area must fit or they would evict each other */
+	if ((size_t)(col1 - col0 + 1) * (size_t)(row1 - row0 + 1) *
+	    TILE_BYTES > budget) {
+		return NSERROR_NOSPACE;
+	}
+
+	res = ctx->plot->clip(ctx, clip);
+	if (res != NSERROR_OK) {
+		return res;
+	}
+
+	for (row = row0; row <= row1; row++) {
+		for (col = col0; col <= col1; col++) {
+			tile = tile_get(cache, col, row, budget);
+			if (tile == NULL) {
+				return NSERROR_NOMEM;
+			}
+			tile_lru_touch(tile);
+
+			if (!tile->valid) {
+				res = tile_render(tile, ctx, render, pw);
+				if (res != NSERROR_OK) {
+					NSLOG(netsurf, INFO,
+					      "unable to render tile %d,%d",
+					      col, row);
+					return res;
+				}
+				/* the render may have changed the clip */
+				res = ctx->plot->clip(ctx, clip);
+				if (res != NSERROR_OK) {
+					return res;
+				}
+			}
+
+			res = ctx->plot->bitmap(ctx, tile->bitmap,
+					x + col * TILE_SIZE,
+					y + row * TILE_SIZE,
+					TILE_SIZE, TILE_SIZE,
+					0xffffff, BITMAPF_NONE);
+			if (res != NSERROR_OK) {
+				return res;
+			}
+		}
+	}
+
+	return NSERROR_OK;
+}
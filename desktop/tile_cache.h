@@ -0,0 +1,116 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Browser window rendered tile cache interface.
+ *
+ * A tile cache holds the rendering of a browser window in fixed size
+ * bitmap tiles, positioned in document pixels (content coordinates
+ * multiplied by the window scale). Redraws plot the cached tiles and
+ * only render tiles which are missing or have been invalidated, so
+ * scrolling does not need the content to be redrawn.
+ *
+ * Tiles are rendered through the optional plot_start and plot_end
+ * entries of the frontend bitmap table. The tiles of every cache
+ * share a single memory budget set by the tile_cache_size option;
+ * the least recently plotted tiles are released first.
+ */
+
+#ifndef NETSURF_DESKTOP_TILE_CACHE_H
+#define NETSURF_DESKTOP_TILE_CACHE_H
+
+struct tile_cache;
+struct redraw_context;
+struct rect;
+
+/**
+ * Callback to render an area into a tile.
+ *
+ * \param pw   private data passed to tile_cache_redraw()
+ * \param x    coordinate of the document origin
+ * \param y    coordinate of the document origin
+ * \param clip area of the tile to render
+ * \param ctx  redraw context plotting into the tile
+ * \return true if successful, false otherwise
+ */
+typedef bool (tile_cache_render_cb)(void *pw, int x, int y,
+		const struct rect *clip, const struct redraw_context *ctx);
+
+
+/**
+ * Determine if tiles can be cached.
+ *
+ * \return true if the frontend can render into bitmaps and the tile
+ *         cache has a memory budget
+ */
+bool tile_cache_available(void);
+
+
+/**
+ * Create an empty tile cache.
+ *
+ * \param cache_out updated to the new tile cache
+ * \return NSERROR_OK on success or NSERROR_NOMEM on memory exhaustion
+ */
+nserror tile_cache_create(struct tile_cache **cache_out);
+
+
+/**
+ * Destroy a tile cache and all its tiles.
+ *
+ * \param cache tile cache to destroy, may be NULL
+ */
+void tile_cache_destroy(struct tile_cache *cache);
+
+
+/**
+ * Mark tiles as needing to be rendered again.
+ *
+ * \param cache tile cache, may be NULL
+ * \param rect  area which has changed in document pixels, or NULL
+ *              for the whole document
+ */
+void tile_cache_invalidate(struct tile_cache *cache, const struct rect *rect);
+
+
+/**
+ * Redraw an area from a tile cache.
+ *
+ * Tiles which are not cached are rendered with the callback before
+ * being plotted.
+ *
+ * \param cache  tile cache
+ * \param x      coordinate of the document origin in the target
+ * \param y      coordinate of the document origin in the target
+ * \param clip   area to redraw in target coordinates
+ * \param ctx    redraw context to plot the tiles with
+ * \param render callback to render tiles
+ * \param pw     private data for the callback
+ * \return NSERROR_OK if the area was redrawn, NSERROR_NOSPACE if the
+ *         budget cannot hold the area or another error code. On
+ *         error the area must be redrawn without the cache.
+ */
+nserror tile_cache_redraw(struct tile_cache *cache,
+		int x, int y,
+		const struct rect *clip,
+		const struct redraw_context *ctx,
+		tile_cache_render_cb *render,
+		void *pw);
+
+#endif
@@ -175,7 +175,8 @@ static char *amiga_dt_picture_datatype(struct content *c)
 	return filetype;
 }
 
-static struct bitmap *amiga_dt_picture_cache_convert(struct content *c)
+static struct bitmap *amiga_dt_picture_cache_convert(struct content *c,
+		int target_width, int target_height)
 {
 	NSLOG(netsurf, INFO, "amiga_dt_picture_cache_convert");
 
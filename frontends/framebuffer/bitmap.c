@@ -30,6 +30,7 @@
 
 #include "utils/log.h"
 #include "utils/utils.h"
+#include "utils/pixel.h"
 #include "netsurf/bitmap.h"
 #include "netsurf/plotters.h"
 #include "netsurf/content.h"
@@ -128,6 +129,7 @@ static void bitmap_destroy(void *bitmap)
 
 	assert(bm != NULL);
 
+	framebuffer_pattern_invalidate(bm);
 	nsfb_free(bm);
 }
 
@@ -152,6 +154,7 @@ static bool bitmap_save(void *bitmap, const char *path, unsigned flags)
  * \param  bitmap  a bitmap, as returned by bitmap_create()
  */
 static void bitmap_modified(void *bitmap) {
+	framebuffer_pattern_invalidate(bitmap);
 }
 
 /**
@@ -182,7 +185,6 @@ static void bitmap_set_opaque(void *bitmap, bool opaque)
  */
 static bool bitmap_test_opaque(void *bitmap)
 {
-        int tst;
 	nsfb_t *bm = bitmap;
 	unsigned char *bmpptr;
 	int width;
@@ -194,15 +196,11 @@ static bool bitmap_test_opaque(void *bitmap)
 
 	nsfb_get_geometry(bm, &width, &height, NULL);
 
-        tst = width * height;
-
-        while (tst-- > 0) {
-                if (bmpptr[(tst << 2) + 3] != 0xff) {
-                        NSLOG(netsurf, INFO, "bitmap %p has transparency", bm);
-                        return false;
-                }
-        }
-        NSLOG(netsurf, INFO, "bitmap %p is opaque", bm);
+	if (!pixel_opaque(bmpptr, width * height)) {
+		NSLOG(netsurf, INFO, "bitmap %p has transparency", bm);
+		return false;
+	}
+	NSLOG(netsurf, INFO, "bitmap %p is opaque", bm);
 	return true;
 }
 
@@ -321,12 +319,55 @@ bitmap_render(struct bitmap *bitmap,
 	loc.y1 = height;
 
 	nsfb_plot_copy(bm, NULL, tbm, &loc);
+	framebuffer_pattern_invalidate(tbm);
 
 	nsfb_free(bm);
 
 	return NSERROR_OK;
 }
 
+/** Surface being plotted to before bitmap_plot_start() */
+static nsfb_t *bitmap_plot_previous;
+
+/**
+ * Start plotting into a bitmap.
+ *
+ * \param bitmap the bitmap to plot into
+ * \param ctx redraw context to update
+ * \return NSERROR_OK on success else error code
+ */
+static nserror
+bitmap_plot_start(struct bitmap *bitmap, struct redraw_context *ctx)
+{
+	if (bitmap_plot_previous != NULL) {
+		/* plotting into bitmaps does not nest */
+		return NSERROR_INVALID;
+	}
+
+	bitmap_plot_previous = framebuffer_set_surface((nsfb_t *)bitmap);
+	ctx->plot = &fb_plotters;
+	ctx->priv = NULL;
+
+	return NSERROR_OK;
+}
+
+/**
+ * Finish plotting into a bitmap.
+ *
+ * \param bitmap the bitmap plotted into
+ * \param ctx redraw context set up by bitmap_plot_start()
+ * \return NSERROR_OK on success else error code
+ */
+static nserror
+bitmap_plot_end(struct bitmap *bitmap, const struct redraw_context *ctx)
+{
+	framebuffer_set_surface(bitmap_plot_previous);
+	bitmap_plot_previous = NULL;
+	framebuffer_pattern_invalidate((nsfb_t *)bitmap);
+
+	return NSERROR_OK;
+}
+
 static struct gui_bitmap_table bitmap_table = {
 	.create = bitmap_create,
 	.destroy = bitmap_destroy,
@@ -341,6 +382,8 @@ static struct gui_bitmap_table bitmap_table = {
 	.save = bitmap_save,
 	.modified = bitmap_modified,
 	.render = bitmap_render,
+	.plot_start = bitmap_plot_start,
+	.plot_end = bitmap_plot_end,
 };
 
 struct gui_bitmap_table *framebuffer_bitmap_table = &bitmap_table;
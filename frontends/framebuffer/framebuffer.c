@@ -276,6 +276,179 @@ framebuffer_plot_path(const struct redraw_context *ctx,
 }
 
 
+/** Number of expanded tile patterns kept */
+#define PATTERN_CACHE_SIZE 8
+
+/** Width or height an expanded tile pattern is made at least */
+#define PATTERN_MIN_SIZE 128
+
+/** Largest expanded tile pattern in pixels */
+#define PATTERN_MAX_PIXELS (256 * 256)
+
+/**
+ * A bitmap tile replicated to form a larger pattern.
+ *
+ * Tiling a small bitmap over a large area plots a great many tiles.
+ * Plotting a pattern of several copies of the tile instead gives
+ * identical results with far fewer plots.
+ */
+struct pattern {
+	nsfb_t *bm; /**< bitmap the pattern was made from or NULL */
+	bool repeat_x; /**< bitmap is replicated horizontally */
+	bool repeat_y; /**< bitmap is replicated vertically */
+	nsfb_colour_t *pixels; /**< pattern pixels */
+	int width; /**< pattern width */
+	int height; /**< pattern height */
+	unsigned int used; /**< plot count when last used */
+};
+
+/** Recently used tile patterns */
+static struct pattern pattern_cache[PATTERN_CACHE_SIZE];
+
+/** Number of pattern plots performed */
+static unsigned int pattern_plots;
+
+
+/**
+ * Release an expanded tile pattern.
+ *
+ * \param pattern The pattern to release.
+ */
+static void pattern_free(struct pattern *pattern)
+{
+	free(pattern->pixels);
+	pattern->pixels = NULL;
+	pattern->bm = NULL;
+}
+
+
+/* exported interface documented in framebuffer/framebuffer.h */
+void framebuffer_pattern_invalidate(nsfb_t *bm)
+{
+	unsigned int idx;
+
+	for (idx = 0; idx < PATTERN_CACHE_SIZE; idx++) {
+		if (pattern_cache[idx].bm == bm) {
+			pattern_free(&pattern_cache[idx]);
+		}
+	}
+}
+
+
+/**
+ * Fill a buffer by repeatedly copying its initial span.
+ *
+ * The copied span doubles each time so a long buffer is filled with
+ * a few large copies.
+ *
+ * \param buf The buffer to fill.
+ * \param span The length of the initial span.
+ * \param len The length of the buffer.
+ */
+static void pattern_replicate(unsigned char *buf, size_t span, size_t len)
+{
+	while (span < len) {
+		memcpy(buf + span, buf, min(span, len - span));
+		span *= 2;
+	}
+}
+
+
+/**
+ * Get an expanded tile pattern for a bitmap.
+ *
+ * The pattern holds enough copies of the bitmap in each repeating
+ * direction to make it at least PATTERN_MIN_SIZE pixels, while not
+ * exceeding PATTERN_MAX_PIXELS in total.
+ *
+ * \param bm The bitmap to replicate.
+ * \param repeat_x Whether the bitmap repeats horizontally.
+ * \param repeat_y Whether the bitmap repeats vertically.
+ * \return The pattern or NULL if the bitmap is not worth replicating.
+ */
+static struct pattern *
+pattern_get(nsfb_t *bm, bool repeat_x, bool repeat_y)
+{
+	struct pattern *pattern = NULL;
+	nsfb_colour_t *pixels;
+	unsigned char *bmptr;
+	int bmwidth, bmheight, bmstride;
+	int copies_x = 1;
+	int copies_y = 1;
+	unsigned int idx;
+	size_t rowlen;
+	int row;
+
+	for (idx = 0; idx < PATTERN_CACHE_SIZE; idx++) {
+		if (pattern_cache[idx].bm == bm &&
+		    pattern_cache[idx].repeat_x == repeat_x &&
+		    pattern_cache[idx].repeat_y == repeat_y) {
+			pattern = &pattern_cache[idx];
+			pattern->used = ++pattern_plots;
+			return pattern;
+		}
+		if (pattern == NULL ||
+		    pattern_cache[idx].used < pattern->used) {
+			pattern = &pattern_cache[idx];
+		}
+	}
+
+	nsfb_get_geometry(bm, &bmwidth, &bmheight, NULL);
+	nsfb_get_buffer(bm, &bmptr, &bmstride);
+
+	if (repeat_x && bmwidth < PATTERN_MIN_SIZE) {
+		copies_x = (PATTERN_MIN_SIZE + bmwidth - 1) / bmwidth;
+	}
+	if (repeat_y && bmheight < PATTERN_MIN_SIZE) {
+		copies_y = (PATTERN_MIN_SIZE + bmheight - 1) / bmheight;
+	}
+	while ((copies_x * copies_y > 1) &&
+	       (copies_x * bmwidth * copies_y * bmheight > PATTERN_MAX_PIXELS)) {
+		if (copies_x >= copies_y) {
+			copies_x /= 2;
+		} else {
+			copies_y /= 2;
+		}
+	}
+	if (copies_x * copies_y < 4) {
+		/* too few tiles are saved to be worthwhile */
+		return NULL;
+	}
+
+	pixels = malloc(copies_x * bmwidth * copies_y * bmheight *
+			sizeof(nsfb_colour_t));
+	if (pixels == NULL) {
+		return NULL;
+	}
+
+	pattern_free(pattern);
+	pattern->bm = bm;
+	pattern->repeat_x = repeat_x;
+	pattern->repeat_y = repeat_y;
+	pattern->pixels = pixels;
+	pattern->width = copies_x * bmwidth;
+	pattern->height = copies_y * bmheight;
+	pattern->used = ++pattern_plots;
+
+	/* replicate each row of the bitmap across the pattern */
+	rowlen = pattern->width * sizeof(nsfb_colour_t);
+	for (row = 0; row < bmheight; row++) {
+		unsigned char *dst = (unsigned char *)pixels + row * rowlen;
+
+		memcpy(dst, bmptr + row * bmstride,
+		       bmwidth * sizeof(nsfb_colour_t));
+		pattern_replicate(dst, bmwidth * sizeof(nsfb_colour_t), rowlen);
+	}
+
+	/* replicate those rows down the pattern */
+	pattern_replicate((unsigned char *)pixels,
+			  bmheight * rowlen,
+			  pattern->height * rowlen);
+
+	return pattern;
+}
+
+
 /**
  * Plot a bitmap
  *
@@ -370,6 +543,21 @@ framebuffer_plot_bitmap(const struct redraw_context *ctx,
 		}
 	}
 
+	/* Plot unscaled tiles of small bitmaps as an expanded pattern of
+	 * several tiles. The pattern is aligned with the tiles so the
+	 * result is identical. */
+	if ((width == bmwidth) && (height == bmheight)) {
+		struct pattern *pattern;
+
+		pattern = pattern_get(bm, repeat_x, repeat_y);
+		if (pattern != NULL) {
+			bmptr = (unsigned char *)pattern->pixels;
+			bmstride = pattern->width * sizeof(nsfb_colour_t);
+			bmwidth = width = pattern->width;
+			bmheight = height = pattern->height;
+		}
+	}
+
 	/* get left most tile position */
 	if (repeat_x) {
 		for (; x > clipbox.x0; x -= width);
@@ -637,6 +825,12 @@ framebuffer_resize(nsfb_t *nsfb, int width, int height, int bpp)
 void
 framebuffer_finalise(void)
 {
+    unsigned int idx;
+
+    for (idx = 0; idx < PATTERN_CACHE_SIZE; idx++) {
+	    pattern_free(&pattern_cache[idx]);
+    }
+
     nsfb_free(nsfb);
 }
 
@@ -37,4 +37,13 @@ bool framebuffer_set_cursor(struct fbtk_bitmap *bm);
  */
 nsfb_t *framebuffer_set_surface(nsfb_t *new_nsfb);
 
+/**
+ * Discard any expanded tile pattern made from a bitmap.
+ *
+ * Must be called whenever the pixels of a bitmap change or it is freed.
+ *
+ * \param bm The bitmap whose patterns are discarded.
+ */
+void framebuffer_pattern_invalidate(nsfb_t *bm);
+
 #endif
@@ -566,6 +566,9 @@ static nserror set_defaults(struct nsoption_s *defaults)
 		return NSERROR_BAD_PARAMETER;
 	}
 
+	/* unaccelerated surfaces scroll from cached page tiles */
+	nsoption_set_uint(tile_cache_size, 16 * 1024 * 1024);
+
 	/* set system colours for framebuffer ui */
 	nsoption_set_colour(sys_colour_ActiveBorder, 0x00000000);
 	nsoption_set_colour(sys_colour_ActiveCaption, 0x00ddddcc);
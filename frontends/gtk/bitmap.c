@@ -32,6 +32,7 @@
 
 #include "utils/utils.h"
 #include "utils/errors.h"
+#include "utils/pixel.h"
 #include "netsurf/content.h"
 #include "netsurf/bitmap.h"
 #include "netsurf/plotters.h"
@@ -135,7 +136,6 @@ static bool bitmap_test_opaque(void *vbitmap)
 	struct bitmap *gbitmap = (struct bitmap *)vbitmap;
 	unsigned char *pixels;
 	int pcount;
-	int ploop;
 
 	assert(gbitmap);
 
@@ -144,13 +144,7 @@ static bool bitmap_test_opaque(void *vbitmap)
 	pcount = cairo_image_surface_get_stride(gbitmap->surface) *
 		cairo_image_surface_get_height(gbitmap->surface);
 
-	for (ploop = 3; ploop < pcount; ploop += 4) {
-		if (pixels[ploop] != 0xff) {
-			return false;
-		}
-	}
-
-	return true;
+	return pixel_opaque(pixels, pcount / 4);
 }
 
 
@@ -187,10 +181,8 @@ static bool bitmap_get_opaque(void *vbitmap)
 static unsigned char *bitmap_get_buffer(void *vbitmap)
 {
 	struct bitmap *gbitmap = (struct bitmap *)vbitmap;
-	int pixel_loop;
 	int pixel_count;
 	uint8_t *pixels;
-	uint32_t t, r, g, b;
 	cairo_format_t fmt;
 
 	assert(gbitmap);
@@ -205,61 +197,18 @@ static unsigned char *bitmap_get_buffer(void *vbitmap)
 	pixel_count = cairo_image_surface_get_width(gbitmap->surface) *
 			cairo_image_surface_get_height(gbitmap->surface);
 
-	if (fmt == CAIRO_FORMAT_RGB24) {
-		/* Opaque image */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-			/* Cairo surface is ARGB, written in native endian */
+	/* Cairo surface is ARGB, written in native endian. Core bitmaps
+	 * always have a component order of rgba, regardless of system
+	 * endianness */
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			b = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			r = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
+	pixel_swizzle(pixels, pixel_count, PIXEL_SWIZZLE_SWAP_RB);
 #else
-			t = pixels[4 * pixel_loop + 0];
-			r = pixels[4 * pixel_loop + 1];
-			g = pixels[4 * pixel_loop + 2];
-			b = pixels[4 * pixel_loop + 3];
+	pixel_swizzle(pixels, pixel_count, PIXEL_SWIZZLE_ARGB_TO_RGBA);
 #endif
 
-			/* Core bitmaps always have a component order of rgba,
-			 * regardless of system endianness */
-			pixels[4 * pixel_loop + 0] = r;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = b;
-			pixels[4 * pixel_loop + 3] = t;
-		}
-	} else {
+	if (fmt != CAIRO_FORMAT_RGB24) {
 		/* Alpha image: de-multiply alpha */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			b = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			r = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
-#else
-			t = pixels[4 * pixel_loop + 0];
-			r = pixels[4 * pixel_loop + 1];
-			g = pixels[4 * pixel_loop + 2];
-			b = pixels[4 * pixel_loop + 3];
-#endif
-
-			if (t != 0) {
-				r = (r << 8) / t;
-				g = (g << 8) / t;
-				b = (b << 8) / t;
-
-				r = (r > 255) ? 255 : r;
-				g = (g > 255) ? 255 : g;
-				b = (b > 255) ? 255 : b;
-			} else {
-				r = g = b = 0;
-			}
-
-			pixels[4 * pixel_loop + 0] = r;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = b;
-			pixels[4 * pixel_loop + 3] = t;
-		}
+		pixel_unpremultiply(pixels, pixel_count);
 	}
 
 	gbitmap->converted = false;
@@ -344,10 +293,8 @@ static bool bitmap_save(void *vbitmap, const char *path, unsigned flags)
 static void bitmap_modified(void *vbitmap)
 {
 	struct bitmap *gbitmap = (struct bitmap *)vbitmap;
-	int pixel_loop;
 	int pixel_count;
 	uint8_t *pixels;
-	uint32_t t, r, g, b;
 	cairo_format_t fmt;
 
 	assert(gbitmap);
@@ -363,58 +310,19 @@ static void bitmap_modified(void *vbitmap)
 		return;
 	}
 
-	if (fmt == CAIRO_FORMAT_RGB24) {
-		/* Opaque image */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-			/* Core bitmaps always have a component order of rgba,
-			 * regardless of system endianness */
-			r = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			b = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
-
-			/* Cairo surface is ARGB, written in native endian */
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			pixels[4 * pixel_loop + 0] = b;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = r;
-			pixels[4 * pixel_loop + 3] = t;
-#else
-			pixels[4 * pixel_loop + 0] = t;
-			pixels[4 * pixel_loop + 1] = r;
-			pixels[4 * pixel_loop + 2] = g;
-			pixels[4 * pixel_loop + 3] = b;
-#endif
-		}
-	} else {
+	if (fmt != CAIRO_FORMAT_RGB24) {
 		/* Alpha image: pre-multiply alpha */
-		for (pixel_loop=0; pixel_loop < pixel_count; pixel_loop++) {
-			r = pixels[4 * pixel_loop + 0];
-			g = pixels[4 * pixel_loop + 1];
-			b = pixels[4 * pixel_loop + 2];
-			t = pixels[4 * pixel_loop + 3];
-
-			if (t != 0) {
-				r = ((r * (t + 1)) >> 8) & 0xff;
-				g = ((g * (t + 1)) >> 8) & 0xff;
-				b = ((b * (t + 1)) >> 8) & 0xff;
-			} else {
-				r = g = b = 0;
-			}
+		pixel_premultiply(pixels, pixel_count);
+	}
 
+	/* Core bitmaps always have a component order of rgba, regardless
+	 * of system endianness. Cairo surface is ARGB, written in native
+	 * endian */
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
-			pixels[4 * pixel_loop + 0] = b;
-			pixels[4 * pixel_loop + 1] = g;
-			pixels[4 * pixel_loop + 2] = r;
-			pixels[4 * pixel_loop + 3] = t;
+	pixel_swizzle(pixels, pixel_count, PIXEL_SWIZZLE_SWAP_RB);
 #else
-			pixels[4 * pixel_loop + 0] = t;
-			pixels[4 * pixel_loop + 1] = r;
-			pixels[4 * pixel_loop + 2] = g;
-			pixels[4 * pixel_loop + 3] = b;
+	pixel_swizzle(pixels, pixel_count, PIXEL_SWIZZLE_RGBA_TO_ARGB);
 #endif
-		}
-	}
 
 	cairo_surface_mark_dirty(gbitmap->surface);
 
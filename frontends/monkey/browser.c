@@ -697,6 +697,52 @@ monkey_window_handle_click(int argc, char **argv)
 	}
 }
 
+static void
+monkey_window_handle_move(int argc, char **argv)
+{
+	/* `WINDOW MOVE WIN` _%id%_ `X` _%num%_ `Y` _%num%_ */
+	/*  0      1    2    3       4  5        6  7        */
+	struct gui_window *gw;
+	if (argc != 8) {
+		moutf(MOUT_ERROR, "WINDOW MOVE ARGS BAD\n");
+		return;
+	}
+
+	gw = monkey_find_window_by_num(atoi(argv[2]));
+
+	if (gw == NULL) {
+		moutf(MOUT_ERROR, "WINDOW NUM BAD");
+	} else {
+		browser_window_mouse_track(gw->bw, 0,
+					   atoi(argv[5]), atoi(argv[7]));
+	}
+}
+
+static void
+monkey_window_handle_resize(int argc, char **argv)
+{
+	/* `WINDOW RESIZE WIN` _%id%_ `WIDTH` _%num%_ `HEIGHT` _%num%_ */
+	/*  0      1      2    3       4       5        6        7        */
+	struct gui_window *gw;
+	if (argc != 8) {
+		moutf(MOUT_ERROR, "WINDOW RESIZE ARGS BAD\n");
+		return;
+	}
+
+	gw = monkey_find_window_by_num(atoi(argv[3]));
+
+	if (gw == NULL) {
+		moutf(MOUT_ERROR, "WINDOW NUM BAD");
+	} else {
+		gw->width = atoi(argv[5]);
+		gw->height = atoi(argv[7]);
+		moutf(MOUT_WINDOW,
+		      "SIZE WIN %u WIDTH %d HEIGHT %d",
+		      gw->win_num, gw->width, gw->height);
+		browser_window_schedule_reformat(gw->bw);
+	}
+}
+
 void
 monkey_window_handle_command(int argc, char **argv)
 {
@@ -719,6 +765,10 @@ monkey_window_handle_command(int argc, char **argv)
 		monkey_window_handle_exec(argc, argv);
 	} else if (strcmp(argv[1], "CLICK") == 0) {
 		monkey_window_handle_click(argc, argv);
+	} else if (strcmp(argv[1], "MOVE") == 0) {
+		monkey_window_handle_move(argc, argv);
+	} else if (strcmp(argv[1], "RESIZE") == 0) {
+		monkey_window_handle_resize(argc, argv);
 	} else {
 		moutf(MOUT_ERROR, "WINDOW COMMAND UNKNOWN %s\n", argv[1]);
 	}
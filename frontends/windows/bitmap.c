@@ -30,6 +30,7 @@
 #include <windows.h>
 
 #include "utils/log.h"
+#include "utils/pixel.h"
 #include "netsurf/bitmap.h"
 #include "netsurf/plotters.h"
 #include "netsurf/content.h"
@@ -214,7 +215,6 @@ static void bitmap_set_opaque(void *bitmap, bool opaque)
  */
 static bool bitmap_test_opaque(void *bitmap)
 {
-	int tst;
 	struct bitmap *bm = bitmap;
 
 	if (bitmap == NULL) {
@@ -222,13 +222,9 @@ static bool bitmap_test_opaque(void *bitmap)
 		return false;
 	}
 
-	tst = bm->width * bm->height;
-
-	while (tst-- > 0) {
-		if (bm->pixdata[(tst << 2) + 3] != 0xff) {
-			NSLOG(netsurf, INFO, "bitmap %p has transparency", bm);
-			return false;
-		}
+	if (!pixel_opaque(bm->pixdata, bm->width * bm->height)) {
+		NSLOG(netsurf, INFO, "bitmap %p has transparency", bm);
+		return false;
 	}
 	NSLOG(netsurf, INFO, "bitmap %p is opaque", bm);
 	return true;
@@ -62,6 +62,7 @@
 struct content;
 struct bitmap;
 struct hlcache_handle;
+struct redraw_context;
 
 /**
  * Bitmap operations.
@@ -172,6 +173,31 @@ struct gui_bitmap_table {
 	 * \param content The content to render.
 	 */
 	nserror (*render)(struct bitmap *bitmap, struct hlcache_handle *content);
+
+	/* Optional entries */
+
+	/**
+	 * Start plotting into a bitmap.
+	 *
+	 * Sets the plotter table and private data of a redraw context
+	 * so that plot operations draw into the bitmap until
+	 * plot_end is called. Without this the core cannot cache
+	 * rendered tiles of browser windows.
+	 *
+	 * \param bitmap The bitmap to plot into.
+	 * \param ctx The redraw context to update.
+	 * \return NSERROR_OK on success else error code.
+	 */
+	nserror (*plot_start)(struct bitmap *bitmap, struct redraw_context *ctx);
+
+	/**
+	 * Finish plotting into a bitmap.
+	 *
+	 * \param bitmap The bitmap plotted into.
+	 * \param ctx The redraw context set up by plot_start.
+	 * \return NSERROR_OK on success else error code.
+	 */
+	nserror (*plot_end)(struct bitmap *bitmap, const struct redraw_context *ctx);
 };
 
 #endif
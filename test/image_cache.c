@@ -0,0 +1,541 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Test image cache replacement.
+ *
+ * Recorded sequences of cache operations are replayed against the
+ * image cache and the hit ratio it reports is checked. The background
+ * cleaner is run by the trace instead of by a timer so the results do
+ * not depend on how long the conversions take.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <check.h>
+
+#include "utils/errors.h"
+#include "netsurf/misc.h"
+#include "netsurf/bitmap.h"
+#include "netsurf/content.h"
+#include "netsurf/plotters.h"
+#include "content/llcache.h"
+#include "content/content.h"
+#include "content/content_protected.h"
+#include "desktop/gui_table.h"
+#include "desktop/gui_internal.h"
+
+#include "image/image_cache.h"
+#include "image/image.h"
+
+#define NELEMS(x)  (sizeof(x) / sizeof((x)[0]))
+
+/** Interval of the background cleaner in ms */
+#define TEST_CLEAN_TIME 5000
+
+/** Size of the test image bitmaps in bytes */
+#define TEST_BITMAP_SIZE(w, h) ((w) * (h) * 4)
+
+struct netsurf_table *guit = NULL;
+
+/**
+ * Image held in the cache by a test trace.
+ */
+struct test_image {
+	int width; /**< image width */
+	int height; /**< image height */
+	unsigned int cost; /**< conversion time in ms */
+	int source; /**< source data shared with this image or -1 */
+};
+
+/**
+ * Operations a trace is made of.
+ */
+enum test_op {
+	TEST_OP_ADD, /**< add an image to the cache without a bitmap */
+	TEST_OP_REDRAW, /**< plot an image at its size */
+	TEST_OP_CLEAN, /**< run the background cleaner */
+	TEST_OP_REMOVE, /**< remove an image from the cache */
+};
+
+/**
+ * Step of a recorded trace.
+ */
+struct test_step {
+	enum test_op op; /**< operation */
+	unsigned int image; /**< index of the image operated on */
+};
+
+/**
+ * Recorded trace and the hit ratio expected from replaying it.
+ */
+struct test_trace {
+	const char *name; /**< trace name */
+	const struct test_image *images; /**< images the trace uses */
+	unsigned int image_count; /**< number of images */
+	const struct test_step *steps; /**< operations */
+	unsigned int step_count; /**< number of operations */
+	struct image_cache_parameters params; /**< cache parameters */
+	const char *summary; /**< expected "%k %l %m %pk" summary */
+};
+
+/** Mock bitmap */
+struct test_bitmap {
+	int width;
+	int height;
+	bool opaque;
+	uint8_t *buffer;
+};
+
+/** Mock scheduled callback */
+static struct {
+	void (*callback)(void *p);
+	void *p;
+} test_schedule_entry;
+
+/** Contents of the replayed images */
+static struct content *test_contents;
+
+/** Source data handles the contents refer to */
+static char *test_sources;
+
+/** Images of the trace being replayed */
+static const struct test_image *test_images;
+
+
+/*************************************************/
+
+/* mock interfaces */
+
+void content_broadcast(struct content *c,
+		       content_msg msg,
+		       const union content_msg_data *data)
+{
+}
+
+bool image_bitmap_plot(struct bitmap *bitmap,
+		       struct content_redraw_data *data,
+		       const struct rect *clip,
+		       const struct redraw_context *ctx)
+{
+	return true;
+}
+
+bool llcache_handle_references_same_object(const llcache_handle *a,
+					   const llcache_handle *b)
+{
+	return a == b;
+}
+
+nsurl *llcache_handle_get_url(const llcache_handle *handle)
+{
+	return NULL;
+}
+
+static nserror test_schedule(int t, void (*callback)(void *p), void *p)
+{
+	/* the image cache only schedules its background cleaner when
+	 * conversions are not deferred */
+	if (t < 0) {
+		test_schedule_entry.callback = NULL;
+	} else {
+		test_schedule_entry.callback = callback;
+		test_schedule_entry.p = p;
+	}
+	return NSERROR_OK;
+}
+
+static void *test_bitmap_create(int width, int height, unsigned int state)
+{
+	struct test_bitmap *bitmap;
+
+	bitmap = calloc(1, sizeof(*bitmap));
+	if (bitmap == NULL) {
+		return NULL;
+	}
+	bitmap->buffer = calloc(TEST_BITMAP_SIZE(width, height), 1);
+	if (bitmap->buffer == NULL) {
+		free(bitmap);
+		return NULL;
+	}
+	bitmap->width = width;
+	bitmap->height = height;
+	bitmap->opaque = (state & BITMAP_OPAQUE) != 0;
+
+	return bitmap;
+}
+
+static void test_bitmap_destroy(void *b)
+{
+	struct test_bitmap *bitmap = b;
+
+	free(bitmap->buffer);
+	free(bitmap);
+}
+
+static bool test_bitmap_get_opaque(void *b)
+{
+	struct test_bitmap *bitmap = b;
+
+	return bitmap->opaque;
+}
+
+static unsigned char *test_bitmap_get_buffer(void *b)
+{
+	struct test_bitmap *bitmap = b;
+
+	return bitmap->buffer;
+}
+
+static size_t test_bitmap_get_rowstride(void *b)
+{
+	struct test_bitmap *bitmap = b;
+
+	return bitmap->width * 4;
+}
+
+static int test_bitmap_get_width(void *b)
+{
+	struct test_bitmap *bitmap = b;
+
+	return bitmap->width;
+}
+
+static int test_bitmap_get_height(void *b)
+{
+	struct test_bitmap *bitmap = b;
+
+	return bitmap->height;
+}
+
+static void test_bitmap_modified(void *b)
+{
+}
+
+static struct gui_misc_table tst_misc_table = {
+	.schedule = test_schedule,
+};
+
+static struct gui_bitmap_table tst_bitmap_table = {
+	.create = test_bitmap_create,
+	.destroy = test_bitmap_destroy,
+	.get_opaque = test_bitmap_get_opaque,
+	.get_buffer = test_bitmap_get_buffer,
+	.get_rowstride = test_bitmap_get_rowstride,
+	.get_width = test_bitmap_get_width,
+	.get_height = test_bitmap_get_height,
+	.modified = test_bitmap_modified,
+};
+
+static struct netsurf_table tst_table = {
+	.misc = &tst_misc_table,
+	.bitmap = &tst_bitmap_table,
+};
+
+/**
+ * Image conversion taking the recorded conversion time.
+ */
+static struct bitmap *
+test_convert(struct content *c, int width, int height)
+{
+	const struct test_image *image = &test_images[c - test_contents];
+	struct timespec delay;
+
+	if (image->cost > 0) {
+		delay.tv_sec = 0;
+		delay.tv_nsec = image->cost * 1000000L;
+		nanosleep(&delay, NULL);
+	}
+
+	return test_bitmap_create(c->width, c->height, BITMAP_OPAQUE);
+}
+
+
+/*************************************************/
+
+/**
+ * Replay a trace against a newly initialised image cache.
+ *
+ * \param trace The trace to replay.
+ * \param summary Buffer for the cache summary after the replay.
+ * \param size The size of the summary buffer.
+ */
+static void
+replay_trace(const struct test_trace *trace, char *summary, size_t size)
+{
+	struct content_redraw_data data;
+	struct redraw_context ctx;
+	struct rect clip;
+	struct content *c;
+	unsigned int idx;
+	int source;
+	nserror res;
+
+	guit = &tst_table;
+
+	test_images = trace->images;
+	test_contents = calloc(trace->image_count, sizeof(struct content));
+	ck_assert(test_contents != NULL);
+	test_sources = calloc(trace->image_count, 1);
+	ck_assert(test_sources != NULL);
+
+	for (idx = 0; idx < trace->image_count; idx++) {
+		c = &test_contents[idx];
+		source = trace->images[idx].source;
+		if (source < 0) {
+			source = idx;
+		}
+		c->llcache = (llcache_handle *)(void *)&test_sources[source];
+		c->status = CONTENT_STATUS_DONE;
+		c->width = trace->images[idx].width;
+		c->height = trace->images[idx].height;
+		c->size = TEST_BITMAP_SIZE(c->width, c->height);
+	}
+
+	res = image_cache_init(&trace->params);
+	ck_assert_int_eq(res, NSERROR_OK);
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.interactive = true;
+
+	for (idx = 0; idx < trace->step_count; idx++) {
+		c = &test_contents[trace->steps[idx].image];
+
+		switch (trace->steps[idx].op) {
+		case TEST_OP_ADD:
+			res = image_cache_add(c, NULL, test_convert);
+			ck_assert_int_eq(res, NSERROR_OK);
+			break;
+
+		case TEST_OP_REDRAW:
+			memset(&data, 0, sizeof(data));
+			data.width = c->width;
+			data.height = c->height;
+			data.scale = 1.0;
+			clip.x0 = 0;
+			clip.y0 = 0;
+			clip.x1 = c->width;
+			clip.y1 = c->height;
+			ck_assert(image_cache_redraw(c, &data, &clip, &ctx));
+			break;
+
+		case TEST_OP_CLEAN:
+			ck_assert(test_schedule_entry.callback != NULL);
+			test_schedule_entry.callback(test_schedule_entry.p);
+			break;
+
+		case TEST_OP_REMOVE:
+			res = image_cache_remove(c);
+			ck_assert_int_eq(res, NSERROR_OK);
+			break;
+		}
+	}
+
+	image_cache_snsummaryf(summary, size, "%k %l %m %pk");
+
+	res = image_cache_fini();
+	ck_assert_int_eq(res, NSERROR_OK);
+	ck_assert(test_schedule_entry.callback == NULL);
+
+	free(test_sources);
+	free(test_contents);
+}
+
+
+/*************************************************/
+
+/* Recorded traces */
+
+#define ADD(i) { TEST_OP_ADD, (i) }
+#define REDRAW(i) { TEST_OP_REDRAW, (i) }
+#define CLEAN { TEST_OP_CLEAN, 0 }
+#define REMOVE(i) { TEST_OP_REMOVE, (i) }
+
+/** A page of six equal images */
+static const struct test_image page_images[] = {
+	{ 64, 64, 0, -1 },
+	{ 64, 64, 0, -1 },
+	{ 64, 64, 0, -1 },
+	{ 64, 64, 0, -1 },
+	{ 64, 64, 0, -1 },
+	{ 64, 64, 0, -1 },
+};
+
+/**
+ * The page is loaded, the first three images redrawn while the page
+ * settles, scrolled to the last three and back to the top.
+ */
+static const struct test_step scroll_steps[] = {
+	ADD(0), ADD(1), ADD(2), ADD(3), ADD(4), ADD(5),
+	REDRAW(0), REDRAW(1), REDRAW(2),
+	REDRAW(0), REDRAW(1), REDRAW(2),
+	REDRAW(0), REDRAW(1), REDRAW(2),
+	CLEAN,
+	REDRAW(3), REDRAW(4), REDRAW(5),
+	REDRAW(3), REDRAW(4), REDRAW(5),
+	CLEAN,
+	REDRAW(0), REDRAW(1), REDRAW(2),
+};
+
+/**
+ * The same page left idle long enough for every bitmap to be
+ * released before it is scrolled.
+ */
+static const struct test_step idle_steps[] = {
+	ADD(0), ADD(1), ADD(2), ADD(3), ADD(4), ADD(5),
+	REDRAW(0), REDRAW(1), REDRAW(2),
+	CLEAN,
+	REDRAW(0), REDRAW(1), REDRAW(2),
+	CLEAN, CLEAN,
+	REDRAW(0), REDRAW(1), REDRAW(2),
+	REDRAW(3), REDRAW(4), REDRAW(5),
+};
+
+/**
+ * A large cheap image and a small expensive one on a page whose
+ * bitmaps exceed the cache limit.
+ */
+static const struct test_image cost_images[] = {
+	{ 256, 256, 0, -1 },
+	{ 64, 64, 20, -1 },
+};
+
+/**
+ * Both images are drawn, left idle and drawn again.
+ */
+static const struct test_step cost_steps[] = {
+	ADD(0), ADD(1),
+	REDRAW(0), REDRAW(1),
+	CLEAN, CLEAN,
+	REDRAW(0), REDRAW(1),
+};
+
+/**
+ * Three images from the same source and one from another.
+ */
+static const struct test_image shared_images[] = {
+	{ 64, 64, 0, -1 },
+	{ 64, 64, 0, 0 },
+	{ 64, 64, 0, 0 },
+	{ 32, 32, 0, -1 },
+};
+
+/**
+ * The images are drawn, the first removed and the rest drawn again.
+ */
+static const struct test_step shared_steps[] = {
+	ADD(0), ADD(1), ADD(2), ADD(3),
+	REDRAW(0), REDRAW(1), REDRAW(2), REDRAW(3),
+	REMOVE(0),
+	REDRAW(1), REDRAW(2), REDRAW(3),
+};
+
+#define TRACE(n, i, s) (n), (i), NELEMS(i), (s), NELEMS(s)
+
+static const struct test_trace test_traces[] = {
+	{
+		/* every bitmap fits so only first draws miss */
+		TRACE("scroll", page_images, scroll_steps),
+		{ TEST_CLEAN_TIME, 1024 * 1024, 0, 0, false, false },
+		"12 6 0 66"
+	}, {
+		/* every idle bitmap is released */
+		TRACE("idle", page_images, idle_steps),
+		{ TEST_CLEAN_TIME, 1, 1, 0, false, true },
+		"3 9 0 25"
+	}, {
+		/* the large cheap bitmap alone is released */
+		TRACE("cost aware", cost_images, cost_steps),
+		{
+			TEST_CLEAN_TIME,
+			TEST_BITMAP_SIZE(64, 64) + 1,
+			1,
+			0,
+			false,
+			true
+		},
+		"1 3 0 25"
+	}, {
+		/* later contents of a source use its first bitmap */
+		TRACE("shared", shared_images, shared_steps),
+		{ TEST_CLEAN_TIME, 1024 * 1024, 0, 0, false, false },
+		"5 2 0 71"
+	},
+};
+
+
+/* Tests */
+
+START_TEST(image_cache_trace_test)
+{
+	const struct test_trace *trace = &test_traces[_i];
+	char summary[64];
+
+	replay_trace(trace, summary, sizeof(summary));
+
+	ck_assert_msg(strcmp(summary, trace->summary) == 0,
+		      "trace \"%s\" summary \"%s\" expected \"%s\"",
+		      trace->name, summary, trace->summary);
+}
+END_TEST
+
+static TCase *image_cache_trace_case_create(void)
+{
+	TCase *tc;
+
+	tc = tcase_create("Trace");
+
+	tcase_add_loop_test(tc, image_cache_trace_test,
+			    0, NELEMS(test_traces));
+
+	return tc;
+}
+
+
+static Suite *image_cache_suite(void)
+{
+	Suite *s;
+	s = suite_create("Image cache");
+
+	suite_add_tcase(s, image_cache_trace_case_create());
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = image_cache_suite();
+
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
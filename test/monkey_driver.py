@@ -26,6 +26,10 @@ import os
 import sys
 import getopt
 import time
+import atexit
+import tempfile
+import struct
+import zlib
 import yaml
 
 from monkeyfarmer import Browser
@@ -254,6 +258,211 @@ def run_test_step_action_window_close(ctx, step):
     assert not win.alive
 
 
+def generate_table_page(rows, columns, stripes=False):
+    """
+    write a page containing a large table to a temporary file
+
+    when stripes is set alternate rows are styled with a structural
+    pseudo class selector
+
+    returns the url of the page which is removed when the driver exits
+    """
+    fd, path = tempfile.mkstemp(prefix="monkey-table-", suffix=".html")
+    with os.fdopen(fd, "w") as page:
+        page.write("<!DOCTYPE html>\n<html>\n<head>\n"
+                   "<title>Table of {} rows</title>\n".format(rows))
+        if stripes:
+            page.write("<style>tr:nth-child(even) "
+                       "{ background-color: #eee }</style>\n")
+        page.write("</head>\n<body>\n<table>\n")
+        for row in range(rows):
+            page.write("<tr>")
+            for column in range(columns):
+                page.write("<td>Cell {} {}</td>".format(row, column))
+            page.write("</tr>\n")
+        page.write("</table>\n</body>\n</html>\n")
+    atexit.register(os.remove, path)
+    return "file://" + path
+
+
+def generate_anchors_page(sections):
+    """
+    write a page of tall sections, each followed by fragment anchors,
+    to a temporary file
+
+    section N has an anchor named name-N, an anchor with id id-N that
+    is named alias-N and a span with id span-N
+
+    returns the url of the page which is removed when the driver exits
+    """
+    fd, path = tempfile.mkstemp(prefix="monkey-anchors-", suffix=".html")
+    with os.fdopen(fd, "w") as page:
+        page.write("<!DOCTYPE html>\n<html>\n<head>\n"
+                   "<title>Page of {} anchored sections</title>\n"
+                   "</head>\n<body>\n".format(sections))
+        for section in range(sections):
+            page.write("<div style=\"height: 1000px\">Section {}</div>\n"
+                       "<p><a name=\"name-{}\">Named {}</a> "
+                       "<a id=\"id-{}\" name=\"alias-{}\">Aliased {}</a> "
+                       "<span id=\"span-{}\">Span {}</span></p>\n"
+                       .format(section, section, section, section,
+                               section, section, section, section))
+        page.write("</body>\n</html>\n")
+    atexit.register(os.remove, path)
+    return "file://" + path
+
+
+def generate_gallery_page(floats):
+    """
+    write a page containing a gallery of floated boxes to a temporary file
+
+    returns the url of the page which is removed when the driver exits
+    """
+    fd, path = tempfile.mkstemp(prefix="monkey-gallery-", suffix=".html")
+    with os.fdopen(fd, "w") as page:
+        page.write("<!DOCTYPE html>\n<html>\n<head>\n"
+                   "<title>Gallery of {} floats</title>\n"
+                   "</head>\n<body>\n".format(floats))
+        for index in range(floats):
+            side = "right" if index % 7 == 0 else "left"
+            page.write("<div style=\"float: {}; width: {}px; height: {}px\">"
+                       "Item {}</div>\n".format(side,
+                                                 80 + (index % 5) * 20,
+                                                 60 + (index % 3) * 30,
+                                                 index))
+            if index % 50 == 49:
+                page.write("<p>Paragraph of text flowing beside the "
+                           "floats of the gallery {}</p>\n".format(index))
+        page.write("</body>\n</html>\n")
+    atexit.register(os.remove, path)
+    return "file://" + path
+
+
+def write_png(path, width, height, seed):
+    """
+    write a truecolour png image of a pattern that varies with the seed
+    """
+    def chunk(kind, data):
+        return (struct.pack(">I", len(data)) + kind + data +
+                struct.pack(">I", zlib.crc32(kind + data) & 0xffffffff))
+
+    rows = bytearray()
+    for y in range(height):
+        rows.append(0)
+        for x in range(width):
+            rows.extend(((x * seed) & 0xff,
+                         (y * (seed + 3)) & 0xff,
+                         ((x ^ y) * seed) & 0xff))
+    with open(path, "wb") as image:
+        image.write(b"\x89PNG\r\n\x1a\n")
+        image.write(chunk(b"IHDR", struct.pack(">IIBBBBB", width, height,
+                                               8, 2, 0, 0, 0)))
+        image.write(chunk(b"IDAT", zlib.compress(bytes(rows))))
+        image.write(chunk(b"IEND", b""))
+
+
+def generate_images_page(count):
+    """
+    write a page containing distinct images of varying sizes to a
+    temporary directory
+
+    returns the url of the page which is removed when the driver exits
+    """
+    path = tempfile.mkdtemp(prefix="monkey-images-")
+    # exit handlers run in reverse so the directory is removed last
+    atexit.register(os.rmdir, path)
+    files = []
+    with open(os.path.join(path, "index.html"), "w") as page:
+        page.write("<!DOCTYPE html>\n<html>\n<head>\n"
+                   "<title>Page of {} images</title>\n"
+                   "</head>\n<body>\n".format(count))
+        for index in range(count):
+            size = 32 + (index % 8) * 32
+            name = "image-{}.png".format(index)
+            write_png(os.path.join(path, name), size, size, index + 1)
+            files.append(name)
+            page.write("<img src=\"{}\" width=\"{}\" height=\"{}\">\n"
+                       .format(name, size, size))
+        page.write("</body>\n</html>\n")
+    files.append("index.html")
+    for name in files:
+        atexit.register(os.remove, os.path.join(path, name))
+    return "file://" + os.path.join(path, "index.html")
+
+
+def generate_article_page(images):
+    """
+    write a long article with images that have no dimensions given to a
+    temporary directory, so every image arriving reflows the document
+
+    returns the url of the page which is removed when the driver exits
+    """
+    path = tempfile.mkdtemp(prefix="monkey-article-")
+    # exit handlers run in reverse so the directory is removed last
+    atexit.register(os.rmdir, path)
+    files = []
+    with open(os.path.join(path, "index.html"), "w") as page:
+        page.write("<!DOCTYPE html>\n<html>\n<head>\n"
+                   "<title>Article with {} images</title>\n"
+                   "</head>\n<body>\n<h1>Article</h1>\n".format(images))
+        for index in range(images):
+            size = 64 + (index % 4) * 64
+            name = "figure-{}.png".format(index)
+            write_png(os.path.join(path, name), size * 2, size, index + 1)
+            files.append(name)
+            page.write("<p><img src=\"{}\" alt=\"Figure {}\"></p>\n"
+                       .format(name, index))
+            for paragraph in range(3):
+                page.write("<p>Section {} paragraph {} of the article "
+                           "text which is laid out in lines that wrap "
+                           "at the window width and are unaffected by "
+                           "the images arriving elsewhere in the "
+                           "document.</p>\n".format(index, paragraph))
+        page.write("</body>\n</html>\n")
+    files.append("index.html")
+    for name in files:
+        atexit.register(os.remove, os.path.join(path, name))
+    return "file://" + os.path.join(path, "index.html")
+
+
+def generate_svgs_page(count):
+    """
+    write a page containing svg icons sized relative to the window to a
+    temporary directory
+
+    returns the url of the page which is removed when the driver exits
+    """
+    path = tempfile.mkdtemp(prefix="monkey-svgs-")
+    # exit handlers run in reverse so the directory is removed last
+    atexit.register(os.rmdir, path)
+    files = []
+    for index in range(8):
+        name = "icon-{}.svg".format(index)
+        with open(os.path.join(path, name), "w") as icon:
+            icon.write("<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                       "viewBox=\"0 0 100 100\">\n"
+                       "<rect x=\"5\" y=\"5\" width=\"90\" height=\"90\" "
+                       "rx=\"{}\" fill=\"#{:06x}\"/>\n"
+                       "<circle cx=\"50%\" cy=\"50%\" r=\"30%\" "
+                       "stroke=\"black\" stroke-width=\"4\" fill=\"none\"/>\n"
+                       "<path d=\"M20 80 L50 20 L80 80 Z\" fill=\"white\"/>\n"
+                       "</svg>\n".format(index * 5,
+                                        (index * 0x2f4b1d) & 0xffffff))
+        files.append(name)
+    with open(os.path.join(path, "index.html"), "w") as page:
+        page.write("<!DOCTYPE html>\n<html>\n<head>\n"
+                   "<title>Page of {} svg icons</title>\n"
+                   "</head>\n<body>\n".format(count))
+        for index in range(count):
+            page.write("<img src=\"{}\" style=\"width: 4%\">\n"
+                       .format(files[index % len(files)]))
+        page.write("</body>\n</html>\n")
+    files.append("index.html")
+    for name in files:
+        atexit.register(os.remove, os.path.join(path, name))
+    return "file://" + os.path.join(path, "index.html")
+
+
 def run_test_step_action_navigate(ctx, step):
     print(get_indent(ctx) + "Action: " + step["action"])
     assert_browser(ctx)
@@ -264,9 +473,25 @@ def run_test_step_action_navigate(ctx, step):
         assert repeat is not None
         assert repeat.get('values') is not None
         url = repeat['values'][repeat['i']]
+    elif 'table' in step.keys():
+        url = generate_table_page(int(step['table']['rows']),
+                                  int(step['table'].get('columns', 1)),
+                                  bool(step['table'].get('stripes', False)))
+    elif 'gallery' in step.keys():
+        url = generate_gallery_page(int(step['gallery']['floats']))
+    elif 'anchors' in step.keys():
+        url = generate_anchors_page(int(step['anchors']['sections']))
+    elif 'images' in step.keys():
+        url = generate_images_page(int(step['images']['count']))
+    elif 'article' in step.keys():
+        url = generate_article_page(int(step['article']['images']))
+    elif 'svgs' in step.keys():
+        url = generate_svgs_page(int(step['svgs']['count']))
     else:
         url = None
     assert url is not None
+    if 'fragment' in step.keys():
+        url = url + "#" + step['fragment']
     tag = step['window']
     print(get_indent(ctx) + "        " + tag + " --> " + url)
     win = ctx['windows'].get(tag)
@@ -426,6 +651,34 @@ def run_test_step_action_click(ctx, step):
     win.click(x, y, button, kind)
 
 
+def run_test_step_action_mouse_move(ctx, step):
+    print(get_indent(ctx) + "Action: " + step["action"])
+    assert_browser(ctx)
+    win = ctx['windows'][step['window']]
+    x = int(step['x'])
+    y = int(step['y'])
+    count = int(step.get('count', 1))
+    x_step = int(step.get('x-step', 0))
+    y_step = int(step.get('y-step', 0))
+
+    print(get_indent(ctx) + "        Moving {} times from {}, {}".format(count, x, y))
+    for _ in range(count):
+        win.mouse_move(x, y)
+        x += x_step
+        y += y_step
+
+
+def run_test_step_action_window_resize(ctx, step):
+    print(get_indent(ctx) + "Action: " + step["action"])
+    assert_browser(ctx)
+    win = ctx['windows'][step['window']]
+    width = int(step['width'])
+    height = int(step['height'])
+
+    print(get_indent(ctx) + "        Resizing to {}x{}".format(width, height))
+    win.resize(width, height)
+
+
 def run_test_step_action_wait_loading(ctx, step):
     print(get_indent(ctx) + "Action: " + step["action"])
     assert_browser(ctx)
@@ -531,6 +784,25 @@ def run_test_step_action_timer_check(ctx, step):
         assert timer1["taken"] > timer2["taken"]
 
 
+def run_test_step_action_scroll_check(ctx, step):
+    print(get_indent(ctx) + "Action: " + step["action"])
+    assert_browser(ctx)
+    win = ctx['windows'][step['window']]
+    y_min = int(step.get('y-min', 0))
+    y_max = int(step.get('y-max', sys.maxsize))
+    timeout = float(step.get('timeout', 5))
+
+    # the scroll to a fragment may follow the end of the fetch
+    start = time.time()
+    while (not y_min <= win.scrolly <= y_max and
+           time.time() - start < timeout):
+        ctx['browser'].farmer.loop(once=True)
+
+    print(get_indent(ctx) + "        Check scroll y {} in {} to {}"
+          .format(win.scrolly, y_min, y_max))
+    assert y_min <= win.scrolly <= y_max
+
+
 def run_test_step_action_add_auth(ctx, step):
     print(get_indent(ctx) + "Action:" + step["action"])
     assert_browser(ctx)
@@ -619,7 +891,10 @@ STEP_HANDLERS = {
     "timer-stop":    run_test_step_action_timer_stop,
     "timer-check":   run_test_step_action_timer_check,
     "plot-check":    run_test_step_action_plot_check,
+    "scroll-check":  run_test_step_action_scroll_check,
     "click":         run_test_step_action_click,
+    "mouse-move":    run_test_step_action_mouse_move,
+    "window-resize": run_test_step_action_window_resize,
     "wait-loading":  run_test_step_action_wait_loading,
     "add-auth":      run_test_step_action_add_auth,
     "remove-auth":   run_test_step_action_remove_auth,
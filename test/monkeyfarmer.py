@@ -398,6 +398,7 @@ class BrowserWindow:
         self.scrolly = 0
         self.content_width = 0
         self.content_height = 0
+        self.extent_updates = 0
         self.status = ""
         self.pointer = ""
         self.scale = 1.0
@@ -441,6 +442,16 @@ class BrowserWindow:
     def click(self, x, y, button="LEFT", kind="SINGLE"):
         self.browser.farmer.tell_monkey("WINDOW CLICK WIN %s X %s Y %s BUTTON %s KIND %s" % (self.winid, x, y, button, kind))
 
+    def mouse_move(self, x, y):
+        self.browser.farmer.tell_monkey("WINDOW MOVE WIN %s X %s Y %s" % (self.winid, x, y))
+
+    def resize(self, width, height):
+        updates = self.extent_updates
+        self.browser.farmer.tell_monkey("WINDOW RESIZE WIN %s WIDTH %s HEIGHT %s" % (self.winid, width, height))
+        # the content extent is updated once it has been reformatted
+        while self.extent_updates == updates:
+            self.browser.farmer.loop(once=True)
+
     def js_exec(self, src):
         self.browser.farmer.tell_monkey("WINDOW EXEC WIN %s %s" % (self.winid, src))
 
@@ -490,6 +501,7 @@ class BrowserWindow:
     def handle_window_UPDATE_EXTENT(self, _width, width, _height, height):
         self.content_width = int(width)
         self.content_height = int(height)
+        self.extent_updates += 1
 
     def handle_window_SET_STATUS(self, _str, *status):
         self.status = (" ".join(status))
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Test pixel format conversion kernels.
+ *
+ * The kernels are compared with straightforward per pixel reference
+ * conversions over every remainder a vector implementation can leave.
+ * The benchmark case reports the throughput of each kernel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <check.h>
+
+#include "utils/pixel.h"
+
+/** Largest pixel count compared against the reference */
+#define PIXEL_TEST_COUNT 67
+
+/** Number of pixels converted by each benchmark pass */
+#define PIXEL_BENCH_COUNT (1024 * 1024)
+
+/** Number of benchmark passes */
+#define PIXEL_BENCH_PASSES 16
+
+/**
+ * Fill a buffer with a repeatable pseudo random pattern.
+ */
+static void fill(uint8_t *buf, size_t len, unsigned int seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+/* Tests */
+
+START_TEST(pixel_rgb_to_rgba_test)
+{
+	uint8_t src[PIXEL_TEST_COUNT * 3];
+	uint8_t dst[PIXEL_TEST_COUNT * 4];
+	uint8_t inplace[PIXEL_TEST_COUNT * 4];
+	size_t count = _i;
+	size_t i;
+
+	fill(src, sizeof(src), count);
+	memcpy(inplace, src, sizeof(src));
+
+	pixel_rgb_to_rgba(dst, src, count);
+	pixel_rgb_to_rgba(inplace, inplace, count);
+
+	for (i = 0; i < count; i++) {
+		ck_assert_int_eq(dst[i * 4 + 0], src[i * 3 + 0]);
+		ck_assert_int_eq(dst[i * 4 + 1], src[i * 3 + 1]);
+		ck_assert_int_eq(dst[i * 4 + 2], src[i * 3 + 2]);
+		ck_assert_int_eq(dst[i * 4 + 3], 0xff);
+	}
+	ck_assert(memcmp(dst, inplace, count * 4) == 0);
+}
+END_TEST
+
+START_TEST(pixel_cmyk_to_rgba_test)
+{
+	uint8_t src[PIXEL_TEST_COUNT * 4];
+	uint8_t dst[PIXEL_TEST_COUNT * 4];
+	size_t count = _i;
+	size_t i;
+	int c;
+
+	fill(src, sizeof(src), count);
+	memcpy(dst, src, sizeof(src));
+
+	pixel_cmyk_to_rgba(dst, count);
+
+	for (i = 0; i < count; i++) {
+		for (c = 0; c < 3; c++) {
+			ck_assert_int_eq(dst[i * 4 + c],
+					 (src[i * 4 + c] * src[i * 4 + 3]) /
+					 255);
+		}
+		ck_assert_int_eq(dst[i * 4 + 3], 0xff);
+	}
+}
+END_TEST
+
+START_TEST(pixel_premultiply_test)
+{
+	uint8_t src[PIXEL_TEST_COUNT * 4];
+	uint8_t dst[PIXEL_TEST_COUNT * 4];
+	size_t count = _i;
+	size_t i;
+	int c;
+
+	fill(src, sizeof(src), count);
+	memcpy(dst, src, sizeof(src));
+
+	pixel_premultiply(dst, count);
+
+	for (i = 0; i < count; i++) {
+		for (c = 0; c < 3; c++) {
+			ck_assert_int_eq(dst[i * 4 + c],
+					 (src[i * 4 + c] *
+					  (src[i * 4 + 3] + 1)) >> 8);
+		}
+		ck_assert_int_eq(dst[i * 4 + 3], src[i * 4 + 3]);
+	}
+}
+END_TEST
+
+START_TEST(pixel_unpremultiply_test)
+{
+	uint8_t src[PIXEL_TEST_COUNT * 4];
+	uint8_t dst[PIXEL_TEST_COUNT * 4];
+	size_t count = _i;
+	size_t i;
+	int c;
+
+	fill(src, sizeof(src), count);
+	memcpy(dst, src, sizeof(src));
+
+	pixel_unpremultiply(dst, count);
+
+	for (i = 0; i < count; i++) {
+		unsigned int a = src[i * 4 + 3];
+
+		for (c = 0; c < 3; c++) {
+			unsigned int v = 0;
+			if (a != 0) {
+				v = (src[i * 4 + c] << 8) / a;
+				v = (v > 255) ? 255 : v;
+			}
+			ck_assert_int_eq(dst[i * 4 + c], v);
+		}
+		ck_assert_int_eq(dst[i * 4 + 3], a);
+	}
+}
+END_TEST
+
+START_TEST(pixel_opaque_test)
+{
+	uint8_t buf[PIXEL_TEST_COUNT * 4];
+	size_t count = _i;
+	size_t i;
+
+	fill(buf, sizeof(buf), count);
+	for (i = 0; i < count; i++) {
+		buf[i * 4 + 3] = 0xff;
+	}
+	ck_assert(pixel_opaque(buf, count) == true);
+
+	/* a single translucent pixel anywhere must be found */
+	for (i = 0; i < count; i++) {
+		buf[i * 4 + 3] = 0xfe;
+		ck_assert(pixel_opaque(buf, count) == false);
+		buf[i * 4 + 3] = 0xff;
+	}
+}
+END_TEST
+
+START_TEST(pixel_swizzle_test)
+{
+	static const struct {
+		enum pixel_swizzle swizzle;
+		int order[4]; /* source channel of each destination channel */
+	} tests[] = {
+		{ PIXEL_SWIZZLE_SWAP_RB, { 2, 1, 0, 3 } },
+		{ PIXEL_SWIZZLE_RGBA_TO_ARGB, { 3, 0, 1, 2 } },
+		{ PIXEL_SWIZZLE_ARGB_TO_RGBA, { 1, 2, 3, 0 } },
+	};
+	uint8_t src[PIXEL_TEST_COUNT * 4];
+	uint8_t dst[PIXEL_TEST_COUNT * 4];
+	size_t count = _i;
+	size_t t, i;
+	int c;
+
+	fill(src, sizeof(src), count);
+
+	for (t = 0; t < sizeof(tests) / sizeof(tests[0]); t++) {
+		memcpy(dst, src, sizeof(src));
+
+		pixel_swizzle(dst, count, tests[t].swizzle);
+
+		for (i = 0; i < count; i++) {
+			for (c = 0; c < 4; c++) {
+				ck_assert_int_eq(dst[i * 4 + c],
+						 src[i * 4 + tests[t].order[c]]);
+			}
+		}
+	}
+}
+END_TEST
+
+static TCase *pixel_conversion_case_create(void)
+{
+	TCase *tc;
+
+	tc = tcase_create("Conversion");
+
+	tcase_add_loop_test(tc, pixel_rgb_to_rgba_test, 0, PIXEL_TEST_COUNT);
+	tcase_add_loop_test(tc, pixel_cmyk_to_rgba_test, 0, PIXEL_TEST_COUNT);
+	tcase_add_loop_test(tc, pixel_premultiply_test, 0, PIXEL_TEST_COUNT);
+	tcase_add_loop_test(tc, pixel_unpremultiply_test, 0, PIXEL_TEST_COUNT);
+	tcase_add_loop_test(tc, pixel_opaque_test, 0, PIXEL_TEST_COUNT);
+	tcase_add_loop_test(tc, pixel_swizzle_test, 0, PIXEL_TEST_COUNT);
+
+	return tc;
+}
+
+
+/**
+ * Report the throughput of a benchmark pass.
+ */
+static void
+bench_report(const char *name, struct timespec *start, struct timespec *end)
+{
+	double elapsed;
+
+	elapsed = (end->tv_sec - start->tv_sec) +
+		(end->tv_nsec - start->tv_nsec) / 1e9;
+
+	printf("%-20s %8.1f Mpixel/s\n", name,
+	       (PIXEL_BENCH_COUNT * (double)PIXEL_BENCH_PASSES) /
+	       (elapsed * 1e6));
+}
+
+#define BENCH(name, expr)						\
+	do {								\
+		int pass;						\
+		clock_gettime(CLOCK_MONOTONIC, &start);			\
+		for (pass = 0; pass < PIXEL_BENCH_PASSES; pass++) {	\
+			expr;						\
+		}							\
+		clock_gettime(CLOCK_MONOTONIC, &end);			\
+		bench_report(name, &start, &end);			\
+	} while (0)
+
+/**
+ * Microbenchmark of each kernel over a large buffer.
+ */
+START_TEST(pixel_benchmark_test)
+{
+	struct timespec start, end;
+	uint8_t *buf;
+	bool opaque = true;
+
+	buf = malloc(PIXEL_BENCH_COUNT * 4);
+	ck_assert(buf != NULL);
+
+	fill(buf, PIXEL_BENCH_COUNT * 4, 1);
+	BENCH("rgb_to_rgba", pixel_rgb_to_rgba(buf, buf, PIXEL_BENCH_COUNT));
+	BENCH("cmyk_to_rgba", pixel_cmyk_to_rgba(buf, PIXEL_BENCH_COUNT));
+	fill(buf, PIXEL_BENCH_COUNT * 4, 1);
+	BENCH("premultiply", pixel_premultiply(buf, PIXEL_BENCH_COUNT));
+	fill(buf, PIXEL_BENCH_COUNT * 4, 1);
+	BENCH("unpremultiply", pixel_unpremultiply(buf, PIXEL_BENCH_COUNT));
+	BENCH("swizzle_swap_rb", pixel_swizzle(buf, PIXEL_BENCH_COUNT,
+					       PIXEL_SWIZZLE_SWAP_RB));
+	BENCH("swizzle_to_argb", pixel_swizzle(buf, PIXEL_BENCH_COUNT,
+					       PIXEL_SWIZZLE_RGBA_TO_ARGB));
+	memset(buf, 0xff, PIXEL_BENCH_COUNT * 4);
+	BENCH("opaque", opaque &= pixel_opaque(buf, PIXEL_BENCH_COUNT));
+	ck_assert(opaque == true);
+
+	free(buf);
+}
+END_TEST
+
+static TCase *pixel_benchmark_case_create(void)
+{
+	TCase *tc;
+
+	tc = tcase_create("Benchmark");
+
+	tcase_set_timeout(tc, 60);
+	tcase_add_test(tc, pixel_benchmark_test);
+
+	return tc;
+}
+
+
+static Suite *pixel_suite(void)
+{
+	Suite *s;
+	s = suite_create("Pixel conversion");
+
+	suite_add_tcase(s, pixel_conversion_case_create());
+	suite_add_tcase(s, pixel_benchmark_case_create());
+
+	return s;
+}
+
+int main(int argc, char **argv)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = pixel_suite();
+
+	sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
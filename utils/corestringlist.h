@@ -64,6 +64,7 @@ CORESTRING_LWC_STRING(col);
 CORESTRING_LWC_STRING(data);
 CORESTRING_LWC_STRING(default);
 CORESTRING_LWC_STRING(div);
+CORESTRING_LWC_STRING(eager);
 CORESTRING_LWC_STRING(embed);
 CORESTRING_LWC_STRING(file);
 CORESTRING_LWC_STRING(filename);
@@ -91,6 +92,7 @@ CORESTRING_LWC_STRING(includesubdomains);
 CORESTRING_LWC_STRING(input);
 CORESTRING_LWC_STRING(javascript);
 CORESTRING_LWC_STRING(justify);
+CORESTRING_LWC_STRING(lazy);
 CORESTRING_LWC_STRING(left);
 CORESTRING_LWC_STRING(li);
 CORESTRING_LWC_STRING(link);
@@ -151,6 +153,7 @@ CORESTRING_LWC_VALUE(query_auth, "query/auth");
 CORESTRING_LWC_VALUE(query_ssl, "query/ssl");
 CORESTRING_LWC_VALUE(query_timeout, "query/timeout");
 CORESTRING_LWC_VALUE(query_fetcherror, "query/fetcherror");
+CORESTRING_LWC_VALUE(query_offline, "query/offline");
 CORESTRING_LWC_VALUE(x_ns_css, "x-ns-css");
 
 /* mime types */
@@ -262,6 +265,7 @@ CORESTRING_DOM_STRING(languagechange);
 CORESTRING_DOM_STRING(load);
 CORESTRING_DOM_STRING(loadeddata);
 CORESTRING_DOM_STRING(loadedmetadata);
+CORESTRING_DOM_STRING(loading);
 CORESTRING_DOM_STRING(loadstart);
 CORESTRING_DOM_STRING(map);
 CORESTRING_DOM_STRING(marginheight);
@@ -380,6 +384,7 @@ CORESTRING_NSURL(about_query_ssl, "about:query/ssl");
 CORESTRING_NSURL(about_query_auth, "about:query/auth");
 CORESTRING_NSURL(about_query_timeout, "about:query/timeout");
 CORESTRING_NSURL(about_query_fetcherror, "about:query/fetcherror");
+CORESTRING_NSURL(about_query_offline, "about:query/offline");
 
 #undef CORESTRING_LWC_STRING
 #undef CORESTRING_DOM_STRING
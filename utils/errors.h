@@ -63,6 +63,7 @@ typedef enum {
 	NSERROR_BAD_AUTH,               /**< Fetch needs authentication data */
 	NSERROR_BAD_CERTS,              /**< Fetch needs certificate chain check */
 	NSERROR_TIMEOUT,                /**< Operation timed out */
+	NSERROR_NOT_CACHED,             /**< Not available in cache only mode */
 } nserror;
 
 #endif
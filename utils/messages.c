@@ -391,6 +391,10 @@ const char *messages_get_errorcode(nserror code)
 	case NSERROR_TIMEOUT:
 		/* Operation timed out */
 		return messages_get_ctx("Timeout", messages_hash);
+
+	case NSERROR_NOT_CACHED:
+		/* Not available in cache only mode */
+		return messages_get_ctx("NotCached", messages_hash);
 	}
 
 	/* The switch has no default, so the compiler should tell us when we
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Pixel format conversion implementation.
+ *
+ * Each kernel processes as many pixels as it can with the vector unit
+ * and finishes the remainder with the scalar code, which also defines
+ * the results the vector code must match.
+ *
+ * The SSE2 code treats pixels as little endian 32 bit words which is
+ * always the case on processors with SSE2.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PIXEL_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PIXEL_NEON 1
+#endif
+
+#include "utils/pixel.h"
+
+/**
+ * Divide the product of two channel values by 255.
+ *
+ * Exact (rounding down) for products of two values in the range 0 to 255.
+ */
+#define PIXEL_DIV255(x) (((x) + 1 + ((x) >> 8)) >> 8)
+
+
+#if defined(PIXEL_SSE2)
+
+/**
+ * Load four pixels.
+ */
+static inline __m128i pixel__load(const uint8_t *p)
+{
+	return _mm_loadu_si128((const __m128i *)(const void *)p);
+}
+
+/**
+ * Store four pixels.
+ */
+static inline void pixel__store(uint8_t *p, __m128i v)
+{
+	_mm_storeu_si128((__m128i *)(void *)p, v);
+}
+
+/**
+ * Load four RGB pixels and expand them to opaque RGBA.
+ *
+ * Only the twelve bytes of the four pixels are read.
+ */
+static inline __m128i pixel__load_rgb(const uint8_t *p)
+{
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000U);
+	uint32_t tail;
+	__m128i v;
+
+	memcpy(&tail, p + 8, sizeof(tail));
+	v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(const void *)p),
+			       _mm_cvtsi32_si128((int)tail));
+
+	/* move each pixel to the bottom of its own lane */
+	v = _mm_unpacklo_epi64(
+		_mm_unpacklo_epi32(v, _mm_srli_si128(v, 3)),
+		_mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9)));
+
+	return _mm_or_si128(v, alpha);
+}
+
+/**
+ * Broadcast the fourth channel of two 16 bit per channel pixels.
+ */
+static inline __m128i pixel__fourth(__m128i v)
+{
+	v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+	return _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/**
+ * Convert two 16 bit per channel CMYK pixels to RGBA.
+ */
+static inline __m128i pixel__cmyk(__m128i v)
+{
+	const __m128i colour = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha = _mm_set_epi16(0xff, 0, 0, 0, 0xff, 0, 0, 0);
+	const __m128i one = _mm_set1_epi16(1);
+	__m128i x;
+
+	x = _mm_mullo_epi16(v, pixel__fourth(v));
+	x = _mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8));
+	x = _mm_srli_epi16(x, 8);
+
+	return _mm_or_si128(_mm_and_si128(x, colour), alpha);
+}
+
+/**
+ * Premultiply two 16 bit per channel RGBA pixels.
+ */
+static inline __m128i pixel__premultiply(__m128i v)
+{
+	const __m128i colour = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i one = _mm_set1_epi16(1);
+	__m128i x;
+
+	x = _mm_mullo_epi16(v, _mm_add_epi16(pixel__fourth(v), one));
+	x = _mm_srli_epi16(x, 8);
+
+	return _mm_or_si128(_mm_and_si128(x, colour),
+			    _mm_andnot_si128(colour, v));
+}
+
+#elif defined(PIXEL_NEON)
+
+/**
+ * Multiply channel values and divide by 255.
+ */
+static inline uint8x16_t pixel__mul255(uint8x16_t a, uint8x16_t b)
+{
+	const uint16x8_t one = vdupq_n_u16(1);
+	uint16x8_t lo = vmull_u8(vget_low_u8(a), vget_low_u8(b));
+	uint16x8_t hi = vmull_u8(vget_high_u8(a), vget_high_u8(b));
+
+	lo = vaddq_u16(vaddq_u16(lo, one), vshrq_n_u16(lo, 8));
+	hi = vaddq_u16(vaddq_u16(hi, one), vshrq_n_u16(hi, 8));
+
+	return vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+}
+
+/**
+ * Multiply channel values by alpha plus one and divide by 256.
+ */
+static inline uint8x16_t pixel__premultiply(uint8x16_t c, uint8x16_t a)
+{
+	uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+	uint16x8_t hi = vmull_u8(vget_high_u8(c), vget_high_u8(a));
+
+	lo = vaddw_u8(lo, vget_low_u8(c));
+	hi = vaddw_u8(hi, vget_high_u8(c));
+
+	return vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+}
+
+#endif
+
+
+/* exported interface documented in utils/pixel.h */
+void pixel_rgb_to_rgba(uint8_t *dst, const uint8_t *src, size_t count)
+{
+	size_t i = count;
+
+	/* work from the end so the conversion can be done in place */
+#if defined(PIXEL_SSE2)
+	while (i >= 4) {
+		i -= 4;
+		pixel__store(dst + i * 4, pixel__load_rgb(src + i * 3));
+	}
+#elif defined(PIXEL_NEON)
+	while (i >= 16) {
+		uint8x16x3_t rgb;
+		uint8x16x4_t rgba;
+
+		i -= 16;
+		rgb = vld3q_u8(src + i * 3);
+		rgba.val[0] = rgb.val[0];
+		rgba.val[1] = rgb.val[1];
+		rgba.val[2] = rgb.val[2];
+		rgba.val[3] = vdupq_n_u8(0xff);
+		vst4q_u8(dst + i * 4, rgba);
+	}
+#endif
+
+	while (i > 0) {
+		uint8_t r, g, b;
+
+		i--;
+		r = src[i * 3 + 0];
+		g = src[i * 3 + 1];
+		b = src[i * 3 + 2];
+		dst[i * 4 + 0] = r;
+		dst[i * 4 + 1] = g;
+		dst[i * 4 + 2] = b;
+		dst[i * 4 + 3] = 0xff;
+	}
+}
+
+
+/* exported interface documented in utils/pixel.h */
+void pixel_cmyk_to_rgba(uint8_t *pixels, size_t count)
+{
+	size_t i = 0;
+
+#if defined(PIXEL_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = pixel__load(pixels + i * 4);
+		__m128i lo = pixel__cmyk(_mm_unpacklo_epi8(v, zero));
+		__m128i hi = pixel__cmyk(_mm_unpackhi_epi8(v, zero));
+
+		pixel__store(pixels + i * 4, _mm_packus_epi16(lo, hi));
+	}
+#elif defined(PIXEL_NEON)
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+
+		v.val[0] = pixel__mul255(v.val[0], v.val[3]);
+		v.val[1] = pixel__mul255(v.val[1], v.val[3]);
+		v.val[2] = pixel__mul255(v.val[2], v.val[3]);
+		v.val[3] = vdupq_n_u8(0xff);
+		vst4q_u8(pixels + i * 4, v);
+	}
+#endif
+
+	for (; i < count; i++) {
+		uint8_t *p = pixels + i * 4;
+		const unsigned int k = p[3];
+
+		p[0] = PIXEL_DIV255(p[0] * k);
+		p[1] = PIXEL_DIV255(p[1] * k);
+		p[2] = PIXEL_DIV255(p[2] * k);
+		p[3] = 0xff;
+	}
+}
+
+
+/* exported interface documented in utils/pixel.h */
+void pixel_premultiply(uint8_t *pixels, size_t count)
+{
+	size_t i = 0;
+
+#if defined(PIXEL_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = pixel__load(pixels + i * 4);
+		__m128i lo = pixel__premultiply(_mm_unpacklo_epi8(v, zero));
+		__m128i hi = pixel__premultiply(_mm_unpackhi_epi8(v, zero));
+
+		pixel__store(pixels + i * 4, _mm_packus_epi16(lo, hi));
+	}
+#elif defined(PIXEL_NEON)
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+
+		v.val[0] = pixel__premultiply(v.val[0], v.val[3]);
+		v.val[1] = pixel__premultiply(v.val[1], v.val[3]);
+		v.val[2] = pixel__premultiply(v.val[2], v.val[3]);
+		vst4q_u8(pixels + i * 4, v);
+	}
+#endif
+
+	for (; i < count; i++) {
+		uint8_t *p = pixels + i * 4;
+		const unsigned int a = p[3] + 1;
+
+		p[0] = (p[0] * a) >> 8;
+		p[1] = (p[1] * a) >> 8;
+		p[2] = (p[2] * a) >> 8;
+	}
+}
+
+
+/* exported interface documented in utils/pixel.h */
+void pixel_unpremultiply(uint8_t *pixels, size_t count)
+{
+	size_t i;
+
+	/* there is no vector integer division, opaque and transparent
+	 * pixels are common enough that skipping them is the win */
+	for (i = 0; i < count; i++) {
+		uint8_t *p = pixels + i * 4;
+		const unsigned int a = p[3];
+		unsigned int r, g, b;
+
+		if (a == 0xff) {
+			continue;
+		}
+
+		if (a == 0) {
+			p[0] = p[1] = p[2] = 0;
+			continue;
+		}
+
+		r = (p[0] << 8) / a;
+		g = (p[1] << 8) / a;
+		b = (p[2] << 8) / a;
+
+		p[0] = (r > 255) ? 255 : r;
+		p[1] = (g > 255) ? 255 : g;
+		p[2] = (b > 255) ? 255 : b;
+	}
+}
+
+
+/* exported interface documented in utils/pixel.h */
+bool pixel_opaque(const uint8_t *pixels, size_t count)
+{
+	size_t i = 0;
+
+#if defined(PIXEL_SSE2)
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000U);
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i v = pixel__load(pixels + i * 4);
+
+		v = _mm_and_si128(v, pixel__load(pixels + i * 4 + 16));
+		v = _mm_and_si128(v, pixel__load(pixels + i * 4 + 32));
+		v = _mm_and_si128(v, pixel__load(pixels + i * 4 + 48));
+		v = _mm_cmpeq_epi32(_mm_and_si128(v, alpha), alpha);
+		if (_mm_movemask_epi8(v) != 0xffff) {
+			return false;
+		}
+	}
+#elif defined(PIXEL_NEON)
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+		uint64x2_t a = vreinterpretq_u64_u8(v.val[3]);
+
+		if ((vgetq_lane_u64(a, 0) & vgetq_lane_u64(a, 1)) !=
+		    UINT64_MAX) {
+			return false;
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		if (pixels[i * 4 + 3] != 0xff) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/* exported interface documented in utils/pixel.h */
+void pixel_swizzle(uint8_t *pixels, size_t count, enum pixel_swizzle swizzle)
+{
+	size_t i = 0;
+
+#if defined(PIXEL_SSE2)
+	const __m128i low = _mm_set1_epi32(0x000000ff);
+	const __m128i middle = _mm_set1_epi32((int)0xff00ff00U);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = pixel__load(pixels + i * 4);
+
+		switch (swizzle) {
+		case PIXEL_SWIZZLE_SWAP_RB:
+			v = _mm_or_si128(_mm_and_si128(v, middle),
+				_mm_or_si128(
+					_mm_and_si128(_mm_srli_epi32(v, 16), low),
+					_mm_slli_epi32(_mm_and_si128(v, low), 16)));
+			break;
+
+		case PIXEL_SWIZZLE_RGBA_TO_ARGB:
+			v = _mm_or_si128(_mm_slli_epi32(v, 8),
+					 _mm_srli_epi32(v, 24));
+			break;
+
+		case PIXEL_SWIZZLE_ARGB_TO_RGBA:
+			v = _mm_or_si128(_mm_srli_epi32(v, 8),
+					 _mm_slli_epi32(v, 24));
+			break;
+		}
+
+		pixel__store(pixels + i * 4, v);
+	}
+#elif defined(PIXEL_NEON)
+	for (; i + 16 <= count; i += 16) {
+		uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+		uint8x16_t t;
+
+		switch (swizzle) {
+		case PIXEL_SWIZZLE_SWAP_RB:
+			t = v.val[0];
+			v.val[0] = v.val[2];
+			v.val[2] = t;
+			break;
+
+		case PIXEL_SWIZZLE_RGBA_TO_ARGB:
+			t = v.val[3];
+			v.val[3] = v.val[2];
+			v.val[2] = v.val[1];
+			v.val[1] = v.val[0];
+			v.val[0] = t;
+			break;
+
+		case PIXEL_SWIZZLE_ARGB_TO_RGBA:
+			t = v.val[0];
+			v.val[0] = v.val[1];
+			v.val[1] = v.val[2];
+			v.val[2] = v.val[3];
+			v.val[3] = t;
+			break;
+		}
+
+		vst4q_u8(pixels + i * 4, v);
+	}
+#endif
+
+	for (; i < count; i++) {
+		uint8_t *p = pixels + i * 4;
+		uint8_t t;
+
+		switch (swizzle) {
+		case PIXEL_SWIZZLE_SWAP_RB:
+			t = p[0];
+			p[0] = p[2];
+			p[2] = t;
+			break;
+
+		case PIXEL_SWIZZLE_RGBA_TO_ARGB:
+			t = p[3];
+			p[3] = p[2];
+			p[2] = p[1];
+			p[1] = p[0];
+			p[0] = t;
+			break;
+
+		case PIXEL_SWIZZLE_ARGB_TO_RGBA:
+			t = p[0];
+			p[0] = p[1];
+			p[1] = p[2];
+			p[2] = p[3];
+			p[3] = t;
+			break;
+		}
+	}
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2026 agent <agent@local>
+ *
+ * This file is part of NetSurf, http://www.netsurf-browser.org/
+ *
+ * NetSurf is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * NetSurf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * Pixel format conversion interface.
+ *
+ * Kernels for converting runs of pixels between the formats used by
+ * image decoders, the core bitmap format (8 bit per channel RGBA in
+ * memory order) and frontend bitmap formats.
+ *
+ * SSE2 or NEON implementations are used where the compiler targets
+ * them, with a scalar fallback otherwise. Every implementation gives
+ * identical results.
+ */
+
+#ifndef NETSURF_UTILS_PIXEL_H
+#define NETSURF_UTILS_PIXEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Channel reorderings performed by pixel_swizzle()
+ *
+ * Orders are named by the memory order of the channels.
+ */
+enum pixel_swizzle {
+	PIXEL_SWIZZLE_SWAP_RB, /**< RGBA to BGRA and BGRA to RGBA */
+	PIXEL_SWIZZLE_RGBA_TO_ARGB, /**< RGBA to ARGB */
+	PIXEL_SWIZZLE_ARGB_TO_RGBA, /**< ARGB to RGBA */
+};
+
+
+/**
+ * Expand RGB pixels to opaque RGBA.
+ *
+ * The conversion may be performed in place with the RGB pixels at the
+ * start of the destination buffer.
+ *
+ * \param dst   buffer of count RGBA pixels to write
+ * \param src   buffer of count RGB pixels to read
+ * \param count number of pixels
+ */
+void pixel_rgb_to_rgba(uint8_t *dst, const uint8_t *src, size_t count);
+
+
+/**
+ * Convert inverted CMYK pixels to opaque RGBA in place.
+ *
+ * This is the trivial conversion of the inverted CMYK produced by JPEG
+ * decoders, each channel is multiplied by the K channel.
+ *
+ * \param pixels buffer of count CMYK pixels
+ * \param count  number of pixels
+ */
+void pixel_cmyk_to_rgba(uint8_t *pixels, size_t count);
+
+
+/**
+ * Premultiply the colour channels of RGBA pixels by alpha in place.
+ *
+ * \param pixels buffer of count RGBA pixels
+ * \param count  number of pixels
+ */
+void pixel_premultiply(uint8_t *pixels, size_t count);
+
+
+/**
+ * Divide the colour channels of premultiplied RGBA pixels by alpha in place.
+ *
+ * \param pixels buffer of count premultiplied RGBA pixels
+ * \param count  number of pixels
+ */
+void pixel_unpremultiply(uint8_t *pixels, size_t count);
+
+
+/**
+ * Determine if RGBA pixels are all fully opaque.
+ *
+ * \param pixels buffer of count RGBA pixels
+ * \param count  number of pixels
+ * \return true if the alpha channel of every pixel is 0xff
+ */
+bool pixel_opaque(const uint8_t *pixels, size_t count);
+
+
+/**
+ * Reorder the channels of four channel pixels in place.
+ *
+ * \param pixels  buffer of count pixels
+ * \param count   number of pixels
+ * \param swizzle the reordering to perform
+ */
+void pixel_swizzle(uint8_t *pixels, size_t count, enum pixel_swizzle swizzle);
+
+#endif